@@ -0,0 +1,475 @@
+// Scanner benchmark suite against the deterministic scan_target fixture.
+//
+// Starts scan_target with the given layout, attaches a MemoryScanner to it and times
+// first scans, every filter mode (on match vectors and on the column store), string, AOB
+// (raw byte pattern) and pointer scans, writing all matches one by one against one WriteBatch,
+// three scan hypotheses in turn and as parallel sessions, recording the candidates at 1 kHz,
+// and capturing/comparing a compressed memory snapshot.
+// Results are written to stdout as one JSON document.
+#include "filter_expression.h"
+#include "memory_scanner.h"
+#include "result_store.h"
+#include "time_series.h"
+#include "write_batch.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+    std::string target;
+    std::string seed = "1";
+    std::string heapMb = "256";
+    std::string regions = "64";
+    std::string density = "64";
+    std::string mutationRate = "0.5";
+    std::string zeroShare = "0";
+    int iterations = 5;
+    size_t queueDepth = defaultReadQueueDepth();
+    size_t memoryBudgetMb = 0; // 0 keeps the default budget
+};
+
+// Running scan_target instance, talked to over its stdin/stdout
+class TargetProcess {
+public:
+    ~TargetProcess() { stop(); }
+
+    bool start(const Options& options) {
+        int toChild[2], fromChild[2];
+        if (pipe(toChild) != 0 || pipe(fromChild) != 0) return false;
+
+        m_pid = fork();
+        if (m_pid < 0) return false;
+        if (m_pid == 0) {
+            dup2(toChild[0], STDIN_FILENO);
+            dup2(fromChild[1], STDOUT_FILENO);
+            close(toChild[1]);
+            close(fromChild[0]);
+            execl(options.target.c_str(), options.target.c_str(),
+                  "--seed", options.seed.c_str(), "--heap-mb", options.heapMb.c_str(),
+                  "--regions", options.regions.c_str(), "--density", options.density.c_str(),
+                  "--mutation-rate", options.mutationRate.c_str(), "--zero-share", options.zeroShare.c_str(),
+                  static_cast<char*>(nullptr));
+            _exit(127);
+        }
+
+        close(toChild[0]);
+        close(fromChild[1]);
+        m_input = fdopen(toChild[1], "w");
+        m_output = fdopen(fromChild[0], "r");
+
+        // "ready key=value ..."
+        std::string line = readLine();
+        std::istringstream fields(line);
+        std::string word;
+        fields >> word;
+        if (word != "ready") return false;
+        while (fields >> word) {
+            size_t equals = word.find('=');
+            if (equals != std::string::npos) m_layout[word.substr(0, equals)] = word.substr(equals + 1);
+        }
+        return true;
+    }
+
+    void stop() {
+        if (m_pid <= 0) return;
+        command("quit");
+        if (m_input) std::fclose(m_input);
+        if (m_output) std::fclose(m_output);
+        m_input = m_output = nullptr;
+        waitpid(m_pid, nullptr, 0);
+        m_pid = -1;
+    }
+
+    std::string command(const std::string& text) {
+        if (!m_input) return {};
+        std::fprintf(m_input, "%s\n", text.c_str());
+        std::fflush(m_input);
+        return text == "quit" ? std::string() : readLine();
+    }
+
+    pid_t pid() const { return m_pid; }
+    const std::string& layout(const std::string& key) { return m_layout[key]; }
+
+private:
+    pid_t m_pid = -1;
+    FILE* m_input = nullptr;
+    FILE* m_output = nullptr;
+    std::map<std::string, std::string> m_layout;
+
+    std::string readLine() {
+        char buffer[1024];
+        if (!m_output || !std::fgets(buffer, sizeof(buffer), m_output)) return {};
+        std::string line(buffer);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        return line;
+    }
+};
+
+// Samples of one benchmark case
+struct CaseResult {
+    std::string name;
+    std::vector<double> milliseconds;
+    uint64_t bytes = 0;      // bytes the operation had to look at
+    uint64_t syscalls = 0;   // summed over all iterations
+    size_t matches = 0;
+    long peakRssKb = 0;
+};
+
+// Reset the peak RSS counter of this process so every case reports its own peak
+void resetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+long peakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+    return 0;
+}
+
+double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+// prepare() runs untimed before every iteration, run() is timed and returns the match count
+CaseResult runCase(const std::string& name, MemoryScanner& scanner, int iterations, uint64_t bytes,
+                   const std::function<void()>& prepare, const std::function<size_t()>& run) {
+    CaseResult result;
+    result.name = name;
+    result.bytes = bytes;
+
+    resetPeakRss();
+    for (int i = 0; i < iterations; i++) {
+        if (prepare) prepare();
+
+        uint64_t syscallsBefore = scanner.syscallCount();
+        auto start = std::chrono::steady_clock::now();
+        result.matches = run();
+        auto end = std::chrono::steady_clock::now();
+
+        result.syscalls += scanner.syscallCount() - syscallsBefore;
+        result.milliseconds.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+void printJson(const Options& options, const char* backend, const MemorySnapshot& snapshot,
+               const std::vector<CaseResult>& results) {
+    std::printf("{\n  \"layout\": {\"seed\": %s, \"heap_mb\": %s, \"regions\": %s, \"density\": %s, \"mutation_rate\": %s, "
+                "\"zero_share\": %s},\n",
+                options.seed.c_str(), options.heapMb.c_str(), options.regions.c_str(),
+                options.density.c_str(), options.mutationRate.c_str(), options.zeroShare.c_str());
+    std::printf("  \"iterations\": %d,\n", options.iterations);
+    const MemoryGovernor& governor = memoryGovernor();
+    std::printf("  \"memory\": {\"budget\": %zu", governor.budget());
+    for (size_t i = 0; i < static_cast<size_t>(MemoryComponent::COUNT); i++) {
+        auto component = static_cast<MemoryComponent>(i);
+        std::printf(", \"%s_peak\": %zu", memoryComponentName(component), governor.peak(component));
+    }
+    std::printf("},\n");
+    const SnapshotStats& stats = snapshot.stats();
+    std::printf("  \"snapshot\": {\"raw_bytes\": %llu, \"memory_bytes\": %zu, \"zero_pages\": %llu, "
+                "\"compressed_pages\": %llu, \"raw_pages\": %llu, \"ratio\": %.2f},\n",
+                static_cast<unsigned long long>(stats.rawBytes), snapshot.memoryUsage(),
+                static_cast<unsigned long long>(stats.zeroPages), static_cast<unsigned long long>(stats.compressedPages),
+                static_cast<unsigned long long>(stats.rawPages),
+                snapshot.memoryUsage() > 0 ? static_cast<double>(stats.rawBytes) / snapshot.memoryUsage() : 0.0);
+    std::printf("  \"read_queue\": {\"depth\": %zu, \"backend\": \"%s\"},\n  \"cases\": [\n", options.queueDepth, backend);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const CaseResult& r = results[i];
+        double p50 = percentile(r.milliseconds, 0.5);
+        double gbPerSecond = p50 > 0 ? r.bytes / (p50 / 1000.0) / 1e9 : 0;
+        std::printf("    {\"name\": \"%s\", \"matches\": %zu, \"bytes\": %llu, \"gb_per_s\": %.3f, "
+                    "\"syscalls_per_scan\": %.1f, \"peak_rss_kb\": %ld, "
+                    "\"latency_ms\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}}%s\n",
+                    r.name.c_str(), r.matches, static_cast<unsigned long long>(r.bytes), gbPerSecond,
+                    static_cast<double>(r.syscalls) / std::max<size_t>(r.milliseconds.size(), 1), r.peakRssKb,
+                    percentile(r.milliseconds, 0), p50, percentile(r.milliseconds, 0.9),
+                    percentile(r.milliseconds, 0.99), percentile(r.milliseconds, 1),
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--target") options.target = value;
+        else if (key == "--seed") options.seed = value;
+        else if (key == "--heap-mb") options.heapMb = value;
+        else if (key == "--regions") options.regions = value;
+        else if (key == "--density") options.density = value;
+        else if (key == "--mutation-rate") options.mutationRate = value;
+        else if (key == "--iterations") options.iterations = std::max(1, std::atoi(value.c_str()));
+        else if (key == "--zero-share") options.zeroShare = value;
+        else if (key == "--queue-depth") options.queueDepth = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--memory-budget-mb") options.memoryBudgetMb = std::strtoull(value.c_str(), nullptr, 10);
+        else return false;
+    }
+    if ((argc - 1) % 2 != 0) return false;
+
+    // Default: scan_target next to this executable
+    if (options.target.empty()) {
+        char self[4096];
+        ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+        if (length <= 0) return false;
+        std::string path(self, length);
+        options.target = path.substr(0, path.find_last_of('/') + 1) + "scan_target";
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: memory_scanner_bench [--target PATH] [--seed N] [--heap-mb M] [--regions R]\n"
+                             "                            [--density D] [--mutation-rate P] [--iterations K]\n"
+                             "                            [--zero-share Z] [--queue-depth Q] [--memory-budget-mb MB]\n");
+        return 2;
+    }
+
+    TargetProcess target;
+    if (!target.start(options)) {
+        std::fprintf(stderr, "could not start %s\n", options.target.c_str());
+        return 1;
+    }
+
+    if (options.memoryBudgetMb > 0) memoryGovernor().setBudget(options.memoryBudgetMb * 1024 * 1024);
+    MemoryScanner scanner(target.pid());
+    scanner.setReadQueueDepth(options.queueDepth);
+    int32_t marker = static_cast<int32_t>(std::strtol(target.layout("marker").c_str(), nullptr, 10));
+    std::string text = target.layout("string");
+    uintptr_t pointer = static_cast<uintptr_t>(std::strtoull(target.layout("pointer").c_str(), nullptr, 10));
+
+    std::string pattern;
+    const std::string& hex = target.layout("aob");
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        pattern.push_back(static_cast<char>(std::strtoul(hex.substr(i, 2).c_str(), nullptr, 16)));
+    }
+
+    uint64_t readableBytes = 0;
+    for (const auto& region : scanner.getReadableRegions()) readableBytes += region.size;
+
+    std::vector<CaseResult> results;
+    std::vector<MemoryMatch<int32_t>> candidates;
+
+    results.push_back(runCase("first_scan_int32", scanner, options.iterations, readableBytes, nullptr, [&] {
+        candidates = scanner.scanForValue(marker);
+        return candidates.size();
+    }));
+    results.push_back(runCase("first_scan_double", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForValue(static_cast<double>(marker)).size();
+    }));
+    // The planted bytes read as a big-endian value: same hits, same kernel as first_scan_int32
+    results.push_back(runCase("first_scan_int32_be", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForValue(Swapped<int32_t>{ marker }).size();
+    }));
+
+    // Value sets: the marker among decoys in one pass, a broadcast set and a bitset-probed one
+    std::vector<int32_t> smallSet{ marker + 1, marker, marker + 2 };
+    std::vector<int32_t> largeSet{ marker };
+    for (int32_t i = 1; i < 64; i++) largeSet.push_back(marker + 7 * i);
+    ValueSet<int32_t> smallValues(smallSet), largeValues(largeSet);
+    results.push_back(runCase("value_set_3", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForValueSet(smallValues).size();
+    }));
+    results.push_back(runCase("value_set_64", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForValueSet(largeValues).size();
+    }));
+
+    // Every filter iteration starts from the same state: planted values reset, first scan, one mutation
+    auto freshCandidates = [&] {
+        target.command("reset");
+        candidates = scanner.scanForValue(marker);
+        target.command("mutate");
+    };
+    uint64_t candidateBytes = candidates.size() * sizeof(int32_t);
+    results.push_back(runCase("filter_exact", scanner, options.iterations, candidateBytes, freshCandidates, [&] {
+        return scanner.filterByValue(candidates, marker).size();
+    }));
+    results.push_back(runCase("filter_changed", scanner, options.iterations, candidateBytes, freshCandidates, [&] {
+        return scanner.filterByChanged(candidates).size();
+    }));
+    results.push_back(runCase("filter_unchanged", scanner, options.iterations, candidateBytes, freshCandidates, [&] {
+        return scanner.filterByUnchanged(candidates).size();
+    }));
+    // The exact filter compacting the candidates in place instead of returning a new set
+    results.push_back(runCase("compact_exact", scanner, options.iterations, candidateBytes, freshCandidates, [&] {
+        return scanner.compactByValue(candidates, marker);
+    }));
+
+    // The same filters over the column store: one batched read of the address column
+    ResultStore columns;
+    auto freshColumns = [&] {
+        freshCandidates();
+        columns.clear();
+        for (const auto& match : candidates) columns.push_back(match);
+    };
+    results.push_back(runCase("filter_columns_exact", scanner, options.iterations, candidateBytes, freshColumns, [&] {
+        return filterResultStore(scanner, columns, ColumnFilter::EQUAL, &marker).size();
+    }));
+    results.push_back(runCase("filter_columns_changed", scanner, options.iterations, candidateBytes, freshColumns, [&] {
+        return filterResultStore(scanner, columns, ColumnFilter::CHANGED).size();
+    }));
+
+    // Two conditions as chained filters (two reads) and as one expression (one read, one pass)
+    FilterExpression expression;
+    std::string expressionError;
+    expression.compile("v != old && v == " + std::to_string(marker + 1), ScanValueType::INT32, expressionError);
+    results.push_back(runCase("filter_chain_2", scanner, options.iterations, candidateBytes, freshCandidates, [&] {
+        return scanner.filterByValue(scanner.filterByChanged(candidates), marker + 1).size();
+    }));
+    results.push_back(runCase("filter_expression_2", scanner, options.iterations, candidateBytes, freshCandidates, [&] {
+        return filterByExpression(scanner, candidates, expression, nullptr).size();
+    }));
+
+    // Write the marker back to every candidate, per address and as one batch
+    target.command("reset");
+    candidates = scanner.scanForValue(marker);
+    candidateBytes = candidates.size() * sizeof(int32_t);
+    results.push_back(runCase("write_each", scanner, options.iterations, candidateBytes, nullptr, [&] {
+        size_t written = 0;
+        for (const auto& match : candidates) {
+            if (scanner.writeValue(match.address, marker)) written++;
+        }
+        return written;
+    }));
+    results.push_back(runCase("write_batch", scanner, options.iterations, candidateBytes, nullptr, [&] {
+        WriteBatch batch;
+        batch.reserve(candidates.size(), candidateBytes);
+        for (const auto& match : candidates) batch.addValue(match.address, marker);
+        return batch.submit(scanner).written;
+    }));
+
+    // A screen of rows read by three interactive consumers in one frame (row refresh, value
+    // display, selection), per value and through the page cache with a 16 ms bound
+    const size_t screenRows = std::min<size_t>(candidates.size(), 64);
+    uint64_t screenBytes = 3 * screenRows * sizeof(int32_t);
+    auto readScreen = [&](auto&& read) {
+        size_t succeeded = 0;
+        for (int consumer = 0; consumer < 3; consumer++) {
+            for (size_t i = 0; i < screenRows; i++) {
+                int32_t value;
+                if (read(candidates[i].address, value)) succeeded++;
+            }
+        }
+        return succeeded;
+    };
+    results.push_back(runCase("interactive_reads", scanner, options.iterations, screenBytes, nullptr, [&] {
+        return readScreen([&](uintptr_t address, int32_t& value) { return scanner.readValue(address, value); });
+    }));
+    results.push_back(runCase("interactive_reads_cached", scanner, options.iterations, screenBytes, nullptr, [&] {
+        return readScreen([&](uintptr_t address, int32_t& value) {
+            return scanner.readValueCached(address, value, std::chrono::milliseconds(16));
+        });
+    }));
+
+    // The candidates recorded at 1 kHz for 250 ms; matches are the samples taken, which fall
+    // short of 250 when reading and encoding a sample takes longer than the interval
+    MemoryScanner recordScanner(target.pid(), scanner.cache());
+    TimeSeriesRecorder recorder(recordScanner);
+    for (const auto& match : candidates) recorder.addRange(match.address, sizeof(int32_t));
+    const std::string recordingPath = "/tmp/memory_scanner_bench_" + std::to_string(getpid()) + ".msts";
+    uint64_t recordSyscalls = recordScanner.syscallCount();
+    results.push_back(runCase("record_1khz", scanner, options.iterations, candidateBytes, nullptr, [&] {
+        std::string error;
+        if (!recorder.start(recordingPath, std::chrono::microseconds(1000), ScanValueType::INT32, error)) return size_t(0);
+        target.command("mutate");
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        recorder.stop();
+        return static_cast<size_t>(recorder.stats().samples);
+    }));
+    results.back().syscalls += recordScanner.syscallCount() - recordSyscalls;
+    std::remove(recordingPath.c_str());
+
+    results.push_back(runCase("string_scan", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForString(text).size();
+    }));
+    results.push_back(runCase("aob_scan", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForString(pattern).size();
+    }));
+    results.push_back(runCase("pointer_scan", scanner, options.iterations, readableBytes, nullptr, [&] {
+        return scanner.scanForValue(pointer).size();
+    }));
+
+    // Three hypotheses about the marker (int32, int64, double): in turn on one scanner, then
+    // as parallel sessions whose scanners share the first one's process cache
+    MemoryScanner secondSession(target.pid(), scanner.cache());
+    MemoryScanner thirdSession(target.pid(), scanner.cache());
+    secondSession.setReadQueueDepth(options.queueDepth);
+    thirdSession.setReadQueueDepth(options.queueDepth);
+    auto hypotheses = [&](bool parallel) {
+        std::array<size_t, 3> found{};
+        auto first = [&] { found[0] = scanner.scanForValue(marker).size(); };
+        auto second = [&] { found[1] = secondSession.scanForValue(static_cast<int64_t>(marker)).size(); };
+        auto third = [&] { found[2] = thirdSession.scanForValue(static_cast<double>(marker)).size(); };
+        if (parallel) {
+            std::thread secondThread(second);
+            std::thread thirdThread(third);
+            first();
+            secondThread.join();
+            thirdThread.join();
+        } else {
+            first();
+            second();
+            third();
+        }
+        return found[0] + found[1] + found[2];
+    };
+    for (bool parallel : { false, true }) {
+        uint64_t sessionSyscalls = secondSession.syscallCount() + thirdSession.syscallCount();
+        results.push_back(runCase(parallel ? "hypotheses_3_parallel" : "hypotheses_3_serial", scanner, options.iterations,
+                                  3 * readableBytes, nullptr, [&] { return hypotheses(parallel); }));
+        results.back().syscalls += secondSession.syscallCount() + thirdSession.syscallCount() - sessionSyscalls;
+    }
+
+    // Unknown-value baseline as a compressed snapshot, then the values changed since it
+    MemorySnapshot snapshot;
+    results.push_back(runCase("snapshot_capture", scanner, options.iterations, readableBytes, nullptr, [&] {
+        scanner.captureSnapshot(snapshot);
+        return static_cast<size_t>(snapshot.stats().zeroPages);
+    }));
+    results.push_back(runCase("snapshot_changed", scanner, options.iterations, readableBytes, [&] {
+        target.command("reset");
+        scanner.captureSnapshot(snapshot);
+        target.command("mutate");
+    }, [&] {
+        size_t changed = 0;
+        scanner.scanSnapshot<int32_t>(snapshot, SnapshotCompare::CHANGED, [&](const MemoryMatch<int32_t>&) { changed++; });
+        return changed;
+    }));
+
+    // Same choice the scanner makes when it sets up its pipeline
+    const char* backend = "sync";
+    if (options.queueDepth > 0) {
+        ReadPipeline probe(target.pid(), std::min(options.queueDepth, kMaxReadQueueDepth));
+        if (probe.valid()) backend = readPipelineBackendName(probe.backend());
+    }
+    printJson(options, backend, snapshot, results);
+    return 0;
+}
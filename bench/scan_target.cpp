@@ -0,0 +1,156 @@
+// Deterministic synthetic target for memory_scanner_bench.
+//
+// Allocates a reproducible memory layout from a seed, plants known values, strings,
+// byte patterns and pointers in it and then waits for commands on stdin:
+//   mutate  - change a share (--mutation-rate) of the planted values, prints "ok <changed>"
+//   reset   - put every planted value back to the marker, prints "ok <planted>"
+//   quit    - exit
+// The first line on stdout describes the layout: "ready pid=... marker=... ..."
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+    uint64_t seed = 1;
+    size_t heapMb = 256;
+    size_t regions = 64;
+    size_t density = 64;         // planted values per MiB
+    double mutationRate = 0.5;   // share of planted values changed per "mutate"
+    double zeroShare = 0;        // share of pages left all-zero, like untouched heap
+};
+
+// xorshift64*, fixed so layouts are identical across runs and machines
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        const char* value = argv[i + 1];
+        if (key == "--seed") options.seed = std::strtoull(value, nullptr, 10);
+        else if (key == "--heap-mb") options.heapMb = std::strtoull(value, nullptr, 10);
+        else if (key == "--regions") options.regions = std::strtoull(value, nullptr, 10);
+        else if (key == "--density") options.density = std::strtoull(value, nullptr, 10);
+        else if (key == "--mutation-rate") options.mutationRate = std::strtod(value, nullptr);
+        else if (key == "--zero-share") options.zeroShare = std::strtod(value, nullptr);
+        else return false;
+    }
+    return options.heapMb > 0 && options.regions > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: scan_target [--seed N] [--heap-mb M] [--regions R] [--density D] [--mutation-rate P]\n"
+                             "                   [--zero-share Z]\n");
+        return 2;
+    }
+
+    Random random(options.seed);
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t regionSize = (options.heapMb * 1024 * 1024 / options.regions + pageSize - 1) / pageSize * pageSize;
+
+    // Regions are separate mappings so the scanner sees realistic region counts
+    std::vector<uint8_t*> regions;
+    for (size_t r = 0; r < options.regions; r++) {
+        void* memory = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            std::perror("mmap");
+            return 1;
+        }
+        auto* bytes = static_cast<uint8_t*>(memory);
+        for (size_t page = 0; page < regionSize; page += pageSize) {
+            if (static_cast<double>(random.next() >> 11) / 9007199254740992.0 < options.zeroShare) continue;
+            for (size_t i = page; i + 8 <= page + pageSize; i += 8) {
+                uint64_t word = random.next();
+                std::memcpy(bytes + i, &word, 8);
+            }
+        }
+        regions.push_back(bytes);
+    }
+
+    // Needles, all derived from the seed
+    int32_t marker = static_cast<int32_t>(random.next() | 0x01000001);
+    std::string text = "scan_target_marker_" + std::to_string(options.seed);
+    uint8_t pattern[16];
+    for (auto& b : pattern) b = static_cast<uint8_t>(random.next());
+
+    // The pointer target is a small struct every pointer slot refers to
+    auto* pointee = regions[0] + 64;
+    uintptr_t pointeeAddress = reinterpret_cast<uintptr_t>(pointee);
+
+    // Planted values live at 4-byte aligned slots, strings/patterns/pointers at 8-byte aligned ones
+    size_t plantCount = options.heapMb * options.density;
+    std::vector<int32_t*> planted;
+    planted.reserve(plantCount);
+    for (size_t i = 0; i < plantCount; i++) {
+        uint8_t* region = regions[random.below(regions.size())];
+        auto* slot = reinterpret_cast<int32_t*>(region + 128 + random.below((regionSize - 256) / 4) * 4);
+        *slot = marker;
+        planted.push_back(slot);
+    }
+
+    size_t extras = std::max<size_t>(options.heapMb / 4, 1);
+    for (size_t i = 0; i < extras; i++) {
+        uint8_t* region = regions[random.below(regions.size())];
+        size_t offset = 128 + random.below((regionSize - 256) / 8) * 8;
+        switch (i % 3) {
+            case 0: std::memcpy(region + offset, text.data(), std::min<size_t>(text.size(), 120)); break;
+            case 1: std::memcpy(region + offset, pattern, sizeof(pattern)); break;
+            case 2: std::memcpy(region + offset, &pointeeAddress, sizeof(pointeeAddress)); break;
+        }
+    }
+
+    char hex[sizeof(pattern) * 2 + 1];
+    for (size_t i = 0; i < sizeof(pattern); i++) std::snprintf(hex + i * 2, 3, "%02x", pattern[i]);
+
+    std::printf("ready pid=%d marker=%d string=%s aob=%s pointer=%llu planted=%zu region_size=%zu regions=%zu\n",
+                static_cast<int>(getpid()), marker, text.c_str(), hex,
+                static_cast<unsigned long long>(pointeeAddress), planted.size(), regionSize, regions.size());
+    std::fflush(stdout);
+
+    std::string command;
+    while (std::getline(std::cin, command)) {
+        if (command == "mutate") {
+            // Bump a deterministic subset of the planted values
+            size_t changed = 0;
+            for (int32_t* slot : planted) {
+                if (static_cast<double>(random.next() >> 11) / 9007199254740992.0 < options.mutationRate) {
+                    (*slot)++;
+                    changed++;
+                }
+            }
+            std::printf("ok %zu\n", changed);
+            std::fflush(stdout);
+        } else if (command == "reset") {
+            for (int32_t* slot : planted) *slot = marker;
+            std::printf("ok %zu\n", planted.size());
+            std::fflush(stdout);
+        } else if (command == "quit") {
+            break;
+        }
+    }
+
+    return 0;
+}
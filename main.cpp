@@ -1,3 +1,5 @@
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -7,49 +9,133 @@
 
 #ifdef _WIN32
 #include "src/process_utils.h"
+#include "src/change_sampler.h"
+#include "src/filter_expression.h"
 #include "src/memory_scanner.h"
+#include "src/scan_history.h"
+#include "src/value_format.h"
+#include "src/watch_list.h"
+#include "src/write_batch.h"
+
+// Watch list intervals: watched values are re-read at 10 Hz, frozen values rewritten at 100 Hz
+constexpr uint32_t kWatchIntervalMs = 100;
+constexpr uint32_t kFreezeIntervalMs = 10;
 
 // Template to handle different data types
 template<typename T>
 class ScanSession {
 public:
-    std::vector<MemoryMatch<T>> currentMatches;
+    // Every scan and filter pushes a generation, undo/redo just moves between them
+    ScanHistory<T> history;
     bool hasInitialScan = false;
 
+    size_t matchCount() const {
+        return history.empty() ? 0 : history.current().count();
+    }
+
     void displayMatches(size_t maxDisplay = 20) {
-        if (currentMatches.empty()) {
+        if (matchCount() == 0) {
             std::cout << "Keine Treffer gefunden.\n";
             return;
         }
 
-        std::cout << "\nGefundene Adressen: " << currentMatches.size() << "\n";
-        std::cout << "Zeige ersten " << std::min(currentMatches.size(), maxDisplay) << " Treffer:\n";
+        const auto& currentMatches = history.current();
+        std::cout << "\nGefundene Adressen: " << currentMatches.count() << "\n";
+        std::cout << "Zeige ersten " << std::min(currentMatches.count(), maxDisplay) << " Treffer:\n";
         std::cout << std::string(60, '-') << "\n";
         std::cout << std::setw(18) << "Adresse" << " | " << "Wert\n";
         std::cout << std::string(60, '-') << "\n";
 
-        for (size_t i = 0; i < std::min(currentMatches.size(), maxDisplay); i++) {
+        for (size_t i = 0; i < std::min(currentMatches.count(), maxDisplay); i++) {
+            // Rows of a shard lost with its spill file are left out, reportDamage says so
+            const auto* match = currentMatches.at(i);
+            if (!match) continue;
             std::cout << "0x" << std::hex << std::setw(16) << std::setfill('0')
-                      << currentMatches[i].address << " | " << std::dec
-                      << currentMatches[i].value << "\n";
+                      << match->address << " | " << std::dec
+                      << match->value << "\n";
         }
         std::cout << std::string(60, '-') << "\n";
+        reportDamage();
+    }
+
+    // Matches of a spilled shard that could not be read back are gone, say so
+    void reportDamage() const {
+        if (!history.empty() && history.current().damaged()) {
+            std::cout << "✗ Ausgelagerte Ergebnisse konnten nicht zurückgelesen werden, die Liste ist unvollständig!\n";
+        }
+    }
+
+    void displayHistory() {
+        if (history.empty()) {
+            std::cout << "Noch kein Scan durchgeführt.\n";
+            return;
+        }
+
+        std::cout << "\nScan-Verlauf (" << history.memoryUsage() / 1024 << " KB im Speicher, "
+                  << history.spilledBytes() / 1024 << " KB ausgelagert):\n";
+        for (size_t i = 0; i < history.generationCount(); i++) {
+            const auto& generation = history.generation(i);
+            std::cout << (i == history.currentIndex() ? " > " : "   ")
+                      << std::setw(2) << i + 1 << ". " << generation.label
+                      << " - " << generation.count() << " Adressen"
+                      << (generation.damaged() ? " (unvollständig)" : "") << "\n";
+        }
     }
 };
 
+// Short per-operation summary after every scan
+void printScanSummary(const MemoryScanner& scanner) {
+    std::cout << formatScanStats(scanner.lastScanStats(), 0);
+}
+
+void toggleScanTrace(MemoryScanner& scanner) {
+    if (!scanner.traceEnabled()) {
+        scanner.clearTraceLog();
+        scanner.setTraceEnabled(true);
+        std::cout << "✓ Trace-Aufzeichnung gestartet. Nach den Scans erneut Option 18 wählen.\n";
+        return;
+    }
+
+    std::cout << "Dateiname für den Trace (Enter = scan_trace.json): ";
+    std::string path;
+    std::getline(std::cin, path);
+    if (path.empty()) path = "scan_trace.json";
+
+    if (writeChromeTrace(scanner.traceLog(), path)) {
+        std::cout << "✓ " << scanner.traceLog().size() << " Operationen nach " << path
+                  << " exportiert (chrome://tracing oder ui.perfetto.dev)\n";
+    } else {
+        std::cout << "✗ Datei konnte nicht geschrieben werden.\n";
+    }
+    scanner.setTraceEnabled(false);
+    scanner.clearTraceLog();
+}
+
 void displayMenu() {
     std::cout << "\n╔════════════════════════════════════════════╗\n";
     std::cout << "║     Memory Scanner - CheatEngine Style    ║\n";
     std::cout << "╚════════════════════════════════════════════╝\n";
     std::cout << "1. Prozess auswählen\n";
     std::cout << "2. Ersten Scan starten (Initial Scan)\n";
-    std::cout << "3. Nächster Scan (exakter Wert)\n";
+    std::cout << "3. Nächster Scan (exakter Wert oder Werteliste)\n";
     std::cout << "4. Nächster Scan (geänderter Wert)\n";
     std::cout << "5. Nächster Scan (ungeänderter Wert)\n";
     std::cout << "6. Gefundene Adressen anzeigen\n";
     std::cout << "7. Wert an Adresse ändern\n";
     std::cout << "8. Wert an Adresse lesen\n";
     std::cout << "9. Scan zurücksetzen\n";
+    std::cout << "10. Adresse beobachten / einfrieren\n";
+    std::cout << "11. Watchlist anzeigen\n";
+    std::cout << "12. Watchlist-Eintrag entfernen\n";
+    std::cout << "13. Gruppen-Scan (mehrere Werte mit Offsets)\n";
+    std::cout << "14. Rückgängig (letzten Filter zurücknehmen)\n";
+    std::cout << "15. Wiederholen\n";
+    std::cout << "16. Scan-Verlauf anzeigen\n";
+    std::cout << "17. Scan-Statistik anzeigen\n";
+    std::cout << "18. Trace-Aufzeichnung starten / exportieren\n";
+    std::cout << "19. Wert an alle gefundenen Adressen schreiben\n";
+    std::cout << "20. Änderungsfrequenz messen (Sampling)\n";
+    std::cout << "21. Filter-Ausdruck (z.B. v > old && v < 1000)\n";
     std::cout << "0. Beenden\n";
     std::cout << "─────────────────────────────────────────────\n";
     std::cout << "Wählen Sie eine Option: ";
@@ -110,47 +196,90 @@ HANDLE selectProcess() {
     return hProcess;
 }
 
+// One value or several separated by commas ("100,150,200"), false if one does not parse
+template<typename T>
+bool readValueList(std::vector<T>& values, std::string& label) {
+    std::string line;
+    std::getline(std::cin, line);
+    std::stringstream stream(line);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        std::stringstream itemStream(item);
+        T value;
+        if (!(itemStream >> value)) return false;
+        values.push_back(value);
+        label += (values.size() == 1 ? "" : ",") + std::to_string(value);
+    }
+    if (values.size() > 1) label = "{" + label + "}";
+    return !values.empty();
+}
+
 template<typename T>
 void performInitialScan(MemoryScanner& scanner, ScanSession<T>& session) {
     std::cout << "\n=== Erster Scan ===\n";
-    std::cout << "Geben Sie den Wert ein, den Sie suchen: ";
+    std::cout << "Geben Sie den Wert ein, den Sie suchen (mehrere mit Komma, z.B. 100,150,200): ";
 
-    T value;
-    std::cin >> value;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::vector<T> values;
+    std::string text;
+    if (!readValueList(values, text)) {
+        std::cout << "Ungültiger Wert.\n";
+        return;
+    }
 
+    // Several candidates are found in one pass, each match holds the one it found
     std::cout << "Scanne Speicher...\n";
-    session.currentMatches = scanner.scanForValue(value);
+    ValueSet<T> set(values);
+    session.history.collect([&](auto&& sink) {
+        if (values.size() == 1) scanner.scanForValue(values[0], sink);
+        else scanner.scanForValueSet(set, sink);
+    }, (values.size() == 1 ? "Erster Scan = " : "Erster Scan in ") + text);
     session.hasInitialScan = true;
 
-    std::cout << "✓ Scan abgeschlossen! Gefunden: " << session.currentMatches.size() << " Adressen\n";
+    std::cout << "✓ Scan abgeschlossen! Gefunden: " << session.matchCount() << " Adressen\n";
+    printScanSummary(scanner);
     session.displayMatches();
 }
 
 template<typename T>
 void performNextScan(MemoryScanner& scanner, ScanSession<T>& session) {
-    if (!session.hasInitialScan || session.currentMatches.empty()) {
+    if (!session.hasInitialScan || session.matchCount() == 0) {
         std::cout << "Führen Sie zuerst einen ersten Scan durch!\n";
         return;
     }
 
     std::cout << "\n=== Nächster Scan (exakter Wert) ===\n";
-    std::cout << "Geben Sie den neuen Wert ein: ";
+    std::cout << "Geben Sie den neuen Wert ein (mehrere mit Komma): ";
 
-    T value;
-    std::cin >> value;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::vector<T> values;
+    std::string text;
+    if (!readValueList(values, text)) {
+        std::cout << "Ungültiger Wert.\n";
+        return;
+    }
 
     std::cout << "Filtere Ergebnisse...\n";
-    session.currentMatches = scanner.filterByValue(session.currentMatches, value);
+    {
+        // One recorded operation over all history shards
+        auto operation = scanner.scanOperation(values.size() == 1 ? "filterByValue" : "filterByValueSet");
+        ValueSet<T> set(values);
+        std::string error;
+        if (!session.history.applyFilter([&](const auto& shard) {
+            if (values.size() == 1) return scanner.filterByValue(shard, values[0]);
+            return scanner.filterByValueSet(shard, set);
+        }, (values.size() == 1 ? "Exakter Wert = " : "Exakter Wert in ") + text, error)) {
+            std::cout << "✗ Filter fehlgeschlagen: " << error << "\n";
+            return;
+        }
+    }
 
-    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.currentMatches.size() << " Adressen\n";
+    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.matchCount() << " Adressen\n";
+    printScanSummary(scanner);
     session.displayMatches();
 }
 
 template<typename T>
 void performChangedScan(MemoryScanner& scanner, ScanSession<T>& session) {
-    if (!session.hasInitialScan || session.currentMatches.empty()) {
+    if (!session.hasInitialScan || session.matchCount() == 0) {
         std::cout << "Führen Sie zuerst einen ersten Scan durch!\n";
         return;
     }
@@ -158,15 +287,25 @@ void performChangedScan(MemoryScanner& scanner, ScanSession<T>& session) {
     std::cout << "\n=== Scan nach geänderten Werten ===\n";
     std::cout << "Filtere Adressen mit geänderten Werten...\n";
 
-    session.currentMatches = scanner.filterByChanged(session.currentMatches);
+    {
+        auto operation = scanner.scanOperation("filterByChanged");
+        std::string error;
+        if (!session.history.applyFilter([&](const auto& shard) {
+            return scanner.filterByChanged(shard);
+        }, "Geändert", error)) {
+            std::cout << "✗ Filter fehlgeschlagen: " << error << "\n";
+            return;
+        }
+    }
 
-    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.currentMatches.size() << " Adressen\n";
+    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.matchCount() << " Adressen\n";
+    printScanSummary(scanner);
     session.displayMatches();
 }
 
 template<typename T>
 void performUnchangedScan(MemoryScanner& scanner, ScanSession<T>& session) {
-    if (!session.hasInitialScan || session.currentMatches.empty()) {
+    if (!session.hasInitialScan || session.matchCount() == 0) {
         std::cout << "Führen Sie zuerst einen ersten Scan durch!\n";
         return;
     }
@@ -174,9 +313,19 @@ void performUnchangedScan(MemoryScanner& scanner, ScanSession<T>& session) {
     std::cout << "\n=== Scan nach ungeänderten Werten ===\n";
     std::cout << "Filtere Adressen mit ungeänderten Werten...\n";
 
-    session.currentMatches = scanner.filterByUnchanged(session.currentMatches);
+    {
+        auto operation = scanner.scanOperation("filterByUnchanged");
+        std::string error;
+        if (!session.history.applyFilter([&](const auto& shard) {
+            return scanner.filterByUnchanged(shard);
+        }, "Ungeändert", error)) {
+            std::cout << "✗ Filter fehlgeschlagen: " << error << "\n";
+            return;
+        }
+    }
 
-    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.currentMatches.size() << " Adressen\n";
+    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.matchCount() << " Adressen\n";
+    printScanSummary(scanner);
     session.displayMatches();
 }
 
@@ -206,6 +355,47 @@ void writeValueToAddress(MemoryScanner& scanner) {
     }
 }
 
+template<typename T>
+void writeValueToAllMatches(MemoryScanner& scanner, ScanSession<T>& session) {
+    if (!session.hasInitialScan || session.matchCount() == 0) {
+        std::cout << "Führen Sie zuerst einen ersten Scan durch!\n";
+        return;
+    }
+
+    std::cout << "\n=== Wert an alle Adressen schreiben ===\n";
+    std::cout << "Geben Sie den neuen Wert für " << session.matchCount() << " Adressen ein: ";
+    T value;
+    std::cin >> value;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    // One batch for all matches, read back afterwards to catch values the target reverted
+    const auto& matches = session.history.current();
+    WriteBatch batch;
+    batch.reserve(matches.count(), matches.count() * sizeof(T));
+    for (size_t i = 0; i < matches.count(); i++) {
+        const auto* match = matches.at(i);
+        if (!match) {
+            session.reportDamage();
+            return;
+        }
+        batch.addValue(match->address, value);
+    }
+    WriteBatchResult result = batch.submit(scanner, true);
+
+    std::cout << (result.ok() ? "✓ " : "✗ ") << result.written << " von " << batch.size()
+              << " Adressen geschrieben (" << result.syscalls << " Systemaufrufe)\n";
+    if (result.ok()) return;
+
+    std::cout << "  " << result.failed << " fehlgeschlagen, " << result.mismatched << " nicht bestätigt:\n";
+    size_t shown = 0;
+    for (const auto& entry : batch.entries()) {
+        if (entry.status != WriteStatus::FAILED && entry.status != WriteStatus::MISMATCH) continue;
+        std::cout << "  0x" << std::hex << std::setw(16) << std::setfill('0') << entry.address << std::dec
+                  << std::setfill(' ') << (entry.status == WriteStatus::FAILED ? "  Schreiben fehlgeschlagen\n" : "  Wert abweichend\n");
+        if (++shown == 10) break;
+    }
+}
+
 template<typename T>
 void readValueFromAddress(MemoryScanner& scanner) {
     std::cout << "\n=== Wert lesen ===\n";
@@ -229,6 +419,262 @@ void readValueFromAddress(MemoryScanner& scanner) {
     }
 }
 
+void addWatchEntry(WatchList& watchList) {
+    std::cout << "\n=== Adresse beobachten / einfrieren ===\n";
+    std::cout << "Geben Sie die Adresse ein (hex, z.B. 0x12345678): ";
+
+    std::string addrStr;
+    std::cin >> addrStr;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    uintptr_t address;
+    std::stringstream ss;
+    ss << std::hex << addrStr;
+    ss >> address;
+
+    std::cout << "Wert zum Einfrieren (leer = nur beobachten): ";
+    std::string input;
+    std::getline(std::cin, input);
+
+    if (input.empty()) {
+        watchList.addWatch(address, ScanValueType::INT32, sizeof(int32_t), kWatchIntervalMs);
+        std::cout << "✓ Adresse wird beobachtet.\n";
+        return;
+    }
+
+    std::vector<uint8_t> value;
+    if (!parseScanValue(ScanValueType::INT32, input, value)) {
+        std::cout << "✗ Ungültiger Wert.\n";
+        return;
+    }
+    watchList.addFreeze(address, ScanValueType::INT32, std::move(value), kFreezeIntervalMs);
+    std::cout << "✓ Adresse eingefroren.\n";
+}
+
+void displayWatchList(WatchList& watchList) {
+    const WatchSnapshot& snapshot = watchList.acquireSnapshot();
+    if (snapshot.values.empty()) {
+        std::cout << "Die Watchlist ist leer.\n";
+        return;
+    }
+
+    std::cout << "\nWatchlist: " << snapshot.values.size() << " Einträge\n";
+    std::cout << std::string(60, '-') << "\n";
+    std::cout << std::setw(4) << "Nr" << " | " << std::setw(18) << "Adresse" << " | "
+              << std::setw(12) << "Wert" << " | " << "Modus\n";
+    std::cout << std::string(60, '-') << "\n";
+
+    char text[512];
+    for (size_t i = 0; i < snapshot.values.size(); i++) {
+        const WatchValue& value = snapshot.values[i];
+        std::string address(text, formatHexAddress(value.address, text));
+        std::string current = value.valid
+            ? std::string(text, formatScanValue(value.type, &snapshot.bytes[value.offset], value.size, text, sizeof(text)))
+            : std::string("??");
+        std::cout << std::setw(4) << i + 1 << " | " << address << " | "
+                  << std::setw(12) << current << " | "
+                  << (value.mode == WatchMode::FREEZE ? "eingefroren" : "beobachtet") << "\n";
+    }
+    std::cout << std::string(60, '-') << "\n";
+}
+
+void removeWatchEntry(WatchList& watchList) {
+    displayWatchList(watchList);
+
+    const WatchSnapshot& snapshot = watchList.acquireSnapshot();
+    if (snapshot.values.empty()) {
+        return;
+    }
+
+    std::cout << "Welchen Eintrag entfernen (Nummer)? ";
+    size_t choice;
+    std::cin >> choice;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    if (choice < 1 || choice > snapshot.values.size()) {
+        std::cout << "Ungültige Auswahl.\n";
+        return;
+    }
+
+    watchList.remove(snapshot.values[choice - 1].id);
+    std::cout << "✓ Eintrag entfernt.\n";
+}
+
+void performGroupScan(MemoryScanner& scanner, ScanSession<int32_t>& session) {
+    std::cout << "\n=== Gruppen-Scan ===\n";
+    std::cout << "Format: [typ:][op]wert[@offset][~bereich]; ...  (typ: i32 i64 f32 f64 str wstr)\n";
+    std::cout << "Beispiel: i32:100@0; i32:100@4; i32:1..999@8~56\n";
+    std::cout << "Gruppe: ";
+
+    std::string input;
+    std::getline(std::cin, input);
+
+    std::vector<GroupScanTerm> terms;
+    if (!parseGroupScan(input, terms)) {
+        std::cout << "✗ Ungültige Gruppenbeschreibung.\n";
+        return;
+    }
+    if (selectGroupAnchor(terms) == terms.size()) {
+        std::cout << "✗ Mindestens ein exakter Wert an festem Offset wird benötigt.\n";
+        return;
+    }
+
+    std::cout << "Scanne Speicher...\n";
+    auto matches = scanner.scanForGroup(terms);
+    std::cout << "✓ Scan abgeschlossen! Gefunden: " << matches.size() << " Gruppen\n";
+    printScanSummary(scanner);
+
+    char text[32];
+    for (size_t i = 0; i < std::min<size_t>(matches.size(), 20); i++) {
+        std::cout << std::string(text, formatHexAddress(matches[i].address, text)) << " |";
+        for (uintptr_t address : matches[i].termAddresses) {
+            std::cout << " +" << std::hex << (address - matches[i].address) << std::dec;
+        }
+        std::cout << "\n";
+    }
+
+    // Group bases become the current matches so int32 groups can be narrowed further
+    if (terms[0].type == ScanValueType::INT32) {
+        std::vector<MemoryMatch<int32_t>> groupMatches;
+        for (const auto& match : matches) {
+            int32_t value;
+            if (scanner.readValue(match.termAddresses[0], value)) {
+                groupMatches.push_back({ match.termAddresses[0], value });
+            }
+        }
+        session.history.reset(std::move(groupMatches), "Gruppen-Scan");
+        session.hasInitialScan = true;
+        std::cout << "Adressen des ersten Werts wurden als aktuelle Treffer übernommen.\n";
+    }
+}
+
+void performRateScan(MemoryScanner& scanner, ScanSession<int32_t>& session) {
+    if (!session.hasInitialScan || session.matchCount() == 0) {
+        std::cout << "Führen Sie zuerst einen ersten Scan durch!\n";
+        return;
+    }
+
+    std::cout << "\n=== Änderungsfrequenz messen ===\n";
+    std::cout << "Dauer in Sekunden (Enter = 5): ";
+    std::string input;
+    std::getline(std::cin, input);
+    int seconds = input.empty() ? 5 : std::max(1, std::atoi(input.c_str()));
+
+    std::cout << "Intervall in ms (Enter = 1): ";
+    std::getline(std::cin, input);
+    int intervalMs = input.empty() ? 1 : std::max(0, std::atoi(input.c_str()));
+
+    std::cout << "Änderungen pro Sekunde, z.B. 55-65 (Enter = nur anzeigen): ";
+    std::getline(std::cin, input);
+    double minRate = 0, maxRate = 0;
+    bool filter = !input.empty();
+    if (filter && std::sscanf(input.c_str(), "%lf-%lf", &minRate, &maxRate) != 2) {
+        std::cout << "✗ Ungültiger Bereich.\n";
+        return;
+    }
+
+    const auto& matches = session.history.current();
+    ChangeSampler sampler(scanner, ScanValueType::INT32, sizeof(int32_t));
+    for (size_t i = 0; i < matches.count(); i++) {
+        const auto* match = matches.at(i);
+        if (!match) {
+            session.reportDamage();
+            return;
+        }
+        if (!sampler.addAddress(match->address)) {
+            std::cout << "✗ Zu viele Adressen für das Sampling (max. " << kMaxSampleSlots << ").\n";
+            return;
+        }
+    }
+
+    std::cout << "Sample " << sampler.size() << " Adressen für " << seconds << " s...\n";
+    SampleRunStats run = sampler.sample(std::chrono::seconds(seconds), std::chrono::milliseconds(intervalMs));
+    std::cout << "✓ " << run.samples << " Durchläufe in " << std::fixed << std::setprecision(2) << run.seconds
+              << " s (" << run.samples / std::max(run.seconds, 0.001) << " pro Sekunde)\n" << std::defaultfloat;
+
+    auto ranked = filter ? sampler.rankByRate(minRate, maxRate) : sampler.rankByRate();
+    std::cout << std::string(60, '-') << "\n";
+    std::cout << std::setw(18) << "Adresse" << " | " << std::setw(8) << "pro s" << " | "
+              << std::setw(11) << "Min" << " | " << std::setw(11) << "Max\n";
+    std::cout << std::string(60, '-') << "\n";
+    char text[32];
+    for (size_t i = 0; i < std::min<size_t>(ranked.size(), 20); i++) {
+        size_t slot = ranked[i];
+        int32_t low, high;
+        std::memcpy(&low, sampler.minValue(slot), sizeof(low));
+        std::memcpy(&high, sampler.maxValue(slot), sizeof(high));
+        std::cout << std::string(text, formatHexAddress(sampler.address(slot), text)) << " | "
+                  << std::setw(8) << std::fixed << std::setprecision(1) << sampler.changesPerSecond(slot)
+                  << std::defaultfloat << " | " << std::setw(11) << low << " | " << std::setw(11) << high << "\n";
+    }
+    std::cout << std::string(60, '-') << "\n";
+    if (!filter) return;
+
+    // Slots follow the match order, so the kept slots are an ascending address list
+    std::vector<std::pair<uintptr_t, int32_t>> kept;
+    kept.reserve(ranked.size());
+    for (size_t slot : ranked) {
+        int32_t value;
+        std::memcpy(&value, sampler.lastValue(slot), sizeof(value));
+        kept.push_back({ sampler.address(slot), value });
+    }
+    std::ranges::sort(kept);
+
+    std::string error;
+    if (!session.history.applyFilter([&](const auto& shard) {
+        std::vector<MemoryMatch<int32_t>> result;
+        for (const auto& match : shard) {
+            auto it = std::ranges::lower_bound(kept, std::pair<uintptr_t, int32_t>{ match.address, INT32_MIN });
+            if (it != kept.end() && it->first == match.address) result.push_back({ match.address, it->second });
+        }
+        return result;
+    }, "Änderungsrate " + input + "/s", error)) {
+        std::cout << "✗ Filter fehlgeschlagen: " << error << "\n";
+        return;
+    }
+
+    std::cout << "✓ Verbleibend: " << session.matchCount() << " Adressen\n";
+}
+
+void performExpressionFilter(MemoryScanner& scanner, ScanSession<int32_t>& session) {
+    if (!session.hasInitialScan || session.matchCount() == 0) {
+        std::cout << "Führen Sie zuerst einen ersten Scan durch!\n";
+        return;
+    }
+
+    std::cout << "\n=== Filter-Ausdruck ===\n";
+    std::cout << "Variablen: v (aktuell), old (vorheriger Scan), first (erster Scan)\n";
+    std::cout << "Operatoren: || && == != < <= > >= + - * / % ! abs()\n";
+    std::cout << "Ausdruck: ";
+    std::string input;
+    std::getline(std::cin, input);
+
+    FilterExpression expression;
+    std::string error;
+    if (!expression.compile(input, ScanValueType::INT32, error)) {
+        std::cout << "✗ Ungültiger Ausdruck: " << error << "\n";
+        return;
+    }
+
+    std::cout << "Filtere Ergebnisse...\n";
+    {
+        FirstValueIndex first;
+        bool filtered = !expression.usesFirst() || firstValuesOf(session.history, first, error);
+        auto operation = scanner.scanOperation("filterByExpression");
+        filtered = filtered && session.history.applyFilter([&](const auto& shard) {
+            return filterByExpression(scanner, shard, expression, &first);
+        }, "Ausdruck: " + input, error);
+        if (!filtered) {
+            std::cout << "✗ Filter fehlgeschlagen: " << error << "\n";
+            return;
+        }
+    }
+
+    std::cout << "✓ Scan abgeschlossen! Verbleibend: " << session.matchCount() << " Adressen\n";
+    printScanSummary(scanner);
+    session.displayMatches();
+}
+
 int main() {
     std::cout << "╔═══════════════════════════════════════════════╗\n";
     std::cout << "║  Memory Scanner - CheatEngine für C++        ║\n";
@@ -237,6 +683,8 @@ int main() {
 
     HANDLE hProcess = nullptr;
     MemoryScanner* scanner = nullptr;
+    MemoryScanner* watchScanner = nullptr; // the watch list thread gets its own scanner
+    WatchList* watchList = nullptr;
 
     // For now, we'll work with 4-byte integers (most common for games)
     ScanSession<int32_t> session;
@@ -251,6 +699,10 @@ int main() {
         switch (choice) {
             case 1: {
                 if (hProcess != nullptr) {
+                    delete watchList;
+                    watchList = nullptr;
+                    delete watchScanner;
+                    watchScanner = nullptr;
                     CloseHandle(hProcess);
                     delete scanner;
                     scanner = nullptr;
@@ -258,6 +710,9 @@ int main() {
                 hProcess = selectProcess();
                 if (hProcess != nullptr) {
                     scanner = new MemoryScanner(hProcess);
+                    watchScanner = new MemoryScanner(hProcess, scanner->cache());
+                    watchList = new WatchList(*watchScanner);
+                    watchList->start();
                     session = ScanSession<int32_t>(); // Reset session
                 }
                 break;
@@ -336,8 +791,116 @@ int main() {
                 break;
             }
 
+            case 10: {
+                if (watchList == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                addWatchEntry(*watchList);
+                break;
+            }
+
+            case 11: {
+                if (watchList == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                displayWatchList(*watchList);
+                break;
+            }
+
+            case 12: {
+                if (watchList == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                removeWatchEntry(*watchList);
+                break;
+            }
+
+            case 13: {
+                if (scanner == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                performGroupScan(*scanner, session);
+                break;
+            }
+
+            case 14: {
+                if (session.history.undo()) {
+                    std::cout << "✓ Zurück zu: " << session.history.current().label << "\n";
+                    session.displayMatches();
+                } else {
+                    std::cout << "Nichts zum Rückgängigmachen.\n";
+                }
+                break;
+            }
+
+            case 15: {
+                if (session.history.redo()) {
+                    std::cout << "✓ Wiederhergestellt: " << session.history.current().label << "\n";
+                    session.displayMatches();
+                } else {
+                    std::cout << "Nichts zum Wiederholen.\n";
+                }
+                break;
+            }
+
+            case 16: {
+                session.displayHistory();
+                break;
+            }
+
+            case 17: {
+                if (scanner == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                std::cout << "\n" << formatScanStats(scanner->lastScanStats(), 10);
+                break;
+            }
+
+            case 18: {
+                if (scanner == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                toggleScanTrace(*scanner);
+                break;
+            }
+
+            case 19: {
+                if (scanner == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                writeValueToAllMatches(*scanner, session);
+                break;
+            }
+
+            case 20: {
+                if (scanner == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                performRateScan(*scanner, session);
+                break;
+            }
+
+            case 21: {
+                if (scanner == nullptr) {
+                    std::cout << "Bitte wählen Sie zuerst einen Prozess aus!\n";
+                    break;
+                }
+                performExpressionFilter(*scanner, session);
+                break;
+            }
+
             case 0: {
                 std::cout << "\nBeende Programm...\n";
+                delete watchList;
+                delete watchScanner;
                 if (scanner != nullptr) {
                     delete scanner;
                 }
@@ -0,0 +1,94 @@
+// Headless scanner daemon: serves the JSON-lines protocol of ScanServer on a Unix socket.
+//
+//   memory_scanner_server [--socket PATH] [--memory-budget-mb MB]
+//
+// Example session with the stand-in client:
+//   {"id":1,"cmd":"attach","pid":1234}
+//   {"id":2,"cmd":"scan","type":"int32","value":"100"}
+//   {"id":3,"cmd":"filter","mode":"exact","value":"95"}
+//   {"id":4,"cmd":"filter","mode":"rate","seconds":5,"min_rate":55,"max_rate":65}
+//   {"id":5,"cmd":"filter","mode":"expr","expr":"v > old && (v - old) % 5 == 0"}
+//   {"id":6,"cmd":"results","page_size":100,"live":true}
+//
+// An unknown-value scan with "snapshot":true keeps a compressed copy of memory instead of
+// every value; the next changed/unchanged filter compares against it:
+//   {"id":7,"cmd":"scan","type":"int32","snapshot":true}
+//   {"id":8,"cmd":"filter","mode":"changed"}
+//
+// The scanner's own memory (chunk buffers, results, snapshots) stays within one budget,
+// "memory" reports it per component and "budget_mb" changes it:
+//   {"id":9,"cmd":"memory","budget_mb":512}
+//
+// Named sessions test several hypotheses on one process at once: every name has its own
+// type, history and lock, so clients attached under different names scan in parallel while
+// sharing the process's region cache and chunk buffers:
+//   {"id":10,"cmd":"attach","pid":1234,"session":"health"}
+//   {"id":11,"cmd":"attach","pid":1234,"session":"ammo"}   (from a second client)
+//
+// Values stored big-endian (emulators, network buffers) use the types int32be, int64be,
+// floatbe and doublebe, or "endian":"big" next to any numeric type. Filters, reads,
+// writes and freezes of such a session keep the byte order:
+//   {"id":12,"cmd":"scan","type":"float","endian":"big","value":"1.5"}
+//
+// Polling clients pass "max_age_ms" to "read" and live "results": pages read by this
+// session no longer ago than that are served from its page cache ("status" counts hits):
+//   {"id":13,"cmd":"results","offset":0,"limit":50,"live":true,"max_age_ms":16}
+//
+// "record" samples the current result set (or "ranges":"0xADDR:size,...") into a file at
+// a fixed rate until stopped; "recording" queries the file later, even without the target:
+//   {"id":14,"cmd":"record","op":"start","path":"/tmp/run.msts","interval_us":1000}
+//   {"id":15,"cmd":"record","op":"stop"}
+//   {"id":16,"cmd":"recording","path":"/tmp/run.msts","op":"changes","address":"0x7f001000"}
+//   {"id":17,"cmd":"recording","path":"/tmp/run.msts","op":"filter","expr":"v > old","times":"0,500000,900000"}
+//
+// On glibc targets "heap" restricts scans and filters to live malloc chunks; results then
+// carry "chunk", "chunk_size" and "chunk_offset" of the allocation they lie in:
+//   {"id":18,"cmd":"heap","enabled":true}
+#include "memory_governor.h"
+#include "scan_server.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+ScanServer* g_server = nullptr;
+
+void onSignal(int) {
+    if (g_server) g_server->requestStop();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string socketPath = "/tmp/memory_scanner.sock";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--memory-budget-mb" && i + 1 < argc && std::strtoll(argv[i + 1], nullptr, 10) > 0) {
+            memoryGovernor().setBudget(static_cast<size_t>(std::strtoll(argv[++i], nullptr, 10)) * 1024 * 1024);
+        } else {
+            std::fprintf(stderr, "usage: memory_scanner_server [--socket PATH] [--memory-budget-mb MB]\n");
+            return 2;
+        }
+    }
+
+    ScanServer server(socketPath);
+    std::string error;
+    if (!server.start(error)) {
+        std::fprintf(stderr, "memory_scanner_server: %s\n", error.c_str());
+        return 1;
+    }
+
+    g_server = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::fprintf(stderr, "memory_scanner_server: listening on %s\n", socketPath.c_str());
+    server.run();
+    g_server = nullptr;
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Stand-in client for memory_scanner_server: sends every stdin line as a request and
+// prints every response line to stdout. Exits once the server has answered all requests.
+//
+//   scan_client [--socket PATH] < requests.jsonl
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    std::string socketPath = "/tmp/memory_scanner.sock";
+    if (argc == 3 && std::string(argv[1]) == "--socket") {
+        socketPath = argv[2];
+    } else if (argc != 1) {
+        std::fprintf(stderr, "usage: scan_client [--socket PATH]\n");
+        return 2;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::fprintf(stderr, "scan_client: socket path too long\n");
+        return 2;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::perror("scan_client: connect");
+        return 1;
+    }
+
+    // Responses are printed while requests are still being sent (pipelining)
+    std::thread printer([fd] {
+        char buffer[64 * 1024];
+        ssize_t received;
+        while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            std::fwrite(buffer, 1, static_cast<size_t>(received), stdout);
+            std::fflush(stdout);
+        }
+    });
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        line.push_back('\n');
+        size_t sent = 0;
+        while (sent < line.size()) {
+            ssize_t n = send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += static_cast<size_t>(n);
+        }
+        if (sent < line.size()) break;
+    }
+
+    // The server answers the remaining requests and then closes the connection
+    shutdown(fd, SHUT_WR);
+    printer.join();
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "block_codec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+// No match reaches into the last bytes of a block, they always end as literals
+constexpr size_t kLastLiterals = 5;
+constexpr int kHashBits = 12;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hash4(uint32_t value) {
+    return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+// Length bytes after a token nibble of 15
+bool putLength(uint8_t*& op, const uint8_t* end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (op == end) return false;
+        *op++ = 255;
+    }
+    if (op == end) return false;
+    *op++ = static_cast<uint8_t>(length);
+    return true;
+}
+
+bool getLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (ip == end) return false;
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// One sequence; matchLength 0 writes the last sequence (literals only)
+bool putSequence(uint8_t*& op, const uint8_t* end, const uint8_t* literals, size_t literalLength,
+                 size_t offset, size_t matchLength) {
+    if (op == end) return false;
+    uint8_t* token = op++;
+    uint8_t literalNibble = static_cast<uint8_t>(std::min<size_t>(literalLength, 15));
+    if (literalLength >= 15 && !putLength(op, end, literalLength - 15)) return false;
+    if (static_cast<size_t>(end - op) < literalLength) return false;
+    if (literalLength != 0) std::memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    uint8_t matchNibble = 0;
+    if (matchLength != 0) {
+        if (end - op < 2) return false;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        size_t extra = matchLength - kMinMatch;
+        matchNibble = static_cast<uint8_t>(std::min<size_t>(extra, 15));
+        if (extra >= 15 && !putLength(op, end, extra - 15)) return false;
+    }
+    *token = static_cast<uint8_t>(literalNibble << 4 | matchNibble);
+    return true;
+}
+
+} // namespace
+
+size_t compressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    if (size > kMaxCodecBlock) return 0;
+    uint8_t* op = dst;
+    const uint8_t* outEnd = dst + capacity;
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end = src + size;
+
+    if (size >= kMinMatch + kLastLiterals) {
+        // Positions of the last 4-byte sequences per hash, stale entries fail the compare
+        uint16_t table[1 << kHashBits] = {};
+        const uint8_t* matchLimit = end - kLastLiterals;
+        const uint8_t* searchEnd = matchLimit - kMinMatch;
+
+        while (ip <= searchEnd) {
+            uint32_t sequence = read32(ip);
+            uint32_t hash = hash4(sequence);
+            const uint8_t* ref = src + table[hash];
+            table[hash] = static_cast<uint16_t>(ip - src);
+
+            if (ref < ip && read32(ref) == sequence) {
+                // Grow the match backwards into the pending literals, then forwards
+                while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                    ip--;
+                    ref--;
+                }
+                const uint8_t* matchEnd = ip + kMinMatch;
+                const uint8_t* refEnd = ref + kMinMatch;
+                while (matchEnd < matchLimit && *matchEnd == *refEnd) {
+                    matchEnd++;
+                    refEnd++;
+                }
+                if (!putSequence(op, outEnd, anchor, ip - anchor, ip - ref, matchEnd - ip)) return 0;
+                ip = anchor = matchEnd;
+                continue;
+            }
+            // Step faster the longer nothing matched, incompressible data is skipped quickly
+            ip += 1 + ((ip - anchor) >> 6);
+        }
+    }
+
+    if (!putSequence(op, outEnd, anchor, end - anchor, 0, 0)) return 0;
+    return op - dst;
+}
+
+bool decompressBlock(const uint8_t* src, size_t compressedSize, uint8_t* dst, size_t size) {
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + compressedSize;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + size;
+
+    while (true) {
+        if (ip == ipEnd) return false;
+        uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !getLength(ip, ipEnd, literalLength)) return false;
+        if (literalLength > static_cast<size_t>(ipEnd - ip) || literalLength > static_cast<size_t>(opEnd - op)) return false;
+        if (literalLength != 0) std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == ipEnd) return op == opEnd;
+
+        if (ipEnd - ip < 2) return false;
+        size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !getLength(ip, ipEnd, matchLength)) return false;
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst) || matchLength > static_cast<size_t>(opEnd - op)) return false;
+
+        // Overlapping matches repeat the last offset bytes
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(op, match, matchLength);
+        } else if (offset == 1) {
+            std::memset(op, *match, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; i++) op[i] = match[i];
+        }
+        op += matchLength;
+    }
+}
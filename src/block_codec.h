@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Largest block compressBlock accepts, match offsets are 16 bit
+constexpr size_t kMaxCodecBlock = 64 * 1024;
+
+// Small LZ77 block codec in the spirit of LZ4: literal runs and back references with
+// 16-bit offsets, found through a hash of the next 4 bytes. Built for speed, not ratio,
+// so snapshot pages can be compressed while a scan reads and decoded in front of every
+// compare pass.
+//
+// A block is a list of sequences: a token (literal length << 4 | match length - 4, 15
+// meaning "more length bytes follow"), the literals, then a 2-byte offset. The last
+// sequence ends after its literals.
+
+// Compress size bytes (at most kMaxCodecBlock) into dst. Returns the compressed size, 0 if
+// it would not fit into capacity (the block does not compress).
+size_t compressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+
+// Decode a block into exactly size bytes. False if the block is damaged or decodes to
+// another size.
+bool decompressBlock(const uint8_t* src, size_t compressedSize, uint8_t* dst, size_t size);
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+// Value with its bytes in reverse order, scalar counterpart of swapByteOrder (scan_kernels.h)
+template<typename T>
+T byteSwapValue(T value) {
+    static_assert(std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "4 or 8 byte numbers");
+    if constexpr (sizeof(T) == 4) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+#ifdef _MSC_VER
+        bits = _byteswap_ulong(bits);
+#else
+        bits = __builtin_bswap32(bits);
+#endif
+        std::memcpy(&value, &bits, sizeof(bits));
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+#ifdef _MSC_VER
+        bits = _byteswap_uint64(bits);
+#else
+        bits = __builtin_bswap64(bits);
+#endif
+        std::memcpy(&value, &bits, sizeof(bits));
+    }
+    return value;
+}
+
+// A number stored in the target's byte order, the scanner's value type for big-endian scans.
+// It holds the raw bytes, so scans, filters and history shards work on memory as it is and
+// only comparisons and display convert. Equality and order are those of the host value
+// (0.0 == -0.0, NaN never equal), like for T itself.
+template<typename T>
+struct Swapped {
+    T raw; // the bytes as they are in the target
+
+    static Swapped fromValue(T value) { return { byteSwapValue(value) }; }
+    T value() const { return byteSwapValue(raw); }
+
+    friend bool operator==(const Swapped& a, const Swapped& b) { return a.value() == b.value(); }
+    friend bool operator!=(const Swapped& a, const Swapped& b) { return a.value() != b.value(); }
+    friend bool operator<(const Swapped& a, const Swapped& b) { return a.value() < b.value(); }
+    friend bool operator>(const Swapped& a, const Swapped& b) { return a.value() > b.value(); }
+};
+
+// Host value of a scan value: the value itself, or the converted value of a Swapped<T>
+template<typename T>
+struct NativeValue {
+    using Type = T;
+    static T get(const T& value) { return value; }
+    static T make(T value) { return value; }
+};
+
+template<typename T>
+struct NativeValue<Swapped<T>> {
+    using Type = T;
+    static T get(const Swapped<T>& value) { return value.value(); }
+    static Swapped<T> make(T value) { return Swapped<T>::fromValue(value); }
+};
+
+template<typename T>
+typename NativeValue<T>::Type nativeValue(const T& value) {
+    return NativeValue<T>::get(value);
+}
+
+template<typename T>
+inline constexpr bool isFloatingScanValue = std::is_floating_point_v<typename NativeValue<T>::Type>;
@@ -0,0 +1,226 @@
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "change_sampler.h"
+#include "byte_order.h"
+#include "scan_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+template<typename T>
+void widenRange(uint8_t* min, uint8_t* max, const uint8_t* value) {
+    T low, high, current;
+    std::memcpy(&low, min, sizeof(T));
+    std::memcpy(&high, max, sizeof(T));
+    std::memcpy(&current, value, sizeof(T));
+    if (current < low) std::memcpy(min, value, sizeof(T));
+    if (current > high) std::memcpy(max, value, sizeof(T));
+}
+
+} // namespace
+
+ChangeSampler::ChangeSampler(MemoryScanner& scanner, ScanValueType type, size_t valueSize)
+    : m_scanner(scanner), m_type(type), m_valueSize(valueSize) {
+    switch (type) {
+        case ScanValueType::INT32: m_widen = widenRange<int32_t>; break;
+        case ScanValueType::INT64: m_widen = widenRange<int64_t>; break;
+        case ScanValueType::FLOAT: m_widen = widenRange<float>; break;
+        case ScanValueType::DOUBLE: m_widen = widenRange<double>; break;
+        case ScanValueType::INT32_BE: m_widen = widenRange<Swapped<int32_t>>; break;
+        case ScanValueType::INT64_BE: m_widen = widenRange<Swapped<int64_t>>; break;
+        case ScanValueType::FLOAT_BE: m_widen = widenRange<Swapped<float>>; break;
+        case ScanValueType::DOUBLE_BE: m_widen = widenRange<Swapped<double>>; break;
+        default: break;
+    }
+}
+
+void ChangeSampler::clear() {
+    m_ranges.clear();
+    m_slotCount = 0;
+    m_changes.clear();
+    m_last.clear();
+    m_read.clear();
+    m_min.clear();
+    m_max.clear();
+    m_seconds = 0;
+}
+
+bool ChangeSampler::addSlots(uintptr_t address, size_t slots, size_t stride) {
+    if (m_valueSize == 0 || slots == 0 || slots > kMaxSampleSlots - m_slotCount) return false;
+
+    // An address that continues the spacing of the previous range is merged into it, a
+    // single-slot range takes the spacing of the address that follows it
+    if (!m_ranges.empty() && slots == 1) {
+        Range& last = m_ranges.back();
+        uintptr_t next = last.address + last.slots * last.stride;
+        uintptr_t distance = address - last.address;
+        if (last.slots == 1 && address > last.address && distance <= m_valueSize && m_valueSize % distance == 0) {
+            last.stride = static_cast<size_t>(distance);
+            next = address;
+        }
+        if (address == next) {
+            last.slots++;
+            m_slotCount++;
+            return true;
+        }
+    }
+    m_ranges.push_back({ address, stride, m_slotCount, slots, 0, false });
+    m_slotCount += slots;
+    return true;
+}
+
+bool ChangeSampler::addAddress(uintptr_t address) {
+    return addSlots(address, 1, m_valueSize);
+}
+
+bool ChangeSampler::addRange(uintptr_t address, size_t size, size_t stride) {
+    if (stride == 0) stride = m_valueSize;
+    if (stride == 0 || m_valueSize % stride != 0 || size < m_valueSize) return false;
+    return addSlots(address, (size - m_valueSize) / stride + 1, stride);
+}
+
+SampleRunStats ChangeSampler::sample(std::chrono::milliseconds duration, std::chrono::microseconds interval,
+                                     const std::atomic<bool>* cancel) {
+    using Clock = std::chrono::steady_clock;
+    SampleRunStats stats;
+
+    size_t bytes = 0;
+    for (Range& range : m_ranges) {
+        range.offset = bytes;
+        range.seen = false;
+        bytes += range.bytes(m_valueSize);
+    }
+    m_changes.assign(m_slotCount, 0);
+    m_last.assign(bytes, 0);
+    m_read.assign(bytes, 0);
+    if (m_widen) {
+        m_min.assign(m_slotCount * m_valueSize, 0);
+        m_max.assign(m_slotCount * m_valueSize, 0);
+    }
+    m_seconds = 0;
+    if (m_slotCount == 0) return stats;
+
+    // Every range reads straight into its part of the round buffer
+    std::vector<MemoryIoRequest> requests(m_ranges.size());
+    for (size_t i = 0; i < m_ranges.size(); i++) {
+        const Range& range = m_ranges[i];
+        requests[i] = { range.address, &m_read[range.offset], range.bytes(m_valueSize), false };
+    }
+
+    const auto start = Clock::now();
+    auto due = start;
+    auto last = start;
+    while (true) {
+        for (auto& request : requests) request.success = false;
+        m_scanner.readMemoryBatch(requests);
+
+        for (size_t i = 0; i < m_ranges.size(); i++) {
+            Range& range = m_ranges[i];
+            if (!requests[i].success) {
+                stats.failedReads++;
+                continue;
+            }
+
+            uint8_t* previous = &m_last[range.offset];
+            const uint8_t* current = &m_read[range.offset];
+            if (!range.seen) {
+                range.seen = true;
+                std::memcpy(previous, current, range.bytes(m_valueSize));
+                if (m_widen) {
+                    for (size_t local = 0; local < range.slots; local++) {
+                        size_t at = (range.firstSlot + local) * m_valueSize;
+                        std::memcpy(&m_min[at], current + local * range.stride, m_valueSize);
+                        std::memcpy(&m_max[at], current + local * range.stride, m_valueSize);
+                    }
+                }
+                continue;
+            }
+
+            // The range is compared in stride-sized units. A changed unit changes every slot
+            // that covers it, slots are counted once per round.
+            const size_t unitsPerValue = m_valueSize / range.stride;
+            const size_t units = range.slots - 1 + unitsPerValue;
+            size_t nextSlot = 0;
+            forEachChangedSlot(previous, current, units, range.stride, [&](size_t unit) {
+                std::memcpy(previous + unit * range.stride, current + unit * range.stride, range.stride);
+                size_t first = std::max(nextSlot, unit + 1 >= unitsPerValue ? unit + 1 - unitsPerValue : 0);
+                size_t end = std::min(unit + 1, range.slots);
+                for (size_t local = first; local < end; local++) {
+                    size_t slot = range.firstSlot + local;
+                    if (m_changes[slot] != UINT16_MAX) m_changes[slot]++;
+                    if (m_widen) {
+                        size_t at = slot * m_valueSize;
+                        m_widen(&m_min[at], &m_max[at], current + local * range.stride);
+                    }
+                }
+                nextSlot = std::max(nextSlot, end);
+            });
+        }
+
+        stats.samples++;
+        last = Clock::now();
+        if (last - start >= duration || (cancel && cancel->load())) break;
+
+        // Fixed rate: a late round does not shift the ones after it
+        due += interval;
+        if (due > last) std::this_thread::sleep_until(due);
+        else due = last;
+    }
+
+    m_seconds = std::chrono::duration<double>(last - start).count();
+    stats.seconds = m_seconds;
+    return stats;
+}
+
+size_t ChangeSampler::rangeOf(size_t slot) const {
+    auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), slot, [](size_t value, const Range& range) {
+        return value < range.firstSlot;
+    });
+    return static_cast<size_t>(it - m_ranges.begin()) - 1;
+}
+
+uintptr_t ChangeSampler::address(size_t slot) const {
+    const Range& range = m_ranges[rangeOf(slot)];
+    return range.address + (slot - range.firstSlot) * range.stride;
+}
+
+bool ChangeSampler::valid(size_t slot) const {
+    return m_ranges[rangeOf(slot)].seen;
+}
+
+double ChangeSampler::changesPerSecond(size_t slot) const {
+    return m_seconds > 0 ? m_changes[slot] / m_seconds : 0;
+}
+
+const uint8_t* ChangeSampler::lastValue(size_t slot) const {
+    const Range& range = m_ranges[rangeOf(slot)];
+    return &m_last[range.offset + (slot - range.firstSlot) * range.stride];
+}
+
+const uint8_t* ChangeSampler::minValue(size_t slot) const {
+    return m_widen ? &m_min[slot * m_valueSize] : lastValue(slot);
+}
+
+const uint8_t* ChangeSampler::maxValue(size_t slot) const {
+    return m_widen ? &m_max[slot * m_valueSize] : lastValue(slot);
+}
+
+std::vector<size_t> ChangeSampler::rankByRate(double minRate, double maxRate) const {
+    std::vector<size_t> slots;
+    if (m_changes.size() != m_slotCount) return slots;
+
+    for (const Range& range : m_ranges) {
+        if (!range.seen) continue;
+        for (size_t slot = range.firstSlot; slot < range.firstSlot + range.slots; slot++) {
+            double rate = changesPerSecond(slot);
+            if (rate >= minRate && rate <= maxRate) slots.push_back(slot);
+        }
+    }
+    std::stable_sort(slots.begin(), slots.end(), [&](size_t a, size_t b) {
+        return m_changes[a] > m_changes[b];
+    });
+    return slots;
+}
+#endif
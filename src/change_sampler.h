@@ -0,0 +1,98 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "memory_scanner.h"
+#include "scan_value_type.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Slots one sampler may hold. A slot costs 2 * value size + 2 bytes for its counters plus
+// two copies of the bytes between it and the next slot.
+constexpr size_t kMaxSampleSlots = 16 * 1024 * 1024;
+
+// Outcome of one sampling run
+struct SampleRunStats {
+    uint32_t samples = 0;     // read rounds taken
+    double seconds = 0;       // between the first and the last round
+    uint64_t failedReads = 0; // range reads that failed in some round
+};
+
+// Change-frequency sampler: re-reads a candidate set or whole ranges at a fixed rate and
+// counts per slot how often the value changed, plus the smallest and largest value seen.
+// Slots can then be ranked or filtered by changes per second (a per-frame counter changes
+// about 60 times per second, a health value almost never).
+// Every round is one batched read; consecutive rounds are compared 16 bytes at a time and
+// only the slots that changed are touched.
+class ChangeSampler {
+public:
+    ChangeSampler(MemoryScanner& scanner, ScanValueType type, size_t valueSize);
+
+    // Sample the value at address. Addresses should come in ascending order (like a result
+    // set): evenly spaced neighbours share one range, also overlapping ones (an unknown
+    // value scan has a candidate at every byte).
+    bool addAddress(uintptr_t address);
+
+    // Sample every value in [address, address + size) that starts at a multiple of stride.
+    // stride must divide the value size, 0 means the value size.
+    bool addRange(uintptr_t address, size_t size, size_t stride = 0);
+
+    size_t size() const { return m_slotCount; }
+    void clear();
+
+    // Read all slots every interval until duration has passed (blocking). A round that takes
+    // longer than interval is followed by the next one right away. Counters of a previous
+    // run are reset. cancel stops the run after the current round.
+    SampleRunStats sample(std::chrono::milliseconds duration, std::chrono::microseconds interval,
+                          const std::atomic<bool>* cancel = nullptr);
+
+    uintptr_t address(size_t slot) const;
+    // False if no round could read the slot
+    bool valid(size_t slot) const;
+    uint32_t changes(size_t slot) const { return m_changes[slot]; }
+    double changesPerSecond(size_t slot) const;
+
+    // valueSize bytes each. Strings have no order, their min and max are the last value.
+    const uint8_t* lastValue(size_t slot) const;
+    const uint8_t* minValue(size_t slot) const;
+    const uint8_t* maxValue(size_t slot) const;
+
+    // Valid slots changing minRate..maxRate times per second, most active first
+    std::vector<size_t> rankByRate(double minRate = 0, double maxRate = std::numeric_limits<double>::infinity()) const;
+
+    ScanValueType type() const { return m_type; }
+    size_t valueSize() const { return m_valueSize; }
+
+private:
+    // Evenly spaced slots read with one request
+    struct Range {
+        uintptr_t address;
+        size_t stride;    // distance between slots, divides the value size
+        size_t firstSlot;
+        size_t slots;
+        size_t offset;    // of the range bytes in m_last and m_read, set by sample()
+        bool seen;        // read at least once in this run
+
+        size_t bytes(size_t valueSize) const { return (slots - 1) * stride + valueSize; }
+    };
+
+    MemoryScanner& m_scanner;
+    ScanValueType m_type;
+    size_t m_valueSize;
+    void (*m_widen)(uint8_t* min, uint8_t* max, const uint8_t* value) = nullptr; // numeric types only
+
+    std::vector<Range> m_ranges;
+    size_t m_slotCount = 0;
+    std::vector<uint16_t> m_changes; // saturating
+    std::vector<uint8_t> m_last;     // range bytes of the previous round
+    std::vector<uint8_t> m_read;     // range bytes of the current round
+    std::vector<uint8_t> m_min;      // valueSize bytes per slot
+    std::vector<uint8_t> m_max;
+    double m_seconds = 0;
+
+    bool addSlots(uintptr_t address, size_t slots, size_t stride);
+    size_t rangeOf(size_t slot) const;
+};
+#endif
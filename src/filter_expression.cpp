@@ -0,0 +1,350 @@
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "filter_expression.h"
+#include "scan_kernels.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <initializer_list>
+#include <utility>
+
+namespace {
+
+bool isIntegerType(ScanValueType type) {
+    type = nativeScanValueType(type);
+    return type == ScanValueType::INT32 || type == ScanValueType::INT64;
+}
+
+// Integer arithmetic wraps instead of overflowing
+template<typename N>
+N addValues(N a, N b) {
+    if constexpr (std::is_integral_v<N>) return static_cast<N>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+    else return a + b;
+}
+
+template<typename N>
+N subValues(N a, N b) {
+    if constexpr (std::is_integral_v<N>) return static_cast<N>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+    else return a - b;
+}
+
+template<typename N>
+N mulValues(N a, N b) {
+    if constexpr (std::is_integral_v<N>) return static_cast<N>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+    else return a * b;
+}
+
+template<typename N>
+N divValues(N a, N b) {
+    if constexpr (std::is_integral_v<N>) {
+        if (b == 0) return 0;
+        if (b == -1) return subValues<N>(0, a);
+        return a / b;
+    } else {
+        return a / b;
+    }
+}
+
+template<typename N>
+N modValues(N a, N b) {
+    if constexpr (std::is_integral_v<N>) return b == 0 || b == -1 ? 0 : a % b;
+    else return std::fmod(a, b);
+}
+
+template<typename N>
+N absValue(N a) {
+    if constexpr (std::is_integral_v<N>) return a < 0 ? subValues<N>(0, a) : a;
+    else return std::fabs(a);
+}
+
+// Widen n values of type S starting at row base into out
+template<typename S, typename N>
+void loadColumn(const uint8_t* column, size_t base, size_t n, N* out) {
+    for (size_t i = 0; i < n; i++) {
+        S value;
+        std::memcpy(&value, column + (base + i) * sizeof(S), sizeof(S));
+        out[i] = static_cast<N>(value);
+    }
+}
+
+template<typename N>
+void loadColumn(ScanValueType type, const uint8_t* column, size_t base, size_t n, N* out) {
+    switch (type) {
+        case ScanValueType::INT32: loadColumn<int32_t>(column, base, n, out); break;
+        case ScanValueType::INT64: loadColumn<int64_t>(column, base, n, out); break;
+        case ScanValueType::FLOAT: loadColumn<float>(column, base, n, out); break;
+        case ScanValueType::DOUBLE: loadColumn<double>(column, base, n, out); break;
+        case ScanValueType::INT32_BE: case ScanValueType::INT64_BE:
+        case ScanValueType::FLOAT_BE: case ScanValueType::DOUBLE_BE: {
+            // Swap the batch into host order with the SIMD kernel, then widen it as usual
+            alignas(16) uint8_t swapped[kExpressionBatch * 8];
+            const size_t width = scanValueTypeSize(type);
+            swapByteOrder(column + base * width, swapped, n, width);
+            loadColumn(nativeScanValueType(type), swapped, 0, n, out);
+            break;
+        }
+        default: std::fill(out, out + n, N{}); break;
+    }
+}
+
+} // namespace
+
+// Recursive descent parser that emits code while it parses. Every rule leaves its result
+// in the register it is given and may use the registers above it.
+class FilterExpression::Parser {
+public:
+    Parser(FilterExpression& expression, std::string& error) : m_expression(expression), m_error(error) {}
+
+    bool parse() {
+        skipSpace();
+        if (!parseOr(0)) return false;
+        if (m_pos != text().size()) return fail("unexpected '" + std::string(1, text()[m_pos]) + "'");
+        return true;
+    }
+
+private:
+    FilterExpression& m_expression;
+    std::string& m_error;
+    size_t m_pos = 0;
+    size_t m_depth = 0;
+
+    const std::string& text() const { return m_expression.m_text; }
+
+    bool fail(const std::string& message) {
+        m_error = message + " at position " + std::to_string(m_pos + 1);
+        return false;
+    }
+
+    void skipSpace() {
+        while (m_pos < text().size() && std::isspace(static_cast<unsigned char>(text()[m_pos]))) m_pos++;
+    }
+
+    // Consume op if the text continues with it (and not with a longer operator)
+    bool accept(std::string_view op) {
+        if (text().compare(m_pos, op.size(), op) != 0) return false;
+        if (op.size() == 1 && (op == "<" || op == ">" || op == "!") && m_pos + 1 < text().size() && text()[m_pos + 1] == '=') {
+            return false;
+        }
+        m_pos += op.size();
+        skipSpace();
+        return true;
+    }
+
+    // Parse a nested rule; the depth is bounded so hostile input cannot exhaust the stack
+    bool parseNested(size_t reg, bool (Parser::*rule)(size_t)) {
+        if (m_depth == kMaxExpressionDepth) return fail("expression nested too deeply");
+        m_depth++;
+        bool parsed = (this->*rule)(reg);
+        m_depth--;
+        return parsed;
+    }
+
+    bool emit(Op op, size_t dst, size_t a = 0, size_t b = 0) {
+        if (dst >= kMaxExpressionRegisters || b >= kMaxExpressionRegisters) return fail("expression nested too deep");
+        m_expression.m_code.push_back({ op, static_cast<uint8_t>(dst), static_cast<uint8_t>(a), static_cast<uint8_t>(b) });
+        m_expression.m_registers = std::max(m_expression.m_registers, std::max(dst, b) + 1);
+        return true;
+    }
+
+    // Left-associative binary level: operand (op operand)*
+    template<typename Next>
+    bool parseBinary(size_t reg, std::initializer_list<std::pair<std::string_view, Op>> ops, Next next) {
+        if (!(this->*next)(reg)) return false;
+        while (true) {
+            const std::pair<std::string_view, Op>* matched = nullptr;
+            for (const auto& op : ops) {
+                if (accept(op.first)) {
+                    matched = &op;
+                    break;
+                }
+            }
+            if (!matched) return true;
+            if (!(this->*next)(reg + 1) || !emit(matched->second, reg, reg, reg + 1)) return false;
+        }
+    }
+
+    bool parseOr(size_t reg) { return parseBinary(reg, { { "||", Op::OR } }, &Parser::parseAnd); }
+    bool parseAnd(size_t reg) { return parseBinary(reg, { { "&&", Op::AND } }, &Parser::parseEquality); }
+    bool parseEquality(size_t reg) {
+        return parseBinary(reg, { { "==", Op::EQ }, { "!=", Op::NE } }, &Parser::parseRelation);
+    }
+    bool parseRelation(size_t reg) {
+        return parseBinary(reg, { { "<=", Op::LE }, { ">=", Op::GE }, { "<", Op::LT }, { ">", Op::GT } }, &Parser::parseSum);
+    }
+    bool parseSum(size_t reg) { return parseBinary(reg, { { "+", Op::ADD }, { "-", Op::SUB } }, &Parser::parseProduct); }
+    bool parseProduct(size_t reg) {
+        return parseBinary(reg, { { "*", Op::MUL }, { "/", Op::DIV }, { "%", Op::MOD } }, &Parser::parseUnary);
+    }
+
+    bool parseUnary(size_t reg) {
+        if (accept("-")) return parseNested(reg, &Parser::parseUnary) && emit(Op::NEG, reg, reg);
+        if (accept("!")) return parseNested(reg, &Parser::parseUnary) && emit(Op::NOT, reg, reg);
+        return parsePrimary(reg);
+    }
+
+    bool parsePrimary(size_t reg) {
+        if (m_pos == text().size()) return fail("unexpected end");
+
+        if (accept("(")) {
+            if (!parseNested(reg, &Parser::parseOr)) return false;
+            return accept(")") ? true : fail("missing ')'");
+        }
+
+        char c = text()[m_pos];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') return parseNumber(reg);
+
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = m_pos;
+            while (m_pos < text().size() && (std::isalnum(static_cast<unsigned char>(text()[m_pos])) || text()[m_pos] == '_')) m_pos++;
+            std::string name = text().substr(start, m_pos - start);
+            skipSpace();
+
+            if (name == "v") return emit(Op::LOAD_V, reg);
+            if (name == "old") {
+                m_expression.m_usesOld = true;
+                return emit(Op::LOAD_OLD, reg);
+            }
+            if (name == "first") {
+                m_expression.m_usesFirst = true;
+                return emit(Op::LOAD_FIRST, reg);
+            }
+            if (name == "abs") {
+                if (!accept("(")) return fail("missing '('");
+                if (!parseNested(reg, &Parser::parseOr)) return false;
+                if (!accept(")")) return fail("missing ')'");
+                return emit(Op::ABS, reg, reg);
+            }
+            m_pos = start;
+            return fail("unknown name '" + name + "'");
+        }
+
+        return fail("unexpected '" + std::string(1, c) + "'");
+    }
+
+    bool parseNumber(size_t reg) {
+        const char* start = text().c_str() + m_pos;
+        char* end = nullptr;
+        Constant constant{};
+        errno = 0;
+
+        if (isIntegerType(m_expression.m_type)) {
+            bool hex = start[0] == '0' && (start[1] == 'x' || start[1] == 'X');
+            long long value = std::strtoll(start, &end, hex ? 16 : 10);
+            if (end == start || *end == '.' || *end == 'e' || *end == 'E') return fail("integer constant expected");
+            if (errno == ERANGE) return fail("constant out of range");
+            constant.integer = value;
+            constant.real = static_cast<double>(value);
+        } else {
+            double value = std::strtod(start, &end);
+            if (end == start) return fail("invalid constant");
+            constant.real = value;
+            constant.integer = static_cast<int64_t>(value);
+        }
+        if (std::isalpha(static_cast<unsigned char>(*end)) || *end == '_') {
+            m_pos += end - start;
+            return fail("invalid constant");
+        }
+
+        m_pos += end - start;
+        skipSpace();
+        if (m_expression.m_constants.size() > UINT8_MAX) return fail("too many constants");
+        m_expression.m_constants.push_back(constant);
+        return emit(Op::CONSTANT, reg, m_expression.m_constants.size() - 1);
+    }
+};
+
+bool FilterExpression::compile(std::string_view text, ScanValueType type, std::string& error) {
+    m_text.assign(text);
+    m_type = type;
+    m_usesOld = false;
+    m_usesFirst = false;
+    m_code.clear();
+    m_constants.clear();
+    m_registers = 0;
+
+    if (isStringScanValueType(type)) {
+        error = "expressions filter numeric values only";
+        return false;
+    }
+    Parser parser(*this, error);
+    if (!parser.parse()) {
+        m_code.clear();
+        return false;
+    }
+    return true;
+}
+
+void FilterExpression::evaluate(const uint8_t* v, const uint8_t* old, const uint8_t* first, size_t count, uint8_t* keep) const {
+    if (m_code.empty()) {
+        std::fill(keep, keep + count, uint8_t{0});
+        return;
+    }
+    if (isIntegerType(m_type)) run<int64_t>(v, old, first, count, keep);
+    else run<double>(v, old, first, count, keep);
+}
+
+template<typename N>
+void FilterExpression::run(const uint8_t* v, const uint8_t* old, const uint8_t* first, size_t count, uint8_t* keep) const {
+    std::vector<N> registers(m_registers * kExpressionBatch);
+    auto reg = [&](uint8_t index) { return registers.data() + index * kExpressionBatch; };
+
+    for (size_t base = 0; base < count; base += kExpressionBatch) {
+        const size_t n = std::min(kExpressionBatch, count - base);
+
+        for (const Instruction& instruction : m_code) {
+            N* d = reg(instruction.dst);
+            switch (instruction.op) {
+                case Op::LOAD_V: loadColumn(m_type, v, base, n, d); continue;
+                case Op::LOAD_OLD: loadColumn(m_type, old, base, n, d); continue;
+                case Op::LOAD_FIRST: loadColumn(m_type, first, base, n, d); continue;
+                case Op::CONSTANT: {
+                    const Constant& constant = m_constants[instruction.a];
+                    std::fill(d, d + n, std::is_integral_v<N> ? static_cast<N>(constant.integer) : static_cast<N>(constant.real));
+                    continue;
+                }
+                default: break;
+            }
+
+            const N* a = reg(instruction.a);
+            const N* b = reg(instruction.b);
+            switch (instruction.op) {
+                case Op::NEG: for (size_t i = 0; i < n; i++) d[i] = subValues<N>(0, a[i]); break;
+                case Op::NOT: for (size_t i = 0; i < n; i++) d[i] = a[i] == 0; break;
+                case Op::ABS: for (size_t i = 0; i < n; i++) d[i] = absValue(a[i]); break;
+                case Op::ADD: for (size_t i = 0; i < n; i++) d[i] = addValues(a[i], b[i]); break;
+                case Op::SUB: for (size_t i = 0; i < n; i++) d[i] = subValues(a[i], b[i]); break;
+                case Op::MUL: for (size_t i = 0; i < n; i++) d[i] = mulValues(a[i], b[i]); break;
+                case Op::DIV: for (size_t i = 0; i < n; i++) d[i] = divValues(a[i], b[i]); break;
+                case Op::MOD: for (size_t i = 0; i < n; i++) d[i] = modValues(a[i], b[i]); break;
+                case Op::EQ: for (size_t i = 0; i < n; i++) d[i] = a[i] == b[i]; break;
+                case Op::NE: for (size_t i = 0; i < n; i++) d[i] = a[i] != b[i]; break;
+                case Op::LT: for (size_t i = 0; i < n; i++) d[i] = a[i] < b[i]; break;
+                case Op::LE: for (size_t i = 0; i < n; i++) d[i] = a[i] <= b[i]; break;
+                case Op::GT: for (size_t i = 0; i < n; i++) d[i] = a[i] > b[i]; break;
+                case Op::GE: for (size_t i = 0; i < n; i++) d[i] = a[i] >= b[i]; break;
+                case Op::AND: for (size_t i = 0; i < n; i++) d[i] = (a[i] != 0) & (b[i] != 0); break;
+                case Op::OR: for (size_t i = 0; i < n; i++) d[i] = (a[i] != 0) | (b[i] != 0); break;
+                default: break;
+            }
+        }
+
+        const N* result = reg(0);
+        for (size_t i = 0; i < n; i++) keep[base + i] = result[i] != 0;
+    }
+}
+
+void FirstValueIndex::add(uintptr_t address, const void* value, size_t size) {
+    m_valueSize = size;
+    m_addresses.push_back(address);
+    const auto* bytes = static_cast<const uint8_t*>(value);
+    m_values.insert(m_values.end(), bytes, bytes + size);
+}
+
+const uint8_t* FirstValueIndex::find(uintptr_t address) const {
+    auto it = std::lower_bound(m_addresses.begin(), m_addresses.end(), address);
+    if (it == m_addresses.end() || *it != address) return nullptr;
+    return &m_values[static_cast<size_t>(it - m_addresses.begin()) * m_valueSize];
+}
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "memory_scanner.h"
+#include "scan_history.h"
+#include "scan_value_type.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Rows an expression is evaluated for at once, every register holds one batch
+constexpr size_t kExpressionBatch = 256;
+// Registers (nesting depth) one expression may use
+constexpr size_t kMaxExpressionRegisters = 32;
+// Parentheses, abs() and unary operators one expression may nest, bounds the parser's recursion
+constexpr size_t kMaxExpressionDepth = 256;
+
+// Filter over the current value v, the value of the previous generation old and the value
+// of the first scan first, e.g. "v > old && v < 1000 && (v - old) % 5 == 0".
+// Operators with C precedence: || && == != < <= > >= + - * / % unary - !, parentheses and
+// abs(x). Integer scans compute in 64-bit integers (wrapping, x / 0 and x % 0 are 0),
+// float scans in double. Constants are decimal, 0x hex or (float scans only) floating point.
+//
+// The text compiles to register bytecode; evaluate() runs every instruction as one loop over
+// a batch of rows, so any number of conditions costs one pass over the value columns.
+class FilterExpression {
+public:
+    // Parse and compile text for values of type. Returns false with a message in error.
+    bool compile(std::string_view text, ScanValueType type, std::string& error);
+
+    bool usesOld() const { return m_usesOld; }
+    bool usesFirst() const { return m_usesFirst; }
+    ScanValueType type() const { return m_type; }
+    const std::string& text() const { return m_text; }
+
+    // keep[row] = 1 where the expression is non-zero, for count rows. The columns hold count
+    // values of the scan type back to back; old and first may be null if they are unused.
+    void evaluate(const uint8_t* v, const uint8_t* old, const uint8_t* first, size_t count, uint8_t* keep) const;
+
+private:
+    enum class Op : uint8_t {
+        LOAD_V, LOAD_OLD, LOAD_FIRST, CONSTANT,
+        NEG, NOT, ABS,
+        ADD, SUB, MUL, DIV, MOD,
+        EQ, NE, LT, LE, GT, GE,
+        AND, OR
+    };
+
+    // dst = a op b; CONSTANT loads m_constants[a]
+    struct Instruction {
+        Op op;
+        uint8_t dst;
+        uint8_t a;
+        uint8_t b;
+    };
+
+    // Constants in both representations, evaluate() picks the one of the scan type
+    struct Constant {
+        int64_t integer;
+        double real;
+    };
+
+    class Parser;
+
+    std::string m_text;
+    ScanValueType m_type = ScanValueType::INT32;
+    bool m_usesOld = false;
+    bool m_usesFirst = false;
+    std::vector<Instruction> m_code;
+    std::vector<Constant> m_constants;
+    size_t m_registers = 0;
+
+    template<typename N>
+    void run(const uint8_t* v, const uint8_t* old, const uint8_t* first, size_t count, uint8_t* keep) const;
+};
+
+// First-scan values of the current candidates, the source of the `first` column
+class FirstValueIndex {
+public:
+    // Addresses must be added in ascending order
+    void add(uintptr_t address, const void* value, size_t size);
+
+    // The first value of address, nullptr if it was not in the first scan
+    const uint8_t* find(uintptr_t address) const;
+
+    size_t size() const { return m_addresses.size(); }
+
+private:
+    size_t m_valueSize = 0;
+    std::vector<uintptr_t> m_addresses;
+    std::vector<uint8_t> m_values;
+};
+
+// Row access shared by typed shards and column stores (see result_store.h)
+template<typename T>
+uintptr_t rowAddress(const std::vector<MemoryMatch<T>>& shard, size_t row) { return shard[row].address; }
+template<typename T>
+const void* rowValue(const std::vector<MemoryMatch<T>>& shard, size_t row) { return &shard[row].value; }
+template<typename T>
+size_t rowValueSize(const std::vector<MemoryMatch<T>>&) { return sizeof(T); }
+
+// Values the current candidates had in the first generation, found by walking both
+// generations in address order. False with error set if a spilled shard cannot be read back.
+template<typename T>
+bool firstValuesOf(const ScanHistory<T>& history, FirstValueIndex& index, std::string& error) {
+    index = FirstValueIndex();
+    if (history.empty()) return true;
+    const auto& first = history.generation(0);
+    const auto& current = history.current();
+
+    size_t firstShard = 0;
+    size_t firstRow = 0;
+    auto loadFirst = [&](size_t shard) { return shard < first.shards.size() ? first.shards[shard]->load() : nullptr; };
+    auto firstLoaded = loadFirst(0);
+    if (!firstLoaded && !first.shards.empty()) {
+        error = kUnreadableSpillError;
+        return false;
+    }
+    for (const auto& shard : current.shards) {
+        auto rows = shard->load();
+        if (!rows) {
+            error = kUnreadableSpillError;
+            return false;
+        }
+        for (size_t row = 0; row < rows->size(); row++) {
+            uintptr_t address = rowAddress(*rows, row);
+            while (firstLoaded) {
+                if (firstRow == firstLoaded->size()) {
+                    firstLoaded = loadFirst(++firstShard);
+                    if (!firstLoaded && firstShard < first.shards.size()) {
+                        error = kUnreadableSpillError;
+                        return false;
+                    }
+                    firstRow = 0;
+                    continue;
+                }
+                if (rowAddress(*firstLoaded, firstRow) >= address) break;
+                firstRow++;
+            }
+            if (firstLoaded && rowAddress(*firstLoaded, firstRow) == address) {
+                index.add(address, rowValue(*firstLoaded, firstRow), rowValueSize(*firstLoaded));
+            }
+        }
+    }
+    return true;
+}
+
+// Matches of one shard whose current value passes expression, with their current value.
+// The current values come from one batched read, first may be null if it is unused.
+template<typename T>
+std::vector<MemoryMatch<T>> filterByExpression(MemoryScanner& scanner, const std::vector<MemoryMatch<T>>& shard,
+                                               const FilterExpression& expression, const FirstValueIndex* first) {
+    static_assert(std::is_arithmetic_v<typename NativeValue<T>::Type>, "expressions filter numeric values");
+    const size_t count = shard.size();
+    std::vector<MemoryMatch<T>> kept;
+    if (count == 0) return kept;
+
+    std::vector<T> current(count), old(expression.usesOld() ? count : 0), firstValues(expression.usesFirst() ? count : 0);
+    std::vector<uint8_t> keep(count);
+    std::vector<MemoryIoRequest> requests(count);
+    for (size_t row = 0; row < count; row++) {
+        requests[row] = { shard[row].address, &current[row], sizeof(T), false };
+        if (!old.empty()) old[row] = shard[row].value;
+    }
+    scanner.readMemoryBatch(requests);
+
+    // Rows in memory the heap filter no longer sees as live drop out like unreadable ones
+    scanner.refreshHeapMap();
+    for (size_t row = 0; row < count; row++) {
+        if (!scanner.heapAllows(shard[row].address, sizeof(T))) requests[row].success = false;
+    }
+
+    // Rows without a first value cannot pass
+    if (!firstValues.empty()) {
+        for (size_t row = 0; row < count; row++) {
+            const uint8_t* value = first ? first->find(shard[row].address) : nullptr;
+            if (value) std::memcpy(&firstValues[row], value, sizeof(T));
+            else requests[row].success = false;
+        }
+    }
+
+    auto bytes = [](const std::vector<T>& column) {
+        return column.empty() ? nullptr : reinterpret_cast<const uint8_t*>(column.data());
+    };
+    expression.evaluate(bytes(current), bytes(old), bytes(firstValues), count, keep.data());
+
+    for (size_t row = 0; row < count; row++) {
+        if (keep[row] && requests[row].success) kept.push_back({ shard[row].address, current[row] });
+    }
+    return kept;
+}
+#endif
@@ -0,0 +1,217 @@
+#include "group_scan.h"
+#include "byte_order.h"
+#include "value_format.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace {
+
+template<typename T>
+T loadValue(const uint8_t* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// -1, 0 or 1 like memcmp; NaN compares as unordered (0 is never returned for it)
+template<typename T>
+int compareValues(const uint8_t* a, const uint8_t* b, bool& ordered) {
+    auto x = nativeValue(loadValue<T>(a));
+    auto y = nativeValue(loadValue<T>(b));
+    if constexpr (isFloatingScanValue<T>) {
+        if (std::isnan(x) || std::isnan(y)) {
+            ordered = false;
+            return 1;
+        }
+    }
+    ordered = true;
+    return x < y ? -1 : (y < x ? 1 : 0);
+}
+
+int compareTermValue(const GroupScanTerm& term, const uint8_t* bytes, const std::vector<uint8_t>& operand, bool& ordered) {
+    switch (term.type) {
+        case ScanValueType::INT32: return compareValues<int32_t>(bytes, operand.data(), ordered);
+        case ScanValueType::INT64: return compareValues<int64_t>(bytes, operand.data(), ordered);
+        case ScanValueType::FLOAT: return compareValues<float>(bytes, operand.data(), ordered);
+        case ScanValueType::DOUBLE: return compareValues<double>(bytes, operand.data(), ordered);
+        case ScanValueType::INT32_BE: return compareValues<Swapped<int32_t>>(bytes, operand.data(), ordered);
+        case ScanValueType::INT64_BE: return compareValues<Swapped<int64_t>>(bytes, operand.data(), ordered);
+        case ScanValueType::FLOAT_BE: return compareValues<Swapped<float>>(bytes, operand.data(), ordered);
+        case ScanValueType::DOUBLE_BE: return compareValues<Swapped<double>>(bytes, operand.data(), ordered);
+        default:
+            ordered = true;
+            return std::memcmp(bytes, operand.data(), operand.size());
+    }
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r' || text.back() == '\n')) text.remove_suffix(1);
+    return text;
+}
+
+bool parseInteger(std::string_view text, int64_t& out) {
+    text = trim(text);
+    bool negative = false;
+    if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+        negative = text.front() == '-';
+        text.remove_prefix(1);
+    }
+    int base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        text.remove_prefix(2);
+    }
+    uint64_t value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size()) return false;
+    out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+    return true;
+}
+
+bool parseTerm(std::string_view text, GroupScanTerm& term) {
+    text = trim(text);
+
+    // Optional type prefix
+    size_t colon = text.find(':');
+    if (colon != std::string_view::npos) {
+        std::string_view type = trim(text.substr(0, colon));
+        if (type == "i32") term.type = ScanValueType::INT32;
+        else if (type == "i64") term.type = ScanValueType::INT64;
+        else if (type == "f32") term.type = ScanValueType::FLOAT;
+        else if (type == "f64") term.type = ScanValueType::DOUBLE;
+        else if (type == "i32be") term.type = ScanValueType::INT32_BE;
+        else if (type == "i64be") term.type = ScanValueType::INT64_BE;
+        else if (type == "f32be") term.type = ScanValueType::FLOAT_BE;
+        else if (type == "f64be") term.type = ScanValueType::DOUBLE_BE;
+        else if (type == "str") term.type = ScanValueType::STRING_ASCII;
+        else if (type == "wstr") term.type = ScanValueType::STRING_UNICODE;
+        else return false;
+        text = text.substr(colon + 1);
+    }
+
+    // Position suffixes: ~range and @offset (strings may not contain them)
+    size_t tilde = text.rfind('~');
+    if (tilde != std::string_view::npos) {
+        int64_t range;
+        if (!parseInteger(text.substr(tilde + 1), range) || range < 0) return false;
+        term.range = static_cast<size_t>(range);
+        text = text.substr(0, tilde);
+    }
+    size_t at = text.rfind('@');
+    if (at != std::string_view::npos) {
+        if (!parseInteger(text.substr(at + 1), term.offset)) return false;
+        text = text.substr(0, at);
+    }
+
+    text = trim(text);
+    if (text.substr(0, 2) == "!=") {
+        term.compare = GroupCompare::NOT_EQUAL;
+        text.remove_prefix(2);
+    } else if (!text.empty() && text.front() == '>') {
+        term.compare = GroupCompare::GREATER;
+        text.remove_prefix(1);
+    } else if (!text.empty() && text.front() == '<') {
+        term.compare = GroupCompare::LESS;
+        text.remove_prefix(1);
+    } else if (!text.empty() && text.front() == '=') {
+        text.remove_prefix(1);
+    }
+
+    size_t dots = isStringScanValueType(term.type) ? std::string_view::npos : text.find("..");
+    if (dots != std::string_view::npos) {
+        if (term.compare != GroupCompare::EQUAL) return false;
+        term.compare = GroupCompare::BETWEEN;
+        return parseScanValue(term.type, text.substr(0, dots), term.value) &&
+               parseScanValue(term.type, text.substr(dots + 2), term.upper);
+    }
+
+    return parseScanValue(term.type, isStringScanValueType(term.type) ? text : trim(text), term.value);
+}
+
+} // namespace
+
+size_t groupTermSize(const GroupScanTerm& term) {
+    size_t size = scanValueTypeSize(term.type);
+    return size != 0 ? size : term.value.size();
+}
+
+size_t groupTermAlignment(const GroupScanTerm& term) {
+    size_t size = scanValueTypeSize(term.type);
+    if (term.type == ScanValueType::STRING_UNICODE) return sizeof(wchar_t);
+    return size != 0 ? size : 1;
+}
+
+bool matchGroupTerm(const GroupScanTerm& term, const uint8_t* bytes) {
+    bool ordered;
+    switch (term.compare) {
+        case GroupCompare::EQUAL:
+            return compareTermValue(term, bytes, term.value, ordered) == 0 && ordered;
+        case GroupCompare::NOT_EQUAL:
+            return compareTermValue(term, bytes, term.value, ordered) != 0 || !ordered;
+        case GroupCompare::GREATER:
+            return compareTermValue(term, bytes, term.value, ordered) > 0 && ordered;
+        case GroupCompare::LESS:
+            return compareTermValue(term, bytes, term.value, ordered) < 0 && ordered;
+        case GroupCompare::BETWEEN:
+            return compareTermValue(term, bytes, term.value, ordered) >= 0 && ordered &&
+                   compareTermValue(term, bytes, term.upper, ordered) <= 0 && ordered;
+    }
+    return false;
+}
+
+size_t selectGroupAnchor(const std::vector<GroupScanTerm>& terms) {
+    size_t best = terms.size();
+    int bestScore = -1;
+
+    for (size_t i = 0; i < terms.size(); i++) {
+        const GroupScanTerm& term = terms[i];
+        if (term.compare != GroupCompare::EQUAL || term.range != 0 || term.value.empty()) continue;
+
+        // 0.0 has two encodings and NaN never compares equal, neither works as a byte pattern
+        if (term.type == ScanValueType::FLOAT || term.type == ScanValueType::FLOAT_BE) {
+            float v = loadValue<float>(term.value.data());
+            if (term.type == ScanValueType::FLOAT_BE) v = byteSwapValue(v);
+            if (v == 0.0f || std::isnan(v)) continue;
+        } else if (term.type == ScanValueType::DOUBLE || term.type == ScanValueType::DOUBLE_BE) {
+            double v = loadValue<double>(term.value.data());
+            if (term.type == ScanValueType::DOUBLE_BE) v = byteSwapValue(v);
+            if (v == 0.0 || std::isnan(v)) continue;
+        }
+
+        // Longer patterns are rarer, 0 / 1 / -1 fill most of memory and are poor anchors
+        int score = static_cast<int>(std::min<size_t>(term.value.size(), 64)) * 8;
+        bool smallValue = true, allOnes = true;
+        for (size_t b = 0; b < term.value.size(); b++) {
+            uint8_t expected = b == 0 ? 0x01 : 0x00;
+            smallValue = smallValue && (term.value[b] == 0 || term.value[b] == expected);
+            allOnes = allOnes && term.value[b] == 0xFF;
+        }
+        if (smallValue || allOnes) score -= 24;
+
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+bool parseGroupScan(std::string_view text, std::vector<GroupScanTerm>& out) {
+    out.clear();
+    while (!text.empty()) {
+        size_t separator = text.find(';');
+        std::string_view part = text.substr(0, separator);
+        text = separator == std::string_view::npos ? std::string_view() : text.substr(separator + 1);
+
+        if (trim(part).empty()) continue;
+        GroupScanTerm term;
+        if (!parseTerm(part, term)) return false;
+        out.push_back(std::move(term));
+    }
+    return !out.empty();
+}
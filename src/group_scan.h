@@ -0,0 +1,49 @@
+#pragma once
+#include "scan_value_type.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Comparison applied by a group scan term
+enum class GroupCompare {
+    EQUAL,
+    NOT_EQUAL,
+    GREATER,
+    LESS,
+    BETWEEN
+};
+
+// One field of a grouped (structure) scan
+struct GroupScanTerm {
+    ScanValueType type = ScanValueType::INT32;
+    GroupCompare compare = GroupCompare::EQUAL;
+    std::vector<uint8_t> value; // needle, or lower bound for BETWEEN
+    std::vector<uint8_t> upper; // upper bound for BETWEEN
+    int64_t offset = 0;         // position relative to the group base
+    size_t range = 0;           // 0 = exactly at offset, otherwise anywhere in [offset, offset + range]
+};
+
+// A group hit: base address plus the address at which each term matched
+struct GroupMatch {
+    uintptr_t address;
+    std::vector<uintptr_t> termAddresses;
+};
+
+// Width of the value a term compares, in bytes
+size_t groupTermSize(const GroupScanTerm& term);
+
+// Step between candidate positions of a floating term (natural alignment of numeric values)
+size_t groupTermAlignment(const GroupScanTerm& term);
+
+// Evaluate a term against the value bytes at one position
+bool matchGroupTerm(const GroupScanTerm& term, const uint8_t* bytes);
+
+// Pick the most selective term that can be searched as a plain byte pattern
+// (exact offset, EQUAL, bitwise comparable). Returns terms.size() if there is none.
+size_t selectGroupAnchor(const std::vector<GroupScanTerm>& terms);
+
+// Parse a group description such as "i32:100@0; i32:100@4; i32:>0@8~56".
+// Term syntax: [type:][op]value[@offset][~range] with type i32|i64|f32|f64|str|wstr (the
+// numeric types with a "be" suffix for big-endian values, e.g. i32be), op = (default), !=, >, < or a range "lo..hi". Returns false on a syntax error.
+bool parseGroupScan(std::string_view text, std::vector<GroupScanTerm>& out);
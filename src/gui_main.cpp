@@ -3,12 +3,23 @@
 #define _UNICODE
 #include "process_utils.h"
 #include "memory_scanner.h"
+#include "result_store.h"
+#include "result_view_model.h"
+#include "scan_history.h"
+#include "scan_value_type.h"
+#include "value_format.h"
+#include "watch_list.h"
+#include "write_batch.h"
 #include <windows.h>
 #include <commctrl.h>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 
 #pragma comment(lib, "comctl32.lib")
 
@@ -31,16 +42,26 @@
 #define IDC_BTN_REFRESH 1016
 #define IDC_BTN_MODULES 1017
 #define IDC_PROCESS_LABEL 1018
-
-// Scan value types
-enum class ScanValueType {
-    INT32,
-    INT64,
-    FLOAT,
-    DOUBLE,
-    STRING_ASCII,
-    STRING_UNICODE
-};
+#define IDC_BTN_WATCH 1019
+#define IDC_BTN_FREEZE 1020
+#define IDC_BTN_WATCH_REMOVE 1021
+#define IDC_WATCH_LIST 1022
+#define IDC_BTN_UNDO 1023
+#define IDC_BTN_REDO 1024
+#define IDC_BTN_WRITE_ALL 1025
+#define IDC_BTN_EXPRESSION 1026
+
+// Timer IDs
+#define IDT_VALUE_REFRESH 2001
+
+// Refresh interval for the values of visible result rows
+#define VALUE_REFRESH_MS 250
+// Age of cached target pages that live rows and the value display still accept
+#define CACHED_READ_MAX_AGE_MS 16
+
+// Watch list intervals: watched values are re-read at 10 Hz, frozen values rewritten at 100 Hz
+#define WATCH_INTERVAL_MS 100
+#define FREEZE_INTERVAL_MS 10
 
 // Global variables
 HWND g_hMainWindow = nullptr;
@@ -52,14 +73,21 @@ HWND g_hAddressInput = nullptr;
 HWND g_hNewValueInput = nullptr;
 HWND g_hTypeCombo = nullptr;
 HWND g_hProcessLabel = nullptr;
+HWND g_hWatchList = nullptr;
+HWND g_hUndoButton = nullptr;
+HWND g_hRedoButton = nullptr;
 
 HANDLE g_hProcess = nullptr;
 MemoryScanner* g_pScanner = nullptr;
-std::vector<MemoryMatch<int32_t>> g_currentMatches;
-std::vector<MemoryMatch<std::string>> g_stringMatches;
-std::vector<MemoryMatch<std::wstring>> g_wstringMatches;
-std::vector<std::wstring> g_displayedAddresses;
-std::vector<std::wstring> g_displayedValues;
+MemoryScanner* g_pWatchScanner = nullptr; // the watch list thread never shares a scanner with scans
+WatchList* g_pWatchList = nullptr;
+// Module snapshot the result view resolves names from, its strings outlive every sort
+std::shared_ptr<const ModuleList> g_modules;
+// Scan history of column stores (any value type), the current generation is what the result list shows
+ScanHistory<ResultStore> g_history;
+// Compressed memory copy of an unknown-value first scan, the first filter compares against it
+MemorySnapshot g_snapshot;
+ResultViewModel g_resultView;
 std::wstring g_currentProcessName = L"";
 ScanValueType g_currentScanType = ScanValueType::INT32;
 bool g_hasInitialScan = false;
@@ -74,14 +102,32 @@ void PerformFirstScan();
 void PerformNextScan();
 void PerformChangedScan();
 void PerformUnchangedScan();
+void PerformExpressionFilter();
 void UpdateResultList();
+bool ParseValueInput(HWND input, std::vector<uint8_t>& bytes);
+bool ParseNewValue(std::vector<uint8_t>& bytes);
+bool ApplyColumnFilter(ColumnFilter filter, const void* value, const std::string& label);
+void ShowFilterError(const std::string& error);
+void FilterSnapshot(ColumnFilter filter, const void* value, const std::string& label);
 void WriteValue();
+void WriteValueToAllResults();
 void ReadValue();
 void ResetScan();
 void UpdateStatusBar(const std::wstring& text);
 void UpdateInputLimitForAddress(uintptr_t address);
 void OnAddressInputChanged();
 void OnResultListItemSelected();
+void OnResultListGetDispInfo(NMLVDISPINFOW* dispInfo);
+void SetListViewText(LVITEMW& item, std::string_view text);
+void OnResultListColumnClick(int column);
+void RefreshVisibleResults();
+void AddWatchEntry(bool freeze);
+void RemoveWatchEntry();
+void RefreshWatchList();
+void OnWatchListGetDispInfo(NMLVDISPINFOW* dispInfo);
+size_t TotalMatchCount();
+void StepScanHistory(bool redo);
+void UpdateHistoryButtons();
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     // Initialize common controls
@@ -132,12 +178,19 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     }
 
     // Cleanup
+    if (g_pWatchList) delete g_pWatchList;
+    if (g_pWatchScanner) delete g_pWatchScanner;
     if (g_pScanner) delete g_pScanner;
     if (g_hProcess) CloseHandle(g_hProcess);
 
     return 0;
 }
 
+// Value from the "Neuer Wert" field as raw bytes of the current scan type
+bool ParseNewValue(std::vector<uint8_t>& bytes) {
+    return ParseValueInput(g_hNewValueInput, bytes);
+}
+
 void OpenModuleList() {
     auto g_hMainWindow = CreateWindowExW(
         0,
@@ -175,6 +228,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             CreateControls(hwnd);
             PopulateProcessList();
             UpdateStatusBar(L"Bereit - Memory Scanner Professional");
+            SetTimer(hwnd, IDT_VALUE_REFRESH, VALUE_REFRESH_MS, nullptr);
+            return 0;
+
+        case WM_TIMER:
+            if (wParam == IDT_VALUE_REFRESH) {
+                RefreshVisibleResults();
+                RefreshWatchList();
+            }
             return 0;
 
         case WM_KEYDOWN:
@@ -218,21 +279,42 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 case IDC_BTN_UNCHANGED:
                     PerformUnchangedScan();
                     break;
+                case IDC_BTN_EXPRESSION:
+                    PerformExpressionFilter();
+                    break;
                 case IDC_BTN_WRITE:
                     WriteValue();
                     break;
+                case IDC_BTN_WRITE_ALL:
+                    WriteValueToAllResults();
+                    break;
                 case IDC_BTN_READ:
                     ReadValue();
                     break;
                 case IDC_BTN_RESET:
                     ResetScan();
                     break;
+                case IDC_BTN_UNDO:
+                    StepScanHistory(false);
+                    break;
+                case IDC_BTN_REDO:
+                    StepScanHistory(true);
+                    break;
                 case IDC_BTN_REFRESH:
                     PopulateProcessList();
                     break;
                 case IDC_BTN_MODULES:
                     OpenModuleList();
                     break;
+                case IDC_BTN_WATCH:
+                    AddWatchEntry(false);
+                    break;
+                case IDC_BTN_FREEZE:
+                    AddWatchEntry(true);
+                    break;
+                case IDC_BTN_WATCH_REMOVE:
+                    RemoveWatchEntry();
+                    break;
                 case IDC_ADDRESS_INPUT:
                     if (HIWORD(wParam) == EN_CHANGE) {
                         OnAddressInputChanged();
@@ -250,11 +332,29 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
         case WM_NOTIFY: {
             LPNMHDR nmhdr = (LPNMHDR)lParam;
-            if (nmhdr->idFrom == IDC_RESULT_LIST && nmhdr->code == LVN_ITEMCHANGED) {
-                LPNMLISTVIEW pnmv = (LPNMLISTVIEW)lParam;
-                if (pnmv->uNewState & LVIS_SELECTED) {
-                    OnResultListItemSelected();
+            if (nmhdr->idFrom == IDC_RESULT_LIST) {
+                switch (nmhdr->code) {
+                    case LVN_ITEMCHANGED: {
+                        LPNMLISTVIEW pnmv = (LPNMLISTVIEW)lParam;
+                        if (pnmv->uNewState & LVIS_SELECTED) {
+                            OnResultListItemSelected();
+                        }
+                        break;
+                    }
+                    case LVN_GETDISPINFOW:
+                        OnResultListGetDispInfo((NMLVDISPINFOW*)lParam);
+                        break;
+                    case LVN_ODCACHEHINT: {
+                        NMLVCACHEHINT* hint = (NMLVCACHEHINT*)lParam;
+                        g_resultView.setVisibleRange(hint->iFrom, hint->iTo);
+                        break;
+                    }
+                    case LVN_COLUMNCLICK:
+                        OnResultListColumnClick(((LPNMLISTVIEW)lParam)->iSubItem);
+                        break;
                 }
+            } else if (nmhdr->idFrom == IDC_WATCH_LIST && nmhdr->code == LVN_GETDISPINFOW) {
+                OnWatchListGetDispInfo((NMLVDISPINFOW*)lParam);
             }
             return 0;
         }
@@ -266,6 +366,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             return 0;
 
         case WM_DESTROY:
+            KillTimer(hwnd, IDT_VALUE_REFRESH);
             PostQuitMessage(0);
             return 0;
     }
@@ -321,6 +422,10 @@ void CreateControls(HWND hwnd) {
     SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"Double");
     SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"String (ASCII)");
     SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"String (Unicode)");
+    SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"4 Byte (int32, Big Endian)");
+    SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"8 Byte (int64, Big Endian)");
+    SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"Float (Big Endian)");
+    SendMessageW(g_hTypeCombo, CB_ADDSTRING, 0, (LPARAM)L"Double (Big Endian)");
     SendMessageW(g_hTypeCombo, CB_SETCURSEL, 0, 0);
 
     CreateWindowW(L"STATIC", L"Suchwert:",
@@ -329,9 +434,14 @@ void CreateControls(HWND hwnd) {
 
     g_hValueInput = CreateWindowW(L"EDIT", L"",
         WS_CHILD | WS_VISIBLE | WS_BORDER | ES_MULTILINE | ES_AUTOHSCROLL | ES_AUTOVSCROLL | WS_HSCROLL | WS_VSCROLL,
-        450, 67, 280, 60, hwnd, (HMENU)IDC_VALUE_INPUT, hInstance, nullptr);
+        450, 67, 220, 60, hwnd, (HMENU)IDC_VALUE_INPUT, hInstance, nullptr);
     SendMessage(g_hValueInput, EM_SETLIMITTEXT, 32768, 0);
 
+    // Filters by the expression in the value field (v, old, first)
+    CreateWindowW(L"BUTTON", L"ƒ(x)",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        675, 67, 55, 60, hwnd, (HMENU)IDC_BTN_EXPRESSION, hInstance, nullptr);
+
     // Scan Buttons - bessere Anordnung
     CreateWindowW(L"BUTTON", L"🎯 Erster Scan",
         WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
@@ -353,6 +463,15 @@ void CreateControls(HWND hwnd) {
         WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
         490, 180, 120, 35, hwnd, (HMENU)IDC_BTN_RESET, hInstance, nullptr);
 
+    g_hUndoButton = CreateWindowW(L"BUTTON", L"↶ Zurück",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        620, 180, 58, 35, hwnd, (HMENU)IDC_BTN_UNDO, hInstance, nullptr);
+
+    g_hRedoButton = CreateWindowW(L"BUTTON", L"↷ Vor",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        682, 180, 58, 35, hwnd, (HMENU)IDC_BTN_REDO, hInstance, nullptr);
+    UpdateHistoryButtons();
+
     // Memory Editor Group (Rechts)
     CreateWindowW(L"BUTTON", L"⚙️ Speicher Editor",
         WS_CHILD | WS_VISIBLE | BS_GROUPBOX,
@@ -375,13 +494,29 @@ void CreateControls(HWND hwnd) {
         890, 72, 250, 60, hwnd, (HMENU)IDC_NEW_VALUE_INPUT, hInstance, nullptr);
     SendMessage(g_hNewValueInput, EM_SETLIMITTEXT, 32768, 0);
 
-    CreateWindowW(L"BUTTON", L"✏️ Wert schreiben",
+    CreateWindowW(L"BUTTON", L"✏️ Schreiben",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        780, 145, 110, 35, hwnd, (HMENU)IDC_BTN_WRITE, hInstance, nullptr);
+
+    CreateWindowW(L"BUTTON", L"✏️ Alle schreiben",
         WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-        780, 145, 170, 35, hwnd, (HMENU)IDC_BTN_WRITE, hInstance, nullptr);
+        900, 145, 110, 35, hwnd, (HMENU)IDC_BTN_WRITE_ALL, hInstance, nullptr);
 
     CreateWindowW(L"BUTTON", L"👁️ Wert lesen",
         WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-        960, 145, 170, 35, hwnd, (HMENU)IDC_BTN_READ, hInstance, nullptr);
+        1020, 145, 110, 35, hwnd, (HMENU)IDC_BTN_READ, hInstance, nullptr);
+
+    CreateWindowW(L"BUTTON", L"👁️ Beobachten",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        780, 188, 110, 35, hwnd, (HMENU)IDC_BTN_WATCH, hInstance, nullptr);
+
+    CreateWindowW(L"BUTTON", L"❄️ Einfrieren",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        900, 188, 110, 35, hwnd, (HMENU)IDC_BTN_FREEZE, hInstance, nullptr);
+
+    CreateWindowW(L"BUTTON", L"🗑️ Entfernen",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        1020, 188, 110, 35, hwnd, (HMENU)IDC_BTN_WATCH_REMOVE, hInstance, nullptr);
 
     // =================================================================================
     // MAIN CONTENT: Results List
@@ -392,8 +527,8 @@ void CreateControls(HWND hwnd) {
         15, 250, 200, 25, hwnd, nullptr, hInstance, nullptr);
 
     g_hResultList = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, nullptr,
-        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS,
-        15, 275, 1350, 420, hwnd, (HMENU)IDC_RESULT_LIST, hInstance, nullptr);
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS | LVS_OWNERDATA,
+        15, 275, 1350, 270, hwnd, (HMENU)IDC_RESULT_LIST, hInstance, nullptr);
 
     // Enhanced list view columns
     LVCOLUMNW lvc = {};
@@ -418,7 +553,49 @@ void CreateControls(HWND hwnd) {
 
     // Enable full row selection and grid lines
     ListView_SetExtendedListViewStyle(g_hResultList,
-        LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES | LVS_EX_INFOTIP);
+        LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES | LVS_EX_INFOTIP | LVS_EX_DOUBLEBUFFER);
+
+    // Rows are produced on demand by the view model (virtual list)
+    g_resultView.setReader([](uintptr_t address, void* buffer, size_t size) {
+        return g_pScanner != nullptr &&
+               g_pScanner->readCached(address, buffer, size, std::chrono::milliseconds(CACHED_READ_MAX_AGE_MS));
+    }, VALUE_REFRESH_MS);
+    g_resultView.setModuleResolver([](uintptr_t address) -> std::string_view {
+        if (!g_modules) return {};
+        const Module* module = findModule(*g_modules, address);
+        return module ? std::string_view(module->name) : std::string_view();
+    });
+
+    // =================================================================================
+    // Watch list (watched and frozen addresses)
+    // =================================================================================
+
+    CreateWindowW(L"STATIC", L"👁️ Beobachtete & eingefrorene Adressen:",
+        WS_CHILD | WS_VISIBLE,
+        15, 555, 300, 20, hwnd, nullptr, hInstance, nullptr);
+
+    g_hWatchList = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, nullptr,
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS | LVS_OWNERDATA,
+        15, 575, 1350, 125, hwnd, (HMENU)IDC_WATCH_LIST, hInstance, nullptr);
+
+    lvc.cx = 250;
+    lvc.pszText = (LPWSTR)L"📍 Speicheradresse";
+    ListView_InsertColumn(g_hWatchList, 0, &lvc);
+
+    lvc.cx = 400;
+    lvc.pszText = (LPWSTR)L"💾 Aktueller Wert";
+    ListView_InsertColumn(g_hWatchList, 1, &lvc);
+
+    lvc.cx = 150;
+    lvc.pszText = (LPWSTR)L"📊 Datentyp";
+    ListView_InsertColumn(g_hWatchList, 2, &lvc);
+
+    lvc.cx = 150;
+    lvc.pszText = (LPWSTR)L"❄️ Modus";
+    ListView_InsertColumn(g_hWatchList, 3, &lvc);
+
+    ListView_SetExtendedListViewStyle(g_hWatchList,
+        LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES | LVS_EX_DOUBLEBUFFER);
 
     // =================================================================================
     // BOTTOM: Status & Process Info
@@ -434,14 +611,25 @@ void CreateControls(HWND hwnd) {
 }
 
 void PopulateProcessList() {
-    SendMessage(g_hProcessList, LB_RESETCONTENT, 0, 0);
+    // Keep the selected process selected across refreshes
+    DWORD selectedPid = 0;
+    int selected = (int)SendMessage(g_hProcessList, LB_GETCURSEL, 0, 0);
+    if (selected != LB_ERR) selectedPid = (DWORD)SendMessage(g_hProcessList, LB_GETITEMDATA, selected, 0);
 
     auto processes = enumerateProcesses();
+
+    // Fill the list without repainting after every item
+    SendMessage(g_hProcessList, WM_SETREDRAW, FALSE, 0);
+    SendMessage(g_hProcessList, LB_RESETCONTENT, 0, 0);
+    SendMessage(g_hProcessList, LB_INITSTORAGE, processes.size(), processes.size() * 32 * sizeof(wchar_t));
     for (const auto& proc : processes) {
-        std::wstringstream ss;
-        ss << L"[" << proc.pid << L"] " << proc.exeName;
-        SendMessageW(g_hProcessList, LB_ADDSTRING, 0, (LPARAM)ss.str().c_str());
+        std::wstring text = L"[" + std::to_wstring(proc.pid) + L"] " + proc.exeName;
+        int index = (int)SendMessageW(g_hProcessList, LB_ADDSTRING, 0, (LPARAM)text.c_str());
+        SendMessage(g_hProcessList, LB_SETITEMDATA, index, proc.pid);
+        if (proc.pid == selectedPid) SendMessage(g_hProcessList, LB_SETCURSEL, index, 0);
     }
+    SendMessage(g_hProcessList, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(g_hProcessList, nullptr, TRUE);
 
     UpdateStatusBar(L"Prozessliste aktualisiert - " + std::to_wstring(processes.size()) + L" Prozesse gefunden");
 }
@@ -463,10 +651,20 @@ void AttachToProcess() {
     DWORD pid = std::stoi(text.substr(start, end - start));
 
     // Clean up old scanner
+    if (g_pWatchList) {
+        delete g_pWatchList;
+        g_pWatchList = nullptr;
+        ListView_SetItemCountEx(g_hWatchList, 0, 0);
+    }
+    if (g_pWatchScanner) {
+        delete g_pWatchScanner;
+        g_pWatchScanner = nullptr;
+    }
     if (g_pScanner) {
         delete g_pScanner;
         g_pScanner = nullptr;
     }
+    g_modules.reset();
     if (g_hProcess) {
         CloseHandle(g_hProcess);
         g_hProcess = nullptr;
@@ -481,8 +679,15 @@ void AttachToProcess() {
     }
 
     g_pScanner = new MemoryScanner(g_hProcess);
+    g_pWatchScanner = new MemoryScanner(g_hProcess, g_pScanner->cache());
+    g_modules = g_pScanner->modules();
+    g_pWatchList = new WatchList(*g_pWatchScanner);
+    g_pWatchList->start();
     g_hasInitialScan = false;
-    g_currentMatches.clear();
+    g_history.clear();
+    g_snapshot.clear();
+    UpdateHistoryButtons();
+    g_resultView.clear();
     ListView_DeleteAllItems(g_hResultList);
 
     // Update process label
@@ -512,69 +717,107 @@ void PerformFirstScan() {
     UpdateStatusBar(L"Scanne Speicher... Bitte warten...");
     UpdateWindow(g_hMainWindow);
 
-    // Clear all match vectors
-    g_currentMatches.clear();
-    g_stringMatches.clear();
-    g_wstringMatches.clear();
+    // Unknown numeric values: only a compressed copy of memory is kept, the first
+    // changed/unchanged filter turns it into results
+    g_snapshot.clear();
+    if (isEmptyInput && !isStringScanValueType(g_currentScanType)) {
+        g_history.clear();
+        if (!g_pScanner->captureSnapshot(g_snapshot)) {
+            g_snapshot.clear();
+            g_hasInitialScan = false;
+            UpdateHistoryButtons();
+            UpdateResultList();
+            MessageBoxW(g_hMainWindow, L"Der Speicher-Snapshot passt nicht in das Speicherbudget!", L"Fehler", MB_OK | MB_ICONERROR);
+            return;
+        }
+        g_hasInitialScan = true;
+        UpdateHistoryButtons();
+        UpdateResultList();
+
+        const SnapshotStats& stats = g_snapshot.stats();
+        std::wstringstream status;
+        status << L"✓ Speicher-Snapshot erstellt: " << stats.rawBytes / (1024 * 1024) << L" MB gelesen, "
+               << g_snapshot.memoryUsage() / (1024 * 1024) << L" MB belegt. Jetzt mit Geändert/Ungeändert filtern";
+        UpdateStatusBar(status.str());
+        return;
+    }
+
+    // Matches of the selected type stream straight into the first history generation,
+    // full shards spill to disk while the scan runs. Each type keeps its own width.
+    std::string label = isEmptyInput ? std::string("Erster Scan (alle Werte)") : "Erster Scan = " + wideToUtf8(buffer.data());
+    auto collect = [&](auto scan) { g_history.collect(scan, label); };
 
     switch (g_currentScanType) {
         case ScanValueType::INT32:
             if (isEmptyInput) {
-                g_currentMatches = g_pScanner->scanAllValues<int32_t>();
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<int32_t>(sink); });
             } else {
                 int32_t value = _wtoi(buffer.data());
-                g_currentMatches = g_pScanner->scanForValue(value);
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
             }
             break;
 
         case ScanValueType::INT64:
             if (isEmptyInput) {
-                auto matches = g_pScanner->scanAllValues<int64_t>();
-                for (const auto& m : matches) {
-                    MemoryMatch<int32_t> converted;
-                    converted.address = m.address;
-                    converted.value = static_cast<int32_t>(m.value);
-                    g_currentMatches.push_back(converted);
-                }
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<int64_t>(sink); });
             } else {
                 int64_t value = _wtoi64(buffer.data());
-                auto matches = g_pScanner->scanForValue(value);
-                for (const auto& m : matches) {
-                    MemoryMatch<int32_t> converted;
-                    converted.address = m.address;
-                    converted.value = static_cast<int32_t>(m.value);
-                    g_currentMatches.push_back(converted);
-                }
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
             }
             break;
 
         case ScanValueType::FLOAT:
             if (isEmptyInput) {
-                g_currentMatches = g_pScanner->scanAllValues<int32_t>();
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<float>(sink); });
             } else {
                 float value = std::stof(buffer.data());
-                auto matches = g_pScanner->scanForValue(value);
-                for (const auto& m : matches) {
-                    MemoryMatch<int32_t> converted;
-                    converted.address = m.address;
-                    converted.value = static_cast<int32_t>(m.value);
-                    g_currentMatches.push_back(converted);
-                }
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
             }
             break;
 
         case ScanValueType::DOUBLE:
             if (isEmptyInput) {
-                g_currentMatches = g_pScanner->scanAllValues<int32_t>();
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<double>(sink); });
             } else {
                 double value = std::stod(buffer.data());
-                auto matches = g_pScanner->scanForValue(value);
-                for (const auto& m : matches) {
-                    MemoryMatch<int32_t> converted;
-                    converted.address = m.address;
-                    converted.value = static_cast<int32_t>(m.value);
-                    g_currentMatches.push_back(converted);
-                }
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
+            }
+            break;
+
+        // Big-endian needles are swapped once, the scan itself is the same byte search
+        case ScanValueType::INT32_BE:
+            if (isEmptyInput) {
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<Swapped<int32_t>>(sink); });
+            } else {
+                auto value = Swapped<int32_t>::fromValue(_wtoi(buffer.data()));
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
+            }
+            break;
+
+        case ScanValueType::INT64_BE:
+            if (isEmptyInput) {
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<Swapped<int64_t>>(sink); });
+            } else {
+                auto value = Swapped<int64_t>::fromValue(_wtoi64(buffer.data()));
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
+            }
+            break;
+
+        case ScanValueType::FLOAT_BE:
+            if (isEmptyInput) {
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<Swapped<float>>(sink); });
+            } else {
+                auto value = Swapped<float>::fromValue(std::stof(buffer.data()));
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
+            }
+            break;
+
+        case ScanValueType::DOUBLE_BE:
+            if (isEmptyInput) {
+                collect([&](auto&& sink) { g_pScanner->scanAllValues<Swapped<double>>(sink); });
+            } else {
+                auto value = Swapped<double>::fromValue(std::stod(buffer.data()));
+                collect([&](auto&& sink) { g_pScanner->scanForValue(value, sink); });
             }
             break;
 
@@ -584,24 +827,33 @@ void PerformFirstScan() {
                 std::vector<char> asciiBuffer(valueLength + 1);
                 wcstombs(asciiBuffer.data(), buffer.data(), valueLength + 1);
                 std::string searchStr(asciiBuffer.data());
-                g_stringMatches = g_pScanner->scanForString(searchStr);
+                collect([&](auto&& sink) {
+                    for (const auto& match : g_pScanner->scanForString(searchStr)) sink(match);
+                });
+            } else {
+                collect([](auto&&) {});
             }
             break;
 
         case ScanValueType::STRING_UNICODE:
             if (!isEmptyInput) {
                 std::wstring searchStr(buffer.data());
-                g_wstringMatches = g_pScanner->scanForWideString(searchStr);
+                collect([&](auto&& sink) {
+                    for (const auto& match : g_pScanner->scanForWideString(searchStr)) sink(match);
+                });
+            } else {
+                collect([](auto&&) {});
             }
             break;
     }
 
     g_hasInitialScan = true;
+    UpdateHistoryButtons();
 
     UpdateResultList();
 
     // Show status based on type
-    size_t totalFound = g_currentMatches.size() + g_stringMatches.size() + g_wstringMatches.size();
+    size_t totalFound = TotalMatchCount();
     std::wstringstream status;
     status << L"✓ Scan abgeschlossen! Gefunden: " << totalFound << L" Adressen";
     UpdateStatusBar(status.str());
@@ -614,8 +866,7 @@ void PerformNextScan() {
     }
 
     // Check if we have any matches
-    bool hasMatches = !g_currentMatches.empty() || !g_stringMatches.empty() || !g_wstringMatches.empty();
-    if (!hasMatches) {
+    if (TotalMatchCount() == 0 && g_snapshot.empty()) {
         MessageBoxW(g_hMainWindow, L"Keine Ergebnisse zum Filtern vorhanden!", L"Fehler", MB_OK | MB_ICONERROR);
         return;
     }
@@ -625,119 +876,25 @@ void PerformNextScan() {
     std::vector<wchar_t> buffer(valueLength + 1);
     GetWindowTextW(g_hValueInput, buffer.data(), valueLength + 1);
 
+    std::vector<uint8_t> value;
+    if (!ParseValueInput(g_hValueInput, value)) {
+        MessageBoxW(g_hMainWindow, L"Bitte geben Sie einen Wert ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
     UpdateStatusBar(L"Filtere Ergebnisse...");
     UpdateWindow(g_hMainWindow);
 
-    // Filter based on current scan type
-    switch (g_currentScanType) {
-        case ScanValueType::INT32: {
-            int32_t value = _wtoi(buffer.data());
-            // Use the proper filter that updates the values
-            std::vector<MemoryMatch<int32_t>> newMatches;
-            for (const auto& match : g_currentMatches) {
-                int32_t currentValue;
-                if (g_pScanner->readValue(match.address, currentValue) && currentValue == value) {
-                    MemoryMatch<int32_t> newMatch;
-                    newMatch.address = match.address;
-                    newMatch.value = currentValue; // Store the CURRENT value
-                    newMatches.push_back(newMatch);
-                }
-            }
-            g_currentMatches = newMatches;
-            break;
-        }
-        case ScanValueType::INT64: {
-            int64_t value = _wtoi64(buffer.data());
-            std::vector<MemoryMatch<int32_t>> newMatches;
-            for (const auto& match : g_currentMatches) {
-                int64_t currentValue;
-                if (g_pScanner->readValue(match.address, currentValue) && currentValue == value) {
-                    MemoryMatch<int32_t> newMatch;
-                    newMatch.address = match.address;
-                    newMatch.value = static_cast<int32_t>(currentValue);
-                    newMatches.push_back(newMatch);
-                }
-            }
-            g_currentMatches = newMatches;
-            break;
-        }
-        case ScanValueType::FLOAT: {
-            float value = std::stof(buffer.data());
-            std::vector<MemoryMatch<int32_t>> newMatches;
-            for (const auto& match : g_currentMatches) {
-                float currentValue;
-                if (g_pScanner->readValue(match.address, currentValue) && currentValue == value) {
-                    MemoryMatch<int32_t> newMatch;
-                    newMatch.address = match.address;
-                    newMatch.value = static_cast<int32_t>(currentValue);
-                    newMatches.push_back(newMatch);
-                }
-            }
-            g_currentMatches = newMatches;
-            break;
-        }
-        case ScanValueType::DOUBLE: {
-            double value = std::stod(buffer.data());
-            std::vector<MemoryMatch<int32_t>> newMatches;
-            for (const auto& match : g_currentMatches) {
-                double currentValue;
-                if (g_pScanner->readValue(match.address, currentValue) && currentValue == value) {
-                    MemoryMatch<int32_t> newMatch;
-                    newMatch.address = match.address;
-                    newMatch.value = static_cast<int32_t>(currentValue);
-                    newMatches.push_back(newMatch);
-                }
-            }
-            g_currentMatches = newMatches;
-            break;
-        }
-        case ScanValueType::STRING_ASCII: {
-            std::vector<char> asciiBuffer(valueLength + 1);
-            wcstombs(asciiBuffer.data(), buffer.data(), valueLength + 1);
-            std::string searchStr(asciiBuffer.data());
-
-            // Filter string matches manually
-            std::vector<MemoryMatch<std::string>> newMatches;
-            for (const auto& match : g_stringMatches) {
-                std::string currentValue;
-                currentValue.resize(searchStr.length());
-                if (g_pScanner->readMemory(match.address, &currentValue[0], searchStr.length())) {
-                    if (currentValue == searchStr) {
-                        MemoryMatch<std::string> newMatch;
-                        newMatch.address = match.address;
-                        newMatch.value = currentValue; // Store current value
-                        newMatches.push_back(newMatch);
-                    }
-                }
-            }
-            g_stringMatches = newMatches;
-            break;
-        }
-        case ScanValueType::STRING_UNICODE: {
-            std::wstring searchStr(buffer.data());
-
-            // Filter wstring matches manually
-            std::vector<MemoryMatch<std::wstring>> newMatches;
-            for (const auto& match : g_wstringMatches) {
-                std::wstring currentValue;
-                currentValue.resize(searchStr.length());
-                if (g_pScanner->readMemory(match.address, &currentValue[0], searchStr.length() * sizeof(wchar_t))) {
-                    if (currentValue == searchStr) {
-                        MemoryMatch<std::wstring> newMatch;
-                        newMatch.address = match.address;
-                        newMatch.value = currentValue; // Store current value
-                        newMatches.push_back(newMatch);
-                    }
-                }
-            }
-            g_wstringMatches = newMatches;
-            break;
-        }
-    }
+    // Every type filters the same way: one batched read of the address column, then a
+    // compare against the value in the width of the current scan
+    std::string label = "Exakter Wert = " + wideToUtf8(buffer.data());
+    if (!g_snapshot.empty()) FilterSnapshot(ColumnFilter::EQUAL, value.data(), label);
+    else if (!ApplyColumnFilter(ColumnFilter::EQUAL, value.data(), label)) return;
 
+    UpdateHistoryButtons();
     UpdateResultList();
 
-    size_t totalFound = g_currentMatches.size() + g_stringMatches.size() + g_wstringMatches.size();
+    size_t totalFound = TotalMatchCount();
     UpdateStatusBar(L"✓ Scan abgeschlossen! Verbleibend: " + std::to_wstring(totalFound) + L" Adressen");
 }
 
@@ -748,8 +905,7 @@ void PerformChangedScan() {
     }
 
     // Check if we have any matches
-    bool hasMatches = !g_currentMatches.empty() || !g_stringMatches.empty() || !g_wstringMatches.empty();
-    if (!hasMatches) {
+    if (TotalMatchCount() == 0 && g_snapshot.empty()) {
         MessageBoxW(g_hMainWindow, L"Keine Ergebnisse zum Filtern vorhanden!", L"Fehler", MB_OK | MB_ICONERROR);
         return;
     }
@@ -757,57 +913,13 @@ void PerformChangedScan() {
     UpdateStatusBar(L"Scanne nach geänderten Werten...");
     UpdateWindow(g_hMainWindow);
 
-    // Filter based on current scan type
-    switch (g_currentScanType) {
-        case ScanValueType::INT32:
-        case ScanValueType::INT64:
-        case ScanValueType::FLOAT:
-        case ScanValueType::DOUBLE:
-            g_currentMatches = g_pScanner->filterByChanged(g_currentMatches);
-            break;
-
-        case ScanValueType::STRING_ASCII: {
-            // Filter string matches for changed values
-            std::vector<MemoryMatch<std::string>> newMatches;
-            for (const auto& match : g_stringMatches) {
-                std::string currentValue;
-                currentValue.resize(match.value.length());
-                if (g_pScanner->readMemory(match.address, &currentValue[0], match.value.length())) {
-                    if (currentValue != match.value) {
-                        MemoryMatch<std::string> newMatch;
-                        newMatch.address = match.address;
-                        newMatch.value = currentValue;
-                        newMatches.push_back(newMatch);
-                    }
-                }
-            }
-            g_stringMatches = newMatches;
-            break;
-        }
-
-        case ScanValueType::STRING_UNICODE: {
-            // Filter wstring matches for changed values
-            std::vector<MemoryMatch<std::wstring>> newMatches;
-            for (const auto& match : g_wstringMatches) {
-                std::wstring currentValue;
-                currentValue.resize(match.value.length());
-                if (g_pScanner->readMemory(match.address, &currentValue[0], match.value.length() * sizeof(wchar_t))) {
-                    if (currentValue != match.value) {
-                        MemoryMatch<std::wstring> newMatch;
-                        newMatch.address = match.address;
-                        newMatch.value = currentValue;
-                        newMatches.push_back(newMatch);
-                    }
-                }
-            }
-            g_wstringMatches = newMatches;
-            break;
-        }
-    }
+    if (!g_snapshot.empty()) FilterSnapshot(ColumnFilter::CHANGED, nullptr, "Geändert seit Snapshot");
+    else if (!ApplyColumnFilter(ColumnFilter::CHANGED, nullptr, "Geändert")) return;
 
+    UpdateHistoryButtons();
     UpdateResultList();
 
-    size_t totalFound = g_currentMatches.size() + g_stringMatches.size() + g_wstringMatches.size();
+    size_t totalFound = TotalMatchCount();
     UpdateStatusBar(L"✓ Scan abgeschlossen! Verbleibend: " + std::to_wstring(totalFound) + L" Adressen");
 }
 
@@ -818,8 +930,7 @@ void PerformUnchangedScan() {
     }
 
     // Check if we have any matches
-    bool hasMatches = !g_currentMatches.empty() || !g_stringMatches.empty() || !g_wstringMatches.empty();
-    if (!hasMatches) {
+    if (TotalMatchCount() == 0 && g_snapshot.empty()) {
         MessageBoxW(g_hMainWindow, L"Keine Ergebnisse zum Filtern vorhanden!", L"Fehler", MB_OK | MB_ICONERROR);
         return;
     }
@@ -827,222 +938,373 @@ void PerformUnchangedScan() {
     UpdateStatusBar(L"Scanne nach ungeänderten Werten...");
     UpdateWindow(g_hMainWindow);
 
-    // Filter based on current scan type
-    switch (g_currentScanType) {
-        case ScanValueType::INT32:
-        case ScanValueType::INT64:
-        case ScanValueType::FLOAT:
-        case ScanValueType::DOUBLE:
-            g_currentMatches = g_pScanner->filterByUnchanged(g_currentMatches);
-            break;
+    if (!g_snapshot.empty()) FilterSnapshot(ColumnFilter::UNCHANGED, nullptr, "Ungeändert seit Snapshot");
+    else if (!ApplyColumnFilter(ColumnFilter::UNCHANGED, nullptr, "Ungeändert")) return;
 
-        case ScanValueType::STRING_ASCII: {
-            // Filter string matches for unchanged values
-            std::vector<MemoryMatch<std::string>> newMatches;
-            for (const auto& match : g_stringMatches) {
-                std::string currentValue;
-                currentValue.resize(match.value.length());
-                if (g_pScanner->readMemory(match.address, &currentValue[0], match.value.length())) {
-                    if (currentValue == match.value) {
-                        newMatches.push_back(match);
-                    }
-                }
-            }
-            g_stringMatches = newMatches;
-            break;
-        }
+    UpdateHistoryButtons();
+    UpdateResultList();
 
-        case ScanValueType::STRING_UNICODE: {
-            // Filter wstring matches for unchanged values
-            std::vector<MemoryMatch<std::wstring>> newMatches;
-            for (const auto& match : g_wstringMatches) {
-                std::wstring currentValue;
-                currentValue.resize(match.value.length());
-                if (g_pScanner->readMemory(match.address, &currentValue[0], match.value.length() * sizeof(wchar_t))) {
-                    if (currentValue == match.value) {
-                        newMatches.push_back(match);
-                    }
-                }
-            }
-            g_wstringMatches = newMatches;
-            break;
-        }
+    size_t totalFound = TotalMatchCount();
+    UpdateStatusBar(L"✓ Scan abgeschlossen! Verbleibend: " + std::to_wstring(totalFound) + L" Adressen");
+}
+
+void PerformExpressionFilter() {
+    if (!g_hasInitialScan) {
+        MessageBoxW(g_hMainWindow, L"Führen Sie zuerst einen ersten Scan durch!", L"Fehler", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    if (!g_snapshot.empty()) {
+        MessageBoxW(g_hMainWindow, L"Filtern Sie den Snapshot zuerst mit Geändert, Ungeändert oder einem Wert!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    if (TotalMatchCount() == 0) {
+        MessageBoxW(g_hMainWindow, L"Keine Ergebnisse zum Filtern vorhanden!", L"Fehler", MB_OK | MB_ICONERROR);
+        return;
     }
 
+    int textLength = GetWindowTextLengthW(g_hValueInput);
+    std::vector<wchar_t> buffer(textLength + 1);
+    GetWindowTextW(g_hValueInput, buffer.data(), textLength + 1);
+    std::string text = wideToUtf8(buffer.data());
+
+    FilterExpression expression;
+    std::string error;
+    if (!expression.compile(text, g_currentScanType, error)) {
+        std::wstring message = L"Ungültiger Ausdruck: " + std::wstring(error.begin(), error.end()) +
+                               L"\n\nVariablen: v (aktuell), old (vorheriger Scan), first (erster Scan)\n"
+                               L"Beispiel: v > old && v < 1000 && (v - old) % 5 == 0";
+        MessageBoxW(g_hMainWindow, message.c_str(), L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    UpdateStatusBar(L"Filtere Ergebnisse...");
+    UpdateWindow(g_hMainWindow);
+
+    // All conditions in one read of the address column and one pass over the value columns
+    FirstValueIndex first;
+    bool filtered = (!expression.usesFirst() || firstValuesOf(g_history, first, error)) &&
+                    g_history.applyFilter([&](const ResultStore& shard) {
+                        return filterResultStore(*g_pScanner, shard, expression, &first);
+                    }, "Ausdruck: " + text, error);
+    if (!filtered) {
+        ShowFilterError(error);
+        return;
+    }
+
+    UpdateHistoryButtons();
     UpdateResultList();
 
-    size_t totalFound = g_currentMatches.size() + g_stringMatches.size() + g_wstringMatches.size();
+    size_t totalFound = TotalMatchCount();
     UpdateStatusBar(L"✓ Scan abgeschlossen! Verbleibend: " + std::to_wstring(totalFound) + L" Adressen");
 }
 
-void UpdateResultList() {
-    ListView_DeleteAllItems(g_hResultList);
+bool ApplyColumnFilter(ColumnFilter filter, const void* value, const std::string& label) {
+    std::string error;
+    if (!g_history.applyFilter([&](const ResultStore& shard) {
+            return filterResultStore(*g_pScanner, shard, filter, value);
+        }, label, error)) {
+        ShowFilterError(error);
+        return false;
+    }
+    return true;
+}
 
-    // Clear old display strings
-    g_displayedAddresses.clear();
-    g_displayedValues.clear();
+void ShowFilterError(const std::string& error) {
+    // The history is left untouched, the current generation stays selected
+    int length = MultiByteToWideChar(CP_UTF8, 0, error.data(), (int)error.size(), nullptr, 0);
+    std::wstring message(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, error.data(), (int)error.size(), message.data(), length);
+    message = L"Filter fehlgeschlagen:\n" + message;
+    MessageBoxW(g_hMainWindow, message.c_str(), L"Fehler", MB_OK | MB_ICONERROR);
+    UpdateStatusBar(L"✗ Filter fehlgeschlagen");
+}
 
-    // Calculate total matches across all types
-    size_t totalMatches = g_currentMatches.size() + g_stringMatches.size() + g_wstringMatches.size();
-    size_t maxDisplay = std::min<size_t>(totalMatches, 2000); // Erhöht auf 2000 für bessere Performance
+void FilterSnapshot(ColumnFilter filter, const void* value, const std::string& label) {
+    // The first filter after a snapshot starts the history, the snapshot is released after it
+    auto collect = [&](auto zero) {
+        using T = decltype(zero);
+        g_history.collect([&](auto&& sink) {
+            if (filter == ColumnFilter::EQUAL) {
+                T needle;
+                std::memcpy(&needle, value, sizeof(T));
+                g_pScanner->scanForValue(needle, sink);
+            } else {
+                SnapshotCompare compare = filter == ColumnFilter::CHANGED ? SnapshotCompare::CHANGED : SnapshotCompare::UNCHANGED;
+                g_pScanner->scanSnapshot<T>(g_snapshot, compare, sink);
+            }
+        }, label);
+    };
 
-    // Reserve space for better performance
-    g_displayedAddresses.reserve(maxDisplay);
-    g_displayedValues.reserve(maxDisplay);
+    switch (g_currentScanType) {
+        case ScanValueType::INT32: collect(int32_t{}); break;
+        case ScanValueType::INT64: collect(int64_t{}); break;
+        case ScanValueType::FLOAT: collect(float{}); break;
+        case ScanValueType::DOUBLE: collect(double{}); break;
+        case ScanValueType::INT32_BE: collect(Swapped<int32_t>{}); break;
+        case ScanValueType::INT64_BE: collect(Swapped<int64_t>{}); break;
+        case ScanValueType::FLOAT_BE: collect(Swapped<float>{}); break;
+        case ScanValueType::DOUBLE_BE: collect(Swapped<double>{}); break;
+        default: break;
+    }
+    g_snapshot.clear();
+}
 
-    // Add int32 matches
-    for (size_t i = 0; i < g_currentMatches.size() && g_displayedAddresses.size() < maxDisplay; i++) {
-        std::wstringstream ss;
-        ss << L"0x" << std::hex << std::uppercase << std::setw(16) << std::setfill(L'0') << g_currentMatches[i].address;
-
-        // Add to ListView
-        LVITEMW lvi = {};
-        lvi.mask = LVIF_TEXT;
-        lvi.iItem = (int)g_displayedAddresses.size();
-        lvi.pszText = const_cast<LPWSTR>(ss.str().c_str());
-        ListView_InsertItem(g_hResultList, &lvi);
-
-        // Wert
-        std::wstring valueStr = std::to_wstring(g_currentMatches[i].value);
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 1, const_cast<LPWSTR>(valueStr.c_str()));
-
-        // Datentyp
-        std::wstring typeStr;
-        switch (g_currentScanType) {
-            case ScanValueType::INT32: typeStr = L"INT32"; break;
-            case ScanValueType::INT64: typeStr = L"INT64"; break;
-            case ScanValueType::FLOAT: typeStr = L"FLOAT"; break;
-            case ScanValueType::DOUBLE: typeStr = L"DOUBLE"; break;
-            default: typeStr = L"NUMERIC"; break;
+void UpdateResultList() {
+    // Bind the current history generation to the view model, rows are formatted on demand
+    if (g_history.empty()) {
+        g_resultView.clear();
+    } else {
+        // Rows of shards lost with their spill file are shown as unreadable
+        const auto* generation = &g_history.current();
+        size_t valueSize = scanValueTypeSize(g_currentScanType);
+        for (size_t s = 0; s < generation->shards.size(); s++) {
+            size_t local;
+            if (const ResultStore* shard = generation->shardAt(generation->shardOffsets[s], local)) {
+                valueSize = shard->valueSize();
+                break;
+            }
         }
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 2, const_cast<LPWSTR>(typeStr.c_str()));
+        g_resultView.setSource(generation->count(), g_currentScanType, valueSize,
+            [generation](size_t i) -> std::optional<uintptr_t> {
+                size_t row;
+                const ResultStore* shard = generation->shardAt(i, row);
+                if (!shard) return std::nullopt;
+                return shard->address(row);
+            },
+            [generation](size_t i, void* out, size_t outSize) -> size_t {
+                size_t row;
+                const ResultStore* shard = generation->shardAt(i, row);
+                if (!shard) return 0;
+                size_t length = std::min<size_t>(outSize, shard->valueSize());
+                std::memcpy(out, shard->value(row), length);
+                return length;
+            });
+    }
 
-        auto name = g_pScanner->getModuleByAddress(g_currentMatches[i].address)->name;
-        std::wstring wname = std::wstring(name.begin(), name.end());
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 3, const_cast<LPWSTR>(wname.c_str()));
+    size_t totalMatches = g_resultView.rowCount();
+    ListView_SetItemCountEx(g_hResultList, (int)std::min<size_t>(totalMatches, INT_MAX), 0);
+    InvalidateRect(g_hResultList, nullptr, FALSE);
 
-        g_displayedAddresses.push_back(ss.str());
-        g_displayedValues.push_back(valueStr);
+    // Scanner memory against the budget, so growth is visible before it hurts the target
+    const MemoryGovernor& governor = memoryGovernor();
+    std::wstring memory = L"  |  Speicher: " + std::to_wstring(governor.used() / (1024 * 1024)) + L" / " +
+                          std::to_wstring(governor.budget() / (1024 * 1024)) + L" MB";
+    if (totalMatches > 0) {
+        UpdateStatusBar(L"📊 " + std::to_wstring(totalMatches) + L" Treffer gefunden" + memory);
+    } else {
+        UpdateStatusBar(L"❌ Keine Treffer gefunden" + memory);
     }
+}
 
-    // Add ASCII string matches
-    for (size_t i = 0; i < g_stringMatches.size() && g_displayedAddresses.size() < maxDisplay; i++) {
-        std::wstringstream ss;
-        ss << L"0x" << std::hex << std::uppercase << std::setw(16) << std::setfill(L'0') << g_stringMatches[i].address;
-
-        // Add to ListView
-        LVITEMW lvi = {};
-        lvi.mask = LVIF_TEXT;
-        lvi.iItem = (int)g_displayedAddresses.size();
-        lvi.pszText = const_cast<LPWSTR>(ss.str().c_str());
-        ListView_InsertItem(g_hResultList, &lvi);
-
-        // Convert ASCII string to wstring for display
-        std::wstring wstr(g_stringMatches[i].value.begin(), g_stringMatches[i].value.end());
-        // Truncate long strings for display
-        if (wstr.length() > 100) {
-            wstr = wstr.substr(0, 97) + L"...";
-        }
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 1, const_cast<LPWSTR>(wstr.c_str()));
+void OnResultListGetDispInfo(NMLVDISPINFOW* dispInfo) {
+    LVITEMW& item = dispInfo->item;
+    if (!(item.mask & LVIF_TEXT) || item.cchTextMax <= 0) return;
 
-        // Datentyp
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 2, L"ASCII");
+    SetListViewText(item, g_resultView.formatCell(item.iItem, static_cast<ResultColumn>(item.iSubItem)));
+}
 
-        auto name = g_pScanner->getModuleByAddress(g_stringMatches[i].address)->name;
-        std::wstring wname = std::wstring(name.begin(), name.end());
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 3, const_cast<LPWSTR>(wname.c_str()));
+void SetListViewText(LVITEMW& item, std::string_view text) {
+    // Widen straight into the buffer provided by the list view. Text longer than the buffer
+    // (long strings) makes MultiByteToWideChar fail outright, so it is widened on the side
+    // and cut to the buffer instead of showing an empty cell.
+    int capacity = item.cchTextMax - 1;
+    int length = 0;
+    // A zero capacity would make MultiByteToWideChar return the needed size instead
+    if (!text.empty() && capacity > 0) {
+        length = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), item.pszText, capacity);
+        if (length == 0 && GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+            int needed = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+            std::wstring wide(needed, L'\0');
+            MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), wide.data(), needed);
+            length = capacity;
+            // Never end on the first half of a surrogate pair
+            if (length > 0 && IS_HIGH_SURROGATE(wide[length - 1])) length--;
+            std::copy_n(wide.data(), length, item.pszText);
+        }
+    }
+    item.pszText[length] = L'\0';
+}
 
-        g_displayedAddresses.push_back(ss.str());
-        g_displayedValues.push_back(wstr);
+void OnResultListColumnClick(int column) {
+    ResultSortKey key;
+    switch (static_cast<ResultColumn>(column)) {
+        case ResultColumn::ADDRESS: key = ResultSortKey::ADDRESS; break;
+        case ResultColumn::VALUE: key = ResultSortKey::VALUE; break;
+        case ResultColumn::MODULE: key = ResultSortKey::MODULE; break;
+        default: return;
     }
 
-    // Add Unicode string matches
-    for (size_t i = 0; i < g_wstringMatches.size() && g_displayedAddresses.size() < maxDisplay; i++) {
-        std::wstringstream ss;
-        ss << L"0x" << std::hex << std::uppercase << std::setw(16) << std::setfill(L'0') << g_wstringMatches[i].address;
-
-        // Add to ListView
-        LVITEMW lvi = {};
-        lvi.mask = LVIF_TEXT;
-        lvi.iItem = (int)g_displayedAddresses.size();
-        lvi.pszText = const_cast<LPWSTR>(ss.str().c_str());
-        ListView_InsertItem(g_hResultList, &lvi);
-
-        // Truncate long strings for display
-        std::wstring displayValue = g_wstringMatches[i].value;
-        if (displayValue.length() > 100) {
-            displayValue = displayValue.substr(0, 97) + L"...";
-        }
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 1, const_cast<LPWSTR>(displayValue.c_str()));
+    bool ascending = g_resultView.sortKey() != key || !g_resultView.sortAscending();
 
-        // Datentyp
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 2, L"UNICODE");
+    UpdateStatusBar(L"Sortiere Ergebnisse...");
+    UpdateWindow(g_hMainWindow);
 
-        auto name = g_pScanner->getModuleByAddress(g_wstringMatches[i].address)->name;
-        std::wstring wname = std::wstring(name.begin(), name.end());
-        ListView_SetItemText(g_hResultList, (int)g_displayedAddresses.size(), 3, const_cast<LPWSTR>(wname.c_str()));
+    if (!g_resultView.sortBy(key, ascending)) {
+        UpdateStatusBar(L"✗ Speicherbudget reicht nicht zum Sortieren von " + std::to_wstring(g_resultView.rowCount()) + L" Treffern");
+        return;
+    }
+    InvalidateRect(g_hResultList, nullptr, FALSE);
+
+    UpdateStatusBar(L"📊 " + std::to_wstring(g_resultView.rowCount()) + L" Treffer sortiert");
+}
 
-        g_displayedAddresses.push_back(ss.str());
-        g_displayedValues.push_back(displayValue);
+void RefreshVisibleResults() {
+    if (!g_pScanner || g_resultView.rowCount() == 0) {
+        return;
     }
 
-    if (totalMatches > maxDisplay) {
-        UpdateStatusBar(L"📊 Zeige " + std::to_wstring(maxDisplay) + L" von " +
-                       std::to_wstring(totalMatches) + L" Treffern");
-    } else if (totalMatches > 0) {
-        UpdateStatusBar(L"📊 " + std::to_wstring(totalMatches) + L" Treffer gefunden");
-    } else {
-        UpdateStatusBar(L"❌ Keine Treffer gefunden");
+    int top = ListView_GetTopIndex(g_hResultList);
+    int perPage = ListView_GetCountPerPage(g_hResultList);
+    g_resultView.setVisibleRange(top, top + perPage);
+
+    // Only the rows on screen are re-read, independent of the result count
+    if (g_resultView.refreshVisible(GetTickCount64())) {
+        ListView_RedrawItems(g_hResultList, top, top + perPage);
     }
 }
 
-void WriteValue() {
-    if (!g_pScanner) {
+void AddWatchEntry(bool freeze) {
+    if (!g_pWatchList) {
         MessageBoxW(g_hMainWindow, L"Bitte hängen Sie sich zuerst an einen Prozess an!", L"Fehler", MB_OK | MB_ICONERROR);
         return;
     }
 
     wchar_t addrBuffer[32];
     GetWindowTextW(g_hAddressInput, addrBuffer, 32);
+    if (wcslen(addrBuffer) == 0) {
+        MessageBoxW(g_hMainWindow, L"Bitte geben Sie eine Adresse ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
 
-    // Dynamische Allokierung für große Eingaben
-    int valueLength = GetWindowTextLengthW(g_hNewValueInput);
-    if (valueLength == 0) {
-        MessageBoxW(g_hMainWindow, L"Bitte geben Sie Adresse und Wert ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+    uintptr_t address;
+    try {
+        address = std::stoull(addrBuffer, nullptr, 16);
+    } catch (...) {
+        MessageBoxW(g_hMainWindow, L"Ungültige Adresse!", L"Fehler", MB_OK | MB_ICONERROR);
         return;
     }
 
+    int valueLength = GetWindowTextLengthW(g_hNewValueInput);
     std::vector<wchar_t> valueBuffer(valueLength + 1);
     GetWindowTextW(g_hNewValueInput, valueBuffer.data(), valueLength + 1);
+    std::vector<uint8_t> value;
+    bool hasValue = parseScanValue(g_currentScanType, wideToUtf8(valueBuffer.data()), value);
 
-    if (wcslen(addrBuffer) == 0) {
-        MessageBoxW(g_hMainWindow, L"Bitte geben Sie Adresse und Wert ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+    if (freeze) {
+        if (!hasValue) {
+            MessageBoxW(g_hMainWindow, L"Bitte geben Sie einen gültigen Wert zum Einfrieren ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+            return;
+        }
+        g_pWatchList->addFreeze(address, g_currentScanType, std::move(value), FREEZE_INTERVAL_MS);
+        UpdateStatusBar(L"❄️ Adresse eingefroren");
+    } else {
+        // Strings are watched with the length of the value field, or 32 characters
+        size_t size = scanValueTypeSize(g_currentScanType);
+        if (size == 0) {
+            size = hasValue ? value.size() : 32 * (g_currentScanType == ScanValueType::STRING_UNICODE ? sizeof(wchar_t) : 1);
+        }
+        g_pWatchList->addWatch(address, g_currentScanType, size, WATCH_INTERVAL_MS);
+        UpdateStatusBar(L"👁️ Adresse wird beobachtet");
+    }
+
+    RefreshWatchList();
+}
+
+void RemoveWatchEntry() {
+    if (!g_pWatchList) {
         return;
     }
 
-    uintptr_t address = std::stoull(addrBuffer, nullptr, 16);
-    bool success = false;
+    int selectedIndex = ListView_GetNextItem(g_hWatchList, -1, LVNI_SELECTED);
+    const WatchSnapshot& snapshot = g_pWatchList->acquireSnapshot();
+    if (selectedIndex == -1 || (size_t)selectedIndex >= snapshot.values.size()) {
+        MessageBoxW(g_hMainWindow, L"Bitte wählen Sie einen Eintrag aus!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    g_pWatchList->remove(snapshot.values[selectedIndex].id);
+    UpdateStatusBar(L"✓ Eintrag entfernt");
+}
+
+void RefreshWatchList() {
+    if (!g_pWatchList) {
+        return;
+    }
+
+    // The scheduler publishes a fresh snapshot per tick, the UI only picks up the latest one
+    const WatchSnapshot& snapshot = g_pWatchList->acquireSnapshot();
+    ListView_SetItemCountEx(g_hWatchList, (int)snapshot.values.size(), LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+    InvalidateRect(g_hWatchList, nullptr, FALSE);
+}
+
+void OnWatchListGetDispInfo(NMLVDISPINFOW* dispInfo) {
+    LVITEMW& item = dispInfo->item;
+    if (!(item.mask & LVIF_TEXT) || item.cchTextMax <= 0 || !g_pWatchList) return;
+
+    const WatchSnapshot& snapshot = g_pWatchList->acquireSnapshot();
+    item.pszText[0] = L'\0';
+    if (item.iItem < 0 || (size_t)item.iItem >= snapshot.values.size()) return;
+
+    const WatchValue& value = snapshot.values[item.iItem];
+    char text[512];
+    size_t length = 0;
+    switch (item.iSubItem) {
+        case 0:
+            length = formatHexAddress(value.address, text);
+            break;
+        case 1:
+            if (value.valid) {
+                length = formatScanValue(value.type, &snapshot.bytes[value.offset], value.size, text, sizeof(text));
+            } else {
+                length = snprintf(text, sizeof(text), "%s", value.timestampMs == 0 ? "..." : "??");
+            }
+            break;
+        case 2:
+            length = snprintf(text, sizeof(text), "%s", scanValueTypeName(value.type));
+            break;
+        case 3:
+            length = snprintf(text, sizeof(text), "%s", value.mode == WatchMode::FREEZE ? "Eingefroren" : "Beobachtet");
+            break;
+    }
+
+    SetListViewText(item, std::string_view(text, std::min<size_t>(length, sizeof(text) - 1)));
+}
+
+// Value from an input field as raw bytes of the current scan type
+bool ParseValueInput(HWND input, std::vector<uint8_t>& bytes) {
+    int valueLength = GetWindowTextLengthW(input);
+    if (valueLength == 0) return false;
+
+    // Dynamische Allokierung für große Eingaben
+    std::vector<wchar_t> valueBuffer(valueLength + 1);
+    GetWindowTextW(input, valueBuffer.data(), valueLength + 1);
+
+    auto assign = [&bytes](const void* data, size_t size) {
+        const auto* begin = static_cast<const uint8_t*>(data);
+        bytes.assign(begin, begin + size);
+    };
 
-    // Write based on current scan type
     switch (g_currentScanType) {
         case ScanValueType::INT32: {
             int32_t value = _wtoi(valueBuffer.data());
-            success = g_pScanner->writeValue(address, value);
+            assign(&value, sizeof(value));
             break;
         }
         case ScanValueType::INT64: {
             int64_t value = _wtoi64(valueBuffer.data());
-            success = g_pScanner->writeValue(address, value);
+            assign(&value, sizeof(value));
             break;
         }
         case ScanValueType::FLOAT: {
             float value = std::stof(valueBuffer.data());
-            success = g_pScanner->writeValue(address, value);
+            assign(&value, sizeof(value));
             break;
         }
         case ScanValueType::DOUBLE: {
             double value = std::stod(valueBuffer.data());
-            success = g_pScanner->writeValue(address, value);
+            assign(&value, sizeof(value));
             break;
         }
         case ScanValueType::STRING_ASCII: {
@@ -1050,15 +1312,42 @@ void WriteValue() {
             std::vector<char> asciiBuffer(valueLength + 1);
             wcstombs(asciiBuffer.data(), valueBuffer.data(), valueLength + 1);
             std::string str(asciiBuffer.data());
-            success = g_pScanner->writeMemory(address, str.c_str(), str.length());
+            assign(str.c_str(), str.length());
             break;
         }
         case ScanValueType::STRING_UNICODE: {
             std::wstring str(valueBuffer.data());
-            success = g_pScanner->writeMemory(address, str.c_str(), str.length() * sizeof(wchar_t));
+            assign(str.c_str(), str.length() * sizeof(wchar_t));
             break;
         }
+        case ScanValueType::INT32_BE:
+        case ScanValueType::INT64_BE:
+        case ScanValueType::FLOAT_BE:
+        case ScanValueType::DOUBLE_BE:
+            // Written in the target's byte order
+            if (!parseScanValue(g_currentScanType, wideToUtf8(valueBuffer.data()), bytes)) return false;
+            break;
     }
+    return true;
+}
+
+void WriteValue() {
+    if (!g_pScanner) {
+        MessageBoxW(g_hMainWindow, L"Bitte hängen Sie sich zuerst an einen Prozess an!", L"Fehler", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    wchar_t addrBuffer[32];
+    GetWindowTextW(g_hAddressInput, addrBuffer, 32);
+
+    std::vector<uint8_t> bytes;
+    if (wcslen(addrBuffer) == 0 || !ParseNewValue(bytes)) {
+        MessageBoxW(g_hMainWindow, L"Bitte geben Sie Adresse und Wert ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    uintptr_t address = std::stoull(addrBuffer, nullptr, 16);
+    bool success = g_pScanner->writeMemory(address, bytes.data(), bytes.size());
 
     if (success) {
         UpdateStatusBar(L"✓ Wert erfolgreich geschrieben!");
@@ -1069,6 +1358,60 @@ void WriteValue() {
     }
 }
 
+void WriteValueToAllResults() {
+    if (!g_pScanner) {
+        MessageBoxW(g_hMainWindow, L"Bitte hängen Sie sich zuerst an einen Prozess an!", L"Fehler", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    size_t count = TotalMatchCount();
+    if (count == 0) {
+        MessageBoxW(g_hMainWindow, L"Keine Adressen in der Ergebnisliste!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    std::vector<uint8_t> bytes;
+    if (!ParseNewValue(bytes)) {
+        MessageBoxW(g_hMainWindow, L"Bitte geben Sie einen Wert ein!", L"Fehler", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    std::wstring question = L"Wert an alle " + std::to_wstring(count) + L" Adressen schreiben?";
+    if (MessageBoxW(g_hMainWindow, question.c_str(), L"Alle schreiben", MB_YESNO | MB_ICONQUESTION) != IDYES) {
+        return;
+    }
+
+    // All result addresses go into one batch, read back afterwards
+    WriteBatch batch;
+    batch.reserve(count, count * bytes.size());
+    for (const auto& shard : g_history.current().shards) {
+        auto rows = shard->load();
+        if (!rows) {
+            MessageBoxW(g_hMainWindow, L"Ausgelagerte Ergebnisse konnten nicht zurückgelesen werden, es wurde nichts geschrieben.",
+                        L"Fehler", MB_OK | MB_ICONERROR);
+            return;
+        }
+        for (uintptr_t address : rows->addresses()) {
+            batch.add(address, bytes.data(), bytes.size());
+        }
+    }
+
+    UpdateStatusBar(L"Schreibe " + std::to_wstring(batch.size()) + L" Adressen...");
+    WriteBatchResult result = batch.submit(*g_pScanner, true);
+    RefreshVisibleResults();
+
+    std::wstring summary = std::to_wstring(result.written) + L" von " + std::to_wstring(batch.size()) +
+                           L" Adressen geschrieben";
+    if (result.ok()) {
+        UpdateStatusBar(L"✓ " + summary);
+    } else {
+        summary += L", " + std::to_wstring(result.failed) + L" fehlgeschlagen, " +
+                   std::to_wstring(result.mismatched) + L" nicht bestätigt";
+        UpdateStatusBar(L"✗ " + summary);
+        MessageBoxW(g_hMainWindow, summary.c_str(), L"Alle schreiben", MB_OK | MB_ICONWARNING);
+    }
+}
+
 void ReadValue() {
     if (!g_pScanner) {
         MessageBoxW(g_hMainWindow, L"Bitte hängen Sie sich zuerst an einen Prozess an!", L"Fehler", MB_OK | MB_ICONERROR);
@@ -1088,11 +1431,12 @@ void ReadValue() {
     ss << L"Wert an Adresse 0x" << std::hex << address << L":\n\n";
     bool success = false;
 
-    // Read based on current scan type
+    // Read based on current scan type, through the pages the live rows keep cached
+    const std::chrono::milliseconds maxAge(CACHED_READ_MAX_AGE_MS);
     switch (g_currentScanType) {
         case ScanValueType::INT32: {
             int32_t value;
-            if (g_pScanner->readValue(address, value)) {
+            if (g_pScanner->readValueCached(address, value, maxAge)) {
                 ss << std::dec << value;
                 SetWindowTextW(g_hNewValueInput, std::to_wstring(value).c_str());
                 success = true;
@@ -1101,7 +1445,7 @@ void ReadValue() {
         }
         case ScanValueType::INT64: {
             int64_t value;
-            if (g_pScanner->readValue(address, value)) {
+            if (g_pScanner->readValueCached(address, value, maxAge)) {
                 ss << std::dec << value;
                 SetWindowTextW(g_hNewValueInput, std::to_wstring(value).c_str());
                 success = true;
@@ -1110,7 +1454,7 @@ void ReadValue() {
         }
         case ScanValueType::FLOAT: {
             float value;
-            if (g_pScanner->readValue(address, value)) {
+            if (g_pScanner->readValueCached(address, value, maxAge)) {
                 ss << value;
                 SetWindowTextW(g_hNewValueInput, std::to_wstring(value).c_str());
                 success = true;
@@ -1119,7 +1463,7 @@ void ReadValue() {
         }
         case ScanValueType::DOUBLE: {
             double value;
-            if (g_pScanner->readValue(address, value)) {
+            if (g_pScanner->readValueCached(address, value, maxAge)) {
                 ss << value;
                 SetWindowTextW(g_hNewValueInput, std::to_wstring(value).c_str());
                 success = true;
@@ -1129,7 +1473,7 @@ void ReadValue() {
         case ScanValueType::STRING_ASCII: {
             // Read up to 8KB as ASCII string
             std::vector<char> buffer(8192, 0);
-            if (g_pScanner->readMemory(address, buffer.data(), buffer.size() - 1)) {
+            if (g_pScanner->readCached(address, buffer.data(), buffer.size() - 1, maxAge)) {
                 std::string str(buffer.data());
                 std::wstring wstr(str.begin(), str.end());
                 ss << wstr;
@@ -1141,7 +1485,7 @@ void ReadValue() {
         case ScanValueType::STRING_UNICODE: {
             // Read up to 4KB wchars as Unicode string
             std::vector<wchar_t> buffer(4096, 0);
-            if (g_pScanner->readMemory(address, buffer.data(), (buffer.size() - 1) * sizeof(wchar_t))) {
+            if (g_pScanner->readCached(address, buffer.data(), (buffer.size() - 1) * sizeof(wchar_t), maxAge)) {
                 std::wstring str(buffer.data());
                 ss << str;
                 SetWindowTextW(g_hNewValueInput, str.c_str());
@@ -1149,6 +1493,23 @@ void ReadValue() {
             }
             break;
         }
+        case ScanValueType::INT32_BE:
+        case ScanValueType::INT64_BE:
+        case ScanValueType::FLOAT_BE:
+        case ScanValueType::DOUBLE_BE: {
+            // Shown and edited in host order
+            uint8_t bytes[8];
+            size_t size = scanValueTypeSize(g_currentScanType);
+            if (g_pScanner->readCached(address, bytes, size, maxAge)) {
+                char text[512];
+                size_t length = formatScanValue(g_currentScanType, bytes, size, text, sizeof(text));
+                std::wstring str(text, text + length);
+                ss << str;
+                SetWindowTextW(g_hNewValueInput, str.c_str());
+                success = true;
+            }
+            break;
+        }
     }
 
     if (success) {
@@ -1161,14 +1522,43 @@ void ReadValue() {
 }
 
 void ResetScan() {
-    g_currentMatches.clear();
-    g_stringMatches.clear();
-    g_wstringMatches.clear();
+    g_history.clear();
+    g_snapshot.clear();
+    UpdateHistoryButtons();
     g_hasInitialScan = false;
+    g_resultView.clear();
     ListView_DeleteAllItems(g_hResultList);
     UpdateStatusBar(L"✓ Scan zurückgesetzt");
 }
 
+size_t TotalMatchCount() {
+    return g_history.empty() ? 0 : g_history.current().count();
+}
+
+void StepScanHistory(bool redo) {
+    // Undo/redo only moves between existing generations, nothing is re-scanned
+    if (!(redo ? g_history.redo() : g_history.undo())) {
+        UpdateStatusBar(redo ? L"Nichts zum Wiederholen" : L"Nichts zum Rückgängigmachen");
+        return;
+    }
+
+    UpdateHistoryButtons();
+    UpdateResultList();
+
+    const std::string& label = g_history.current().label;
+    int length = MultiByteToWideChar(CP_UTF8, 0, label.data(), (int)label.size(), nullptr, 0);
+    std::wstring wlabel(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, label.data(), (int)label.size(), wlabel.data(), length);
+    UpdateStatusBar((redo ? L"↷ Wiederhergestellt: " : L"↶ Zurück zu: ") + wlabel +
+                    L" (" + std::to_wstring(TotalMatchCount()) + L" Adressen" +
+                    (g_history.current().damaged() ? L", unvollständig)" : L")"));
+}
+
+void UpdateHistoryButtons() {
+    if (g_hUndoButton) EnableWindow(g_hUndoButton, g_history.canUndo());
+    if (g_hRedoButton) EnableWindow(g_hRedoButton, g_history.canRedo());
+}
+
 void UpdateStatusBar(const std::wstring& text) {
     if (g_hStatusBar) {
         SendMessageW(g_hStatusBar, SB_SETTEXTW, 0, (LPARAM)text.c_str());
@@ -1211,31 +1601,25 @@ void OnAddressInputChanged() {
 void OnResultListItemSelected() {
     int selectedIndex = ListView_GetNextItem(g_hResultList, -1, LVNI_SELECTED);
 
-    if (selectedIndex == -1) {
+    if (selectedIndex == -1 || (size_t)selectedIndex >= g_resultView.rowCount()) {
         return; // No item selected
     }
 
-    // Get address text from the selected item
-    wchar_t addressText[32] = {0};
-    ListView_GetItemText(g_hResultList, selectedIndex, 0, addressText, 32);
+    // Rows of a shard lost with its spill file have no address to work with
+    std::optional<uintptr_t> address = g_resultView.addressAt(selectedIndex);
+    if (!address) return;
 
     // Set the address in the address input field
-    SetWindowTextW(g_hAddressInput, addressText);
-
-    // Parse the address and update input limit
-    if (wcslen(addressText) > 0) {
-        try {
-            uintptr_t address = std::stoull(addressText, nullptr, 16);
-            UpdateInputLimitForAddress(address);
-
-            // Also get the current value and display it
-            wchar_t valueText[256] = {0};
-            ListView_GetItemText(g_hResultList, selectedIndex, 1, valueText, 256);
-            SetWindowTextW(g_hNewValueInput, valueText);
-        } catch (...) {
-            // Invalid address
-        }
-    }
+    std::string_view addressText = g_resultView.formatCell(selectedIndex, ResultColumn::ADDRESS);
+    SetWindowTextW(g_hAddressInput, std::wstring(addressText.begin(), addressText.end()).c_str());
+    UpdateInputLimitForAddress(*address);
+
+    // Also get the current value and display it
+    std::string_view valueText = g_resultView.formatCell(selectedIndex, ResultColumn::VALUE);
+    int length = MultiByteToWideChar(CP_UTF8, 0, valueText.data(), (int)valueText.size(), nullptr, 0);
+    std::wstring value(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, valueText.data(), (int)valueText.size(), value.data(), length);
+    SetWindowTextW(g_hNewValueInput, value.c_str());
 }
 #else
 #include <iostream>
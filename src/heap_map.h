@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A live malloc allocation: address is the pointer malloc returned, size the bytes usable from it
+struct HeapChunk {
+    uintptr_t address;
+    size_t size;
+};
+
+// What the last heap walk found
+struct HeapMapStats {
+    uint32_t arenas = 0;
+    uint32_t heaps = 0;         // walked heaps: the brk heap plus the mmapped heaps of thread arenas
+    uint32_t failedHeaps = 0;   // could not be walked (changed under the walk), scanned as a whole
+    uint64_t liveChunks = 0;
+    uint64_t freeChunks = 0;    // in a bin, fastbin, tcache or the top chunk
+    uint64_t liveBytes = 0;
+    uint64_t freeBytes = 0;
+    uint64_t skippedBytes = 0;  // free stretches large enough that scans do not read them
+    uint64_t buildMicros = 0;
+};
+
+#ifdef __linux__
+class MemoryScanner;
+
+// Free stretches of a heap at least this large are cut out of the scanned regions (page
+// aligned), smaller ones are read with their neighbours and skipped by the compare
+constexpr size_t kHeapSkipMin = 256 * 1024;
+// Scans and filters reuse a heap map this young instead of walking the arenas again
+constexpr std::chrono::milliseconds kHeapMapMaxAge{ 100 };
+
+// Where a heap walk starts
+struct HeapSearch {
+    uintptr_t brkStart = 0;  // the [heap] mapping of the main arena, 0 if there is none
+    uintptr_t brkEnd = 0;
+    std::vector<std::pair<uintptr_t, uintptr_t>> dataRanges; // writable data of the C library holding main_arena
+};
+
+// Live-allocation map of a glibc malloc heap (x86-64, glibc 2.27 and later). main_arena is
+// found in the C library's data by the layout of its bins, the other arenas through its
+// ring. The chunk headers of every arena heap are walked through the scanner's read path;
+// a chunk is free if its successor's PREV_INUSE bit is clear or it is on a fastbin or tcache
+// list (safe-linked pointers of glibc 2.32 are recognised). Memory outside the walked heaps
+// (mmapped chunks, stacks, images) is not judged. Immutable once built.
+class HeapMap {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Walk the target's arenas. False with error set if no main_arena was found.
+    bool build(MemoryScanner& scanner, const HeapSearch& search, std::string& error);
+
+    Clock::time_point builtAt() const { return m_builtAt; }
+    const HeapMapStats& stats() const { return m_stats; }
+
+    // Live chunk whose usable bytes hold [address, address + size), nullptr if none does
+    const HeapChunk* chunkAt(uintptr_t address, size_t size) const;
+
+    // False if [address, address + size) overlaps a walked heap without lying inside one live chunk
+    bool allows(uintptr_t address, size_t size) const;
+
+    // Calls f(start, end) for the parts of [start, end) a scan looks at, in address order:
+    // memory outside the walked heaps and the usable bytes of live chunks inside them
+    template<typename F>
+    void forEachAllowedRun(uintptr_t start, uintptr_t end, F&& f) const;
+
+    // Page-aligned stretches of free chunks of at least kHeapSkipMin, in address order
+    const std::vector<std::pair<uintptr_t, uintptr_t>>& skippedRanges() const { return m_skipped; }
+
+private:
+    // A chunk header found by the walk
+    struct RawChunk {
+        uintptr_t address; // of the header
+        size_t size;
+        uint64_t link;     // first word of the user data: fd on a fastbin, next on a tcache list
+        bool free;
+    };
+
+    std::vector<HeapChunk> m_live;                          // in address order, disjoint
+    std::vector<std::pair<uintptr_t, uintptr_t>> m_heaps;   // walked heaps, in address order
+    std::vector<std::pair<uintptr_t, uintptr_t>> m_skipped;
+    HeapMapStats m_stats;
+    Clock::time_point m_builtAt;
+
+    // Chunks of [first, end) up to and including top, false if a header makes no sense
+    bool walkHeap(MemoryScanner& scanner, uintptr_t first, uintptr_t end, uintptr_t top, std::vector<RawChunk>& chunks);
+    // Walk one arena's heaps (the brk heap for main_arena), appending chunks and heap ranges
+    void walkArena(MemoryScanner& scanner, uintptr_t arena, bool mainArena, const HeapSearch& search,
+                   std::vector<RawChunk>& chunks);
+    // Mark the chunks on the fastbin lists of an arena and on the tcache lists as free,
+    // following the links the walk saw
+    void markFastbins(MemoryScanner& scanner, uintptr_t arena, std::vector<RawChunk>& chunks);
+    void markTcaches(MemoryScanner& scanner, std::vector<RawChunk>& chunks);
+    // Chunk with its header at address in a list in address order, nullptr if there is none
+    static RawChunk* findChunk(std::vector<RawChunk>& chunks, uintptr_t address);
+};
+
+template<typename F>
+void HeapMap::forEachAllowedRun(uintptr_t start, uintptr_t end, F&& f) const {
+    uintptr_t position = start;
+    auto heap = std::upper_bound(m_heaps.begin(), m_heaps.end(), start,
+                                 [](uintptr_t address, const auto& range) { return address < range.second; });
+    for (; heap != m_heaps.end() && heap->first < end; ++heap) {
+        if (position < heap->first) f(position, heap->first);
+        const uintptr_t inside = std::max(position, heap->first);
+        const uintptr_t insideEnd = std::min(end, heap->second);
+        auto chunk = std::upper_bound(m_live.begin(), m_live.end(), inside,
+                                      [](uintptr_t address, const HeapChunk& c) { return address < c.address + c.size; });
+        for (; chunk != m_live.end() && chunk->address < insideEnd; ++chunk) {
+            f(std::max(chunk->address, inside), std::min(chunk->address + chunk->size, insideEnd));
+        }
+        position = insideEnd;
+    }
+    if (position < end) f(position, end);
+}
+#endif
@@ -0,0 +1,332 @@
+#ifdef __linux__
+#include "heap_map.h"
+#include "memory_scanner.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Chunk layout of 64-bit glibc: prev_size and size, then the user data
+constexpr size_t kChunkHeader = 16;
+constexpr size_t kMinChunkSize = 32;
+constexpr size_t kChunkAlignment = 16;
+constexpr uint64_t kPrevInUse = 1;
+constexpr uint64_t kSizeFlags = 7; // PREV_INUSE, IS_MMAPPED, NON_MAIN_ARENA
+
+// malloc_state (glibc 2.27 and later), offsets from its start
+constexpr size_t kArenaFastbins = 16;
+constexpr size_t kFastbinCount = 10;
+constexpr size_t kArenaTop = 96;
+constexpr size_t kArenaBins = 112;
+constexpr size_t kBinCount = 127; // bins 1..127, an fd/bk pair each
+constexpr size_t kArenaNext = 2160;
+constexpr size_t kArenaSystemMem = 2184;
+constexpr size_t kArenaSize = 2200;
+
+// Thread arenas live in heaps aligned to their maximum size; heap_info is ar_ptr, prev,
+// size, mprotect_size and since glibc 2.35 pagesize (32 or 48 bytes with padding)
+constexpr uintptr_t kHeapMaxSize = 64 * 1024 * 1024;
+constexpr size_t kMaxHeapsPerArena = 1024;
+constexpr size_t kMaxArenas = 1024;
+
+// tcache_perthread_struct: 64 counts (uint16 since glibc 2.30, char before) and 64 list heads
+constexpr size_t kTcacheBins = 64;
+constexpr size_t kTcacheChunkSize = 0x290;
+constexpr size_t kOldTcacheChunkSize = 0x250;
+
+// The heap is walked through windows of this size
+constexpr size_t kHeapWalkWindow = 1024 * 1024;
+constexpr size_t kPageSize = 4096;
+
+uintptr_t alignUp(uintptr_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+uintptr_t alignDown(uintptr_t value, size_t alignment) { return value / alignment * alignment; }
+
+uint64_t wordAt(const std::vector<uint8_t>& data, size_t offset) {
+    uint64_t word;
+    std::memcpy(&word, &data[offset], sizeof(word));
+    return word;
+}
+
+// main_arena at offset of data (read from base): every bin is empty (fd and bk point at
+// the bin itself) or holds chunk pointers, most bins are empty, top and next are set
+bool looksLikeMainArena(const std::vector<uint8_t>& data, size_t offset, uintptr_t base) {
+    const uintptr_t arena = base + offset;
+    auto binSelf = [&](size_t bin) { return arena + kArenaBins + 16 * (bin - 1) - kChunkHeader; };
+
+    // The largest bins are all but always empty, a cheap first test
+    size_t last = offset + kArenaBins + 16 * (kBinCount - 1);
+    if (wordAt(data, last) != binSelf(kBinCount) || wordAt(data, last + 8) != binSelf(kBinCount)) return false;
+
+    size_t empty = 0;
+    for (size_t bin = 1; bin <= kBinCount; bin++) {
+        uint64_t fd = wordAt(data, offset + kArenaBins + 16 * (bin - 1));
+        uint64_t bk = wordAt(data, offset + kArenaBins + 16 * (bin - 1) + 8);
+        if (fd == binSelf(bin) && bk == binSelf(bin)) empty++;
+        else if (fd == 0 || bk == 0 || fd % kChunkAlignment || bk % kChunkAlignment) return false;
+    }
+    uint64_t top = wordAt(data, offset + kArenaTop);
+    uint64_t next = wordAt(data, offset + kArenaNext);
+    return empty >= kBinCount / 2 && top != 0 && top % kChunkAlignment == 0 && next != 0 &&
+           next % kChunkAlignment == 0 && wordAt(data, offset + kArenaSystemMem) != 0;
+}
+
+} // namespace
+
+bool HeapMap::build(MemoryScanner& scanner, const HeapSearch& search, std::string& error) {
+    auto start = Clock::now();
+    m_stats = HeapMapStats();
+    m_heaps.clear();
+
+    // main_arena is a static of the C library
+    uintptr_t mainArena = 0;
+    std::vector<uint8_t> data;
+    for (const auto& [rangeStart, rangeEnd] : search.dataRanges) {
+        if (rangeEnd - rangeStart < kArenaSize) continue;
+        data.resize(rangeEnd - rangeStart);
+        if (!scanner.readMemory(rangeStart, data.data(), data.size())) continue;
+        for (size_t offset = 0; offset + kArenaSize <= data.size(); offset += 8) {
+            if (looksLikeMainArena(data, offset, rangeStart)) {
+                mainArena = rangeStart + offset;
+                break;
+            }
+        }
+        if (mainArena) break;
+    }
+    if (!mainArena) {
+        error = "no glibc main_arena found (not a glibc target, or malloc not used yet)";
+        return false;
+    }
+
+    // Every arena's heaps, then the free lists that do not show in the headers
+    std::vector<RawChunk> chunks;
+    std::vector<uintptr_t> arenas;
+    for (uintptr_t arena = mainArena; arenas.size() < kMaxArenas;) {
+        arenas.push_back(arena);
+        walkArena(scanner, arena, arena == mainArena, search, chunks);
+        uint64_t next;
+        if (!scanner.readMemory(arena + kArenaNext, &next, sizeof(next)) || next == mainArena || next == 0) break;
+        arena = next;
+    }
+    std::ranges::sort(chunks, {}, &RawChunk::address);
+    std::ranges::sort(m_heaps);
+    for (uintptr_t arena : arenas) markFastbins(scanner, arena, chunks);
+    markTcaches(scanner, chunks);
+
+    m_live.clear();
+    m_skipped.clear();
+    uintptr_t freeStart = 0;
+    uintptr_t freeEnd = 0;
+    auto closeFree = [&] {
+        uintptr_t first = alignUp(freeStart, kPageSize);
+        uintptr_t last = alignDown(freeEnd, kPageSize);
+        if (last > first && last - first >= kHeapSkipMin) {
+            m_skipped.push_back({ first, last });
+            m_stats.skippedBytes += last - first;
+        }
+        freeStart = freeEnd = 0;
+    };
+    for (const auto& chunk : chunks) {
+        if (!chunk.free) {
+            if (freeEnd) closeFree();
+            m_live.push_back({ chunk.address + kChunkHeader, chunk.size - 8 });
+            m_stats.liveChunks++;
+            m_stats.liveBytes += chunk.size;
+            continue;
+        }
+        // Free chunks next to each other form one stretch
+        if (freeEnd && freeEnd != chunk.address) closeFree();
+        if (!freeEnd) freeStart = chunk.address;
+        freeEnd = chunk.address + chunk.size;
+        m_stats.freeChunks++;
+        m_stats.freeBytes += chunk.size;
+    }
+    if (freeEnd) closeFree();
+
+    m_stats.arenas = static_cast<uint32_t>(arenas.size());
+    m_stats.heaps = static_cast<uint32_t>(m_heaps.size());
+    m_builtAt = Clock::now();
+    m_stats.buildMicros = std::chrono::duration_cast<std::chrono::microseconds>(m_builtAt - start).count();
+    return true;
+}
+
+bool HeapMap::walkHeap(MemoryScanner& scanner, uintptr_t first, uintptr_t end, uintptr_t top, std::vector<RawChunk>& chunks) {
+    const size_t base = chunks.size();
+    std::vector<uint8_t> window;
+    uintptr_t windowStart = 0;
+    uintptr_t windowEnd = 0;
+
+    for (uintptr_t position = first;;) {
+        // A thread heap that does not hold top ends at its end or at the fencepost chunks
+        if (position == end && top == 0) return true;
+        if (position + kChunkHeader > end) return false;
+        // The header and the first word after it, a fencepost at the very end has no such word
+        const size_t needed = std::min<uintptr_t>(kChunkHeader + 8, end - position);
+        if (position < windowStart || position + needed > windowEnd) {
+            windowStart = position;
+            windowEnd = std::min<uintptr_t>(end, position + kHeapWalkWindow);
+            window.resize(windowEnd - windowStart);
+            if (!scanner.readMemory(windowStart, window.data(), window.size())) return false;
+        }
+
+        // A chunk's PREV_INUSE bit tells whether the one before it is in use
+        const uint64_t field = wordAt(window, position - windowStart + 8);
+        const size_t size = field & ~kSizeFlags;
+        if (chunks.size() > base) chunks.back().free = (field & kPrevInUse) == 0;
+        if (size == kChunkHeader && top == 0) return true;
+        if (size < kMinChunkSize || size % kChunkAlignment || size > end - position) return false;
+
+        // size is at least kMinChunkSize here, so the word is in the window
+        chunks.push_back({ position, size, wordAt(window, position - windowStart + kChunkHeader), position == top });
+        if (position == top) return true;
+        position += size;
+    }
+}
+
+void HeapMap::walkArena(MemoryScanner& scanner, uintptr_t arena, bool mainArena, const HeapSearch& search,
+                        std::vector<RawChunk>& chunks) {
+    uint64_t top;
+    if (!scanner.readMemory(arena + kArenaTop, &top, sizeof(top))) return;
+
+    // The walk races the target's allocations, a heap that fails is tried once more and
+    // otherwise left to be scanned as a whole
+    auto walk = [&](uintptr_t first, uintptr_t end, uintptr_t heapTop) {
+        const size_t base = chunks.size();
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (walkHeap(scanner, first, end, heapTop, chunks)) {
+                if (chunks.size() > base) m_heaps.push_back({ first, chunks.back().address + chunks.back().size });
+                return;
+            }
+            chunks.resize(base);
+        }
+        m_stats.failedHeaps++;
+    };
+
+    if (mainArena) {
+        // The brk heap; a main arena that had to fall back to mmap is not walked
+        if (search.brkStart && top >= search.brkStart && top < search.brkEnd) walk(search.brkStart, search.brkEnd, top);
+        return;
+    }
+
+    const uintptr_t firstHeap = arena & ~(kHeapMaxSize - 1);
+    uintptr_t heap = top & ~(kHeapMaxSize - 1);
+    for (size_t count = 0; heap != 0 && count < kMaxHeapsPerArena; count++) {
+        uint64_t info[5];
+        if (!scanner.readMemory(heap, info, sizeof(info)) || info[0] != arena) return;
+        const uintptr_t end = heap + info[2];
+
+        // The first heap holds the arena itself, the others start after heap_info; glibc
+        // 2.35 added pagesize to it, a power of two where older versions have the first chunk
+        uintptr_t first;
+        if (heap == firstHeap) first = alignUp(arena + kArenaSize, kChunkAlignment);
+        else first = heap + (info[4] >= kPageSize && (info[4] & (info[4] - 1)) == 0 ? 48 : 32);
+        walk(first, end, top >= heap && top < end ? top : 0);
+        heap = info[1];
+    }
+}
+
+void HeapMap::markFastbins(MemoryScanner& scanner, uintptr_t arena, std::vector<RawChunk>& chunks) {
+    uint64_t heads[kFastbinCount];
+    if (!scanner.readMemory(arena + kArenaFastbins, heads, sizeof(heads))) return;
+
+    auto find = [&](uintptr_t address) { return findChunk(chunks, address); };
+    for (size_t bin = 0; bin < kFastbinCount; bin++) {
+        uintptr_t chunk = heads[bin];
+        // A list can never be longer than the heap has chunks, a bound against cycles
+        for (size_t steps = 0; chunk != 0 && steps < chunks.size(); steps++) {
+            RawChunk* found = find(chunk);
+            if (!found) break;
+            found->free = true;
+
+            // fd is at chunk + 16, safe-linked (glibc 2.32) as (&fd >> 12) ^ next
+            const uint64_t fd = found->link;
+            uintptr_t demangled = fd ^ ((chunk + kChunkHeader) >> 12);
+            chunk = fd == 0 || find(fd) ? fd : demangled;
+        }
+    }
+}
+
+void HeapMap::markTcaches(MemoryScanner& scanner, std::vector<RawChunk>& chunks) {
+    // Every thread's tcache_perthread_struct is a chunk of one of two sizes, read them all
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (!chunks[i].free && (chunks[i].size == kTcacheChunkSize || chunks[i].size == kOldTcacheChunkSize)) {
+            candidates.push_back(i);
+        }
+    }
+    if (candidates.empty()) return;
+    std::vector<uint8_t> contents(candidates.size() * kTcacheChunkSize);
+    std::vector<MemoryIoRequest> requests(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const RawChunk& chunk = chunks[candidates[i]];
+        requests[i] = { chunk.address + kChunkHeader, &contents[i * kTcacheChunkSize], chunk.size - kChunkHeader, false };
+    }
+    scanner.readMemoryBatch(requests);
+
+    // Entries point at the user data of chunks of exactly the bin's size
+    auto entryChunk = [&](uintptr_t entry, size_t bin) -> RawChunk* {
+        if (entry < kChunkHeader) return nullptr;
+        RawChunk* chunk = findChunk(chunks, entry - kChunkHeader);
+        return chunk && chunk->size == kMinChunkSize + bin * kChunkAlignment ? chunk : nullptr;
+    };
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!requests[i].success) continue;
+        const uint8_t* tcache = &contents[i * kTcacheChunkSize];
+        const bool wideCounts = chunks[candidates[i]].size == kTcacheChunkSize;
+        const size_t entriesOffset = kTcacheBins * (wideCounts ? 2 : 1);
+        auto count = [&](size_t bin) -> size_t {
+            if (!wideCounts) return tcache[bin];
+            uint16_t value;
+            std::memcpy(&value, tcache + 2 * bin, sizeof(value));
+            return value;
+        };
+        auto entry = [&](size_t bin) {
+            uint64_t value;
+            std::memcpy(&value, tcache + entriesOffset + 8 * bin, sizeof(value));
+            return value;
+        };
+
+        // Only a chunk whose counts and heads agree everywhere is taken for a tcache
+        bool valid = true;
+        bool used = false;
+        for (size_t bin = 0; bin < kTcacheBins && valid; bin++) {
+            valid = (count(bin) == 0) == (entry(bin) == 0) && (entry(bin) == 0 || entryChunk(entry(bin), bin));
+            used = used || entry(bin) != 0;
+        }
+        if (!valid || !used) continue;
+
+        for (size_t bin = 0; bin < kTcacheBins; bin++) {
+            uintptr_t next = entry(bin);
+            for (size_t steps = 0; next != 0 && steps < count(bin); steps++) {
+                RawChunk* chunk = entryChunk(next, bin);
+                if (!chunk) break;
+                chunk->free = true;
+
+                // The link is the first word of the entry, safe-linked like the fastbins
+                const uint64_t link = chunk->link;
+                uintptr_t demangled = link ^ (next >> 12);
+                next = link == 0 || entryChunk(link, bin) ? link : demangled;
+            }
+        }
+    }
+}
+
+HeapMap::RawChunk* HeapMap::findChunk(std::vector<RawChunk>& chunks, uintptr_t address) {
+    auto it = std::ranges::lower_bound(chunks, address, {}, &RawChunk::address);
+    return it != chunks.end() && it->address == address ? &*it : nullptr;
+}
+
+const HeapChunk* HeapMap::chunkAt(uintptr_t address, size_t size) const {
+    auto chunk = std::upper_bound(m_live.begin(), m_live.end(), address,
+                                  [](uintptr_t value, const HeapChunk& c) { return value < c.address + c.size; });
+    if (chunk == m_live.end() || chunk->address > address || address + size > chunk->address + chunk->size) return nullptr;
+    return &*chunk;
+}
+
+bool HeapMap::allows(uintptr_t address, size_t size) const {
+    auto heap = std::upper_bound(m_heaps.begin(), m_heaps.end(), address,
+                                 [](uintptr_t value, const auto& range) { return value < range.second; });
+    if (heap == m_heaps.end() || heap->first >= address + size) return true;
+    return chunkAt(address, size) != nullptr;
+}
+#endif
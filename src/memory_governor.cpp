@@ -0,0 +1,110 @@
+#include "memory_governor.h"
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Budget when the physical memory size is unknown
+constexpr size_t kFallbackMemoryBudget = 2ull * 1024 * 1024 * 1024;
+
+} // namespace
+
+const char* memoryComponentName(MemoryComponent component) {
+    switch (component) {
+        case MemoryComponent::CHUNK_BUFFERS: return "chunk_buffers";
+        case MemoryComponent::SCAN_RESULTS: return "scan_results";
+        case MemoryComponent::SNAPSHOTS: return "snapshots";
+        case MemoryComponent::VIEW_CACHES: return "view_caches";
+        default: return "unknown";
+    }
+}
+
+MemoryGovernor::MemoryGovernor(size_t budget) : m_budget(budget) {}
+
+size_t MemoryGovernor::available() const {
+    size_t budget = m_budget;
+    size_t total = m_total;
+    return total < budget ? budget - total : 0;
+}
+
+void MemoryGovernor::book(MemoryComponent component, size_t bytes) {
+    size_t now = m_used[index(component)].fetch_add(bytes) + bytes;
+    size_t peak = m_peak[index(component)];
+    while (now > peak && !m_peak[index(component)].compare_exchange_weak(peak, now)) {}
+}
+
+bool MemoryGovernor::tryReserve(MemoryComponent component, size_t bytes) {
+    size_t total = m_total;
+    do {
+        if (bytes > m_budget || total > m_budget - bytes) return false;
+    } while (!m_total.compare_exchange_weak(total, total + bytes));
+    book(component, bytes);
+    return true;
+}
+
+void MemoryGovernor::reserve(MemoryComponent component, size_t bytes) {
+    m_total += bytes;
+    book(component, bytes);
+}
+
+void MemoryGovernor::release(MemoryComponent component, size_t bytes) {
+    m_total -= bytes;
+    m_used[index(component)] -= bytes;
+}
+
+size_t MemoryGovernor::chunkSize(size_t largest, size_t inFlight) const {
+    size_t share = available() / 4 / std::max<size_t>(inFlight, 1);
+    size_t size = largest;
+    while (size > kMinScanChunkSize && size > share) size /= 2;
+    return std::max<size_t>(size, std::min<size_t>(largest, kMinScanChunkSize));
+}
+
+size_t MemoryGovernor::readQueueDepth(size_t requested, size_t chunkSize) const {
+    if (chunkSize == 0) return requested;
+    return std::min<size_t>(requested, available() / 2 / chunkSize);
+}
+
+size_t defaultMemoryBudget() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) return static_cast<size_t>(status.ullTotalPhys / 4);
+#else
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) return static_cast<size_t>(pages) * static_cast<size_t>(pageSize) / 4;
+#endif
+    return kFallbackMemoryBudget;
+}
+
+MemoryGovernor& memoryGovernor() {
+    static MemoryGovernor governor(defaultMemoryBudget());
+    return governor;
+}
+
+MemoryReservation& MemoryReservation::operator=(MemoryReservation&& other) noexcept {
+    if (this != &other) {
+        force(0);
+        m_component = other.m_component;
+        m_bytes = other.m_bytes;
+        other.m_bytes = 0;
+    }
+    return *this;
+}
+
+bool MemoryReservation::resize(size_t bytes) {
+    if (bytes > m_bytes && !memoryGovernor().tryReserve(m_component, bytes - m_bytes)) return false;
+    if (bytes < m_bytes) memoryGovernor().release(m_component, m_bytes - bytes);
+    m_bytes = bytes;
+    return true;
+}
+
+void MemoryReservation::force(size_t bytes) {
+    if (bytes > m_bytes) memoryGovernor().reserve(m_component, bytes - m_bytes);
+    else if (bytes < m_bytes) memoryGovernor().release(m_component, m_bytes - bytes);
+    m_bytes = bytes;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Smallest chunk the governor shrinks scan reads to
+constexpr size_t kMinScanChunkSize = 256 * 1024;
+
+// What scanner memory is spent on
+enum class MemoryComponent {
+    CHUNK_BUFFERS, // read buffers of scans, including read-ahead slots
+    SCAN_RESULTS,  // resident result shards of scan histories
+    SNAPSHOTS,     // compressed memory snapshots
+    VIEW_CACHES,   // result view sort orders and similar UI caches
+    COUNT
+};
+
+const char* memoryComponentName(MemoryComponent component);
+
+// One budget for the scanner's own memory, shared by every component of the process.
+// Components reserve before they allocate and release when they free; optional memory
+// (snapshot blocks, view caches) is refused once the budget is used up, memory a scan
+// cannot do without is booked anyway. Scans ask the governor how big their chunks and how
+// deep their read-ahead may be, histories spill shards to disk beyond what it allows.
+class MemoryGovernor {
+public:
+    explicit MemoryGovernor(size_t budget);
+
+    void setBudget(size_t bytes) { m_budget = bytes; }
+    size_t budget() const { return m_budget; }
+
+    size_t used() const { return m_total; }
+    size_t used(MemoryComponent component) const { return m_used[index(component)]; }
+    size_t peak(MemoryComponent component) const { return m_peak[index(component)]; }
+    // Bytes left before the budget is reached, 0 when it is exceeded
+    size_t available() const;
+
+    // Book bytes if they fit into the budget
+    bool tryReserve(MemoryComponent component, size_t bytes);
+    // Book bytes whether or not they fit
+    void reserve(MemoryComponent component, size_t bytes);
+    void release(MemoryComponent component, size_t bytes);
+
+    // Chunk size for a scan keeping inFlight chunks in memory: largest halved until the
+    // chunks take at most a quarter of the free budget, never below kMinScanChunkSize
+    size_t chunkSize(size_t largest, size_t inFlight) const;
+    // Read-ahead depth (at most requested) whose chunk buffers fit into half the free budget
+    size_t readQueueDepth(size_t requested, size_t chunkSize) const;
+
+private:
+    std::atomic<size_t> m_budget;
+    std::atomic<size_t> m_total{0};
+    std::array<std::atomic<size_t>, static_cast<size_t>(MemoryComponent::COUNT)> m_used{};
+    std::array<std::atomic<size_t>, static_cast<size_t>(MemoryComponent::COUNT)> m_peak{};
+
+    static size_t index(MemoryComponent component) { return static_cast<size_t>(component); }
+    void book(MemoryComponent component, size_t bytes);
+};
+
+// A quarter of the physical memory, so a scanner never competes with its target for most of it
+size_t defaultMemoryBudget();
+
+// The governor of this process
+MemoryGovernor& memoryGovernor();
+
+// Bytes one owner holds of a component, released on destruction
+class MemoryReservation {
+public:
+    explicit MemoryReservation(MemoryComponent component, size_t bytes = 0) : m_component(component) { force(bytes); }
+    ~MemoryReservation() { force(0); }
+
+    MemoryReservation(MemoryReservation&& other) noexcept : m_component(other.m_component), m_bytes(other.m_bytes) {
+        other.m_bytes = 0;
+    }
+    MemoryReservation& operator=(MemoryReservation&& other) noexcept;
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    // Change the held amount; growing fails (and keeps the old amount) beyond the budget
+    bool resize(size_t bytes);
+    // Change the held amount regardless of the budget
+    void force(size_t bytes);
+
+    size_t bytes() const { return m_bytes; }
+
+private:
+    MemoryComponent m_component;
+    size_t m_bytes = 0;
+};
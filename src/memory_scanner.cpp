@@ -1,7 +1,11 @@
-#ifdef _WIN32
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
 #include "memory_scanner.h"
 #include <algorithm>
+#include <condition_variable>
 
+// Platform specific parts: the Win32 backend lives here, the Linux one in memory_scanner_linux.cpp
+#ifdef _WIN32
 #include <windows.h>
 #include <tchar.h>
 #include <stdio.h>
@@ -33,7 +37,7 @@ std::vector<Module> fetchModules( HANDLE hProcess )
 
                 modules.push_back(Module {
                     .name = std::string( name.substr(name.find_last_of("/\\") + 1) ),
-                    .baseAddress = reinterpret_cast<uintptr_t>(modinfo.EntryPoint),
+                    .baseAddress = reinterpret_cast<uintptr_t>(modinfo.lpBaseOfDll),
                     .size = modinfo.SizeOfImage,
                 });
             }
@@ -47,17 +51,30 @@ std::vector<Module> fetchModules( HANDLE hProcess )
     return modules;
 }
 
-MemoryScanner::MemoryScanner(HANDLE processHandle) : m_processHandle(processHandle), m_modules(fetchModules(m_processHandle)) {}
+MemoryScanner::MemoryScanner(ProcessHandle processHandle, std::shared_ptr<ProcessCache> cache)
+    : m_processHandle(processHandle), m_cache(std::move(cache)) {
+    // The first scanner on a process fills the shared cache
+    if (!m_cache) {
+        m_cache = std::make_shared<ProcessCache>();
+        refreshModules();
+    }
+}
 
 MemoryScanner::~MemoryScanner() {}
 
-std::vector<MemoryRegion> MemoryScanner::getReadableRegions() {
+void MemoryScanner::refreshModules() {
+    m_cache->publishModules(fetchModules(m_processHandle));
+}
+
+std::vector<MemoryRegion> MemoryScanner::enumerateRegions() {
+    auto start = ScanRecorder::Clock::now();
     std::vector<MemoryRegion> regions;
 
     MEMORY_BASIC_INFORMATION mbi;
     uintptr_t address = 0;
 
     while (VirtualQueryEx(m_processHandle, (LPCVOID)address, &mbi, sizeof(mbi))) {
+        countSyscall();
         if (mbi.State == MEM_COMMIT && isReadableRegion(MemoryRegion{
             (uintptr_t)mbi.BaseAddress, mbi.RegionSize, mbi.Protect, mbi.State, mbi.Type
         })) {
@@ -75,21 +92,15 @@ std::vector<MemoryRegion> MemoryScanner::getReadableRegions() {
         if (address == 0) break;
     }
 
+    m_recorder.recordEnumeration(start, regions.size());
     return regions;
 }
 
 
-Module* MemoryScanner::getModuleByAddress(uintptr_t address) {
-    for (int i = 0; i < m_modules.size(); i++) {
-        if (m_modules[i].baseAddress <= address && address <= m_modules[i].baseAddress + m_modules[i].size)
-            return &m_modules[i-1];
-    }
-    return &m_modules[0];
-}
-
 size_t MemoryScanner::getRegionSizeAtAddress(uintptr_t address) {
     MEMORY_BASIC_INFORMATION mbi;
 
+    countSyscall();
     if (VirtualQueryEx(m_processHandle, (LPCVOID)address, &mbi, sizeof(mbi))) {
         if (mbi.State == MEM_COMMIT) {
             // Calculate the remaining size from the given address to the end of the region
@@ -112,63 +123,683 @@ bool MemoryScanner::isReadableRegion(const MemoryRegion& region) {
 }
 
 bool MemoryScanner::readMemory(uintptr_t address, void* buffer, size_t size) {
-    SIZE_T bytesRead;
-    return ReadProcessMemory(m_processHandle, (LPCVOID)address, buffer, size, &bytesRead) && bytesRead == size;
+    auto start = ScanRecorder::Clock::now();
+    SIZE_T bytesRead = 0;
+    countSyscall();
+    bool success = ReadProcessMemory(m_processHandle, (LPCVOID)address, buffer, size, &bytesRead) && bytesRead == size;
+
+    if (m_recorder.active()) {
+        ReadFailure reason = ReadFailure::OTHER;
+        if (!success) {
+            switch (GetLastError()) {
+                case ERROR_PARTIAL_COPY: reason = bytesRead > 0 ? ReadFailure::PARTIAL : ReadFailure::UNMAPPED; break;
+                case ERROR_NOACCESS: reason = ReadFailure::UNMAPPED; break;
+                case ERROR_ACCESS_DENIED: reason = ReadFailure::PERMISSION; break;
+                default: break;
+            }
+        }
+        m_recorder.recordRead(address, size, success ? size : bytesRead, reason, start);
+    }
+    return success;
 }
 
 bool MemoryScanner::writeMemory(uintptr_t address, const void* buffer, size_t size) {
     SIZE_T bytesWritten;
+    m_pageCache.invalidate(address, size);
+    countSyscall();
     return WriteProcessMemory(m_processHandle, (LPVOID)address, buffer, size, &bytesWritten) && bytesWritten == size;
 }
+#endif
 
-std::vector<MemoryMatch<std::string>> MemoryScanner::scanForString(const std::string& value) {
-    std::vector<MemoryMatch<std::string>> matches;
-    auto regions = getReadableRegions();
+namespace {
+
+class ParallelPool {
+public:
+    void run(size_t count, const std::function<void(size_t)>& task) {
+        Job job(task, count);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t wanted = std::min(count - 1, std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1);
+        while (m_threads.size() < wanted) m_threads.emplace_back(&ParallelPool::work, this);
+        m_jobs.push_back(&job);
+        m_wake.notify_all();
+
+        while (job.next < job.count) execute(job, lock);
+        job.done.wait(lock, [&] { return job.finished == job.count; });
+    }
+
+private:
+    struct Job {
+        Job(const std::function<void(size_t)>& task, size_t count) : task(&task), count(count) {}
+
+        const std::function<void(size_t)>* task;
+        size_t count;
+        size_t next = 0;     // next index to hand out
+        size_t finished = 0;
+        std::condition_variable done;
+    };
+
+    // Take the next index of job and run it unlocked; a job leaves the queue with its last index
+    void execute(Job& job, std::unique_lock<std::mutex>& lock) {
+        size_t index = job.next++;
+        if (job.next == job.count) m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+        lock.unlock();
+        (*job.task)(index);
+        lock.lock();
+        if (++job.finished == job.count) job.done.notify_one();
+    }
 
-    for (const auto& region : regions) {
-        if (region.size < value.length()) continue;
+    void work() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return !m_jobs.empty(); });
+            execute(*m_jobs.front(), lock);
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Job*> m_jobs;
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace
+
+void runParallel(size_t count, const std::function<void(size_t)>& task) {
+    if (count <= 1) {
+        if (count == 1) task(0);
+        return;
+    }
+    // Never destroyed: its threads wait for work until the process exits
+    static ParallelPool* pool = new ParallelPool;
+    pool->run(count, task);
+}
+
+std::vector<size_t> MemoryScanner::planPartitions(size_t count) {
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t partitions = count < kFilterParallelThreshold ? 1 : std::clamp<size_t>(count / kFilterPartitionSize, 1, cores);
+
+    std::vector<size_t> starts(partitions + 1);
+    for (size_t p = 0; p <= partitions; p++) starts[p] = count * p / partitions;
+    return starts;
+}
+
+const Module* findModule(const ModuleList& modules, uintptr_t address) {
+    auto it = std::upper_bound(modules.begin(), modules.end(), address, [](uintptr_t value, const Module& module) {
+        return value < module.baseAddress;
+    });
+    if (it == modules.begin()) return nullptr;
+    --it;
+    return address - it->baseAddress < it->size ? &*it : nullptr;
+}
+
+std::shared_ptr<const RegionSnapshot> ProcessCache::publishRegions(std::vector<MemoryRegion> regions) {
+    // Page caches keyed to the generation survive re-enumerations of an unchanged map
+    auto previous = m_regions.load(std::memory_order_acquire);
+    uint64_t generation = previous ? previous->generation : 0;
+    auto sameRegion = [](const MemoryRegion& a, const MemoryRegion& b) {
+        return a.baseAddress == b.baseAddress && a.size == b.size && a.protection == b.protection &&
+               a.state == b.state && a.type == b.type;
+    };
+    if (!previous || !std::ranges::equal(previous->regions, regions, sameRegion)) generation++;
+
+    auto snapshot = std::make_shared<const RegionSnapshot>(
+        RegionSnapshot{ std::move(regions), std::chrono::steady_clock::now(), generation });
+    m_regions.store(snapshot, std::memory_order_release);
+
+    // Both lists are in address order
+    std::lock_guard<std::mutex> lock(m_badRangesMutex);
+    const auto& current = snapshot->regions;
+    size_t region = 0;
+    for (auto bad = m_badRanges.begin(); bad != m_badRanges.end();) {
+        while (region < current.size() && current[region].baseAddress + current[region].size <= bad->first) region++;
+        bool inside = region < current.size() && current[region].baseAddress <= bad->first &&
+                      bad->second <= current[region].baseAddress + current[region].size;
+        bad = inside ? std::next(bad) : m_badRanges.erase(bad);
+    }
+    return snapshot;
+}
+
+void ProcessCache::publishModules(ModuleList modules) {
+    m_modules.store(std::make_shared<const ModuleList>(std::move(modules)), std::memory_order_release);
+}
+
+bool ProcessCache::overlapsBadRange(uintptr_t address, size_t size) const {
+    std::lock_guard<std::mutex> lock(m_badRangesMutex);
+    auto next = m_badRanges.lower_bound(address + size);
+    if (next == m_badRanges.begin()) return false;
+    --next;
+    return next->second > address;
+}
 
-        std::vector<uint8_t> buffer(region.size);
+std::vector<std::pair<uintptr_t, uintptr_t>> ProcessCache::badRangesIn(uintptr_t start, uintptr_t end) const {
+    std::lock_guard<std::mutex> lock(m_badRangesMutex);
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+    auto bad = m_badRanges.upper_bound(start);
+    if (bad != m_badRanges.begin() && std::prev(bad)->second > start) --bad;
+    for (; bad != m_badRanges.end() && bad->first < end; ++bad) {
+        ranges.emplace_back(std::max<uintptr_t>(bad->first, start), std::min<uintptr_t>(bad->second, end));
+    }
+    return ranges;
+}
+
+void ProcessCache::addBadRange(uintptr_t start, uintptr_t end) {
+    // Touching ranges are merged, so the map stays disjoint
+    std::lock_guard<std::mutex> lock(m_badRangesMutex);
+    auto next = m_badRanges.upper_bound(start);
+    if (next != m_badRanges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->second >= start) {
+            start = previous->first;
+            end = std::max(end, previous->second);
+            next = m_badRanges.erase(previous);
+        }
+    }
+    while (next != m_badRanges.end() && next->first <= end) {
+        end = std::max(end, next->second);
+        next = m_badRanges.erase(next);
+    }
+    m_badRanges.emplace(start, end);
+}
+
+std::vector<uint8_t> ProcessCache::takeBuffer() {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    if (m_pool.empty()) return {};
+    std::vector<uint8_t> buffer = std::move(m_pool.back());
+    m_pool.pop_back();
+    m_poolReservation.force(m_poolReservation.bytes() - buffer.capacity());
+    return buffer;
+}
+
+void ProcessCache::returnBuffer(std::vector<uint8_t> buffer) {
+    // Idle buffers count against the memory budget, one that does not fit is freed
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    if (buffer.capacity() == 0 || m_pool.size() >= kMaxPooledBuffers) return;
+    if (!m_poolReservation.resize(m_poolReservation.bytes() + buffer.capacity())) return;
+    m_pool.push_back(std::move(buffer));
+}
+
+std::vector<MemoryRegion> MemoryScanner::getReadableRegions() {
+    auto regions = enumerateRegions();
+    m_cache->publishRegions(regions);
+    return regions;
+}
+
+std::shared_ptr<const RegionSnapshot> MemoryScanner::scanRegions() {
+    // Sessions scanning the same process at once share one walk of the memory map
+    auto cached = m_cache->regions();
+    if (!cached || std::chrono::steady_clock::now() - cached->taken >= kRegionCacheMaxAge) {
+        cached = m_cache->publishRegions(enumerateRegions());
+    }
+    return m_heapFilter ? withoutFreeHeap(std::move(cached)) : cached;
+}
+
+bool MemoryScanner::getModuleByAddress(uintptr_t address, Module& module) const {
+    auto modules = m_cache->modules();
+    const Module* found = findModule(*modules, address);
+    if (!found) return false;
+    module = *found;
+    return true;
+}
+
+// Reads one chunk's recovery may spend on bisection: enough to prove every page of a default
+// chunk bad (2n - 1 reads for n pages), a bound against chunks that shrink in the meantime
+static constexpr size_t kMaxRecoveryReads = 2 * kScanChunkSize / kReadPageSize;
+
+size_t MemoryScanner::readCachedBatch(std::vector<MemoryIoRequest>& requests, std::chrono::milliseconds maxAge) {
+    auto pageOf = [](uintptr_t address) { return address / kCachedPageSize * kCachedPageSize; };
+
+    // Every page the requests touch, once
+    std::vector<uintptr_t> pages;
+    for (const auto& request : requests) {
+        if (request.size == 0) continue;
+        for (uintptr_t page = pageOf(request.address);; page += kCachedPageSize) {
+            pages.push_back(page);
+            if (page == pageOf(request.address + request.size - 1)) break;
+        }
+    }
+    std::ranges::sort(pages);
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    // Reads bigger than half the cache would only evict what the next refresh needs
+    if (pages.size() > kPageCacheCapacity / 2 || !m_pageCache.ready()) return readMemoryBatch(requests);
+    auto regions = m_cache->regions();
+    m_pageCache.setGeneration(regions ? regions->generation : 0);
+
+    const auto now = PageCache::Clock::now();
+    std::vector<const uint8_t*> data(pages.size());
+    std::vector<uint8_t> fetched;
+    std::vector<MemoryIoRequest> misses;
+    std::vector<size_t> missIndex;
+    for (size_t i = 0; i < pages.size(); i++) {
+        bool found;
+        data[i] = m_pageCache.find(pages[i], now - maxAge, found);
+        if (!found) missIndex.push_back(i);
+    }
+
+    // Missing pages in one batch, neighbours coalesce into one read
+    fetched.resize(missIndex.size() * kCachedPageSize);
+    for (size_t m = 0; m < missIndex.size(); m++) {
+        misses.push_back({ pages[missIndex[m]], fetched.data() + m * kCachedPageSize, kCachedPageSize, false });
+    }
+    if (!misses.empty()) readMemoryBatch(misses);
+    for (size_t m = 0; m < misses.size(); m++) {
+        if (misses[m].success) data[missIndex[m]] = static_cast<const uint8_t*>(misses[m].buffer);
+    }
+
+    // Copy out before inserting, an insert may replace a page this batch still reads
+    size_t succeeded = 0;
+    for (auto& request : requests) {
+        request.success = true;
+        auto* out = static_cast<uint8_t*>(request.buffer);
+        for (size_t done = 0; done < request.size && request.success;) {
+            uintptr_t address = request.address + done;
+            size_t index = std::lower_bound(pages.begin(), pages.end(), pageOf(address)) - pages.begin();
+            size_t inPage = address - pages[index];
+            size_t length = std::min(kCachedPageSize - inPage, request.size - done);
+            if (data[index]) std::memcpy(out + done, data[index] + inPage, length);
+            else request.success = false;
+            done += length;
+        }
+        if (request.success) succeeded++;
+    }
+    for (const auto& miss : misses) {
+        m_pageCache.insert(miss.address, now, miss.success ? static_cast<const uint8_t*>(miss.buffer) : nullptr);
+    }
+    return succeeded;
+}
+
+bool MemoryScanner::readCached(uintptr_t address, void* buffer, size_t size, std::chrono::milliseconds maxAge) {
+    std::vector<MemoryIoRequest> requests{ { address, buffer, size, false } };
+    return readCachedBatch(requests, maxAge) == 1;
+}
+
+#ifdef _WIN32
+static std::vector<size_t> sortedRequestOrder(const std::vector<MemoryIoRequest>& requests) {
+    std::vector<size_t> order(requests.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::ranges::sort(order, [&](size_t a, size_t b) {
+        return requests[a].address < requests[b].address;
+    });
+    return order;
+}
 
-        if (readMemory(region.baseAddress, buffer.data(), region.size)) {
-            for (size_t i = 0; i <= region.size - value.length(); i++) {
-                if (memcmp(&buffer[i], value.c_str(), value.length()) == 0) {
-                    MemoryMatch<std::string> match;
-                    match.address = region.baseAddress + i;
-                    match.value = value;
-                    matches.push_back(match);
+size_t MemoryScanner::readMemoryBatch(std::vector<MemoryIoRequest>& requests) {
+    // Win32 has no vectored ReadProcessMemory, so batching means merging neighbouring ranges
+    // (Linux reads the merged spans with process_vm_readv, see memory_scanner_linux.cpp)
+    auto order = sortedRequestOrder(requests);
+    std::vector<uint8_t> span;
+    size_t succeeded = 0;
+
+    size_t begin = 0;
+    while (begin < order.size()) {
+        uintptr_t spanStart = requests[order[begin]].address;
+        uintptr_t spanEnd = spanStart + requests[order[begin]].size;
+        size_t end = begin + 1;
+        while (end < order.size()) {
+            const auto& next = requests[order[end]];
+            if (next.address > spanEnd + kBatchCoalesceGap || next.address + next.size - spanStart > kBatchMaxSpan) break;
+            spanEnd = std::max<uintptr_t>(spanEnd, next.address + next.size);
+            end++;
+        }
+
+        if (end - begin > 1) {
+            span.resize(spanEnd - spanStart);
+            if (readMemory(spanStart, span.data(), span.size())) {
+                for (size_t i = begin; i < end; i++) {
+                    auto& request = requests[order[i]];
+                    std::memcpy(request.buffer, &span[request.address - spanStart], request.size);
+                    request.success = true;
+                    succeeded++;
+                }
+                begin = end;
+                continue;
+            }
+        }
+
+        // Single range, or the merged span crosses unreadable memory
+        for (size_t i = begin; i < end; i++) {
+            auto& request = requests[order[i]];
+            request.success = readMemory(request.address, request.buffer, request.size);
+            if (request.success) succeeded++;
+        }
+        begin = end;
+    }
+
+    return succeeded;
+}
+
+void MemoryScanner::readChunks(const std::vector<MemoryRegion>& regions, const std::vector<ScanChunk>& chunks, const ChunkCompare& compare) {
+    // ReadProcessMemory has no asynchronous form, chunks are read and compared in turn
+    readChunksInTurn(regions, chunks, compare);
+}
+
+size_t MemoryScanner::writeMemoryBatch(std::vector<MemoryIoRequest>& requests) {
+    // No vectored WriteProcessMemory either: exactly adjacent ranges are merged into one
+    // write, gaps must not be overwritten (Linux uses process_vm_writev, see memory_scanner_linux.cpp)
+    auto order = sortedRequestOrder(requests);
+    std::vector<uint8_t> span;
+    size_t succeeded = 0;
+
+    size_t begin = 0;
+    while (begin < order.size()) {
+        uintptr_t spanStart = requests[order[begin]].address;
+        uintptr_t spanEnd = spanStart + requests[order[begin]].size;
+        size_t end = begin + 1;
+        while (end < order.size()) {
+            const auto& next = requests[order[end]];
+            if (next.address != spanEnd || spanEnd + next.size - spanStart > kBatchMaxSpan) break;
+            spanEnd += next.size;
+            end++;
+        }
+
+        if (end - begin > 1) {
+            span.resize(spanEnd - spanStart);
+            for (size_t i = begin; i < end; i++) {
+                const auto& request = requests[order[i]];
+                std::memcpy(&span[request.address - spanStart], request.buffer, request.size);
+            }
+            if (writeMemory(spanStart, span.data(), span.size())) {
+                for (size_t i = begin; i < end; i++) {
+                    requests[order[i]].success = true;
+                    succeeded++;
                 }
+                begin = end;
+                continue;
+            }
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            auto& request = requests[order[i]];
+            request.success = writeMemory(request.address, request.buffer, request.size);
+            if (request.success) succeeded++;
+        }
+        begin = end;
+    }
+
+    return succeeded;
+}
+
+// The heap filter walks glibc's malloc arenas, Windows targets are scanned as a whole
+bool MemoryScanner::setHeapFilter(bool enabled, std::string& error) {
+    if (!enabled) return true;
+    error = "heap-aware scanning needs a Linux target using glibc malloc";
+    return false;
+}
+
+void MemoryScanner::refreshHeapMap() {}
+
+bool MemoryScanner::heapAllows(uintptr_t, size_t) const { return true; }
+
+bool MemoryScanner::heapChunkOf(uintptr_t, size_t, HeapChunk&) const { return false; }
+
+HeapMapStats MemoryScanner::heapMapStats() const { return HeapMapStats(); }
+
+std::shared_ptr<const RegionSnapshot> MemoryScanner::withoutFreeHeap(std::shared_ptr<const RegionSnapshot> regions) {
+    return regions;
+}
+
+MemoryScanner::ChunkCompare MemoryScanner::liveHeapOnly(ChunkCompare compare) const { return compare; }
+
+void MemoryScanner::shareHeapFilter(MemoryScanner&) const {}
+#endif
+
+std::vector<ScanChunk> MemoryScanner::planChunks(const std::vector<MemoryRegion>& regions, size_t minSize, size_t overlap) {
+    const size_t chunkSize = scanChunkSize();
+    std::vector<ScanChunk> chunks;
+    for (size_t index = 0; index < regions.size(); index++) {
+        const MemoryRegion& region = regions[index];
+        if (region.size < minSize) {
+            m_recorder.skipRegion();
+            continue;
+        }
+
+        const uintptr_t regionEnd = region.baseAddress + region.size;
+        for (uintptr_t chunkStart = region.baseAddress; chunkStart < regionEnd; chunkStart += chunkSize) {
+            uintptr_t chunkEnd = std::min<uintptr_t>(chunkStart + chunkSize + overlap, regionEnd);
+            if (chunkEnd - chunkStart < minSize) break;
+            chunks.push_back(ScanChunk{ chunkStart, chunkEnd - chunkStart, chunkStart, index });
+        }
+    }
+    return chunks;
+}
+
+void MemoryScanner::readChunksInTurn(const std::vector<MemoryRegion>& regions, const std::vector<ScanChunk>& chunks, const ChunkCompare& compare) {
+    PooledBuffer buffer(*m_cache);
+    size_t region = regions.size();
+    for (const auto& chunk : chunks) {
+        if (chunk.region != region) {
+            region = chunk.region;
+            m_recorder.beginRegion(regions[region].baseAddress, regions[region].size);
+        }
+
+        uint8_t* data = buffer.resize(chunk.size);
+        m_recorder.recordBuffer(buffer.capacity());
+
+        // A chunk over known bad pages skips the full read, it would fail anyway
+        if (m_cache->overlapsBadRange(chunk.address, chunk.size)) {
+            recoverChunk(chunk, data, compare, false);
+        } else if (readMemory(chunk.address, data, chunk.size)) {
+            compare(chunk, data);
+        } else {
+            recoverChunk(chunk, data, compare, true);
+        }
+    }
+}
+
+void MemoryScanner::recoverChunk(const ScanChunk& chunk, uint8_t* buffer, const ChunkCompare& compare, bool fullReadFailed) {
+    const uintptr_t chunkEnd = chunk.address + chunk.size;
+    std::vector<ScanChunk> runs;
+    size_t reads = 0;
+
+    auto addRun = [&](uintptr_t start, uintptr_t end) {
+        if (!runs.empty() && runs.back().address + runs.back().size == start) {
+            runs.back().size += end - start;
+        } else {
+            runs.push_back(ScanChunk{ start, end - start, chunk.core, chunk.region });
+        }
+    };
+
+    // Halves are tried until a failed range lies within one page. Past kMaxRecoveryReads the
+    // rest of the chunk is left out unproven (and probed again by the next scan).
+    auto probe = [&](auto& self, uintptr_t start, uintptr_t end, bool failed) -> void {
+        if (!failed) {
+            if (reads == kMaxRecoveryReads) {
+                m_recorder.recordHole(start, end - start, false);
+                return;
+            }
+            reads++;
+            if (readMemory(start, buffer + (start - chunk.address), end - start)) {
+                addRun(start, end);
+                return;
             }
         }
+
+        uintptr_t firstPage = start / kReadPageSize;
+        uintptr_t lastPage = (end - 1) / kReadPageSize;
+        if (firstPage == lastPage) {
+            m_cache->addBadRange(firstPage * kReadPageSize, (lastPage + 1) * kReadPageSize);
+            m_recorder.recordHole(start, end - start, false);
+            return;
+        }
+        uintptr_t middle = (firstPage + lastPage + 1) / 2 * kReadPageSize;
+        self(self, start, middle, false);
+        self(self, middle, end, false);
+    };
+
+    // Cached bad ranges are cut out first, only the memory between them is probed
+    auto known = m_cache->badRangesIn(chunk.address, chunkEnd);
+    known.emplace_back(chunkEnd, chunkEnd);
+
+    uintptr_t position = chunk.address;
+    for (const auto& [badStart, badEnd] : known) {
+        if (position < badStart) {
+            probe(probe, position, badStart, fullReadFailed && position == chunk.address && badStart == chunkEnd);
+        }
+        if (badStart < badEnd) m_recorder.recordHole(badStart, badEnd - badStart, true);
+        position = badEnd;
     }
 
+    for (const auto& run : runs) {
+        m_recorder.recordRecovered(run.size);
+        compare(run, buffer + (run.address - chunk.address));
+    }
+}
+
+std::vector<MemoryMatch<std::string>> MemoryScanner::scanForString(const std::string& value) {
+    ScanOperationScope operation(m_recorder, "scanForString");
+    std::vector<MemoryMatch<std::string>> matches;
+    if (value.empty()) return matches;
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
+
+    // Chunks overlap by the needle length - 1, like the value scans
+    readChunks(regions, planChunks(regions, value.length(), value.length() - 1), liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* data) {
+        auto compareStart = ScanRecorder::Clock::now();
+        size_t before = matches.size();
+        findPattern(data, chunk.size, reinterpret_cast<const uint8_t*>(value.data()), value.length(), [&](size_t i) {
+            MemoryMatch<std::string> match;
+            match.address = chunk.address + i;
+            match.value = value;
+            matches.push_back(match);
+        });
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, matches.size() - before);
+    }));
+
     return matches;
 }
 
 std::vector<MemoryMatch<std::wstring>> MemoryScanner::scanForWideString(const std::wstring& value) {
+    ScanOperationScope operation(m_recorder, "scanForWideString");
     std::vector<MemoryMatch<std::wstring>> matches;
-    auto regions = getReadableRegions();
+    if (value.empty()) return matches;
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
 
     size_t searchSize = value.length() * sizeof(wchar_t);
 
-    for (const auto& region : regions) {
-        if (region.size < searchSize) continue;
+    readChunks(regions, planChunks(regions, searchSize, searchSize - 1), liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* data) {
+        auto compareStart = ScanRecorder::Clock::now();
+        size_t before = matches.size();
+        findPattern(data, chunk.size, reinterpret_cast<const uint8_t*>(value.data()), searchSize, [&](size_t i) {
+            MemoryMatch<std::wstring> match;
+            match.address = chunk.address + i;
+            match.value = value;
+            matches.push_back(match);
+        });
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, matches.size() - before);
+    }));
 
-        std::vector<uint8_t> buffer(region.size);
+    return matches;
+}
 
-        if (readMemory(region.baseAddress, buffer.data(), region.size)) {
-            for (size_t i = 0; i <= region.size - searchSize; i++) {
-                if (memcmp(&buffer[i], value.c_str(), searchSize) == 0) {
-                    MemoryMatch<std::wstring> match;
-                    match.address = region.baseAddress + i;
-                    match.value = value;
-                    matches.push_back(match);
-                }
-            }
+std::vector<GroupMatch> MemoryScanner::scanForGroup(const std::vector<GroupScanTerm>& terms) {
+    ScanOperationScope operation(m_recorder, "scanForGroup");
+    std::vector<GroupMatch> matches;
+
+    size_t anchorIndex = selectGroupAnchor(terms);
+    if (anchorIndex == terms.size()) return matches;
+
+    const GroupScanTerm& anchor = terms[anchorIndex];
+    const size_t anchorSize = groupTermSize(anchor);
+
+    // Window around an anchor hit that must be in the buffer to verify every term
+    int64_t windowBefore = 0;
+    int64_t windowAfter = static_cast<int64_t>(anchorSize);
+    for (const auto& term : terms) {
+        int64_t relative = term.offset - anchor.offset;
+        windowBefore = std::min(windowBefore, relative);
+        windowAfter = std::max(windowAfter, relative + static_cast<int64_t>(term.range + groupTermSize(term)));
+    }
+
+    std::vector<uintptr_t> termAddresses(terms.size());
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
+
+    // Every chunk holds one core plus the group window around it
+    const size_t chunkSize = scanChunkSize();
+    std::vector<ScanChunk> chunks;
+    for (size_t index = 0; index < regions.size(); index++) {
+        const MemoryRegion& region = regions[index];
+        if (region.size < anchorSize) {
+            m_recorder.skipRegion();
+            continue;
+        }
+        const uintptr_t regionEnd = region.baseAddress + region.size;
+        for (uintptr_t coreStart = region.baseAddress; coreStart < regionEnd; coreStart += chunkSize) {
+            uintptr_t coreEnd = std::min<uintptr_t>(coreStart + chunkSize, regionEnd);
+            uintptr_t bufferStart = std::max<uintptr_t>(region.baseAddress, coreStart + windowBefore);
+            uintptr_t bufferEnd = std::min<uintptr_t>(regionEnd, coreEnd + windowAfter);
+            chunks.push_back(ScanChunk{ bufferStart, bufferEnd - bufferStart, coreStart, index });
         }
     }
 
+    // Members of a structure lie in one allocation, the anchor has to be in a live chunk
+    readChunks(regions, chunks, liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* buffer) {
+        const MemoryRegion& region = regions[chunk.region];
+        const uintptr_t coreEnd = std::min<uintptr_t>(chunk.core + chunkSize, region.baseAddress + region.size);
+        const uintptr_t bufferStart = chunk.address;
+        const uintptr_t bufferEnd = chunk.address + chunk.size;
+        // A run recovered from a partly unreadable chunk may start inside the core
+        const uintptr_t coreStart = std::max<uintptr_t>(chunk.core, bufferStart);
+        if (coreStart >= coreEnd || bufferEnd < coreStart + anchorSize) return;
+
+        auto compareStart = ScanRecorder::Clock::now();
+        size_t before = matches.size();
+
+        // Anchor hits must start inside the core, the window only serves verification
+        size_t searchSize = std::min<uintptr_t>(bufferEnd, coreEnd + anchorSize - 1) - coreStart;
+        const uint8_t* core = buffer + (coreStart - bufferStart);
+
+        findPattern(core, searchSize, anchor.value.data(), anchorSize, [&](size_t offset) {
+            uintptr_t base = coreStart + offset - anchor.offset;
+
+            for (size_t t = 0; t < terms.size(); t++) {
+                const GroupScanTerm& term = terms[t];
+                if (t == anchorIndex) {
+                    termAddresses[t] = coreStart + offset;
+                    continue;
+                }
+
+                size_t size = groupTermSize(term);
+                size_t step = term.range == 0 ? 1 : groupTermAlignment(term);
+                uintptr_t first = base + term.offset;
+                bool found = false;
+                for (uintptr_t address = first; address <= first + term.range; address += step) {
+                    if (address < bufferStart || address + size > bufferEnd) continue;
+                    if (matchGroupTerm(term, &buffer[address - bufferStart])) {
+                        termAddresses[t] = address;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) return;
+            }
+
+            matches.push_back(GroupMatch{ base, termAddresses });
+        });
+        m_recorder.recordCompare(coreStart, coreEnd - coreStart, compareStart, matches.size() - before);
+    }));
+
     return matches;
 }
 
+bool MemoryScanner::captureSnapshot(MemorySnapshot& snapshot) {
+    ScanOperationScope operation(m_recorder, "captureSnapshot");
+    snapshot.clear();
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
+    for (const auto& region : regions) snapshot.addRegion(region.baseAddress, region.size);
+
+    // Plain chunks without overlap, every page is compressed while the next chunk is read.
+    // Once the memory budget is used up the remaining chunks are left out.
+    bool complete = true;
+    readChunks(regions, planChunks(regions, 1, 0), [&](const ScanChunk& chunk, const uint8_t* data) {
+        if (!complete) return;
+        auto compareStart = ScanRecorder::Clock::now();
+        complete = snapshot.store(chunk.address, data, chunk.size);
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, 0);
+    });
+    return complete;
+}
+
 #endif
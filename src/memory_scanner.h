@@ -1,19 +1,54 @@
 #pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <cstring>
+#include <cmath>
 #include <string>
 #include <map>
+#include <thread>
+#include <type_traits>
+#include "byte_order.h"
+#include "group_scan.h"
+#include "heap_map.h"
+#include "memory_governor.h"
+#include "memory_snapshot.h"
+#include "page_cache.h"
+#include "scan_kernels.h"
+#include "scan_stats.h"
+#include "value_set.h"
+#ifdef __linux__
+#include "read_pipeline.h"
+#endif
+
+#ifdef _WIN32
+using ProcessHandle = HANDLE;
+using RegionFlags = DWORD;
+#else
+// On Linux the target is addressed by its pid
+using ProcessHandle = pid_t;
+using RegionFlags = uint32_t;
+#endif
 
 // Represents a memory region
 struct MemoryRegion {
     uintptr_t baseAddress;
     size_t size;
-    DWORD protection;
-    DWORD state;
-    DWORD type;
+    RegionFlags protection; // PAGE_* on Windows, PROT_* on Linux
+    RegionFlags state;      // MEM_COMMIT etc. on Windows, unused on Linux
+    RegionFlags type;       // MEM_IMAGE/MEM_MAPPED/MEM_PRIVATE on Windows, MAP_SHARED/MAP_PRIVATE on Linux
 };
 
 // Represents a found memory address with its value
@@ -23,27 +58,159 @@ struct MemoryMatch {
     T value;
 };
 
+// One entry of a batched (scatter/gather) memory operation
+struct MemoryIoRequest {
+    uintptr_t address;
+    void* buffer;
+    size_t size;
+    bool success;
+};
+
+// Regions are read in chunks of this size, a large region never needs one huge buffer
+constexpr size_t kScanChunkSize = 4 * 1024 * 1024;
+
+// Granularity of partial-read recovery and of the bad-range cache
+constexpr size_t kReadPageSize = 4096;
+
+// Smallest share of a filter's candidates worth a thread of its own
+constexpr size_t kFilterPartitionSize = 16 * 1024;
+// Filters of fewer candidates run on the calling thread alone
+constexpr size_t kFilterParallelThreshold = 64 * 1024;
+// Candidates whose current values a filter partition reads with one batch
+constexpr size_t kFilterReadWindow = 4096;
+
+// Ranges of a batch closer than this are fetched with one read
+constexpr size_t kBatchCoalesceGap = 4096;
+// Upper bound for a single coalesced read or write
+constexpr size_t kBatchMaxSpan = 64 * 1024;
+
+// One planned read of a scan. Chunks of a region are consecutive and in address order.
+struct ScanChunk {
+    uintptr_t address; // first byte read
+    size_t size;
+    uintptr_t core;    // first byte this chunk is responsible for, bytes before it are overlap.
+                       // A run recovered from a partly unreadable chunk may start after it.
+    size_t region;     // index into the region list the plan was made from
+};
+
 struct Module {
     std::string name;
     uintptr_t baseAddress;
     size_t size;
 };
 
-// Memory Scanner class
+using ModuleList = std::vector<Module>;
+
+// Module containing address in a list sorted by base address, nullptr if there is none
+const Module* findModule(const ModuleList& modules, uintptr_t address);
+
+// Readable regions of one enumeration of the target's memory map
+struct RegionSnapshot {
+    std::vector<MemoryRegion> regions;
+    std::chrono::steady_clock::time_point taken;
+    uint64_t generation = 0; // advances only when the regions differ from the previous enumeration
+};
+
+// Scans reuse a region enumeration this young instead of walking the memory map again
+constexpr std::chrono::milliseconds kRegionCacheMaxAge{ 100 };
+// Idle chunk buffers a process cache keeps for the next scan
+constexpr size_t kMaxPooledBuffers = 4;
+
+// Everything the scanners of one process share: region and module snapshots, the bad-range
+// cache and a pool of chunk buffers. Snapshots are immutable and replaced as a whole by an
+// atomic pointer swap (read-copy-update): readers never lock, and a snapshot stays alive
+// for as long as someone holds it. Safe to use from any thread.
+class ProcessCache {
+public:
+    // Latest region enumeration, nullptr before the first one
+    std::shared_ptr<const RegionSnapshot> regions() const { return m_regions.load(std::memory_order_acquire); }
+    // Publish a new enumeration; bad ranges outside its regions are dropped, the memory
+    // behind them may have been remapped
+    std::shared_ptr<const RegionSnapshot> publishRegions(std::vector<MemoryRegion> regions);
+
+    // Latest module list, empty before the first publishModules
+    std::shared_ptr<const ModuleList> modules() const { return m_modules.load(std::memory_order_acquire); }
+    void publishModules(ModuleList modules);
+
+    // Page ranges that failed to read, skipped by later scans without a read
+    bool overlapsBadRange(uintptr_t address, size_t size) const;
+    // The bad ranges inside [start, end), clipped and in address order
+    std::vector<std::pair<uintptr_t, uintptr_t>> badRangesIn(uintptr_t start, uintptr_t end) const;
+    void addBadRange(uintptr_t start, uintptr_t end);
+
+    // Chunk buffers go back to the pool after a scan instead of being freed, so the next
+    // scan (of any scanner on this process) skips allocating and faulting them in
+    std::vector<uint8_t> takeBuffer();
+    void returnBuffer(std::vector<uint8_t> buffer);
+
+private:
+    std::atomic<std::shared_ptr<const RegionSnapshot>> m_regions;
+    std::atomic<std::shared_ptr<const ModuleList>> m_modules{ std::make_shared<const ModuleList>() };
+
+    mutable std::mutex m_badRangesMutex;
+    std::map<uintptr_t, uintptr_t> m_badRanges; // start -> end, page aligned and disjoint
+
+    std::mutex m_poolMutex;
+    std::vector<std::vector<uint8_t>> m_pool;
+    MemoryReservation m_poolReservation{ MemoryComponent::CHUNK_BUFFERS }; // idle pooled buffers
+};
+
+// A chunk buffer borrowed from a process cache for one scan, booked as a chunk buffer while
+// it is held and returned to the pool on destruction
+class PooledBuffer {
+public:
+    explicit PooledBuffer(ProcessCache& cache) : m_cache(cache), m_buffer(cache.takeBuffer()) {}
+    ~PooledBuffer() { m_cache.returnBuffer(std::move(m_buffer)); }
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    uint8_t* resize(size_t size) {
+        m_buffer.resize(size);
+        m_reservation.force(m_buffer.capacity());
+        return m_buffer.data();
+    }
+    uint8_t* data() { return m_buffer.data(); }
+    size_t capacity() const { return m_buffer.capacity(); }
+
+private:
+    ProcessCache& m_cache;
+    std::vector<uint8_t> m_buffer;
+    MemoryReservation m_reservation{ MemoryComponent::CHUNK_BUFFERS };
+};
+
+// Call task(0) .. task(count - 1) in parallel and return once all have finished. The
+// tasks run on the calling thread and on a process-wide pool of up to one thread per core
+// less one, started on first use. The caller takes tasks too, so a call finishes even
+// while every pool thread works for another caller.
+void runParallel(size_t count, const std::function<void(size_t)>& task);
+
+// Memory Scanner class.
+// One scanner serves one thread at a time: it keeps per-operation stats and its read queue.
+// Any number of scanners may work on the same process concurrently (independent sessions,
+// the watch list thread); scanners created with the same ProcessCache share its region
+// snapshot, module list, bad ranges and chunk buffers.
 class MemoryScanner {
 public:
-    explicit MemoryScanner(HANDLE processHandle);
+    explicit MemoryScanner(ProcessHandle processHandle, std::shared_ptr<ProcessCache> cache = nullptr);
     ~MemoryScanner();
 
-    // Get all readable memory regions
+    // Cache shared with other scanners on this process
+    const std::shared_ptr<ProcessCache>& cache() const { return m_cache; }
+
+    // Get all readable memory regions (always a fresh enumeration, published to the cache)
     std::vector<MemoryRegion> getReadableRegions();
 
     // Get the size of the memory region at a specific address
     size_t getRegionSizeAtAddress(uintptr_t address);
 
+    // Immutable module snapshot, valid for as long as it is held
+    std::shared_ptr<const ModuleList> modules() const { return m_cache->modules(); }
+    // Enumerate the modules again (libraries loaded since attaching) and publish the list
+    void refreshModules();
 
-    // Get the size of the memory region at a specific address
-    Module* getModuleByAddress(uintptr_t address);
+    // Copy of the module containing address, false if the address is in no module
+    bool getModuleByAddress(uintptr_t address, Module& module) const;
 
     // Initial scan: find all addresses matching a specific value
     template<typename T>
@@ -53,6 +220,23 @@ public:
     template<typename T>
     std::vector<MemoryMatch<T>> scanAllValues();
 
+    // Streaming variants of the initial scans: every match is passed to
+    // sink(const MemoryMatch<T>&) in ascending address order instead of being collected,
+    // so the caller decides where results are stored (see ScanHistory::collect)
+    template<typename T, typename Sink>
+    void scanForValue(T value, Sink&& sink);
+
+    template<typename T, typename Sink>
+    void scanAllValues(Sink&& sink);
+
+    // Initial scan for any member of a value set in one pass instead of one scan per value.
+    // A match holds the member found, set.indexOf(match.value) tells which one it is.
+    template<typename T>
+    std::vector<MemoryMatch<T>> scanForValueSet(const ValueSet<T>& set);
+
+    template<typename T, typename Sink>
+    void scanForValueSet(const ValueSet<T>& set, Sink&& sink);
+
     // Next scan: filter previous results by new value
     template<typename T>
     std::vector<MemoryMatch<T>> filterByValue(const std::vector<MemoryMatch<T>>& previous, T value);
@@ -65,6 +249,34 @@ public:
     template<typename T>
     std::vector<MemoryMatch<T>> filterByUnchanged(const std::vector<MemoryMatch<T>>& previous);
 
+    // Next scan: keep the results whose current value is a member of set
+    template<typename T>
+    std::vector<MemoryMatch<T>> filterByValueSet(const std::vector<MemoryMatch<T>>& previous, const ValueSet<T>& set);
+
+    // In-place variants of the filters for callers that own their result set: survivors
+    // are moved to the front with their current value, in order, and the vector shrinks
+    // without reallocating. Returns how many survived.
+    template<typename T>
+    size_t compactByValue(std::vector<MemoryMatch<T>>& matches, T value);
+    template<typename T>
+    size_t compactByChanged(std::vector<MemoryMatch<T>>& matches);
+    template<typename T>
+    size_t compactByUnchanged(std::vector<MemoryMatch<T>>& matches);
+    template<typename T>
+    size_t compactByValueSet(std::vector<MemoryMatch<T>>& matches, const ValueSet<T>& set);
+
+    // Bounds of the partitions [0, count) is filtered in: one below kFilterParallelThreshold,
+    // otherwise up to one per core, none smaller than kFilterPartitionSize. One more entry
+    // than partitions, the last is count.
+    static std::vector<size_t> planPartitions(size_t count);
+
+    // Call work(reader, begin, end) for every partition of partitionStarts in parallel and
+    // return their results in order. The first runs on this scanner, the others on readers
+    // this scanner keeps for it (sharing its cache, their reads count towards
+    // syscallCount()), on the threads of runParallel.
+    template<typename Work>
+    std::vector<size_t> forEachPartition(const std::vector<size_t>& partitionStarts, Work&& work);
+
     // Read value at specific address
     template<typename T>
     bool readValue(uintptr_t address, T& outValue);
@@ -73,135 +285,466 @@ public:
     template<typename T>
     bool writeValue(uintptr_t address, T value);
 
+    // Reads through the scanner's page cache, for consumers that tolerate values up to maxAge
+    // old (live rows, value display). Cached pages no older than maxAge are copied, the
+    // missing pages of all requests are fetched with one readMemoryBatch. Pages are dropped
+    // when the region map changes and when this scanner writes to them. Returns the number
+    // of successful entries like readMemoryBatch.
+    size_t readCachedBatch(std::vector<MemoryIoRequest>& requests, std::chrono::milliseconds maxAge);
+    bool readCached(uintptr_t address, void* buffer, size_t size, std::chrono::milliseconds maxAge);
+    template<typename T>
+    bool readValueCached(uintptr_t address, T& outValue, std::chrono::milliseconds maxAge) {
+        return readCached(address, &outValue, sizeof(T), maxAge);
+    }
+    const PageCacheStats& pageCacheStats() const { return m_pageCache.stats(); }
+
     // Read memory region
     bool readMemory(uintptr_t address, void* buffer, size_t size);
 
     // Write memory region
     bool writeMemory(uintptr_t address, const void* buffer, size_t size);
 
+    // Read many small ranges at once. Nearby ranges share one read, on Linux the merged ranges
+    // go out as vectored process_vm_readv calls. Per-entry success is reported in
+    // MemoryIoRequest::success. Returns the number of successful entries.
+    size_t readMemoryBatch(std::vector<MemoryIoRequest>& requests);
+
+    // Write many ranges at once. Adjacent ranges are merged into one write, on Linux the
+    // whole batch goes out as vectored process_vm_writev calls. Per-entry success is
+    // reported in MemoryIoRequest::success. Returns the number of successful entries.
+    size_t writeMemoryBatch(std::vector<MemoryIoRequest>& requests);
+
     // String-specific scan functions
     std::vector<MemoryMatch<std::string>> scanForString(const std::string& value);
     std::vector<MemoryMatch<std::wstring>> scanForWideString(const std::wstring& value);
 
+    // Grouped (structure) scan: find places where all terms match relative to each other.
+    // The most selective exact term is searched with the pattern kernel, the other terms are
+    // verified from the same chunk buffer. Needs at least one exact-offset EQUAL term.
+    std::vector<GroupMatch> scanForGroup(const std::vector<GroupScanTerm>& terms);
+
+    // Capture all readable memory into a compressed snapshot, the baseline of an
+    // unknown-value scan that does not store every value as a match. False if the memory
+    // budget ran out before everything was captured.
+    bool captureSnapshot(MemorySnapshot& snapshot);
+
+    // Compare the current memory with a snapshot at every byte offset and pass the values
+    // for which compare holds to sink(const MemoryMatch<T>&) with their current value, in
+    // ascending address order. Values are compared bitwise for CHANGED and UNCHANGED.
+    template<typename T, typename Sink>
+    void scanSnapshot(const MemorySnapshot& snapshot, SnapshotCompare compare, Sink&& sink);
+
+    // Heap-aware scanning (Linux, glibc targets): scans and filters skip the free chunks and
+    // chunk headers of the malloc arenas and look only at the usable bytes of live
+    // allocations, large free stretches are not even read. Memory outside the arenas is
+    // scanned as before. The live-allocation map is walked again for a scan or filter once
+    // it is older than kHeapMapMaxAge. False with error set if the heap cannot be walked.
+    bool setHeapFilter(bool enabled, std::string& error);
+    bool heapFilter() const { return m_heapFilter; }
+    // Walk the heap again if the map is stale; filters call it once before heapAllows
+    void refreshHeapMap();
+    // False if the heap filter is on and [address, address + size) is heap memory outside
+    // every live chunk of the current map
+    bool heapAllows(uintptr_t address, size_t size) const;
+    // Live chunk holding [address, address + size), false without the filter or if none does
+    bool heapChunkOf(uintptr_t address, size_t size, HeapChunk& chunk) const;
+    // What the current map found, all zero without the filter
+    HeapMapStats heapMapStats() const;
+
+    // OS calls (region queries, reads, writes) issued by this scanner so far
+    uint64_t syscallCount() const { return m_syscallCount.load(std::memory_order_relaxed); }
+
+    // Counters and timings of the last scan or filter operation
+    const ScanStats& lastScanStats() const { return m_recorder.stats(); }
+
+    // Chunks read ahead while the previous ones are compared (Linux: io_uring, or reader
+    // threads, on /proc/<pid>/mem). 0 reads and compares every chunk in turn.
+    void setReadQueueDepth(size_t depth) { m_readQueueDepth = depth; }
+    size_t readQueueDepth() const { return m_readQueueDepth; }
+
+    // Group several calls (e.g. one filter per history shard) into one recorded operation
+    ScanOperationScope scanOperation(const char* name) { return ScanOperationScope(m_recorder, name); }
+
+    // Record per-region read/compare spans and keep completed operations for
+    // writeChromeTrace (costs memory on big scans)
+    void setTraceEnabled(bool enabled) { m_recorder.setTraceEnabled(enabled); }
+    bool traceEnabled() const { return m_recorder.traceEnabled(); }
+    const std::vector<ScanStats>& traceLog() const { return m_recorder.traceLog(); }
+    void clearTraceLog() { m_recorder.clearTraceLog(); }
+
 private:
-    HANDLE m_processHandle;
-    std::vector<Module> m_modules;
+    ProcessHandle m_processHandle;
+    std::shared_ptr<ProcessCache> m_cache;
+    std::atomic<uint64_t> m_syscallCount{0};
+    ScanRecorder m_recorder;
+    PageCache m_pageCache;
+    bool m_heapFilter = false;
+    // Readers of forEachPartition's partitions after the first, created on first use
+    std::vector<std::unique_ptr<MemoryScanner>> m_partitionReaders;
+#ifdef __linux__
+    int m_memFd = -1; // /proc/<pid>/mem, opened on the first write that process_vm_writev refuses
+    std::unique_ptr<ReadPipeline> m_readPipeline;
+    size_t m_readQueueDepth = defaultReadQueueDepth();
+    std::shared_ptr<const HeapMap> m_heapMap; // set while the heap filter is on
+
+    // Walk the target's malloc arenas, nullptr with error set if they cannot be found
+    std::shared_ptr<const HeapMap> buildHeapMap(std::string& error);
+#else
+    size_t m_readQueueDepth = 0;
+#endif
 
     bool isReadableRegion(const MemoryRegion& region);
+    std::vector<MemoryRegion> enumerateRegions();
+
+    // Regions for a scan: the cached enumeration while it is younger than kRegionCacheMaxAge
+    std::shared_ptr<const RegionSnapshot> scanRegions();
+
+    // kScanChunkSize, or less when the memory budget cannot hold the chunks in flight
+    size_t scanChunkSize() const { return memoryGovernor().chunkSize(kScanChunkSize, m_readQueueDepth + 1); }
+
+    // Split regions into scanChunkSize() chunks that overlap by overlap bytes (a value
+    // starting near the end of one chunk is found in it, not twice). Regions smaller than
+    // minSize are skipped.
+    std::vector<ScanChunk> planChunks(const std::vector<MemoryRegion>& regions, size_t minSize, size_t overlap);
+
+    // Read the planned chunks and call compare(chunk, data) for every chunk, in plan order.
+    // A chunk that does not read in full is compared as the runs of pages that do (see
+    // recoverChunk). With a read queue the next chunks are already being read meanwhile.
+    using ChunkCompare = std::function<void(const ScanChunk& chunk, const uint8_t* data)>;
+    void readChunks(const std::vector<MemoryRegion>& regions, const std::vector<ScanChunk>& chunks, const ChunkCompare& compare);
+    void readChunksInTurn(const std::vector<MemoryRegion>& regions, const std::vector<ScanChunk>& chunks, const ChunkCompare& compare);
+
+    // Read a chunk into buffer range by range, bisecting failed ranges down to single pages,
+    // and compare every readable run on its own. Pages that fail go to the cache's bad ranges.
+    // fullReadFailed: the whole chunk was already tried, its first read is skipped.
+    void recoverChunk(const ScanChunk& chunk, uint8_t* buffer, const ChunkCompare& compare, bool fullReadFailed);
+
+    // With the heap filter on: regions without the heap's large free stretches, and compare
+    // called only for the parts of a chunk outside the heap or inside live chunks
+    std::shared_ptr<const RegionSnapshot> withoutFreeHeap(std::shared_ptr<const RegionSnapshot> regions);
+    ChunkCompare liveHeapOnly(ChunkCompare compare) const;
+    // Partition readers filter with the map of the scanner they work for
+    void shareHeapFilter(MemoryScanner& reader) const;
+
+    void countSyscall(uint64_t count = 1) {
+        m_syscallCount.fetch_add(count, std::memory_order_relaxed);
+        m_recorder.recordSyscall(count);
+    }
+
+    // Re-read the candidates of every partition in windows of kFilterReadWindow and keep
+    // those for which keep(stored, current) holds, with their current value, in out. out
+    // may be source itself: survivors then move forward in place and the gaps between the
+    // partitions' survivors are closed. Otherwise only the survivors are copied to out.
+    template<typename T, typename Keep>
+    size_t compactMatches(const std::vector<MemoryMatch<T>>& source, std::vector<MemoryMatch<T>>& out, Keep keep);
 };
 
 // Template implementations
 template<typename T>
 std::vector<MemoryMatch<T>> MemoryScanner::scanForValue(T value) {
     std::vector<MemoryMatch<T>> matches;
-    auto regions = getReadableRegions();
+    scanForValue(value, [&](const MemoryMatch<T>& match) { matches.push_back(match); });
+    return matches;
+}
+
+template<typename T>
+std::vector<MemoryMatch<T>> MemoryScanner::scanAllValues() {
+    std::vector<MemoryMatch<T>> matches;
+    scanAllValues<T>([&](const MemoryMatch<T>& match) { matches.push_back(match); });
+    return matches;
+}
 
-    for (const auto& region : regions) {
-        // Skip if region is too small
-        if (region.size < sizeof(T)) continue;
+template<typename T, typename Sink>
+void MemoryScanner::scanForValue(T value, Sink&& sink) {
+    // Bitwise equality matches value equality except for 0.0 (two encodings) and NaN
+    bool bitwise = true;
+    if constexpr (isFloatingScanValue<T>) {
+        auto native = nativeValue(value);
+        bitwise = native != 0 && !std::isnan(native);
+    }
 
-        // Allocate buffer for this region
-        std::vector<uint8_t> buffer(region.size);
+    ScanOperationScope operation(m_recorder, "scanForValue");
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
 
-        if (readMemory(region.baseAddress, buffer.data(), region.size)) {
+    // Chunks overlap by sizeof(T) - 1 bytes so values across a chunk border are found once
+    readChunks(regions, planChunks(regions, sizeof(T), sizeof(T) - 1), liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* data) {
+        auto compareStart = ScanRecorder::Clock::now();
+        uint64_t chunkMatches = 0;
+        if (bitwise) {
+            findPattern(data, chunk.size, reinterpret_cast<const uint8_t*>(&value), sizeof(T), [&](size_t i) {
+                MemoryMatch<T> match;
+                match.address = chunk.address + i;
+                match.value = value;
+                sink(match);
+                chunkMatches++;
+            });
+        } else {
             // Scan through the buffer
-            for (size_t i = 0; i <= region.size - sizeof(T); i++) {
+            for (size_t i = 0; i + sizeof(T) <= chunk.size; i++) {
                 // Use memcpy to avoid alignment issues
                 T currentValue;
-                std::memcpy(&currentValue, &buffer[i], sizeof(T));
+                std::memcpy(&currentValue, &data[i], sizeof(T));
 
                 if (currentValue == value) {
                     MemoryMatch<T> match;
-                    match.address = region.baseAddress + i;
+                    match.address = chunk.address + i;
                     match.value = currentValue;
-                    matches.push_back(match);
+                    sink(match);
+                    chunkMatches++;
                 }
             }
         }
-    }
-
-    return matches;
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, chunkMatches);
+    }));
 }
 
 template<typename T>
-std::vector<MemoryMatch<T>> MemoryScanner::scanAllValues() {
+std::vector<MemoryMatch<T>> MemoryScanner::scanForValueSet(const ValueSet<T>& set) {
     std::vector<MemoryMatch<T>> matches;
-    auto regions = getReadableRegions();
-
-    for (const auto& region : regions) {
-        // Skip if region is too small
-        if (region.size < sizeof(T)) continue;
+    scanForValueSet(set, [&](const MemoryMatch<T>& match) { matches.push_back(match); });
+    return matches;
+}
 
-        // Allocate buffer for this region
-        std::vector<uint8_t> buffer(region.size);
+template<typename T, typename Sink>
+void MemoryScanner::scanForValueSet(const ValueSet<T>& set, Sink&& sink) {
+    ScanOperationScope operation(m_recorder, "scanForValueSet");
+    if (set.empty()) return;
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
+
+    // Same overlapping chunks as the single value scan
+    readChunks(regions, planChunks(regions, sizeof(T), sizeof(T) - 1), liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* data) {
+        auto compareStart = ScanRecorder::Clock::now();
+        uint64_t chunkMatches = 0;
+        set.find(data, chunk.size, [&](size_t i, size_t) {
+            MemoryMatch<T> match;
+            match.address = chunk.address + i;
+            std::memcpy(&match.value, &data[i], sizeof(T));
+            sink(match);
+            chunkMatches++;
+        });
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, chunkMatches);
+    }));
+}
 
-        if (readMemory(region.baseAddress, buffer.data(), region.size)) {
-            // Scan through the buffer
-            for (size_t i = 0; i <= region.size - sizeof(T); i++) {
-                // Use memcpy to avoid alignment issues
-                T currentValue;
-                std::memcpy(&currentValue, &buffer[i], sizeof(T));
+template<typename T, typename Sink>
+void MemoryScanner::scanAllValues(Sink&& sink) {
+    ScanOperationScope operation(m_recorder, "scanAllValues");
+    auto enumeration = scanRegions();
+    const auto& regions = enumeration->regions;
+
+    // Same overlapping chunks as the value scan
+    readChunks(regions, planChunks(regions, sizeof(T), sizeof(T) - 1), liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* data) {
+        // Every offset is a candidate
+        if (chunk.size < sizeof(T)) return;
+        auto compareStart = ScanRecorder::Clock::now();
+        for (size_t i = 0; i <= chunk.size - sizeof(T); i++) {
+            // Use memcpy to avoid alignment issues
+            MemoryMatch<T> match;
+            match.address = chunk.address + i;
+            std::memcpy(&match.value, &data[i], sizeof(T));
+            sink(match);
+        }
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, chunk.size - sizeof(T) + 1);
+    }));
+}
 
-                MemoryMatch<T> match;
-                match.address = region.baseAddress + i;
-                match.value = currentValue;
-                matches.push_back(match);
+template<typename T, typename Sink>
+void MemoryScanner::scanSnapshot(const MemorySnapshot& snapshot, SnapshotCompare compare, Sink&& sink) {
+    ScanOperationScope operation(m_recorder, "scanSnapshot");
+
+    // Only captured memory can be compared, the regions come from the snapshot
+    std::vector<MemoryRegion> regions;
+    for (const auto& region : snapshot.regions()) regions.push_back({ region.base, region.size, 0, 0, 0 });
+
+    // The map is not part of the snapshot, it is walked for this comparison
+    refreshHeapMap();
+    PooledBuffer beforeBuffer(*m_cache);
+    readChunks(regions, planChunks(regions, sizeof(T), sizeof(T) - 1), liveHeapOnly([&](const ScanChunk& chunk, const uint8_t* data) {
+        auto compareStart = ScanRecorder::Clock::now();
+        uint64_t chunkMatches = 0;
+
+        // The snapshot part of this chunk is decoded next to the fresh read
+        uint8_t* before = beforeBuffer.resize(chunk.size);
+        m_recorder.recordBuffer(beforeBuffer.capacity());
+        const size_t size = snapshot.decode(chunk.address, chunk.size, before);
+        if (size < sizeof(T)) return;
+        const size_t values = size - sizeof(T) + 1;
+
+        auto emit = [&](size_t i) {
+            MemoryMatch<T> match;
+            match.address = chunk.address + i;
+            std::memcpy(&match.value, &data[i], sizeof(T));
+            sink(match);
+            chunkMatches++;
+        };
+        auto keepChanged = [&](size_t i) {
+            if (compare == SnapshotCompare::CHANGED) return true;
+            T oldValue, newValue;
+            std::memcpy(&oldValue, &before[i], sizeof(T));
+            std::memcpy(&newValue, &data[i], sizeof(T));
+            return compare == SnapshotCompare::INCREASED ? newValue > oldValue : newValue < oldValue;
+        };
+
+        // A value changed if any of its bytes did. Differing bytes are found 16 at a time,
+        // the offsets between them are unchanged.
+        size_t next = 0;
+        forEachChangedSlot(before, data, size, 1, [&](size_t byte) {
+            size_t first = std::max(next, byte + 1 >= sizeof(T) ? byte + 1 - sizeof(T) : 0);
+            size_t end = std::min(byte + 1, values);
+            if (compare == SnapshotCompare::UNCHANGED) {
+                for (size_t i = next; i < first; i++) emit(i);
+            } else {
+                for (size_t i = first; i < end; i++) {
+                    if (keepChanged(i)) emit(i);
+                }
             }
+            next = std::max(next, end);
+        });
+        if (compare == SnapshotCompare::UNCHANGED) {
+            for (size_t i = next; i < values; i++) emit(i);
         }
-    }
-
-    return matches;
+        m_recorder.recordCompare(chunk.address, chunk.size, compareStart, chunkMatches);
+    }));
 }
 
 template<typename T>
 std::vector<MemoryMatch<T>> MemoryScanner::filterByValue(const std::vector<MemoryMatch<T>>& previous, T value) {
+    ScanOperationScope operation(m_recorder, "filterByValue");
+    // The input may be shared (history shards are), only its survivors are copied out
     std::vector<MemoryMatch<T>> matches;
-
-    for (const auto& match : previous) {
-        T currentValue;
-        if (readValue(match.address, currentValue) && currentValue == value) {
-            MemoryMatch<T> newMatch;
-            newMatch.address = match.address;
-            newMatch.value = currentValue;
-            matches.push_back(newMatch);
-        }
-    }
-
+    compactMatches(previous, matches, [value](const T&, const T& current) { return current == value; });
     return matches;
 }
 
 template<typename T>
 std::vector<MemoryMatch<T>> MemoryScanner::filterByChanged(const std::vector<MemoryMatch<T>>& previous) {
+    ScanOperationScope operation(m_recorder, "filterByChanged");
     std::vector<MemoryMatch<T>> matches;
-
-    for (const auto& match : previous) {
-        T currentValue;
-        if (readValue(match.address, currentValue) && currentValue != match.value) {
-            MemoryMatch<T> newMatch;
-            newMatch.address = match.address;
-            newMatch.value = currentValue;
-            matches.push_back(newMatch);
-        }
-    }
-
+    compactMatches(previous, matches, [](const T& stored, const T& current) { return current != stored; });
     return matches;
 }
 
 template<typename T>
 std::vector<MemoryMatch<T>> MemoryScanner::filterByUnchanged(const std::vector<MemoryMatch<T>>& previous) {
+    ScanOperationScope operation(m_recorder, "filterByUnchanged");
     std::vector<MemoryMatch<T>> matches;
+    compactMatches(previous, matches, [](const T& stored, const T& current) { return current == stored; });
+    return matches;
+}
 
-    for (const auto& match : previous) {
-        T currentValue;
-        if (readValue(match.address, currentValue) && currentValue == match.value) {
-            MemoryMatch<T> newMatch;
-            newMatch.address = match.address;
-            newMatch.value = currentValue;
-            matches.push_back(newMatch);
-        }
+template<typename T>
+std::vector<MemoryMatch<T>> MemoryScanner::filterByValueSet(const std::vector<MemoryMatch<T>>& previous, const ValueSet<T>& set) {
+    ScanOperationScope operation(m_recorder, "filterByValueSet");
+    std::vector<MemoryMatch<T>> matches;
+    compactMatches(previous, matches, [&set](const T&, const T& current) { return set.contains(current); });
+    return matches;
+}
+
+template<typename T>
+size_t MemoryScanner::compactByValue(std::vector<MemoryMatch<T>>& matches, T value) {
+    ScanOperationScope operation(m_recorder, "compactByValue");
+    return compactMatches(matches, matches, [value](const T&, const T& current) { return current == value; });
+}
+
+template<typename T>
+size_t MemoryScanner::compactByChanged(std::vector<MemoryMatch<T>>& matches) {
+    ScanOperationScope operation(m_recorder, "compactByChanged");
+    return compactMatches(matches, matches, [](const T& stored, const T& current) { return current != stored; });
+}
+
+template<typename T>
+size_t MemoryScanner::compactByUnchanged(std::vector<MemoryMatch<T>>& matches) {
+    ScanOperationScope operation(m_recorder, "compactByUnchanged");
+    return compactMatches(matches, matches, [](const T& stored, const T& current) { return current == stored; });
+}
+
+template<typename T>
+size_t MemoryScanner::compactByValueSet(std::vector<MemoryMatch<T>>& matches, const ValueSet<T>& set) {
+    ScanOperationScope operation(m_recorder, "compactByValueSet");
+    return compactMatches(matches, matches, [&set](const T&, const T& current) { return set.contains(current); });
+}
+
+template<typename Work>
+std::vector<size_t> MemoryScanner::forEachPartition(const std::vector<size_t>& partitionStarts, Work&& work) {
+    size_t partitions = partitionStarts.size() - 1;
+    std::vector<size_t> results(partitions);
+
+    // Readers of their own, the recorder of a scanner is not shared between threads. They
+    // are kept for the next call, a history filter calls once per shard.
+    refreshHeapMap();
+    while (m_partitionReaders.size() + 1 < partitions) {
+        m_partitionReaders.push_back(std::make_unique<MemoryScanner>(m_processHandle, m_cache));
+    }
+    std::vector<uint64_t> syscalls(partitions);
+    for (size_t p = 1; p < partitions; p++) {
+        shareHeapFilter(*m_partitionReaders[p - 1]);
+        syscalls[p] = m_partitionReaders[p - 1]->syscallCount();
     }
 
-    return matches;
+    runParallel(partitions, [&](size_t p) {
+        MemoryScanner& reader = p == 0 ? *this : *m_partitionReaders[p - 1];
+        results[p] = work(reader, partitionStarts[p], partitionStarts[p + 1]);
+    });
+    for (size_t p = 1; p < partitions; p++) countSyscall(m_partitionReaders[p - 1]->syscallCount() - syscalls[p]);
+    return results;
+}
+
+template<typename T, typename Keep>
+size_t MemoryScanner::compactMatches(const std::vector<MemoryMatch<T>>& source, std::vector<MemoryMatch<T>>& out, Keep keep) {
+    const bool inPlace = &source == &out;
+    std::vector<size_t> starts = planPartitions(source.size());
+    std::vector<std::vector<MemoryMatch<T>>> survivors(inPlace ? 0 : starts.size() - 1);
+
+    std::vector<size_t> kept = forEachPartition(starts, [&](MemoryScanner& reader, size_t begin, size_t end) {
+        std::vector<MemoryMatch<T>>* collected = nullptr;
+        if (!inPlace) collected = &survivors[std::lower_bound(starts.begin(), starts.end(), begin) - starts.begin()];
+        std::vector<T> current;
+        std::vector<MemoryIoRequest> requests;
+        size_t next = begin;
+        for (size_t window = begin; window < end; window += kFilterReadWindow) {
+            size_t size = std::min<size_t>(kFilterReadWindow, end - window);
+            current.resize(size);
+            requests.resize(size);
+            for (size_t i = 0; i < size; i++) requests[i] = { source[window + i].address, &current[i], sizeof(T), false };
+            reader.readMemoryBatch(requests);
+
+            // In place, next never passes the candidate being looked at, survivors move forward only
+            for (size_t i = 0; i < size; i++) {
+                const MemoryMatch<T>& candidate = source[window + i];
+                if (!requests[i].success || !keep(candidate.value, current[i]) ||
+                    !reader.heapAllows(candidate.address, sizeof(T))) {
+                    continue;
+                }
+                if (collected) collected->push_back({ candidate.address, current[i] });
+                else out[next] = { candidate.address, current[i] };
+                next++;
+            }
+        }
+        return next - begin;
+    });
+
+    size_t total = 0;
+    for (size_t count : kept) total += count;
+    if (!inPlace) {
+        // The partition counts size the output once, it never grows by reallocation
+        out.clear();
+        out.reserve(total);
+        for (auto& partition : survivors) std::move(partition.begin(), partition.end(), std::back_inserter(out));
+    } else {
+        // Prefix sum of the partition counts: every partition's survivors move down to where
+        // the previous partition's end, so the set stays in address order
+        total = kept[0];
+        for (size_t p = 1; p < kept.size(); p++) {
+            auto first = out.begin() + static_cast<ptrdiff_t>(starts[p]);
+            std::move(first, first + static_cast<ptrdiff_t>(kept[p]), out.begin() + static_cast<ptrdiff_t>(total));
+            total += kept[p];
+        }
+        out.resize(total);
+    }
+    m_recorder.recordMatches(total);
+    return total;
 }
 
 template<typename T>
@@ -215,7 +758,7 @@ bool MemoryScanner::writeValue(uintptr_t address, T value) {
 }
 
 #else
-// Stub for non-Windows
+// Stub for unsupported platforms
 class MemoryScanner {
 public:
     explicit MemoryScanner(void*) {}
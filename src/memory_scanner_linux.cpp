@@ -0,0 +1,542 @@
+#ifdef __linux__
+#include "memory_scanner.h"
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+// Largest iovec count process_vm_writev accepts per side (IOV_MAX)
+constexpr size_t kMaxIovecs = 1024;
+// Scratch bytes one vectored batch read fills at most
+constexpr size_t kMaxBatchReadBytes = 1024 * 1024;
+
+// One line of /proc/<pid>/maps
+struct MapsEntry {
+    uintptr_t start;
+    uintptr_t end;
+    std::string permissions;
+    uint64_t offset;
+    std::string path;
+};
+
+// Why a read returned read bytes, error is the errno of a failed read
+ReadFailure readFailureOf(size_t read, int error) {
+    if (read > 0) return ReadFailure::PARTIAL;
+    if (error == EFAULT || error == ENOMEM || error == EIO) return ReadFailure::UNMAPPED;
+    if (error == EPERM || error == ESRCH) return ReadFailure::PERMISSION;
+    return ReadFailure::OTHER;
+}
+
+std::vector<MapsEntry> readMaps(pid_t pid) {
+    std::vector<MapsEntry> entries;
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+
+    std::string line;
+    while (std::getline(maps, line)) {
+        // start-end perms offset dev inode [path]
+        std::istringstream fields(line);
+        MapsEntry entry;
+        std::string range, device, inode;
+        char dash;
+        fields >> range >> entry.permissions >> std::hex >> entry.offset >> std::dec >> device >> inode;
+        std::getline(fields >> std::ws, entry.path);
+
+        std::istringstream bounds(range);
+        bounds >> std::hex >> entry.start >> dash >> entry.end;
+        if (!bounds || dash != '-') continue;
+        entries.push_back(std::move(entry));
+    }
+
+    return entries;
+}
+
+std::vector<Module> fetchModules(pid_t pid) {
+    std::vector<Module> modules;
+
+    // A module spans all mappings of the same file, starting at the one with file offset 0
+    for (const auto& entry : readMaps(pid)) {
+        if (entry.path.empty() || entry.path.front() != '/') continue;
+
+        std::string name = entry.path.substr(entry.path.find_last_of('/') + 1);
+        if (entry.offset == 0 && (modules.empty() || modules.back().name != name)) {
+            modules.push_back(Module {
+                .name = name,
+                .baseAddress = entry.start,
+                .size = entry.end - entry.start,
+            });
+        } else if (!modules.empty() && modules.back().name == name) {
+            modules.back().size = entry.end - modules.back().baseAddress;
+        }
+    }
+
+    std::ranges::sort(modules, [](const Module& a, const Module& b) {
+        return a.baseAddress < b.baseAddress;
+    });
+
+    return modules;
+}
+
+} // namespace
+
+MemoryScanner::MemoryScanner(ProcessHandle processHandle, std::shared_ptr<ProcessCache> cache)
+    : m_processHandle(processHandle), m_cache(std::move(cache)) {
+    // The first scanner on a process fills the shared cache
+    if (!m_cache) {
+        m_cache = std::make_shared<ProcessCache>();
+        refreshModules();
+    }
+}
+
+MemoryScanner::~MemoryScanner() {
+    if (m_memFd >= 0) close(m_memFd);
+}
+
+void MemoryScanner::refreshModules() {
+    m_cache->publishModules(fetchModules(m_processHandle));
+}
+
+std::vector<MemoryRegion> MemoryScanner::enumerateRegions() {
+    auto start = ScanRecorder::Clock::now();
+    std::vector<MemoryRegion> regions;
+
+    countSyscall();
+    for (const auto& entry : readMaps(m_processHandle)) {
+        // The vsyscall/vvar pages cannot be read through process_vm_readv
+        if (entry.path == "[vvar]" || entry.path == "[vsyscall]" || entry.path == "[vvar_vclock]") continue;
+
+        MemoryRegion region;
+        region.baseAddress = entry.start;
+        region.size = entry.end - entry.start;
+        region.protection = (entry.permissions[0] == 'r' ? PROT_READ : 0) |
+                            (entry.permissions[1] == 'w' ? PROT_WRITE : 0) |
+                            (entry.permissions[2] == 'x' ? PROT_EXEC : 0);
+        region.state = 0;
+        region.type = entry.permissions[3] == 's' ? MAP_SHARED : MAP_PRIVATE;
+
+        if (isReadableRegion(region)) {
+            regions.push_back(region);
+        }
+    }
+
+    m_recorder.recordEnumeration(start, regions.size());
+    return regions;
+}
+
+size_t MemoryScanner::getRegionSizeAtAddress(uintptr_t address) {
+    countSyscall();
+    for (const auto& entry : readMaps(m_processHandle)) {
+        if (address >= entry.start && address < entry.end) {
+            // Remaining size from the given address to the end of the mapping
+            return entry.end - address;
+        }
+    }
+
+    return 0;
+}
+
+bool MemoryScanner::isReadableRegion(const MemoryRegion& region) {
+    return (region.protection & PROT_READ) != 0;
+}
+
+bool MemoryScanner::readMemory(uintptr_t address, void* buffer, size_t size) {
+    auto start = ScanRecorder::Clock::now();
+    iovec local{ buffer, size };
+    iovec remote{ reinterpret_cast<void*>(address), size };
+    countSyscall();
+    ssize_t bytesRead = process_vm_readv(m_processHandle, &local, 1, &remote, 1, 0);
+    bool success = bytesRead == static_cast<ssize_t>(size);
+
+    if (m_recorder.active()) {
+        size_t read = bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+        m_recorder.recordRead(address, size, read, readFailureOf(read, bytesRead < 0 ? errno : 0), start);
+    }
+    return success;
+}
+
+size_t MemoryScanner::readMemoryBatch(std::vector<MemoryIoRequest>& requests) {
+    // Nearby requests are merged into spans like on Windows, then every process_vm_readv
+    // fetches up to kMaxIovecs spans into one scratch buffer; sparse batches (watch lists,
+    // samplers) need a syscall per thousand ranges instead of one per range
+    std::vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::ranges::sort(order, [&](size_t a, size_t b) {
+        return requests[a].address < requests[b].address;
+    });
+
+    // order[first, last) lies in [address, address + size), read to scratch[offset]
+    struct Span {
+        size_t first;
+        size_t last;
+        uintptr_t address;
+        size_t size;
+        size_t offset;
+    };
+    std::vector<Span> spans;
+    for (size_t i = 0; i < order.size(); i++) {
+        auto& request = requests[order[i]];
+        request.success = false;
+        if (!spans.empty()) {
+            Span& span = spans.back();
+            if (request.address <= span.address + span.size + kBatchCoalesceGap &&
+                request.address + request.size - span.address <= kBatchMaxSpan) {
+                span.size = std::max<size_t>(span.size, request.address + request.size - span.address);
+                span.last++;
+                continue;
+            }
+        }
+        spans.push_back({ i, i + 1, request.address, request.size, 0 });
+    }
+
+    std::vector<uint8_t> scratch;
+    std::vector<iovec> local;
+    std::vector<iovec> remote;
+    size_t succeeded = 0;
+    auto copyOut = [&](const Span& span) {
+        for (size_t i = span.first; i < span.last; i++) {
+            auto& request = requests[order[i]];
+            std::memcpy(request.buffer, &scratch[span.offset + (request.address - span.address)], request.size);
+            request.success = true;
+        }
+        succeeded += span.last - span.first;
+    };
+
+    size_t next = 0;
+    while (next < spans.size()) {
+        size_t bytes = 0;
+        size_t end = next;
+        while (end < spans.size() && end - next < kMaxIovecs && (end == next || bytes + spans[end].size <= kMaxBatchReadBytes)) {
+            spans[end].offset = bytes;
+            bytes += spans[end].size;
+            end++;
+        }
+        scratch.resize(bytes);
+        local.clear();
+        remote.clear();
+        for (size_t span = next; span < end; span++) {
+            local.push_back({ &scratch[spans[span].offset], spans[span].size });
+            remote.push_back({ reinterpret_cast<void*>(spans[span].address), spans[span].size });
+        }
+
+        auto start = ScanRecorder::Clock::now();
+        countSyscall();
+        ssize_t bytesRead = process_vm_readv(m_processHandle, local.data(), local.size(), remote.data(), remote.size(), 0);
+        int error = bytesRead < 0 ? errno : EFAULT;
+        auto finish = ScanRecorder::Clock::now();
+
+        // The kernel stops at the first remote iovec it cannot read completely
+        size_t remaining = bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+        size_t span = next;
+        while (span < end && remaining >= spans[span].size) {
+            remaining -= spans[span].size;
+            if (m_recorder.active()) {
+                m_recorder.recordRead(spans[span].address, spans[span].size, spans[span].size, ReadFailure::PARTIAL, start, finish);
+            }
+            copyOut(spans[span]);
+            span++;
+        }
+        if (span == end) {
+            next = end;
+            continue;
+        }
+
+        // A merged span may cross unreadable memory, its ranges are read one by one; the
+        // spans after it go into the next vectored call
+        if (m_recorder.active()) {
+            m_recorder.recordRead(spans[span].address, spans[span].size, remaining, readFailureOf(remaining, error), start, finish);
+        }
+        if (spans[span].last - spans[span].first > 1) {
+            for (size_t i = spans[span].first; i < spans[span].last; i++) {
+                auto& request = requests[order[i]];
+                request.success = readMemory(request.address, request.buffer, request.size);
+                if (request.success) succeeded++;
+            }
+        }
+        next = span + 1;
+    }
+
+    return succeeded;
+}
+
+void MemoryScanner::readChunks(const std::vector<MemoryRegion>& regions, const std::vector<ScanChunk>& chunks, const ChunkCompare& compare) {
+    if (m_readQueueDepth == 0 || chunks.size() < 2) {
+        readChunksInTurn(regions, chunks, compare);
+        return;
+    }
+
+    // Read-ahead slots only as far as the memory budget has room for their buffers
+    size_t largest = 0;
+    for (const auto& chunk : chunks) largest = std::max(largest, chunk.size);
+    size_t depth = memoryGovernor().readQueueDepth(std::min(m_readQueueDepth, kMaxReadQueueDepth), largest);
+    if (depth == 0) {
+        readChunksInTurn(regions, chunks, compare);
+        return;
+    }
+    MemoryReservation reservation(MemoryComponent::CHUNK_BUFFERS, std::min(depth, chunks.size()) * largest);
+
+    if (!m_readPipeline || m_readPipeline->queueDepth() != depth) {
+        m_readPipeline = std::make_unique<ReadPipeline>(m_processHandle, depth);
+    }
+    if (!m_readPipeline->valid()) {
+        readChunksInTurn(regions, chunks, compare);
+        return;
+    }
+
+    // Chunks over known bad pages are not read ahead (size 0), they are recovered page range
+    // by page range when their turn comes
+    std::vector<ReadChunk> reads(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        reads[i] = { chunks[i].address, m_cache->overlapsBadRange(chunks[i].address, chunks[i].size) ? 0 : chunks[i].size };
+    }
+    std::unique_ptr<PooledBuffer> recovery;
+
+    uint64_t syscalls = m_readPipeline->syscalls();
+    size_t region = regions.size();
+    bool bufferRecorded = false;
+    m_readPipeline->run(reads, [&](const ReadCompletion& done) {
+        // Submissions happen ahead of the consumer, they are booked as they show up
+        uint64_t issued = m_readPipeline->syscalls();
+        countSyscall(issued - syscalls);
+        syscalls = issued;
+
+        const ScanChunk& chunk = chunks[done.index];
+        if (chunk.region != region) {
+            region = chunk.region;
+            m_recorder.beginRegion(regions[region].baseAddress, regions[region].size);
+        }
+        if (!bufferRecorded) {
+            m_recorder.recordBuffer(m_readPipeline->bufferBytes());
+            bufferRecorded = true;
+        }
+
+        const bool known = reads[done.index].size == 0;
+        if (!known) {
+            m_recorder.recordRead(chunk.address, chunk.size, done.bytesRead, readFailureOf(done.bytesRead, done.error),
+                                  done.start, done.end);
+        }
+        if (done.bytesRead == chunk.size) {
+            compare(chunk, done.data);
+            return;
+        }
+
+        // Slot buffers are read-only for the consumer, recovery reads into its own
+        if (!recovery) recovery = std::make_unique<PooledBuffer>(*m_cache);
+        recoverChunk(chunk, recovery->resize(chunk.size), compare, !known);
+    });
+    countSyscall(m_readPipeline->syscalls() - syscalls);
+}
+
+bool MemoryScanner::writeMemory(uintptr_t address, const void* buffer, size_t size) {
+    iovec local{ const_cast<void*>(buffer), size };
+    iovec remote{ reinterpret_cast<void*>(address), size };
+    m_pageCache.invalidate(address, size);
+    countSyscall();
+    if (process_vm_writev(m_processHandle, &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size)) {
+        return true;
+    }
+
+    // process_vm_writev honours page protection, /proc/<pid>/mem can also patch read-only
+    // pages (like WriteProcessMemory does on Windows)
+    if (m_memFd < 0) {
+        m_memFd = open(("/proc/" + std::to_string(m_processHandle) + "/mem").c_str(), O_RDWR | O_CLOEXEC);
+        if (m_memFd < 0) return false;
+    }
+    countSyscall();
+    return pwrite(m_memFd, buffer, size, static_cast<off_t>(address)) == static_cast<ssize_t>(size);
+}
+
+size_t MemoryScanner::writeMemoryBatch(std::vector<MemoryIoRequest>& requests) {
+    // Every request is one local iovec, exactly adjacent requests share one remote iovec,
+    // so a whole batch usually lands with a single process_vm_writev
+    for (const auto& request : requests) m_pageCache.invalidate(request.address, request.size);
+    std::vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::ranges::sort(order, [&](size_t a, size_t b) {
+        return requests[a].address < requests[b].address;
+    });
+
+    // Remote spans over the sorted requests, order[first, last) is written to [address, address + size)
+    struct Span {
+        size_t first;
+        size_t last;
+        uintptr_t address;
+        size_t size;
+    };
+    std::vector<Span> spans;
+    for (size_t i = 0; i < order.size(); i++) {
+        auto& request = requests[order[i]];
+        request.success = false;
+        if (!spans.empty() && spans.back().address + spans.back().size == request.address &&
+            spans.back().last - spans.back().first < kMaxIovecs) {
+            spans.back().last++;
+            spans.back().size += request.size;
+        } else {
+            spans.push_back({ i, i + 1, request.address, request.size });
+        }
+    }
+
+    std::vector<iovec> local;
+    std::vector<iovec> remote;
+    size_t succeeded = 0;
+    auto markWritten = [&](const Span& span) {
+        for (size_t i = span.first; i < span.last; i++) requests[order[i]].success = true;
+        succeeded += span.last - span.first;
+    };
+
+    size_t next = 0;
+    while (next < spans.size()) {
+        local.clear();
+        remote.clear();
+        size_t end = next;
+        while (end < spans.size() && remote.size() < kMaxIovecs &&
+               local.size() + (spans[end].last - spans[end].first) <= kMaxIovecs) {
+            remote.push_back({ reinterpret_cast<void*>(spans[end].address), spans[end].size });
+            for (size_t i = spans[end].first; i < spans[end].last; i++) {
+                const auto& request = requests[order[i]];
+                local.push_back({ request.buffer, request.size });
+            }
+            end++;
+        }
+
+        countSyscall();
+        ssize_t written = process_vm_writev(m_processHandle, local.data(), local.size(), remote.data(), remote.size(), 0);
+
+        // The kernel stops at the first remote iovec it cannot write, everything before it is complete
+        size_t remaining = written > 0 ? static_cast<size_t>(written) : 0;
+        size_t span = next;
+        while (span < end && remaining >= spans[span].size) {
+            remaining -= spans[span].size;
+            markWritten(spans[span]);
+            span++;
+        }
+        if (span == end) {
+            next = end;
+            continue;
+        }
+
+        // Retry the failing span range by range, writeMemory also falls back to /proc/<pid>/mem
+        // for read-only pages; the spans after it go into the next vectored call
+        for (size_t i = spans[span].first; i < spans[span].last; i++) {
+            auto& request = requests[order[i]];
+            request.success = writeMemory(request.address, request.buffer, request.size);
+            if (request.success) succeeded++;
+        }
+        next = span + 1;
+    }
+
+    return succeeded;
+}
+
+std::shared_ptr<const HeapMap> MemoryScanner::buildHeapMap(std::string& error) {
+    // main_arena is in the C library's data, a static binary carries it in its own
+    HeapSearch search;
+    std::vector<std::pair<uintptr_t, uintptr_t>> fileData;
+    countSyscall();
+    for (const auto& entry : readMaps(m_processHandle)) {
+        if (entry.path == "[heap]") {
+            search.brkStart = entry.start;
+            search.brkEnd = entry.end;
+        }
+        if (entry.permissions[1] != 'w' || entry.path.empty() || entry.path.front() != '/') continue;
+        std::string name = entry.path.substr(entry.path.find_last_of('/') + 1);
+        if (name.starts_with("libc.so") || name.starts_with("libc-")) search.dataRanges.push_back({ entry.start, entry.end });
+        fileData.push_back({ entry.start, entry.end });
+    }
+    if (search.dataRanges.empty()) search.dataRanges = std::move(fileData);
+
+    auto map = std::make_shared<HeapMap>();
+    if (!map->build(*this, search, error)) return nullptr;
+    return map;
+}
+
+bool MemoryScanner::setHeapFilter(bool enabled, std::string& error) {
+    if (!enabled) {
+        m_heapFilter = false;
+        m_heapMap.reset();
+        return true;
+    }
+    auto map = buildHeapMap(error);
+    if (!map) return false;
+    m_heapMap = std::move(map);
+    m_heapFilter = true;
+    return true;
+}
+
+void MemoryScanner::refreshHeapMap() {
+    if (!m_heapFilter || (m_heapMap && HeapMap::Clock::now() - m_heapMap->builtAt() < kHeapMapMaxAge)) return;
+    // A walk that fails (the target is exiting) keeps the previous map
+    std::string error;
+    if (auto map = buildHeapMap(error)) m_heapMap = std::move(map);
+}
+
+bool MemoryScanner::heapAllows(uintptr_t address, size_t size) const {
+    return !m_heapFilter || !m_heapMap || m_heapMap->allows(address, size);
+}
+
+bool MemoryScanner::heapChunkOf(uintptr_t address, size_t size, HeapChunk& chunk) const {
+    const HeapChunk* found = m_heapFilter && m_heapMap ? m_heapMap->chunkAt(address, size) : nullptr;
+    if (!found) return false;
+    chunk = *found;
+    return true;
+}
+
+HeapMapStats MemoryScanner::heapMapStats() const {
+    return m_heapFilter && m_heapMap ? m_heapMap->stats() : HeapMapStats();
+}
+
+std::shared_ptr<const RegionSnapshot> MemoryScanner::withoutFreeHeap(std::shared_ptr<const RegionSnapshot> regions) {
+    refreshHeapMap();
+    if (!m_heapMap || m_heapMap->skippedRanges().empty()) return regions;
+
+    // The enumeration is shared with other scanners, the trimmed one is a copy of this scan
+    const auto& skipped = m_heapMap->skippedRanges();
+    auto trimmed = std::make_shared<RegionSnapshot>(*regions);
+    trimmed->regions.clear();
+    for (const auto& region : regions->regions) {
+        uintptr_t position = region.baseAddress;
+        const uintptr_t end = region.baseAddress + region.size;
+        auto range = std::ranges::upper_bound(skipped, position, {}, &std::pair<uintptr_t, uintptr_t>::second);
+        for (; range != skipped.end() && range->first < end; ++range) {
+            if (range->first > position) {
+                MemoryRegion part = region;
+                part.baseAddress = position;
+                part.size = range->first - position;
+                trimmed->regions.push_back(part);
+            }
+            position = std::min(end, range->second);
+        }
+        if (position < end) {
+            MemoryRegion part = region;
+            part.baseAddress = position;
+            part.size = end - position;
+            trimmed->regions.push_back(part);
+        }
+    }
+    return trimmed;
+}
+
+MemoryScanner::ChunkCompare MemoryScanner::liveHeapOnly(ChunkCompare compare) const {
+    if (!m_heapFilter || !m_heapMap) return compare;
+
+    // Runs of a chunk are compared like the runs of a recovered chunk, each on its own
+    return [map = m_heapMap, compare = std::move(compare)](const ScanChunk& chunk, const uint8_t* data) {
+        map->forEachAllowedRun(chunk.address, chunk.address + chunk.size, [&](uintptr_t start, uintptr_t end) {
+            if (start == chunk.address && end == chunk.address + chunk.size) compare(chunk, data);
+            else compare(ScanChunk{ start, end - start, chunk.core, chunk.region }, data + (start - chunk.address));
+        });
+    };
+}
+
+void MemoryScanner::shareHeapFilter(MemoryScanner& reader) const {
+    reader.m_heapFilter = m_heapFilter;
+    reader.m_heapMap = m_heapMap;
+}
+#endif
@@ -0,0 +1,172 @@
+#include "memory_snapshot.h"
+#include "block_codec.h"
+#include "scan_kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+
+bool testBit(const std::vector<uint64_t>& bits, size_t index) {
+    return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+void setBit(std::vector<uint64_t>& bits, size_t index) {
+    bits[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+} // namespace
+
+void MemorySnapshot::clear() {
+    m_regions.clear();
+    m_pageCount = 0;
+    m_present.clear();
+    m_zero.clear();
+    m_rank.clear();
+    m_offsets.clear();
+    m_blocks.clear();
+    m_blockUsed.clear();
+    m_reservation.force(0);
+    m_stats = SnapshotStats();
+}
+
+void MemorySnapshot::addRegion(uintptr_t base, size_t size) {
+    size_t pages = size / kSnapshotPageSize;
+    if (pages == 0) return;
+    m_regions.push_back({ base, pages * kSnapshotPageSize, m_pageCount });
+    m_pageCount += pages;
+    m_present.resize((m_pageCount + 63) / 64, 0);
+    m_zero.resize(m_present.size(), 0);
+    m_stats.missingPages += pages;
+}
+
+const MemorySnapshot::Region* MemorySnapshot::regionAt(uintptr_t address) const {
+    auto it = std::upper_bound(m_regions.begin(), m_regions.end(), address, [](uintptr_t value, const Region& region) {
+        return value < region.base;
+    });
+    if (it == m_regions.begin()) return nullptr;
+    --it;
+    return address - it->base < it->size ? &*it : nullptr;
+}
+
+bool MemorySnapshot::store(uintptr_t address, const uint8_t* data, size_t size) {
+    const Region* region = regionAt(address);
+    if (!region || (address - region->base) % kSnapshotPageSize != 0) return true;
+    size = std::min(size, region->size - (address - region->base));
+
+    uint8_t compressed[kSnapshotPageSize];
+    for (size_t at = 0; at + kSnapshotPageSize <= size; at += kSnapshotPageSize) {
+        size_t page = region->firstPage + (address - region->base + at) / kSnapshotPageSize;
+        if (testBit(m_present, page)) continue;
+        const uint8_t* bytes = data + at;
+        const bool zero = isZeroBlock(bytes, kSnapshotPageSize);
+
+        // A page is only marked present once its data has a place
+        size_t length = 0;
+        if (!zero) {
+            length = compressBlock(bytes, kSnapshotPageSize, compressed, kSnapshotPageSize - 1);
+            size_t stored = length != 0 ? length : kSnapshotPageSize;
+            if ((m_blocks.empty() || kSnapshotBlockSize - m_blockUsed.back() < stored) &&
+                !m_reservation.resize(m_reservation.bytes() + kSnapshotBlockSize)) {
+                return false;
+            }
+        }
+
+        // Pages arrive in ascending order: the stored pages before a word are known when
+        // its first page comes in
+        while (m_rank.size() <= page / 64) m_rank.push_back(static_cast<uint32_t>(m_offsets.size()));
+        setBit(m_present, page);
+        m_stats.missingPages--;
+        m_stats.rawBytes += kSnapshotPageSize;
+
+        if (zero) {
+            setBit(m_zero, page);
+            m_stats.zeroPages++;
+            continue;
+        }
+
+        // A page that does not shrink is stored raw, its stored size tells the two apart
+        const uint8_t* source = length != 0 ? compressed : bytes;
+        if (length != 0) {
+            m_stats.compressedPages++;
+        } else {
+            length = kSnapshotPageSize;
+            m_stats.rawPages++;
+        }
+
+        if (m_blocks.empty() || kSnapshotBlockSize - m_blockUsed.back() < length) {
+            m_blocks.push_back(std::make_unique_for_overwrite<uint8_t[]>(kSnapshotBlockSize));
+            m_blockUsed.push_back(0);
+        }
+        uint32_t& used = m_blockUsed.back();
+        std::memcpy(m_blocks.back().get() + used, source, length);
+        m_offsets.push_back(uint64_t(m_blocks.size() - 1) << kBlockBits | used);
+        used += static_cast<uint32_t>(length);
+        m_stats.storedBytes += length;
+    }
+    return true;
+}
+
+size_t MemorySnapshot::storedSize(size_t entry) const {
+    uint64_t offset = m_offsets[entry];
+    size_t block = static_cast<size_t>(offset >> kBlockBits);
+    size_t position = static_cast<size_t>(offset & (kSnapshotBlockSize - 1));
+    if (entry + 1 < m_offsets.size() && (m_offsets[entry + 1] >> kBlockBits) == block) {
+        return static_cast<size_t>(m_offsets[entry + 1] & (kSnapshotBlockSize - 1)) - position;
+    }
+    return m_blockUsed[block] - position;
+}
+
+bool MemorySnapshot::decodePage(size_t page, uint8_t* out) const {
+    if (!testBit(m_present, page)) return false;
+    if (testBit(m_zero, page)) {
+        std::memset(out, 0, kSnapshotPageSize);
+        return true;
+    }
+
+    // Stored pages before this one: the word's rank plus the stored pages below it in the word
+    const size_t word = page / 64;
+    const uint64_t below = (uint64_t(1) << (page % 64)) - 1;
+    const size_t entry = m_rank[word] + std::popcount(m_present[word] & ~m_zero[word] & below);
+
+    const uint64_t offset = m_offsets[entry];
+    const uint8_t* data = m_blocks[offset >> kBlockBits].get() + (offset & (kSnapshotBlockSize - 1));
+    const size_t length = storedSize(entry);
+    if (length == kSnapshotPageSize) {
+        std::memcpy(out, data, kSnapshotPageSize);
+        return true;
+    }
+    return decompressBlock(data, length, out, kSnapshotPageSize);
+}
+
+size_t MemorySnapshot::decode(uintptr_t address, size_t size, uint8_t* out) const {
+    const Region* region = regionAt(address);
+    if (!region) return 0;
+    size = std::min(size, region->size - (address - region->base));
+
+    // Partial pages at either end go through a page buffer, whole pages decode in place
+    uint8_t pageBuffer[kSnapshotPageSize];
+    size_t done = 0;
+    while (done < size) {
+        size_t offset = address - region->base + done;
+        size_t page = region->firstPage + offset / kSnapshotPageSize;
+        size_t inPage = offset % kSnapshotPageSize;
+        size_t length = std::min(kSnapshotPageSize - inPage, size - done);
+
+        if (inPage == 0 && length == kSnapshotPageSize) {
+            if (!decodePage(page, out + done)) break;
+        } else {
+            if (!decodePage(page, pageBuffer)) break;
+            std::memcpy(out + done, pageBuffer + inPage, length);
+        }
+        done += length;
+    }
+    return done;
+}
+
+size_t MemorySnapshot::memoryUsage() const {
+    return m_blocks.size() * kSnapshotBlockSize + m_blockUsed.capacity() * sizeof(uint32_t) +
+           m_regions.capacity() * sizeof(Region) +
+           (m_present.capacity() + m_zero.capacity() + m_offsets.capacity()) * sizeof(uint64_t) +
+           m_rank.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "memory_governor.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Unit of zero elision and compression
+constexpr size_t kSnapshotPageSize = 4096;
+// Compressed pages are packed into blocks of this size, a page never spans two blocks
+constexpr size_t kSnapshotBlockSize = 1024 * 1024;
+
+// How a value must differ from its snapshot value to be kept by MemoryScanner::scanSnapshot
+enum class SnapshotCompare {
+    CHANGED,
+    UNCHANGED,
+    INCREASED,
+    DECREASED
+};
+
+struct SnapshotStats {
+    uint64_t rawBytes = 0;        // captured bytes
+    uint64_t storedBytes = 0;     // compressed and raw pages
+    uint64_t zeroPages = 0;       // kept as a bit only
+    uint64_t compressedPages = 0;
+    uint64_t rawPages = 0;        // did not shrink
+    uint64_t missingPages = 0;    // could not be read
+};
+
+// Copy of a process's readable memory, the baseline of unknown-value scans. All-zero pages
+// are one bit in a bitmap, every other page is compressed with the block codec (or kept raw
+// if it does not shrink). decode() unpacks any range straight into the caller's chunk
+// buffer, so a compare never holds more than one chunk of the snapshot in the clear.
+class MemorySnapshot {
+public:
+    struct Region {
+        uintptr_t base;
+        size_t size;
+        size_t firstPage; // index of the region's first page in the page bitmaps
+    };
+
+    void clear();
+
+    // Add a page-aligned region in ascending address order. Its pages start out missing.
+    void addRegion(uintptr_t base, size_t size);
+
+    // Capture whole pages of an added region. Pages must be stored in ascending address
+    // order, a trailing partial page is ignored. False once the memory budget has no room
+    // for another block; the pages that did not fit stay missing.
+    bool store(uintptr_t address, const uint8_t* data, size_t size);
+
+    // Decode size bytes starting at address into out. Returns how many leading bytes were
+    // captured; decoding stops at the first missing page and at the end of the region.
+    size_t decode(uintptr_t address, size_t size, uint8_t* out) const;
+
+    const std::vector<Region>& regions() const { return m_regions; }
+    const SnapshotStats& stats() const { return m_stats; }
+    bool empty() const { return m_regions.empty(); }
+
+    // Heap bytes held by the snapshot (page data, bitmaps, page index)
+    size_t memoryUsage() const;
+
+private:
+    static constexpr unsigned kBlockBits = 20;
+    static_assert(kSnapshotBlockSize == size_t(1) << kBlockBits, "block offsets are split at kBlockBits");
+
+    std::vector<Region> m_regions;
+    size_t m_pageCount = 0;
+    std::vector<uint64_t> m_present; // captured pages
+    std::vector<uint64_t> m_zero;    // captured all-zero pages, no data stored
+    std::vector<uint32_t> m_rank;    // stored pages before every 64-page word
+    std::vector<uint64_t> m_offsets; // block << kBlockBits | position of every stored page
+    std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+    std::vector<uint32_t> m_blockUsed; // bytes used in every block
+    MemoryReservation m_reservation{ MemoryComponent::SNAPSHOTS };
+    SnapshotStats m_stats;
+
+    const Region* regionAt(uintptr_t address) const;
+    size_t storedSize(size_t entry) const;
+    bool decodePage(size_t page, uint8_t* out) const;
+};
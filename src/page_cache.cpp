@@ -0,0 +1,77 @@
+#include "page_cache.h"
+#include <algorithm>
+#include <cstring>
+
+bool PageCache::ready() {
+    if (m_data) return true;
+    if (!m_reservation.resize(kPageCacheCapacity * kCachedPageSize)) return false;
+    m_data = std::make_unique_for_overwrite<uint8_t[]>(kPageCacheCapacity * kCachedPageSize);
+    m_slotPages.assign(kPageCacheCapacity, kFreeSlot);
+    return true;
+}
+
+void PageCache::setGeneration(uint64_t generation) {
+    if (generation == m_generation) return;
+    m_generation = generation;
+    if (!m_entries.empty()) {
+        clear();
+        m_stats.flushes++;
+    }
+}
+
+const uint8_t* PageCache::find(uintptr_t page, Clock::time_point oldest, bool& found) {
+    auto it = m_entries.find(page);
+    found = it != m_entries.end() && it->second.readAt >= oldest;
+    if (!found) return nullptr;
+    m_stats.hits++;
+    return it->second.readable ? m_data.get() + it->second.slot * kCachedPageSize : nullptr;
+}
+
+void PageCache::insert(uintptr_t page, Clock::time_point readAt, const uint8_t* data) {
+    m_stats.misses++;
+
+    // A page read again keeps its slot, a new one takes the oldest
+    auto it = m_entries.find(page);
+    if (it == m_entries.end()) {
+        size_t slot = m_nextSlot;
+        m_nextSlot = (m_nextSlot + 1) % kPageCacheCapacity;
+        if (m_slotPages[slot] != kFreeSlot) erase(m_entries.find(m_slotPages[slot]));
+        m_slotPages[slot] = page;
+        it = m_entries.emplace(page, Entry{ readAt, static_cast<uint32_t>(slot), false }).first;
+    }
+
+    it->second.readAt = readAt;
+    it->second.readable = data != nullptr;
+    if (data) std::memcpy(m_data.get() + it->second.slot * kCachedPageSize, data, kCachedPageSize);
+}
+
+void PageCache::invalidate(uintptr_t address, size_t size) {
+    if (m_entries.empty() || size == 0) return;
+    uintptr_t first = address / kCachedPageSize * kCachedPageSize;
+    uintptr_t last = (address + size - 1) / kCachedPageSize * kCachedPageSize;
+    if ((last - first) / kCachedPageSize >= m_entries.size()) {
+        // Range larger than the cache: walk the entries instead of the pages
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            auto next = std::next(it);
+            if (it->first >= first && it->first <= last) erase(it);
+            it = next;
+        }
+        return;
+    }
+    for (uintptr_t page = first;; page += kCachedPageSize) {
+        auto it = m_entries.find(page);
+        if (it != m_entries.end()) erase(it);
+        if (page == last) break;
+    }
+}
+
+void PageCache::clear() {
+    m_entries.clear();
+    std::fill(m_slotPages.begin(), m_slotPages.end(), kFreeSlot);
+    m_nextSlot = 0;
+}
+
+void PageCache::erase(std::unordered_map<uintptr_t, Entry>::iterator entry) {
+    m_slotPages[entry->second.slot] = kFreeSlot;
+    m_entries.erase(entry);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "memory_governor.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Unit of the page cache, the smallest page size of the supported systems
+constexpr size_t kCachedPageSize = 4096;
+// Pages one cache holds (1 MB), the oldest insert is replaced beyond that
+constexpr size_t kPageCacheCapacity = 256;
+
+struct PageCacheStats {
+    uint64_t hits = 0;     // pages served from the cache
+    uint64_t misses = 0;   // pages read from the target
+    uint64_t flushes = 0;  // times every page was dropped for a new memory map
+};
+
+// Recently read pages of a target for reads that tolerate bounded staleness (live values
+// of visible rows, value display). Every page remembers when it was read and a lookup names
+// the oldest read it accepts, so each consumer picks its own bound. Pages that could not be
+// read are remembered too. All pages belong to one region-map generation and are dropped
+// when it changes. Slots are replaced in insertion order, entries expire by age anyway.
+// Not thread-safe, like the MemoryScanner that owns it.
+class PageCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Allocate the page slots on first use. False if the memory budget has no room for them,
+    // the owner then reads around the cache.
+    bool ready();
+
+    // Drop every page if the region map moved on to another generation
+    void setGeneration(uint64_t generation);
+
+    // Page starting at page if it was read at or after oldest: found is set, the result is
+    // its data or nullptr if it could not be read. found = false on a miss.
+    const uint8_t* find(uintptr_t page, Clock::time_point oldest, bool& found);
+
+    // Store a page read at readAt (data is nullptr if the read failed). Needs ready().
+    void insert(uintptr_t page, Clock::time_point readAt, const uint8_t* data);
+
+    // Forget the pages overlapping [address, address + size), e.g. after a write
+    void invalidate(uintptr_t address, size_t size);
+    void clear();
+
+    size_t size() const { return m_entries.size(); }
+    const PageCacheStats& stats() const { return m_stats; }
+
+private:
+    static constexpr uintptr_t kFreeSlot = 1; // never a page address, pages are aligned
+
+    struct Entry {
+        Clock::time_point readAt;
+        uint32_t slot;
+        bool readable;
+    };
+
+    std::unordered_map<uintptr_t, Entry> m_entries;
+    std::unique_ptr<uint8_t[]> m_data; // kPageCacheCapacity pages
+    std::vector<uintptr_t> m_slotPages; // page held by every slot, kFreeSlot if none
+    size_t m_nextSlot = 0;
+    uint64_t m_generation = 0;
+    MemoryReservation m_reservation{ MemoryComponent::VIEW_CACHES };
+    PageCacheStats m_stats;
+
+    void erase(std::unordered_map<uintptr_t, Entry>::iterator entry);
+};
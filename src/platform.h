@@ -0,0 +1,7 @@
+#pragma once
+
+// The scanner engine runs on Windows (Win32 process API) and Linux (/proc and
+// process_vm_readv). Everything else only gets the stubs.
+#if defined(_WIN32) || defined(__linux__)
+#define MEMORY_SCANNER_SUPPORTED 1
+#endif
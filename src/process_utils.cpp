@@ -38,12 +38,12 @@ std::vector<ProcessInfo> findProcessesBySubstring(const std::wstring &substring)
     std::transform(lowerSubstring.begin(), lowerSubstring.end(),
                    lowerSubstring.begin(), ::towlower);
 
+    // Compare in place instead of lowering a copy of every name
+    auto sameCharacter = [](wchar_t a, wchar_t lowerB) { return (wchar_t)::towlower(a) == lowerB; };
     for (const auto &proc : allProcesses) {
-        std::wstring lowerName = proc.exeName;
-        std::transform(lowerName.begin(), lowerName.end(),
-                       lowerName.begin(), ::towlower);
-
-        if (lowerName.find(lowerSubstring) != std::wstring::npos) {
+        auto match = std::search(proc.exeName.begin(), proc.exeName.end(),
+                                 lowerSubstring.begin(), lowerSubstring.end(), sameCharacter);
+        if (match != proc.exeName.end() || lowerSubstring.empty()) {
             result.push_back(proc);
         }
     }
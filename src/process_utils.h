@@ -21,8 +21,76 @@ HANDLE openProcessBasic(DWORD pid, bool requireWrite = false);
 
 // Simple helper to convert wide string to UTF-8 (for console output).
 std::string wideToUtf8(const std::wstring &w);
+#elif defined(__linux__)
+#include <sys/types.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct ProcessInfo {
+    pid_t pid{};
+    std::string exeName;     // comm, at most 15 characters
+    std::string commandLine; // arguments separated by spaces, empty for kernel threads
+    uint64_t startTime{};    // clock ticks after boot, tells a reused pid apart
+    uid_t uid{};
+    uint64_t rssKb{};        // resident set size
+    size_t mappingCount{};   // lines in /proc/<pid>/maps, 0 if not readable
+};
+
+// Cached view of /proc. refresh() only reads the details (cmdline, maps) of processes it
+// has not seen before; a pid is only trusted again if its start time did not change.
+// Known processes just get their RSS updated, the mapping count at most every few seconds.
+class ProcessDirectory {
+public:
+    // Rescan /proc, returns the number of new (or reused-pid) processes
+    size_t refresh();
+
+    // All processes of the last refresh, ordered by pid
+    std::vector<ProcessInfo> processes() const;
+
+    const ProcessInfo* findByPid(pid_t pid) const;
+
+    // Case-insensitive substring match on the name and the command line
+    std::vector<ProcessInfo> findBySubstring(std::string_view substring) const;
+
+    size_t size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        ProcessInfo info;
+        std::string lowerName;        // lowered once when the process is first seen
+        std::string lowerCommandLine;
+        std::chrono::steady_clock::time_point mapsCounted;
+        uint64_t seen = 0;
+    };
+
+    std::unordered_map<pid_t, Entry> m_entries;
+    uint64_t m_generation = 0;
+};
+
+// Longest pattern matchProcessesByRegex accepts
+constexpr size_t kMaxProcessRegexLength = 256;
+// Command line bytes a regex is searched in. std::regex recurses once per input character,
+// a whole (Java-sized) command line would overflow the stack of the calling thread.
+constexpr size_t kProcessRegexCommandLineLimit = 4096;
+
+// Processes of candidates whose name or command line (its first
+// kProcessRegexCommandLineLimit bytes) contain a match of the ECMAScript regex pattern,
+// case-insensitive, in the order of candidates. False with error set if the pattern is
+// invalid or too long. Takes a copy of the processes so no directory lock is held meanwhile.
+bool matchProcessesByRegex(const std::string& pattern, const std::vector<ProcessInfo>& candidates,
+                           std::vector<ProcessInfo>& out, std::string& error);
+
+// Enumerate all running processes (through a shared ProcessDirectory).
+std::vector<ProcessInfo> enumerateProcesses();
+
+// Find processes whose (case-insensitive) name or command line contains the substring.
+std::vector<ProcessInfo> findProcessesBySubstring(const std::string &substring);
 #else
-// Stubs for non-Windows builds.
+// Stubs for other platforms.
 #include <string>
 #include <vector>
 struct ProcessInfo { int pid; std::string exeName; };
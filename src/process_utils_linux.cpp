@@ -0,0 +1,226 @@
+#ifdef __linux__
+#include "process_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <regex>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Counting the mappings means reading the whole maps file, known processes are recounted
+// at most this often
+constexpr auto kMapsRecountInterval = std::chrono::seconds(5);
+
+// Read a small /proc file relative to the /proc directory. /proc files report size 0,
+// so they are read until EOF.
+bool readProcFile(int procFd, const std::string& path, std::string& out) {
+    int fd = openat(procFd, path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    out.clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        out.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    return n == 0;
+}
+
+size_t countMappings(int procFd, const std::string& pid) {
+    int fd = openat(procFd, (pid + "/maps").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    size_t lines = 0;
+    char buffer[64 * 1024];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        lines += static_cast<size_t>(std::count(buffer, buffer + n, '\n'));
+    }
+    close(fd);
+    return lines;
+}
+
+// The fields of /proc/<pid>/stat needed here. comm may contain spaces and parentheses,
+// the fields after it start behind the last ')'.
+bool parseStat(const std::string& stat, std::string& comm, uint64_t& startTime, uint64_t& rssPages) {
+    size_t open = stat.find('(');
+    size_t close = stat.rfind(')');
+    if (open == std::string::npos || close == std::string::npos || close < open) return false;
+    comm = stat.substr(open + 1, close - open - 1);
+
+    // Field 3 (state) is the first after ')', starttime is field 22 and rss field 24
+    const char* pos = stat.c_str() + close + 1;
+    for (int field = 3; field <= 24; field++) {
+        while (*pos == ' ') pos++;
+        if (*pos == '\0') return false;
+        char* end = nullptr;
+        if (field == 22) startTime = std::strtoull(pos, &end, 10);
+        else if (field == 24) rssPages = std::strtoull(pos, &end, 10);
+        while (*pos != ' ' && *pos != '\0') pos++;
+    }
+    return true;
+}
+
+std::string toLower(std::string_view text) {
+    std::string lower(text);
+    for (char& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return lower;
+}
+
+bool isPidName(const char* name) {
+    if (*name == '\0') return false;
+    for (const char* c = name; *c; c++) {
+        if (*c < '0' || *c > '9') return false;
+    }
+    return true;
+}
+
+} // namespace
+
+size_t ProcessDirectory::refresh() {
+    DIR* dir = opendir("/proc");
+    if (!dir) return 0;
+    int procFd = dirfd(dir);
+
+    static const uint64_t pageKb = static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+    auto now = std::chrono::steady_clock::now();
+    m_generation++;
+    size_t added = 0;
+
+    std::string statLine;
+    std::string comm;
+    while (dirent* item = readdir(dir)) {
+        if (!isPidName(item->d_name)) continue;
+        std::string name = item->d_name;
+
+        // One read per known process: stat carries the start time and the RSS
+        uint64_t startTime = 0;
+        uint64_t rssPages = 0;
+        if (!readProcFile(procFd, name + "/stat", statLine) || !parseStat(statLine, comm, startTime, rssPages)) continue;
+
+        pid_t pid = static_cast<pid_t>(std::strtol(name.c_str(), nullptr, 10));
+        auto it = m_entries.find(pid);
+        if (it == m_entries.end() || it->second.info.startTime != startTime) {
+            Entry entry;
+            entry.info.pid = pid;
+            entry.info.exeName = comm;
+            entry.info.startTime = startTime;
+
+            std::string commandLine;
+            if (readProcFile(procFd, name + "/cmdline", commandLine)) {
+                while (!commandLine.empty() && commandLine.back() == '\0') commandLine.pop_back();
+                std::replace(commandLine.begin(), commandLine.end(), '\0', ' ');
+            }
+            entry.info.commandLine = std::move(commandLine);
+
+            struct stat owner;
+            if (fstatat(procFd, name.c_str(), &owner, 0) == 0) entry.info.uid = owner.st_uid;
+
+            entry.info.mappingCount = countMappings(procFd, name);
+            entry.mapsCounted = now;
+            entry.lowerName = toLower(entry.info.exeName);
+            entry.lowerCommandLine = toLower(entry.info.commandLine);
+            it = m_entries.insert_or_assign(pid, std::move(entry)).first;
+            added++;
+        } else if (now - it->second.mapsCounted >= kMapsRecountInterval) {
+            it->second.info.mappingCount = countMappings(procFd, name);
+            it->second.mapsCounted = now;
+        }
+
+        it->second.info.rssKb = rssPages * pageKb;
+        it->second.seen = m_generation;
+    }
+    closedir(dir);
+
+    // Processes that were not listed anymore have exited
+    std::erase_if(m_entries, [this](const auto& item) { return item.second.seen != m_generation; });
+    return added;
+}
+
+std::vector<ProcessInfo> ProcessDirectory::processes() const {
+    std::vector<ProcessInfo> result;
+    result.reserve(m_entries.size());
+    for (const auto& [pid, entry] : m_entries) result.push_back(entry.info);
+    std::ranges::sort(result, [](const ProcessInfo& a, const ProcessInfo& b) { return a.pid < b.pid; });
+    return result;
+}
+
+const ProcessInfo* ProcessDirectory::findByPid(pid_t pid) const {
+    auto it = m_entries.find(pid);
+    return it == m_entries.end() ? nullptr : &it->second.info;
+}
+
+std::vector<ProcessInfo> ProcessDirectory::findBySubstring(std::string_view substring) const {
+    std::string needle = toLower(substring);
+    std::vector<ProcessInfo> result;
+    for (const auto& [pid, entry] : m_entries) {
+        if (entry.lowerName.find(needle) != std::string::npos || entry.lowerCommandLine.find(needle) != std::string::npos) {
+            result.push_back(entry.info);
+        }
+    }
+    std::ranges::sort(result, [](const ProcessInfo& a, const ProcessInfo& b) { return a.pid < b.pid; });
+    return result;
+}
+
+bool matchProcessesByRegex(const std::string& pattern, const std::vector<ProcessInfo>& candidates,
+                           std::vector<ProcessInfo>& out, std::string& error) {
+    // The compiler recurses per nesting level, the pattern is bounded like the input
+    if (pattern.size() > kMaxProcessRegexLength) {
+        error = "regex longer than " + std::to_string(kMaxProcessRegexLength) + " characters";
+        return false;
+    }
+    std::regex expression;
+    try {
+        expression = std::regex(pattern, std::regex::ECMAScript | std::regex::icase);
+    } catch (const std::regex_error&) {
+        error = "invalid regex";
+        return false;
+    }
+
+    out.clear();
+    try {
+        for (const auto& process : candidates) {
+            size_t length = std::min(process.commandLine.size(), kProcessRegexCommandLineLimit);
+            if (std::regex_search(process.exeName, expression) ||
+                std::regex_search(process.commandLine.begin(), process.commandLine.begin() + length, expression)) {
+                out.push_back(process);
+            }
+        }
+    } catch (const std::regex_error&) {
+        // error_complexity / error_stack of a pathological pattern
+        error = "regex too complex";
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+ProcessDirectory& sharedDirectory(std::unique_lock<std::mutex>& lock) {
+    static std::mutex mutex;
+    static ProcessDirectory directory;
+    lock = std::unique_lock<std::mutex>(mutex);
+    directory.refresh();
+    return directory;
+}
+
+} // namespace
+
+std::vector<ProcessInfo> enumerateProcesses() {
+    std::unique_lock<std::mutex> lock;
+    return sharedDirectory(lock).processes();
+}
+
+std::vector<ProcessInfo> findProcessesBySubstring(const std::string &substring) {
+    std::unique_lock<std::mutex> lock;
+    return sharedDirectory(lock).findBySubstring(substring);
+}
+#endif
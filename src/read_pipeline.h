@@ -0,0 +1,92 @@
+#pragma once
+#ifdef __linux__
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <sys/types.h>
+
+// Chunks a scan keeps in flight by default. Every slot holds one chunk buffer, so the
+// read-ahead memory is about depth * kScanChunkSize.
+constexpr size_t kDefaultReadQueueDepth = 4;
+constexpr size_t kMaxReadQueueDepth = 64;
+
+// kDefaultReadQueueDepth, or 0 on a single core where reads and compares cannot overlap
+// and the read-ahead only costs cache
+size_t defaultReadQueueDepth();
+
+// Reader threads of the fallback backend
+constexpr size_t kReadPipelineThreads = 4;
+
+// One range of target memory to read
+struct ReadChunk {
+    uintptr_t address;
+    size_t size;
+};
+
+// A finished read as handed to the consumer
+struct ReadCompletion {
+    size_t index;            // position in the chunk list
+    const uint8_t* data;     // only valid during the consume call
+    size_t bytesRead;        // less than the chunk size if the read failed or stopped early
+    int error;               // errno of a failed read, 0 otherwise
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+};
+
+// Asynchronous reads of /proc/<pid>/mem. Up to queueDepth chunks are read ahead while the
+// consumer works on the completed ones; completions are delivered in list order on the
+// calling thread, so address-ordered sinks stay ordered. io_uring is used when the kernel
+// allows it, otherwise a small pool of threads issues the preads.
+class ReadPipeline {
+public:
+    enum class Backend {
+        IO_URING,
+        THREADS
+    };
+
+    ReadPipeline(pid_t pid, size_t queueDepth = kDefaultReadQueueDepth);
+    ~ReadPipeline();
+
+    ReadPipeline(const ReadPipeline&) = delete;
+    ReadPipeline& operator=(const ReadPipeline&) = delete;
+
+    // False if /proc/<pid>/mem cannot be opened, callers then read synchronously
+    bool valid() const { return m_memFd >= 0; }
+    Backend backend() const { return m_ring ? Backend::IO_URING : Backend::THREADS; }
+    size_t queueDepth() const { return m_depth; }
+
+    // Read every chunk and call consume once per chunk, in list order
+    void run(const std::vector<ReadChunk>& chunks, const std::function<void(const ReadCompletion&)>& consume);
+
+    // Buffer memory held for the chunks in flight
+    size_t bufferBytes() const;
+
+    // Kernel calls issued so far (ring submissions or preads)
+    uint64_t syscalls() const { return m_syscalls.load(std::memory_order_relaxed); }
+
+private:
+    struct Ring;
+    struct Slot {
+        std::vector<uint8_t> buffer;
+        ReadCompletion completion{};
+        bool done = false;
+    };
+
+    int m_memFd = -1;
+    size_t m_depth;
+    std::unique_ptr<Ring> m_ring;
+    std::vector<Slot> m_slots;
+    std::atomic<uint64_t> m_syscalls{0};
+
+    void prepareSlots(const std::vector<ReadChunk>& chunks);
+    void runRing(const std::vector<ReadChunk>& chunks, const std::function<void(const ReadCompletion&)>& consume);
+    void runThreads(const std::vector<ReadChunk>& chunks, const std::function<void(const ReadCompletion&)>& consume);
+};
+
+const char* readPipelineBackendName(ReadPipeline::Backend backend);
+#endif
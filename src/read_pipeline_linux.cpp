@@ -0,0 +1,322 @@
+#ifdef __linux__
+#include "read_pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// One pread of a chunk. /proc/<pid>/mem stops at the first unreadable page, like process_vm_readv.
+void readChunk(int fd, const ReadChunk& chunk, uint8_t* buffer, ReadCompletion& completion) {
+    ssize_t result;
+    do {
+        result = pread(fd, buffer, chunk.size, static_cast<off_t>(chunk.address));
+    } while (result < 0 && errno == EINTR);
+    completion.bytesRead = result > 0 ? static_cast<size_t>(result) : 0;
+    completion.error = result < 0 ? errno : 0;
+    completion.end = Clock::now();
+}
+
+} // namespace
+
+// Submission and completion rings shared with the kernel, set up with the raw syscalls
+struct ReadPipeline::Ring {
+    int fd = -1;
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) close(fd);
+    }
+
+    // nullptr if io_uring is unavailable (old kernel, disabled by sysctl or seccomp)
+    static std::unique_ptr<Ring> create(unsigned entries) {
+        io_uring_params params{};
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return nullptr;
+
+        auto ring = std::make_unique<Ring>();
+        ring->fd = fd;
+        // IORING_OP_READ arrived together with IORING_FEAT_RW_CUR_POS (5.6)
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) return nullptr;
+
+        ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) ring->sqMapSize = ring->cqMapSize = std::max(ring->sqMapSize, ring->cqMapSize);
+
+        ring->sqMap = mmap(nullptr, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (ring->sqMap == MAP_FAILED) return nullptr;
+        ring->cqMap = singleMap ? ring->sqMap
+                                : mmap(nullptr, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cqMap == MAP_FAILED) return nullptr;
+        ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) return nullptr;
+
+        auto* sq = static_cast<uint8_t*>(ring->sqMap);
+        auto* cq = static_cast<uint8_t*>(ring->cqMap);
+        ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return ring;
+    }
+
+    void pushRead(int memFd, const ReadChunk& chunk, uint8_t* buffer, uint64_t userData) {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        sqe = io_uring_sqe{};
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = memFd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = static_cast<uint32_t>(chunk.size);
+        sqe.off = chunk.address;
+        sqe.user_data = userData;
+        sqArray[index] = index;
+        std::atomic_ref<unsigned>(*sqTail).store(tail + 1, std::memory_order_release);
+    }
+
+    // Submit pending entries and optionally wait for one completion. Returns false on a ring error.
+    bool enter(unsigned submit, bool wait) {
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, fd, submit, wait ? 1u : 0u,
+                                  wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (result >= 0) return true;
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) return false;
+        }
+    }
+
+    template<typename F>
+    void reap(F&& onCompletion) {
+        unsigned head = *cqHead;
+        unsigned tail = std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes[head & *cqMask];
+            onCompletion(cqe.user_data, cqe.res);
+            head++;
+        }
+        std::atomic_ref<unsigned>(*cqHead).store(head, std::memory_order_release);
+    }
+};
+
+size_t defaultReadQueueDepth() {
+    return std::thread::hardware_concurrency() > 1 ? kDefaultReadQueueDepth : 0;
+}
+
+ReadPipeline::ReadPipeline(pid_t pid, size_t queueDepth)
+    : m_depth(std::clamp<size_t>(queueDepth, 1, kMaxReadQueueDepth)) {
+    m_memFd = open(("/proc/" + std::to_string(pid) + "/mem").c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_memFd >= 0) m_ring = Ring::create(static_cast<unsigned>(m_depth));
+}
+
+ReadPipeline::~ReadPipeline() {
+    m_ring.reset();
+    if (m_memFd >= 0) close(m_memFd);
+}
+
+size_t ReadPipeline::bufferBytes() const {
+    size_t bytes = 0;
+    for (const auto& slot : m_slots) bytes += slot.buffer.capacity();
+    return bytes;
+}
+
+void ReadPipeline::prepareSlots(const std::vector<ReadChunk>& chunks) {
+    size_t largest = 0;
+    for (const auto& chunk : chunks) largest = std::max(largest, chunk.size);
+
+    // No more slots than chunks, a list of small regions gets small buffers
+    m_slots.resize(std::min(m_depth, chunks.size()));
+    for (auto& slot : m_slots) {
+        slot.buffer.resize(largest);
+        slot.done = false;
+    }
+}
+
+void ReadPipeline::run(const std::vector<ReadChunk>& chunks, const std::function<void(const ReadCompletion&)>& consume) {
+    if (chunks.empty() || !valid()) return;
+    prepareSlots(chunks);
+
+    if (m_ring) runRing(chunks, consume);
+    else runThreads(chunks, consume);
+
+    // Buffers live for one run only, like the buffer of a synchronous scan
+    m_slots.clear();
+}
+
+void ReadPipeline::runRing(const std::vector<ReadChunk>& chunks, const std::function<void(const ReadCompletion&)>& consume) {
+    const size_t depth = m_slots.size();
+    size_t next = 0;
+    size_t deliver = 0;
+    size_t inFlight = 0;
+    unsigned unsubmitted = 0;
+
+    auto complete = [&](uint64_t index, int result) {
+        Slot& slot = m_slots[index % depth];
+        slot.completion.bytesRead = result > 0 ? static_cast<size_t>(result) : 0;
+        slot.completion.error = result < 0 ? -result : 0;
+        slot.completion.end = Clock::now();
+        slot.done = true;
+        inFlight--;
+    };
+
+    // Entries still owned by the kernel must finish before their buffers can go away
+    auto drain = [&] {
+        while (inFlight > 0 && m_ring->enter(unsubmitted, true)) {
+            unsubmitted = 0;
+            m_ring->reap(complete);
+        }
+    };
+
+    try {
+        while (deliver < chunks.size()) {
+            // Keep the queue full: slot i % depth is free once chunk i - depth was consumed
+            while (next < chunks.size() && next < deliver + depth) {
+                Slot& slot = m_slots[next % depth];
+                slot.done = false;
+                slot.completion = ReadCompletion{ next, slot.buffer.data(), 0, 0, Clock::now(), {} };
+                m_ring->pushRead(m_memFd, chunks[next], slot.buffer.data(), next);
+                next++;
+                inFlight++;
+                unsubmitted++;
+            }
+
+            Slot& head = m_slots[deliver % depth];
+            if (unsubmitted > 0 || !head.done) {
+                m_syscalls.fetch_add(1, std::memory_order_relaxed);
+                if (!m_ring->enter(unsubmitted, !head.done)) break;
+                unsubmitted = 0;
+            }
+            m_ring->reap(complete);
+
+            while (deliver < chunks.size() && m_slots[deliver % depth].done) {
+                Slot& slot = m_slots[deliver % depth];
+                consume(slot.completion);
+                slot.done = false;
+                deliver++;
+            }
+        }
+    } catch (...) {
+        drain();
+        throw;
+    }
+
+    if (deliver == chunks.size()) return;
+
+    // The ring failed: wait for what it still owns, read the rest with plain preads from now on
+    drain();
+    m_ring.reset();
+    for (; deliver < chunks.size(); deliver++) {
+        Slot& slot = m_slots[deliver % depth];
+        if (!slot.done || slot.completion.index != deliver) {
+            slot.completion = ReadCompletion{ deliver, slot.buffer.data(), 0, 0, Clock::now(), {} };
+            m_syscalls.fetch_add(1, std::memory_order_relaxed);
+            readChunk(m_memFd, chunks[deliver], slot.buffer.data(), slot.completion);
+        }
+        consume(slot.completion);
+        slot.done = false;
+    }
+}
+
+void ReadPipeline::runThreads(const std::vector<ReadChunk>& chunks, const std::function<void(const ReadCompletion&)>& consume) {
+    const size_t depth = m_slots.size();
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable chunkDone;
+    size_t next = 0;
+    size_t deliver = 0;
+    bool stop = false;
+
+    auto worker = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            workAvailable.wait(lock, [&] { return stop || (next < chunks.size() && next < deliver + depth); });
+            if (stop) return;
+
+            size_t index = next++;
+            Slot& slot = m_slots[index % depth];
+            lock.unlock();
+
+            ReadCompletion completion{ index, slot.buffer.data(), 0, 0, Clock::now(), {} };
+            m_syscalls.fetch_add(1, std::memory_order_relaxed);
+            readChunk(m_memFd, chunks[index], slot.buffer.data(), completion);
+
+            lock.lock();
+            slot.completion = completion;
+            slot.done = true;
+            chunkDone.notify_one();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(kReadPipelineThreads, depth); i++) threads.emplace_back(worker);
+
+    auto stopWorkers = [&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        workAvailable.notify_all();
+        for (auto& thread : threads) thread.join();
+    };
+
+    try {
+        while (deliver < chunks.size()) {
+            Slot& slot = m_slots[deliver % depth];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunkDone.wait(lock, [&] { return slot.done; });
+            }
+            consume(slot.completion);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot.done = false;
+                deliver++;
+            }
+            workAvailable.notify_all();
+        }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+    stopWorkers();
+}
+
+const char* readPipelineBackendName(ReadPipeline::Backend backend) {
+    return backend == ReadPipeline::Backend::IO_URING ? "io_uring" : "threads";
+}
+#endif
@@ -0,0 +1,129 @@
+#include "result_spill.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#else
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+std::shared_ptr<SpillSegment> SpillSegment::create(const std::filesystem::path& directory) {
+    // CREATE_NEW never opens an existing file or link; a name that is taken gets another try
+    static std::atomic<uint32_t> counter{0};
+    for (int attempt = 0; attempt < 16; attempt++) {
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::filesystem::path path = directory / ("memscan-" + std::to_string(stamp) + "-" +
+                                                  std::to_string(counter.fetch_add(1)) + ".spill");
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+                                  FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (file != INVALID_HANDLE_VALUE) return std::shared_ptr<SpillSegment>(new SpillSegment(file));
+        if (GetLastError() != ERROR_FILE_EXISTS) return nullptr;
+    }
+    return nullptr;
+}
+
+SpillSegment::~SpillSegment() {
+    CloseHandle(m_file);
+}
+
+bool SpillSegment::append(const std::vector<uint8_t>& bytes, uint64_t& offset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t written = 0; written < bytes.size();) {
+        OVERLAPPED position{};
+        position.Offset = static_cast<DWORD>(m_size + written);
+        position.OffsetHigh = static_cast<DWORD>((m_size + written) >> 32);
+        DWORD n = 0;
+        DWORD request = static_cast<DWORD>(std::min<size_t>(bytes.size() - written, 1u << 30));
+        if (!WriteFile(m_file, bytes.data() + written, request, &n, &position) || n == 0) return false;
+        written += n;
+    }
+
+    offset = m_size;
+    m_size += bytes.size();
+    return true;
+}
+
+bool SpillSegment::read(uint64_t offset, size_t size, std::vector<uint8_t>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (offset + size > m_size) return false;
+    out.resize(size);
+    for (size_t done = 0; done < size;) {
+        OVERLAPPED position{};
+        position.Offset = static_cast<DWORD>(offset + done);
+        position.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+        DWORD n = 0;
+        DWORD request = static_cast<DWORD>(std::min<size_t>(size - done, 1u << 30));
+        if (!ReadFile(m_file, out.data() + done, request, &n, &position) || n == 0) return false;
+        done += n;
+    }
+    return true;
+}
+#else
+std::shared_ptr<SpillSegment> SpillSegment::create(const std::filesystem::path& directory) {
+    // mkostemp creates the file exclusively with mode 0600, no planted link is followed
+    std::string path = (directory / "memscan-XXXXXX").string();
+    int fd = mkostemp(path.data(), O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    unlink(path.c_str());
+    return std::shared_ptr<SpillSegment>(new SpillSegment(fd));
+}
+
+SpillSegment::~SpillSegment() {
+    close(m_file);
+}
+
+bool SpillSegment::append(const std::vector<uint8_t>& bytes, uint64_t& offset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t written = 0; written < bytes.size();) {
+        ssize_t n = pwrite(m_file, bytes.data() + written, bytes.size() - written, static_cast<off_t>(m_size + written));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += static_cast<size_t>(n);
+    }
+
+    offset = m_size;
+    m_size += bytes.size();
+    return true;
+}
+
+bool SpillSegment::read(uint64_t offset, size_t size, std::vector<uint8_t>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (offset + size > m_size) return false;
+    out.resize(size);
+    for (size_t done = 0; done < size;) {
+        ssize_t n = pread(m_file, out.data() + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+#endif
+
+void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool readVarint(const uint8_t*& pos, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos == end) return false;
+        uint8_t byte = *pos++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
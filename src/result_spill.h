@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Spilled runs are appended to segment files of about this size. A segment is
+// deleted as soon as no run stored in it is referenced anymore.
+constexpr uint64_t kSpillSegmentSize = 256ull * 1024 * 1024;
+
+// Temporary file holding compressed result runs. The file holds target memory, so it is
+// created exclusively, readable by the owner only, and never reachable by name: unlinked
+// right after creation on POSIX, deleted on close on Windows.
+class SpillSegment {
+public:
+    // Create a new segment file in directory, nullptr if it cannot be created
+    static std::shared_ptr<SpillSegment> create(const std::filesystem::path& directory);
+
+    ~SpillSegment();
+
+    SpillSegment(const SpillSegment&) = delete;
+    SpillSegment& operator=(const SpillSegment&) = delete;
+
+    // Append bytes at the end of the file, offset receives their position
+    bool append(const std::vector<uint8_t>& bytes, uint64_t& offset);
+
+    // Read size bytes at offset into out
+    bool read(uint64_t offset, size_t size, std::vector<uint8_t>& out);
+
+    uint64_t size() const { return m_size; }
+
+private:
+#ifdef _WIN32
+    using NativeFile = void*; // HANDLE
+#else
+    using NativeFile = int;
+#endif
+    explicit SpillSegment(NativeFile file) : m_file(file) {}
+
+    NativeFile m_file;
+    uint64_t m_size = 0;
+    std::mutex m_mutex;
+};
+
+// Location of one spilled run inside a segment
+struct SpillRun {
+    std::shared_ptr<SpillSegment> segment;
+    uint64_t offset = 0;
+    uint32_t bytes = 0;
+    uint32_t count = 0;
+};
+
+// LEB128 varints, used for address deltas and integer values
+void appendVarint(std::vector<uint8_t>& out, uint64_t value);
+bool readVarint(const uint8_t*& pos, const uint8_t* end, uint64_t& value);
+
+// Integers are stored zigzag encoded (small magnitudes take one or two bytes),
+// floating point values raw and strings as length + characters
+template<typename T>
+void encodeSpillValue(std::vector<uint8_t>& out, const T& value) {
+    if constexpr (std::is_integral_v<T>) {
+        using U = std::make_unsigned_t<T>;
+        U bits = static_cast<U>(value);
+        if constexpr (std::is_signed_v<T>) {
+            bits = static_cast<U>(bits << 1) ^ static_cast<U>(value < 0 ? ~U(0) : U(0));
+        }
+        appendVarint(out, bits);
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    } else {
+        using Char = typename T::value_type;
+        appendVarint(out, value.size());
+        const auto* bytes = reinterpret_cast<const uint8_t*>(value.data());
+        out.insert(out.end(), bytes, bytes + value.size() * sizeof(Char));
+    }
+}
+
+template<typename T>
+bool decodeSpillValue(const uint8_t*& pos, const uint8_t* end, T& value) {
+    if constexpr (std::is_integral_v<T>) {
+        using U = std::make_unsigned_t<T>;
+        uint64_t raw;
+        if (!readVarint(pos, end, raw)) return false;
+        U bits = static_cast<U>(raw);
+        if constexpr (std::is_signed_v<T>) {
+            bits = static_cast<U>(bits >> 1) ^ static_cast<U>(-static_cast<U>(bits & 1));
+        }
+        value = static_cast<T>(bits);
+        return true;
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) return false;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    } else {
+        using Char = typename T::value_type;
+        uint64_t length;
+        if (!readVarint(pos, end, length)) return false;
+        if (length > static_cast<size_t>(end - pos) / sizeof(Char)) return false;
+        value.resize(length);
+        std::memcpy(value.data(), pos, length * sizeof(Char));
+        pos += length * sizeof(Char);
+        return true;
+    }
+}
+
+// Encode an address-ordered run of matches: first address, then address deltas,
+// each followed by its value
+template<typename Match>
+std::vector<uint8_t> encodeSpillRun(const std::vector<Match>& run) {
+    std::vector<uint8_t> out;
+    out.reserve(run.size() * 3);
+
+    uintptr_t previous = 0;
+    for (const auto& match : run) {
+        appendVarint(out, match.address - previous);
+        encodeSpillValue(out, match.value);
+        previous = match.address;
+    }
+    return out;
+}
+
+template<typename Match>
+bool decodeSpillRun(const std::vector<uint8_t>& bytes, size_t count, std::vector<Match>& out) {
+    out.clear();
+    out.reserve(count);
+
+    const uint8_t* pos = bytes.data();
+    const uint8_t* end = bytes.data() + bytes.size();
+    uintptr_t address = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t delta;
+        Match match;
+        if (!readVarint(pos, end, delta) || !decodeSpillValue(pos, end, match.value)) return false;
+        address += static_cast<uintptr_t>(delta);
+        match.address = address;
+        out.push_back(std::move(match));
+    }
+    return pos == end;
+}
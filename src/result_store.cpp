@@ -0,0 +1,223 @@
+#include "result_store.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "result_spill.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+bool valuesEqual(ScanValueType type, const uint8_t* a, const uint8_t* b, size_t size) {
+    switch (type) {
+        case ScanValueType::FLOAT: {
+            float x, y;
+            std::memcpy(&x, a, sizeof(x));
+            std::memcpy(&y, b, sizeof(y));
+            return x == y;
+        }
+        case ScanValueType::DOUBLE: {
+            double x, y;
+            std::memcpy(&x, a, sizeof(x));
+            std::memcpy(&y, b, sizeof(y));
+            return x == y;
+        }
+        case ScanValueType::FLOAT_BE:
+        case ScanValueType::DOUBLE_BE: {
+            // Compare in host order so 0.0 == -0.0 and NaN != NaN hold as for native floats
+            uint8_t x[8], y[8];
+            std::reverse_copy(a, a + size, x);
+            std::reverse_copy(b, b + size, y);
+            return valuesEqual(nativeScanValueType(type), x, y, size);
+        }
+        default:
+            return std::memcmp(a, b, size) == 0;
+    }
+}
+
+} // namespace
+
+void ResultStore::shrink_to_fit() {
+    m_addresses.shrink_to_fit();
+    m_values.shrink_to_fit();
+}
+
+void ResultStore::clear() {
+    m_addresses.clear();
+    m_sharedValue.clear();
+    m_values.clear();
+}
+
+void ResultStore::push_back(uintptr_t address, const void* value) {
+    const auto* bytes = static_cast<const uint8_t*>(value);
+    if (m_addresses.empty()) {
+        m_values.clear();
+        m_sharedValue.assign(bytes, bytes + m_valueSize);
+    } else if (m_values.empty() && m_valueSize != 0 && std::memcmp(m_sharedValue.data(), bytes, m_valueSize) != 0) {
+        expandValues();
+    }
+
+    if (!m_values.empty()) m_values.insert(m_values.end(), bytes, bytes + m_valueSize);
+    m_addresses.push_back(address);
+}
+
+void ResultStore::expandValues() {
+    // The first differing value: every row so far gets its copy of the shared value
+    m_values.reserve(m_addresses.capacity() * m_valueSize);
+    for (size_t row = 0; row < m_addresses.size(); row++) {
+        m_values.insert(m_values.end(), m_sharedValue.begin(), m_sharedValue.end());
+    }
+}
+
+size_t ResultStore::residentBytes() const {
+    return m_addresses.capacity() * sizeof(uintptr_t) + m_sharedValue.capacity() + m_values.capacity();
+}
+
+bool ResultStore::sameRows(const ResultStore& other) const {
+    if (size() != other.size() || m_valueSize != other.m_valueSize) return false;
+    if (m_addresses != other.m_addresses) return false;
+    if (sharedValue() && other.sharedValue()) return m_sharedValue == other.m_sharedValue;
+    for (size_t row = 0; row < size(); row++) {
+        if (std::memcmp(value(row), other.value(row), m_valueSize) != 0) return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> ResultStore::encode() const {
+    std::vector<uint8_t> out;
+    out.reserve(m_addresses.size() * 3 + m_values.size() + m_sharedValue.size() + 8);
+
+    appendVarint(out, static_cast<uint64_t>(m_type));
+    appendVarint(out, m_valueSize);
+    out.push_back(sharedValue() ? 1 : 0);
+    if (sharedValue()) out.insert(out.end(), m_sharedValue.begin(), m_sharedValue.end());
+
+    uintptr_t previous = 0;
+    for (uintptr_t address : m_addresses) {
+        appendVarint(out, address - previous);
+        previous = address;
+    }
+    out.insert(out.end(), m_values.begin(), m_values.end());
+    return out;
+}
+
+bool ResultStore::decode(const std::vector<uint8_t>& bytes, size_t count) {
+    clear();
+    const uint8_t* pos = bytes.data();
+    const uint8_t* end = bytes.data() + bytes.size();
+
+    uint64_t type, valueSize;
+    if (!readVarint(pos, end, type) || !readVarint(pos, end, valueSize) || pos >= end) return false;
+    m_type = static_cast<ScanValueType>(type);
+    m_valueSize = static_cast<size_t>(valueSize);
+
+    bool shared = *pos++ != 0;
+    if (shared) {
+        if (static_cast<size_t>(end - pos) < m_valueSize) return false;
+        m_sharedValue.assign(pos, pos + m_valueSize);
+        pos += m_valueSize;
+    }
+
+    m_addresses.reserve(count);
+    uintptr_t address = 0;
+    for (size_t row = 0; row < count; row++) {
+        uint64_t delta;
+        if (!readVarint(pos, end, delta)) return false;
+        address += static_cast<uintptr_t>(delta);
+        m_addresses.push_back(address);
+    }
+
+    if (!shared) {
+        if (static_cast<size_t>(end - pos) != count * m_valueSize) return false;
+        m_values.assign(pos, end);
+        pos = end;
+    }
+    return pos == end;
+}
+
+ResultStore filterResultStore(MemoryScanner& scanner, const ResultStore& input, ColumnFilter filter, const void* value) {
+    size_t width = input.valueSize();
+    ResultStore output(input.type(), width);
+    if (input.empty() || width == 0) return output;
+
+    // Current values land in one contiguous column, nearby rows share one read. Partitions
+    // of the rows are read and compared in parallel, each marks the rows that pass.
+    std::vector<uint8_t> current(input.size() * width);
+    std::vector<uint8_t> keep(input.size());
+    const auto* wanted = static_cast<const uint8_t*>(value);
+    std::vector<size_t> starts = MemoryScanner::planPartitions(input.size());
+    std::vector<size_t> passed = scanner.forEachPartition(starts, [&](MemoryScanner& reader, size_t begin, size_t end) {
+        std::vector<MemoryIoRequest> requests(end - begin);
+        for (size_t row = begin; row < end; row++) {
+            requests[row - begin] = { input.address(row), &current[row * width], width, false };
+        }
+        reader.readMemoryBatch(requests);
+
+        size_t count = 0;
+        for (size_t row = begin; row < end; row++) {
+            if (!requests[row - begin].success || !reader.heapAllows(input.address(row), width)) continue;
+            const uint8_t* now = &current[row * width];
+            bool equal = valuesEqual(input.type(), now, filter == ColumnFilter::EQUAL ? wanted : input.value(row), width);
+            keep[row] = equal != (filter == ColumnFilter::CHANGED);
+            count += keep[row];
+        }
+        return count;
+    });
+
+    // The partition counts size the output columns once, they never grow by reallocation
+    size_t total = 0;
+    for (size_t count : passed) total += count;
+    output.reserve(total);
+    for (size_t row = 0; row < input.size(); row++) {
+        if (keep[row]) output.push_back(input.address(row), &current[row * width]);
+    }
+    return output;
+}
+
+ResultStore filterResultStore(MemoryScanner& scanner, const ResultStore& input, const FilterExpression& expression,
+                              const FirstValueIndex* first) {
+    size_t width = input.valueSize();
+    ResultStore output(input.type(), width);
+    if (input.empty() || width == 0 || input.type() != expression.type()) return output;
+
+    std::vector<uint8_t> current(input.size() * width);
+    std::vector<MemoryIoRequest> requests(input.size());
+    for (size_t row = 0; row < input.size(); row++) {
+        requests[row] = { input.address(row), &current[row * width], width, false };
+    }
+    scanner.readMemoryBatch(requests);
+    scanner.refreshHeapMap();
+    for (size_t row = 0; row < input.size(); row++) {
+        if (!scanner.heapAllows(input.address(row), width)) requests[row].success = false;
+    }
+
+    // The stored column is used as it is, a shared value is spread out first
+    std::vector<uint8_t> spread;
+    const uint8_t* old = nullptr;
+    if (expression.usesOld()) {
+        if (input.sharedValue()) {
+            spread.resize(input.size() * width);
+            for (size_t row = 0; row < input.size(); row++) std::memcpy(&spread[row * width], input.value(0), width);
+            old = spread.data();
+        } else {
+            old = input.value(0);
+        }
+    }
+
+    // Rows without a first value cannot pass
+    std::vector<uint8_t> firstColumn;
+    if (expression.usesFirst()) {
+        firstColumn.resize(input.size() * width);
+        for (size_t row = 0; row < input.size(); row++) {
+            const uint8_t* value = first ? first->find(input.address(row)) : nullptr;
+            if (value) std::memcpy(&firstColumn[row * width], value, width);
+            else requests[row].success = false;
+        }
+    }
+
+    std::vector<uint8_t> keep(input.size());
+    expression.evaluate(current.data(), old, firstColumn.empty() ? nullptr : firstColumn.data(), input.size(), keep.data());
+    for (size_t row = 0; row < input.size(); row++) {
+        if (keep[row] && requests[row].success) output.push_back(input.address(row), &current[row * width]);
+    }
+    return output;
+}
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "filter_expression.h"
+#include "memory_scanner.h"
+#include "scan_history.h"
+#include "scan_value_type.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Scan value type of a scanner value type
+template<typename T>
+constexpr ScanValueType scanValueTypeOf() {
+    if constexpr (std::is_same_v<T, int32_t>) return ScanValueType::INT32;
+    else if constexpr (std::is_same_v<T, int64_t>) return ScanValueType::INT64;
+    else if constexpr (std::is_same_v<T, float>) return ScanValueType::FLOAT;
+    else if constexpr (std::is_same_v<T, double>) return ScanValueType::DOUBLE;
+    else if constexpr (std::is_same_v<T, Swapped<int32_t>>) return ScanValueType::INT32_BE;
+    else if constexpr (std::is_same_v<T, Swapped<int64_t>>) return ScanValueType::INT64_BE;
+    else if constexpr (std::is_same_v<T, Swapped<float>>) return ScanValueType::FLOAT_BE;
+    else if constexpr (std::is_same_v<T, Swapped<double>>) return ScanValueType::DOUBLE_BE;
+    else if constexpr (std::is_same_v<T, std::string>) return ScanValueType::STRING_ASCII;
+    else {
+        static_assert(std::is_same_v<T, std::wstring>, "unsupported scan value type");
+        return ScanValueType::STRING_UNICODE;
+    }
+}
+
+// Type-erased result set in structure-of-arrays layout: an address column and a value
+// column of fixed width. Type and width are stored once for the whole set, not per row.
+// While every row holds the same value (exact scans, string hits) that value is kept once
+// and the value column stays empty, so such a row costs only its address.
+class ResultStore {
+public:
+    ResultStore() = default;
+    ResultStore(ScanValueType type, size_t valueSize) : m_type(type), m_valueSize(valueSize) {}
+
+    ScanValueType type() const { return m_type; }
+    size_t valueSize() const { return m_valueSize; }
+    size_t size() const { return m_addresses.size(); }
+    bool empty() const { return m_addresses.empty(); }
+
+    void reserve(size_t rows) { m_addresses.reserve(rows); }
+    void shrink_to_fit();
+    void clear();
+
+    // Append a row, value points to valueSize() bytes
+    void push_back(uintptr_t address, const void* value);
+
+    // Append a scanner match. The first match of an empty store sets type and width,
+    // all string hits of one scan have the length of the needle.
+    template<typename T>
+    void push_back(const MemoryMatch<T>& match);
+
+    uintptr_t address(size_t row) const { return m_addresses[row]; }
+    const uint8_t* value(size_t row) const {
+        return m_values.empty() ? m_sharedValue.data() : &m_values[row * m_valueSize];
+    }
+
+    const std::vector<uintptr_t>& addresses() const { return m_addresses; }
+
+    // True while all rows share one value and no value column is stored
+    bool sharedValue() const { return m_values.empty(); }
+
+    size_t residentBytes() const;
+
+    // Same addresses and value bytes in the same order
+    bool sameRows(const ResultStore& other) const;
+
+    // Spill format: type, width, the shared value or nothing, address deltas, value column
+    std::vector<uint8_t> encode() const;
+    bool decode(const std::vector<uint8_t>& bytes, size_t count);
+
+private:
+    ScanValueType m_type = ScanValueType::INT32;
+    size_t m_valueSize = 0;
+    std::vector<uintptr_t> m_addresses;
+    std::vector<uint8_t> m_sharedValue; // value of every row while m_values is empty
+    std::vector<uint8_t> m_values;      // m_valueSize bytes per row, once the values differ
+
+    void expandValues();
+};
+
+template<typename T>
+void ResultStore::push_back(const MemoryMatch<T>& match) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (empty()) {
+            m_type = scanValueTypeOf<T>();
+            m_valueSize = sizeof(T);
+        }
+        push_back(match.address, &match.value);
+    } else {
+        if (empty()) {
+            m_type = scanValueTypeOf<T>();
+            m_valueSize = match.value.size() * sizeof(typename T::value_type);
+        }
+        push_back(match.address, match.value.data());
+    }
+}
+
+// Rows a column filter keeps
+enum class ColumnFilter {
+    EQUAL,    // current value equals the given value
+    CHANGED,  // current value differs from the stored one
+    UNCHANGED // current value equals the stored one
+};
+
+// Re-read the values of all rows with batched reads (partitions of a large store in
+// parallel) and keep the rows that pass filter, together with their current values. value (valueSize() bytes) is only used by EQUAL.
+// Floating point values compare like the typed filters (0.0 == -0.0, NaN never equal).
+ResultStore filterResultStore(MemoryScanner& scanner, const ResultStore& input, ColumnFilter filter,
+                              const void* value = nullptr);
+
+// Re-read the values of all rows with one batched read and keep the rows for which expression
+// is true, in one evaluation pass over the current, stored (old) and first value columns.
+// first may be null if the expression does not use it.
+ResultStore filterResultStore(MemoryScanner& scanner, const ResultStore& input, const FilterExpression& expression,
+                              const FirstValueIndex* first = nullptr);
+
+// Row access for firstValuesOf
+inline uintptr_t rowAddress(const ResultStore& shard, size_t row) { return shard.address(row); }
+inline const void* rowValue(const ResultStore& shard, size_t row) { return shard.value(row); }
+inline size_t rowValueSize(const ResultStore& shard) { return shard.valueSize(); }
+
+// A history of column stores
+template<>
+struct HistoryShardTraits<ResultStore> {
+    using Shard = ResultStore;
+
+    static size_t residentBytes(const Shard& shard) { return shard.residentBytes(); }
+    static std::vector<uint8_t> encode(const Shard& shard) { return shard.encode(); }
+    static bool decode(const std::vector<uint8_t>& bytes, size_t count, Shard& out) { return out.decode(bytes, count); }
+    static bool same(const Shard& a, const Shard& b) { return a.sameRows(b); }
+};
+#endif
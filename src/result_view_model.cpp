@@ -0,0 +1,358 @@
+#include "result_view_model.h"
+#include "byte_order.h"
+#include "value_format.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+// Visible rows closer than this are fetched with one read
+constexpr size_t kCoalesceGap = 4096;
+// Upper bound for a single coalesced read
+constexpr size_t kMaxCoalescedRead = 64 * 1024;
+
+template<typename T>
+T loadValue(const uint8_t* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// Text shown for the address and value of an unreadable row
+constexpr std::string_view kUnreadableCell = "??";
+
+// Strict weak ordering that also holds for NaN (NaN sorts last)
+template<typename T>
+bool numericLess(T a, T b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(a)) return false;
+        if (std::isnan(b)) return true;
+    }
+    return a < b;
+}
+
+} // namespace
+
+ResultViewModel::ResultViewModel() : m_cellBuffer(512) {}
+
+void ResultViewModel::setSource(size_t rowCount, ScanValueType type, size_t valueSize, AddressFn addressAt, ValueFn valueAt) {
+    m_rowCount = rowCount;
+    m_type = type;
+    m_valueSize = valueSize;
+    m_addressAt = std::move(addressAt);
+    m_valueAt = std::move(valueAt);
+    m_order = std::vector<size_t>();
+    m_orderReservation.force(0);
+    m_sortKey = ResultSortKey::ADDRESS;
+    m_sortAscending = true;
+    m_valueBuffer.assign(valueSize, 0);
+    m_visibleFirst = 0;
+    m_visibleCount = 0;
+    m_liveValues.clear();
+    m_liveValid.clear();
+    m_lastRefreshMs = 0;
+}
+
+void ResultViewModel::clear() {
+    setSource(0, m_type, 0, nullptr, nullptr);
+}
+
+void ResultViewModel::setReader(ReadFn reader, uint32_t refreshIntervalMs) {
+    m_reader = std::move(reader);
+    m_refreshIntervalMs = refreshIntervalMs;
+}
+
+void ResultViewModel::setModuleResolver(ModuleFn resolver) {
+    m_moduleResolver = std::move(resolver);
+}
+
+size_t ResultViewModel::sourceIndex(size_t row) const {
+    return m_order.empty() ? row : m_order[row];
+}
+
+std::optional<uintptr_t> ResultViewModel::addressAt(size_t row) const {
+    if (!m_addressAt) return std::nullopt;
+    return m_addressAt(sourceIndex(row));
+}
+
+template<typename T>
+void ResultViewModel::sortByNumericValue(bool ascending) {
+    // Extract the keys once so the sort itself never goes through the callbacks
+    std::vector<typename NativeValue<T>::Type> keys(m_rowCount);
+    std::vector<uint8_t> readable(m_rowCount);
+    uint8_t bytes[sizeof(T)] = {};
+    for (size_t i = 0; i < m_rowCount; i++) {
+        readable[i] = m_valueAt(i, bytes, sizeof(T)) == sizeof(T);
+        if (readable[i]) keys[i] = nativeValue(loadValue<T>(bytes));
+    }
+
+    // Unreadable rows go last in both directions
+    m_order.resize(m_rowCount);
+    std::iota(m_order.begin(), m_order.end(), size_t{0});
+    std::stable_sort(m_order.begin(), m_order.end(), [&](size_t a, size_t b) {
+        if (readable[a] != readable[b]) return readable[a] > readable[b];
+        if (!readable[a]) return false;
+        return ascending ? numericLess(keys[a], keys[b]) : numericLess(keys[b], keys[a]);
+    });
+}
+
+bool ResultViewModel::sortBy(ResultSortKey key, bool ascending) {
+    // The permutation and the sort keys extracted next to it
+    if (!m_orderReservation.resize(std::max<size_t>(m_orderReservation.bytes(), m_rowCount * 2 * sizeof(size_t)))) return false;
+
+    m_sortKey = key;
+    m_sortAscending = ascending;
+    m_order.clear();
+
+    // Rows in the visible window move, their live values no longer apply
+    std::fill(m_liveValid.begin(), m_liveValid.end(), 0);
+    m_lastRefreshMs = 0;
+
+    if (m_rowCount != 0 && m_addressAt) sortRows(key, ascending);
+    m_orderReservation.force(m_order.capacity() * sizeof(size_t));
+    return true;
+}
+
+void ResultViewModel::sortRows(ResultSortKey key, bool ascending) {
+    switch (key) {
+        case ResultSortKey::ADDRESS: {
+            // Scans and filters emit results in address order, keep the identity mapping then
+            std::optional<uintptr_t> previous = m_addressAt(0);
+            bool sorted = previous.has_value();
+            for (size_t i = 1; i < m_rowCount && sorted; i++) {
+                std::optional<uintptr_t> current = m_addressAt(i);
+                sorted = current && *previous <= *current;
+                previous = current;
+            }
+
+            if (sorted && ascending) return;
+
+            m_order.resize(m_rowCount);
+            std::iota(m_order.begin(), m_order.end(), size_t{0});
+            if (sorted) {
+                std::reverse(m_order.begin(), m_order.end());
+                return;
+            }
+
+            // Unreadable rows go last in both directions
+            std::vector<std::optional<uintptr_t>> keys(m_rowCount);
+            for (size_t i = 0; i < m_rowCount; i++) keys[i] = m_addressAt(i);
+            std::stable_sort(m_order.begin(), m_order.end(), [&](size_t a, size_t b) {
+                if (keys[a].has_value() != keys[b].has_value()) return keys[a].has_value();
+                if (!keys[a]) return false;
+                return ascending ? *keys[a] < *keys[b] : *keys[b] < *keys[a];
+            });
+            break;
+        }
+
+        case ResultSortKey::VALUE: {
+            if (!m_valueAt) return;
+            switch (m_type) {
+                case ScanValueType::INT32: sortByNumericValue<int32_t>(ascending); break;
+                case ScanValueType::INT64: sortByNumericValue<int64_t>(ascending); break;
+                case ScanValueType::FLOAT: sortByNumericValue<float>(ascending); break;
+                case ScanValueType::DOUBLE: sortByNumericValue<double>(ascending); break;
+                case ScanValueType::INT32_BE: sortByNumericValue<Swapped<int32_t>>(ascending); break;
+                case ScanValueType::INT64_BE: sortByNumericValue<Swapped<int64_t>>(ascending); break;
+                case ScanValueType::FLOAT_BE: sortByNumericValue<Swapped<float>>(ascending); break;
+                case ScanValueType::DOUBLE_BE: sortByNumericValue<Swapped<double>>(ascending); break;
+                case ScanValueType::STRING_ASCII:
+                case ScanValueType::STRING_UNICODE: {
+                    // String result sets are small, compare the stored bytes directly.
+                    // Unreadable rows go last in both directions.
+                    std::vector<uint8_t> a(m_valueSize), b(m_valueSize);
+                    m_order.resize(m_rowCount);
+                    std::iota(m_order.begin(), m_order.end(), size_t{0});
+                    std::stable_sort(m_order.begin(), m_order.end(), [&](size_t x, size_t y) {
+                        bool readableX = m_valueAt(x, a.data(), a.size()) != 0;
+                        bool readableY = m_valueAt(y, b.data(), b.size()) != 0;
+                        if (readableX != readableY) return readableX;
+                        if (!readableX) return false;
+                        int cmp = std::memcmp(a.data(), b.data(), m_valueSize);
+                        return ascending ? cmp < 0 : cmp > 0;
+                    });
+                    break;
+                }
+            }
+            break;
+        }
+
+        case ResultSortKey::MODULE: {
+            if (!m_moduleResolver) return;
+
+            // Intern module names and rank them alphabetically, unreadable rows go last
+            constexpr uint32_t kNoModule = UINT32_MAX;
+            std::unordered_map<std::string_view, uint32_t> ids;
+            std::vector<std::string_view> names;
+            std::vector<uint32_t> rowModule(m_rowCount);
+            for (size_t i = 0; i < m_rowCount; i++) {
+                std::optional<uintptr_t> address = m_addressAt(i);
+                if (!address) {
+                    rowModule[i] = kNoModule;
+                    continue;
+                }
+                std::string_view name = m_moduleResolver(*address);
+                auto [it, inserted] = ids.try_emplace(name, static_cast<uint32_t>(names.size()));
+                if (inserted) names.push_back(name);
+                rowModule[i] = it->second;
+            }
+
+            std::vector<uint32_t> byName(names.size());
+            std::iota(byName.begin(), byName.end(), 0u);
+            std::sort(byName.begin(), byName.end(), [&](uint32_t a, uint32_t b) {
+                return names[a] < names[b];
+            });
+            std::vector<uint32_t> rank(names.size());
+            for (uint32_t i = 0; i < byName.size(); i++) rank[byName[i]] = i;
+
+            m_order.resize(m_rowCount);
+            std::iota(m_order.begin(), m_order.end(), size_t{0});
+            std::stable_sort(m_order.begin(), m_order.end(), [&](size_t a, size_t b) {
+                if ((rowModule[a] == kNoModule) != (rowModule[b] == kNoModule)) return rowModule[b] == kNoModule;
+                if (rowModule[a] == kNoModule) return false;
+                uint32_t ra = rank[rowModule[a]];
+                uint32_t rb = rank[rowModule[b]];
+                return ascending ? ra < rb : rb < ra;
+            });
+            break;
+        }
+    }
+}
+
+void ResultViewModel::setVisibleRange(size_t first, size_t last) {
+    if (m_rowCount == 0 || first > last) {
+        m_visibleFirst = 0;
+        m_visibleCount = 0;
+        return;
+    }
+
+    last = std::min(last, m_rowCount - 1);
+    first = std::min(first, last);
+    size_t count = last - first + 1;
+    if (first == m_visibleFirst && count == m_visibleCount) return;
+
+    // Keep live values of rows that stay on screen
+    std::vector<uint8_t> values(count * m_valueSize, 0);
+    std::vector<uint8_t> valid(count, 0);
+    size_t overlapBegin = std::max(first, m_visibleFirst);
+    size_t overlapEnd = std::min(first + count, m_visibleFirst + m_visibleCount);
+    for (size_t row = overlapBegin; row < overlapEnd; row++) {
+        size_t from = row - m_visibleFirst;
+        size_t to = row - first;
+        valid[to] = m_liveValid[from];
+        std::memcpy(&values[to * m_valueSize], &m_liveValues[from * m_valueSize], m_valueSize);
+    }
+
+    m_visibleFirst = first;
+    m_visibleCount = count;
+    m_liveValues = std::move(values);
+    m_liveValid = std::move(valid);
+    // New rows scrolled in, fetch them on the next refresh tick
+    m_lastRefreshMs = 0;
+}
+
+bool ResultViewModel::refreshVisible(uint64_t nowMs) {
+    if (!m_reader || m_visibleCount == 0 || m_valueSize == 0) return false;
+    if (m_lastRefreshMs != 0 && nowMs - m_lastRefreshMs < m_refreshIntervalMs) return false;
+    m_lastRefreshMs = nowMs == 0 ? 1 : nowMs;
+
+    // Visible slots ordered by address so neighbouring values share one read.
+    // Unreadable rows have no address to read.
+    std::vector<std::pair<uintptr_t, size_t>> slots;
+    slots.reserve(m_visibleCount);
+    for (size_t i = 0; i < m_visibleCount; i++) {
+        if (auto address = addressAt(m_visibleFirst + i)) slots.push_back({ *address, i });
+    }
+    std::sort(slots.begin(), slots.end());
+
+    bool changed = false;
+    auto storeSlot = [&](size_t slot, const uint8_t* bytes) {
+        uint8_t* live = &m_liveValues[slot * m_valueSize];
+        if (!m_liveValid[slot] || std::memcmp(live, bytes, m_valueSize) != 0) {
+            changed = true;
+        }
+        std::memcpy(live, bytes, m_valueSize);
+        m_liveValid[slot] = 1;
+    };
+
+    size_t begin = 0;
+    while (begin < slots.size()) {
+        uintptr_t spanStart = slots[begin].first;
+        uintptr_t spanEnd = spanStart + m_valueSize;
+        size_t end = begin + 1;
+        while (end < slots.size()) {
+            uintptr_t next = slots[end].first;
+            if (next > spanEnd + kCoalesceGap || next + m_valueSize - spanStart > kMaxCoalescedRead) break;
+            spanEnd = std::max<uintptr_t>(spanEnd, next + m_valueSize);
+            end++;
+        }
+
+        size_t spanSize = spanEnd - spanStart;
+        m_readBuffer.resize(std::max(spanSize, m_valueSize));
+        if (m_reader(spanStart, m_readBuffer.data(), spanSize)) {
+            for (size_t i = begin; i < end; i++) {
+                storeSlot(slots[i].second, &m_readBuffer[slots[i].first - spanStart]);
+            }
+        } else {
+            // The span crosses unreadable memory, fall back to one read per value
+            for (size_t i = begin; i < end; i++) {
+                if (m_reader(slots[i].first, m_readBuffer.data(), m_valueSize)) {
+                    storeSlot(slots[i].second, m_readBuffer.data());
+                } else if (m_liveValid[slots[i].second]) {
+                    m_liveValid[slots[i].second] = 0;
+                    changed = true;
+                }
+            }
+        }
+        begin = end;
+    }
+
+    return changed;
+}
+
+const uint8_t* ResultViewModel::valueBytes(size_t row) {
+    if (row >= m_visibleFirst && row < m_visibleFirst + m_visibleCount && m_liveValid[row - m_visibleFirst]) {
+        return &m_liveValues[(row - m_visibleFirst) * m_valueSize];
+    }
+
+    if (!m_valueAt) return nullptr;
+    size_t copied = m_valueAt(sourceIndex(row), m_valueBuffer.data(), m_valueBuffer.size());
+    if (copied == 0 && !m_valueBuffer.empty()) return nullptr;
+    if (copied < m_valueBuffer.size()) {
+        std::fill(m_valueBuffer.begin() + copied, m_valueBuffer.end(), 0);
+    }
+    return m_valueBuffer.data();
+}
+
+std::string_view ResultViewModel::formatCell(size_t row, ResultColumn column) {
+    if (row >= m_rowCount) return {};
+    char* out = m_cellBuffer.data();
+
+    switch (column) {
+        case ResultColumn::ADDRESS: {
+            std::optional<uintptr_t> address = addressAt(row);
+            if (!address) return kUnreadableCell;
+            return { out, formatHexAddress(*address, out) };
+        }
+
+        case ResultColumn::VALUE: {
+            const uint8_t* bytes = valueBytes(row);
+            if (!bytes) return m_valueAt ? kUnreadableCell : std::string_view();
+            return { out, formatScanValue(m_type, bytes, m_valueSize, out, m_cellBuffer.size()) };
+        }
+
+        case ResultColumn::TYPE:
+            return scanValueTypeName(m_type);
+
+        case ResultColumn::MODULE: {
+            std::optional<uintptr_t> address = addressAt(row);
+            if (!m_moduleResolver || !address) return {};
+            return m_moduleResolver(*address);
+        }
+    }
+    return {};
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "memory_governor.h"
+#include "scan_value_type.h"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Columns of the result view
+enum class ResultColumn {
+    ADDRESS,
+    VALUE,
+    TYPE,
+    MODULE
+};
+
+// Sort keys supported by the result view
+enum class ResultSortKey {
+    ADDRESS,
+    VALUE,
+    MODULE
+};
+
+// Platform-neutral view model over a scan result set.
+// Rows are formatted on demand into reusable buffers, so the cost of a view
+// depends on the number of visible rows and not on the size of the result set.
+// Sorting only permutes row indices, the underlying results are never copied.
+class ResultViewModel {
+public:
+    // Address of result row i (in source order), nullopt if the row is unreadable
+    // (its shard was lost with the spill file)
+    using AddressFn = std::function<std::optional<uintptr_t>(size_t index)>;
+    // Copies the stored value bytes of result row i into out, returns the number of bytes
+    // written (0 for an unreadable row)
+    using ValueFn = std::function<size_t(size_t index, void* out, size_t outSize)>;
+    // Reads live memory of the target process
+    using ReadFn = std::function<bool(uintptr_t address, void* buffer, size_t size)>;
+    // Resolves the module name an address belongs to
+    using ModuleFn = std::function<std::string_view(uintptr_t address)>;
+
+    ResultViewModel();
+
+    // Bind a new result set. valueSize is the width of one value in bytes (needle length for strings).
+    void setSource(size_t rowCount, ScanValueType type, size_t valueSize, AddressFn addressAt, ValueFn valueAt);
+
+    // Drop the current result set
+    void clear();
+
+    // Enable live value refresh for visible rows, at most once per refreshIntervalMs
+    void setReader(ReadFn reader, uint32_t refreshIntervalMs);
+
+    void setModuleResolver(ModuleFn resolver);
+
+    size_t rowCount() const { return m_rowCount; }
+    ScanValueType valueType() const { return m_type; }
+
+    // Sort rows via an index permutation. False (rows keep their order) if the memory
+    // budget has no room for the permutation.
+    bool sortBy(ResultSortKey key, bool ascending);
+    ResultSortKey sortKey() const { return m_sortKey; }
+    bool sortAscending() const { return m_sortAscending; }
+
+    // Index into the source result set for a (possibly sorted) view row
+    size_t sourceIndex(size_t row) const;
+
+    // Address shown in a view row, nullopt if the row is unreadable
+    std::optional<uintptr_t> addressAt(size_t row) const;
+
+    // Tell the model which rows are currently on screen (inclusive range)
+    void setVisibleRange(size_t first, size_t last);
+
+    // Re-read live values of the visible rows if the refresh interval has elapsed.
+    // Returns true if at least one visible value changed.
+    bool refreshVisible(uint64_t nowMs);
+
+    // Format a single cell into an internal buffer. The returned UTF-8 text stays
+    // valid until the next call to formatCell.
+    std::string_view formatCell(size_t row, ResultColumn column);
+
+private:
+    size_t m_rowCount = 0;
+    ScanValueType m_type = ScanValueType::INT32;
+    size_t m_valueSize = 0;
+    AddressFn m_addressAt;
+    ValueFn m_valueAt;
+    ReadFn m_reader;
+    ModuleFn m_moduleResolver;
+    uint32_t m_refreshIntervalMs = 0;
+    uint64_t m_lastRefreshMs = 0;
+
+    // Empty permutation means identity (source order)
+    std::vector<size_t> m_order;
+    MemoryReservation m_orderReservation{ MemoryComponent::VIEW_CACHES };
+    ResultSortKey m_sortKey = ResultSortKey::ADDRESS;
+    bool m_sortAscending = true;
+
+    // Live values of the visible window, m_valueSize bytes per row
+    size_t m_visibleFirst = 0;
+    size_t m_visibleCount = 0;
+    std::vector<uint8_t> m_liveValues;
+    std::vector<uint8_t> m_liveValid;
+
+    // Reusable formatting buffers
+    std::vector<char> m_cellBuffer;
+    std::vector<uint8_t> m_valueBuffer;
+    std::vector<uint8_t> m_readBuffer;
+
+    const uint8_t* valueBytes(size_t row);
+
+    void sortRows(ResultSortKey key, bool ascending);
+
+    template<typename T>
+    void sortByNumericValue(bool ascending);
+};
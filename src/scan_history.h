@@ -0,0 +1,483 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "memory_scanner.h"
+#include "result_spill.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+
+// Results are split into shards by address block, a filter that leaves a shard
+// untouched shares it with the parent generation instead of copying it
+constexpr uintptr_t kHistoryShardSpan = 16 * 1024 * 1024;
+constexpr size_t kHistoryShardCapacity = 64 * 1024;
+
+// Error of an operation that needed matches whose spill file could not be read back
+constexpr const char* kUnreadableSpillError = "spilled results could not be read back from disk";
+
+// Resident shard memory of all generations together, beyond it shards spill to disk
+constexpr size_t kDefaultHistoryMemoryLimit = 1024ull * 1024 * 1024;
+// Spilled bytes kept on disk, beyond it the oldest generations are evicted
+constexpr uint64_t kDefaultHistoryDiskLimit = 64ull * 1024 * 1024 * 1024;
+
+// How a history stores one shard of results. The default is an address-ordered vector of
+// matches, result_store.h specialises it for the column store.
+template<typename T>
+struct HistoryShardTraits {
+    using Shard = std::vector<MemoryMatch<T>>;
+
+    static size_t residentBytes(const Shard& shard) {
+        size_t bytes = shard.capacity() * sizeof(MemoryMatch<T>);
+        if constexpr (requires(const T& v) { v.capacity(); }) {
+            for (const auto& match : shard) {
+                bytes += match.value.capacity() * sizeof(typename T::value_type);
+            }
+        }
+        return bytes;
+    }
+
+    static std::vector<uint8_t> encode(const Shard& shard) { return encodeSpillRun(shard); }
+    static bool decode(const std::vector<uint8_t>& bytes, size_t count, Shard& out) {
+        return decodeSpillRun(bytes, count, out);
+    }
+
+    // Filters only drop entries, so equal size and equal values means nothing changed
+    static bool same(const Shard& a, const Shard& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i].address != b[i].address) return false;
+            if constexpr (std::is_floating_point_v<T> || isFloatingScanValue<T>) {
+                if (std::memcmp(&a[i].value, &b[i].value, sizeof(T)) != 0) return false;
+            } else {
+                if (!(a[i].value == b[i].value)) return false;
+            }
+        }
+        return true;
+    }
+};
+
+// One address-ordered block of matches, either in memory or spilled to a segment file
+template<typename T>
+class ResultShard {
+public:
+    using Traits = HistoryShardTraits<T>;
+    using Matches = typename Traits::Shard;
+
+    explicit ResultShard(Matches matches)
+        : m_count(matches.size()), m_matches(std::make_shared<const Matches>(std::move(matches))) {}
+
+    size_t size() const { return m_count; }
+    bool resident() const { return m_matches != nullptr; }
+
+    // The matches, decoded from the spill file if the shard is not resident.
+    // nullptr if the spill file cannot be read back; the shard stays unreadable after that.
+    std::shared_ptr<const Matches> load() const {
+        if (m_matches) return m_matches;
+        if (m_unreadable) return nullptr;
+
+        std::vector<uint8_t> bytes;
+        auto matches = std::make_shared<Matches>();
+        if (!m_run.segment->read(m_run.offset, m_run.bytes, bytes) ||
+            !Traits::decode(bytes, m_run.count, *matches)) {
+            m_unreadable = true;
+            return nullptr;
+        }
+        return matches;
+    }
+
+    // A load() of this shard failed, its matches are lost
+    bool unreadable() const { return m_unreadable; }
+
+    size_t residentBytes() const { return m_matches ? Traits::residentBytes(*m_matches) : 0; }
+
+    size_t spilledBytes() const { return m_matches ? 0 : m_run.bytes; }
+    const SpillSegment* segment() const { return m_run.segment.get(); }
+
+    // Move the matches into segment and release the memory. A shard is spilled at most once.
+    bool spill(const std::shared_ptr<SpillSegment>& segment) {
+        if (!m_matches) return true;
+
+        std::vector<uint8_t> bytes = Traits::encode(*m_matches);
+        SpillRun run;
+        run.segment = segment;
+        run.bytes = static_cast<uint32_t>(bytes.size());
+        run.count = static_cast<uint32_t>(m_count);
+        if (!segment->append(bytes, run.offset)) return false;
+
+        m_run = std::move(run);
+        m_matches.reset();
+        return true;
+    }
+
+private:
+    size_t m_count;
+    std::shared_ptr<const Matches> m_matches; // null once spilled
+    SpillRun m_run;
+    mutable std::atomic<bool> m_unreadable{false};
+};
+
+// One immutable result set in the scan history
+template<typename T>
+struct ScanGeneration {
+    using Shard = typename HistoryShardTraits<T>::Shard;
+
+    std::string label;
+    std::vector<std::shared_ptr<ResultShard<T>>> shards;
+    std::vector<size_t> shardOffsets{0}; // prefix sums, shardOffsets[i] = first index of shard i
+
+    size_t count() const { return shardOffsets.back(); }
+    bool empty() const { return count() == 0; }
+
+    // True once a shard of this generation could not be read back from its spill file.
+    // at() and shardAt() then return nullptr for the rows of that shard.
+    bool damaged() const {
+        return std::ranges::any_of(shards, [](const auto& shard) { return shard->unreadable(); });
+    }
+
+    // Match at a flat index across all shards, nullptr if its shard could not be read back
+    // from the spill file. The last shard used stays decoded, so walking rows in order reads
+    // every spilled shard once. The pointer is only valid until at() is called for a row in
+    // another shard.
+    const MemoryMatch<T>* at(size_t index) const {
+        size_t local;
+        const Shard* shard = shardAt(index, local);
+        return shard ? &(*shard)[local] : nullptr;
+    }
+
+    // Shard holding a flat index, local receives the row inside it. nullptr if the shard
+    // could not be read back. Same caching as at().
+    const Shard* shardAt(size_t index, size_t& local) const {
+        size_t shard = std::upper_bound(shardOffsets.begin(), shardOffsets.end(), index) - shardOffsets.begin() - 1;
+        if (!m_cacheValid || shard != m_cachedShard) {
+            m_cached = shards[shard]->load();
+            m_cachedShard = shard;
+            m_cacheValid = true;
+        }
+        local = index - shardOffsets[shard];
+        return m_cached.get();
+    }
+
+    // Flat copy of all matches, false if a spilled shard could not be read back
+    bool materialize(std::vector<MemoryMatch<T>>& matches) const {
+        matches.clear();
+        matches.reserve(count());
+        for (const auto& shard : shards) {
+            auto loaded = shard->load();
+            if (!loaded) return false;
+            matches.insert(matches.end(), loaded->begin(), loaded->end());
+        }
+        return true;
+    }
+
+    void addShard(std::shared_ptr<ResultShard<T>> shard) {
+        if (shard->size() == 0) return;
+        shardOffsets.push_back(shardOffsets.back() + shard->size());
+        shards.push_back(std::move(shard));
+    }
+
+private:
+    mutable std::shared_ptr<const Shard> m_cached; // null if m_cachedShard is unreadable
+    mutable size_t m_cachedShard = 0;
+    mutable bool m_cacheValid = false;
+};
+
+// Undo/redo stack of result generations with copy-on-write shards. Shards beyond the
+// memory limit are spilled to compressed runs in temp files and streamed back on use.
+template<typename T>
+class ScanHistory {
+public:
+    using Generation = ScanGeneration<T>;
+    using Shard = typename Generation::Shard;
+
+    // Start a new history from a first scan (address-ordered matches)
+    void reset(std::vector<MemoryMatch<T>> matches, const std::string& label);
+
+    // Start a new history from a streaming scan. scan(sink) calls sink(const MemoryMatch<U>&)
+    // for every match in address order (U is T, or any value type the shard accepts); full shards are sealed (and spilled if needed)
+    // while the scan is still running, so the result never has to fit in memory at once.
+    template<typename F>
+    const Generation& collect(F&& scan, const std::string& label);
+
+    // Drop all generations
+    void clear();
+
+    // Run filter over every shard of the current generation and push the result as a new
+    // generation. filter(const Shard&) returns the surviving matches of one shard.
+    // Shards that come back unchanged are shared with the parent. Spilled shards are read
+    // back one at a time in address order, the next one is fetched while filtering.
+    // If one cannot be read back nothing is pushed and false is returned with error set.
+    template<typename F>
+    bool applyFilter(F&& filter, const std::string& label, std::string& error);
+
+    bool empty() const { return m_generations.empty(); }
+    const Generation& current() const { return m_generations[m_current]; }
+    size_t generationCount() const { return m_generations.size(); }
+    size_t currentIndex() const { return m_current; }
+    const Generation& generation(size_t index) const { return m_generations[index]; }
+
+    bool canUndo() const { return !m_generations.empty() && m_current > 0; }
+    bool canRedo() const { return m_current + 1 < m_generations.size(); }
+    bool undo();
+    bool redo();
+
+    // Budget for resident shard memory of all generations, older shards spill first. The
+    // process memory budget (memory_governor.h) can lower it while other components need room.
+    void setMemoryLimit(size_t bytes);
+    // Budget for spilled data, the oldest generations are evicted first
+    void setDiskLimit(uint64_t bytes);
+    // Where spill segments are created (default: the system temp directory)
+    void setSpillDirectory(std::filesystem::path directory);
+
+    size_t memoryUsage() const;
+    uint64_t spilledBytes() const;
+
+private:
+    std::vector<Generation> m_generations;
+    size_t m_current = 0;
+    size_t m_memoryLimit = kDefaultHistoryMemoryLimit;
+    uint64_t m_diskLimit = kDefaultHistoryDiskLimit;
+    std::filesystem::path m_spillDirectory;
+    std::shared_ptr<SpillSegment> m_segment;
+    size_t m_residentEstimate = 0;
+    MemoryReservation m_reservation{ MemoryComponent::SCAN_RESULTS }; // m_residentEstimate, booked with the governor
+
+    void push(Generation generation);
+    void addShard(Generation& generation, Shard matches);
+    void enforceMemoryLimit(const Generation* pending = nullptr);
+    void enforceDiskLimit();
+    bool spillShard(ResultShard<T>& shard);
+
+};
+
+template<typename T>
+void ScanHistory<T>::reset(std::vector<MemoryMatch<T>> matches, const std::string& label) {
+    collect([&](auto&& sink) {
+        for (const auto& match : matches) sink(match);
+    }, label);
+}
+
+template<typename T>
+template<typename F>
+const ScanGeneration<T>& ScanHistory<T>::collect(F&& scan, const std::string& label) {
+    m_generations.clear();
+    m_current = 0;
+    m_residentEstimate = 0;
+    m_reservation.force(0);
+    m_segment.reset();
+
+    Generation generation;
+    generation.label = label;
+
+    Shard pending;
+    uintptr_t block = 0;
+    scan([&](const auto& match) {
+        uintptr_t matchBlock = match.address / kHistoryShardSpan;
+        if (!pending.empty() && (matchBlock != block || pending.size() >= kHistoryShardCapacity)) {
+            // A shard closed by a block change would otherwise keep its full reservation
+            pending.shrink_to_fit();
+            addShard(generation, std::move(pending));
+            pending = Shard();
+            enforceMemoryLimit(&generation);
+        }
+        if (pending.empty()) pending.reserve(kHistoryShardCapacity);
+        block = matchBlock;
+        pending.push_back(match);
+    });
+    pending.shrink_to_fit();
+    addShard(generation, std::move(pending));
+
+    push(std::move(generation));
+    return current();
+}
+
+template<typename T>
+void ScanHistory<T>::clear() {
+    m_generations.clear();
+    m_current = 0;
+    m_residentEstimate = 0;
+    m_reservation.force(0);
+    m_segment.reset();
+}
+
+template<typename T>
+template<typename F>
+bool ScanHistory<T>::applyFilter(F&& filter, const std::string& label, std::string& error) {
+    Generation next;
+    next.label = label;
+
+    if (!m_generations.empty()) {
+        const auto& shards = current().shards;
+        std::future<std::shared_ptr<const Shard>> readAhead;
+
+        for (size_t i = 0; i < shards.size(); i++) {
+            std::shared_ptr<const Shard> matches = readAhead.valid() ? readAhead.get() : shards[i]->load();
+            if (!matches) {
+                // Survivors of this filter would silently miss the lost shard's matches
+                error = kUnreadableSpillError;
+                return false;
+            }
+
+            // Spilled shards never change again, so the next one can be decoded in parallel
+            if (i + 1 < shards.size() && !shards[i + 1]->resident()) {
+                readAhead = std::async(std::launch::async, [shard = shards[i + 1]] { return shard->load(); });
+            }
+
+            Shard survivors = filter(*matches);
+            if (HistoryShardTraits<T>::same(survivors, *matches)) {
+                next.addShard(shards[i]);
+            } else {
+                survivors.shrink_to_fit();
+                addShard(next, std::move(survivors));
+                enforceMemoryLimit(&next);
+            }
+        }
+    }
+
+    push(std::move(next));
+    return true;
+}
+
+template<typename T>
+bool ScanHistory<T>::undo() {
+    if (!canUndo()) return false;
+    m_current--;
+    return true;
+}
+
+template<typename T>
+bool ScanHistory<T>::redo() {
+    if (!canRedo()) return false;
+    m_current++;
+    return true;
+}
+
+template<typename T>
+void ScanHistory<T>::setMemoryLimit(size_t bytes) {
+    m_memoryLimit = bytes;
+    m_residentEstimate = memoryUsage();
+    enforceMemoryLimit();
+}
+
+template<typename T>
+void ScanHistory<T>::setDiskLimit(uint64_t bytes) {
+    m_diskLimit = bytes;
+    enforceDiskLimit();
+}
+
+template<typename T>
+void ScanHistory<T>::setSpillDirectory(std::filesystem::path directory) {
+    m_spillDirectory = std::move(directory);
+    m_segment.reset();
+}
+
+template<typename T>
+size_t ScanHistory<T>::memoryUsage() const {
+    // Shared shards are counted once
+    std::unordered_set<const ResultShard<T>*> seen;
+    size_t bytes = 0;
+    for (const auto& generation : m_generations) {
+        for (const auto& shard : generation.shards) {
+            if (seen.insert(shard.get()).second) {
+                bytes += shard->residentBytes();
+            }
+        }
+    }
+    return bytes;
+}
+
+template<typename T>
+uint64_t ScanHistory<T>::spilledBytes() const {
+    // Whole segments count, dead runs stay on disk until their segment is released
+    std::unordered_set<const SpillSegment*> seen;
+    uint64_t bytes = 0;
+    for (const auto& generation : m_generations) {
+        for (const auto& shard : generation.shards) {
+            const SpillSegment* segment = shard->segment();
+            if (segment && seen.insert(segment).second) {
+                bytes += segment->size();
+            }
+        }
+    }
+    return bytes;
+}
+
+template<typename T>
+void ScanHistory<T>::push(Generation generation) {
+    // A new generation discards everything that could have been redone
+    if (!m_generations.empty()) {
+        m_generations.erase(m_generations.begin() + m_current + 1, m_generations.end());
+    }
+    m_generations.push_back(std::move(generation));
+    m_current = m_generations.size() - 1;
+    m_residentEstimate = memoryUsage();
+    enforceMemoryLimit();
+    enforceDiskLimit();
+}
+
+template<typename T>
+void ScanHistory<T>::addShard(Generation& generation, Shard matches) {
+    auto shard = std::make_shared<ResultShard<T>>(std::move(matches));
+    m_residentEstimate += shard->residentBytes();
+    generation.addShard(std::move(shard));
+}
+
+template<typename T>
+void ScanHistory<T>::enforceMemoryLimit(const Generation* pending) {
+    // The history's own limit, or less when the memory budget has no room for more shards
+    const size_t limit = std::min<size_t>(m_memoryLimit, m_reservation.bytes() + memoryGovernor().available());
+    if (m_residentEstimate <= limit) {
+        m_reservation.force(m_residentEstimate);
+        return;
+    }
+
+    // Spill down to half the limit so a growing scan does not re-walk all shards every time.
+    // Oldest generations go first, the generation being built last, each in address order.
+    size_t target = limit / 2;
+    size_t resident = memoryUsage();
+    if (pending) {
+        for (const auto& shard : pending->shards) resident += shard->residentBytes();
+    }
+
+    auto spillFrom = [&](const Generation& generation) {
+        for (const auto& shard : generation.shards) {
+            if (resident <= target) return;
+            size_t bytes = shard->residentBytes();
+            if (bytes != 0 && spillShard(*shard)) resident -= bytes;
+        }
+    };
+    for (const auto& generation : m_generations) spillFrom(generation);
+    if (pending) spillFrom(*pending);
+
+    // If nothing could be spilled (no temp space) the shards simply stay in memory
+    m_residentEstimate = resident;
+    m_reservation.force(resident);
+}
+
+template<typename T>
+void ScanHistory<T>::enforceDiskLimit() {
+    // The current generation is never evicted
+    while (m_current > 0 && spilledBytes() > m_diskLimit) {
+        m_generations.erase(m_generations.begin());
+        m_current--;
+    }
+}
+
+template<typename T>
+bool ScanHistory<T>::spillShard(ResultShard<T>& shard) {
+    if (!m_segment || m_segment->size() >= kSpillSegmentSize) {
+        std::error_code error;
+        std::filesystem::path directory = m_spillDirectory.empty()
+            ? std::filesystem::temp_directory_path(error) : m_spillDirectory;
+        if (error) return false;
+        m_segment = SpillSegment::create(directory);
+        if (!m_segment) return false;
+    }
+    return shard.spill(m_segment);
+}
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCAN_KERNELS_SSE2 1
+#endif
+
+// Calls onMatch(offset) for every byte offset at which pattern occurs in data, in ascending order.
+// With SSE2 the first and last pattern byte are compared for 16 offsets at once and only the
+// surviving candidates are verified with memcmp.
+template<typename F>
+void findPattern(const uint8_t* data, size_t size, const uint8_t* pattern, size_t patternSize, F&& onMatch) {
+    if (patternSize == 0 || size < patternSize) return;
+
+    const size_t lastStart = size - patternSize;
+    size_t i = 0;
+
+#ifdef SCAN_KERNELS_SSE2
+    const __m128i firstByte = _mm_set1_epi8(static_cast<char>(pattern[0]));
+    const __m128i lastByte = _mm_set1_epi8(static_cast<char>(pattern[patternSize - 1]));
+
+    // Both loads stay inside data as long as all 16 start offsets are valid
+    for (; i + 15 <= lastStart; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + patternSize - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(firstByte, blockFirst), _mm_cmpeq_epi8(lastByte, blockLast))));
+
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(std::countr_zero(mask));
+            if (patternSize <= 2 || std::memcmp(data + i + bit + 1, pattern + 1, patternSize - 2) == 0) {
+                onMatch(i + bit);
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i <= lastStart; i++) {
+        if (data[i] == pattern[0] && std::memcmp(data + i, pattern, patternSize) == 0) {
+            onMatch(i);
+        }
+    }
+}
+
+// Calls onChanged(slot) for every slot whose slotSize bytes differ between a and b, in ascending
+// order. With SSE2 and a slot size dividing 16, 16 bytes are compared at once and unchanged
+// blocks are skipped whole.
+template<typename F>
+void forEachChangedSlot(const uint8_t* a, const uint8_t* b, size_t slots, size_t slotSize, F&& onChanged) {
+    if (slotSize == 0) return;
+    size_t slot = 0;
+
+#ifdef SCAN_KERNELS_SSE2
+    if (16 % slotSize == 0) {
+        const size_t perBlock = 16 / slotSize;
+        const unsigned slotBits = (1u << slotSize) - 1;
+        for (; slot + perBlock <= slots; slot += perBlock) {
+            __m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + slot * slotSize));
+            __m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + slot * slotSize));
+            unsigned differing = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(blockA, blockB))) & 0xFFFF;
+
+            while (differing != 0) {
+                size_t inBlock = static_cast<size_t>(std::countr_zero(differing)) / slotSize;
+                onChanged(slot + inBlock);
+                differing &= ~(slotBits << (inBlock * slotSize));
+            }
+        }
+    }
+#endif
+
+    for (; slot < slots; slot++) {
+        if (std::memcmp(a + slot * slotSize, b + slot * slotSize, slotSize) != 0) onChanged(slot);
+    }
+}
+
+// True if all size bytes of data are zero. With SSE2 64 bytes are OR-ed per step.
+inline bool isZeroBlock(const uint8_t* data, size_t size) {
+    size_t i = 0;
+#ifdef SCAN_KERNELS_SSE2
+    for (; i + 64 <= size; i += 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48));
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF) return false;
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] != 0) return false;
+    }
+    return true;
+}
+
+// Reverse the byte order of count values of width bytes (2, 4 or 8) from src into dst, which
+// may be src itself. With SSE2 16 bytes are swapped per step: bytes within 16-bit lanes by
+// shifts, then the lanes of every value by a shuffle.
+inline void swapByteOrder(const uint8_t* src, uint8_t* dst, size_t count, size_t width) {
+    size_t i = 0;
+    const size_t bytes = count * width;
+#ifdef SCAN_KERNELS_SSE2
+    if (width == 2 || width == 4 || width == 8) {
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            if (width == 4) {
+                v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            } else if (width == 8) {
+                v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+        }
+    }
+#endif
+    for (; i + width <= bytes; i += width) {
+        uint8_t value[8];
+        std::memcpy(value, src + i, width);
+        for (size_t b = 0; b < width; b++) dst[i + b] = value[width - 1 - b];
+    }
+}
@@ -0,0 +1,1400 @@
+#ifdef __linux__
+#include "scan_server.h"
+#include "change_sampler.h"
+#include "filter_expression.h"
+#include "memory_scanner.h"
+#include "scan_history.h"
+#include "server_protocol.h"
+#include "time_series.h"
+#include "value_format.h"
+#include "watch_list.h"
+#include "write_batch.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <variant>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// A request line longer than this closes the connection
+constexpr size_t kMaxRequestLine = 1024 * 1024;
+// Longest change-frequency sampling run
+constexpr int64_t kMaxSampleSeconds = 60;
+// How often blocking waits check for shutdown
+constexpr int kPollIntervalMs = 200;
+// How often the accept loop looks for sessions to drop
+constexpr auto kSessionPruneInterval = std::chrono::seconds(5);
+// Largest page a client may ask for
+constexpr size_t kMaxPageSize = 10000;
+// Longest string read by "read" without a matching scan
+constexpr size_t kMaxReadSize = 4096;
+// Same watch list intervals as the console frontend
+constexpr uint32_t kWatchIntervalMs = 100;
+constexpr uint32_t kFreezeIntervalMs = 10;
+// Most processes one fleet command covers, and most workers it may use
+constexpr size_t kMaxFleetSize = 1024;
+constexpr int64_t kMaxFleetThreads = 64;
+// Oldest cached page a read may be served from
+constexpr int64_t kMaxCachedReadAgeMs = 60 * 1000;
+// Default and longest sampling interval of a recording
+constexpr int64_t kRecordIntervalUs = 1000;
+constexpr int64_t kMaxRecordIntervalUs = 1000 * 1000;
+
+using ServerHistory = std::variant<ScanHistory<int32_t>, ScanHistory<int64_t>, ScanHistory<float>,
+                                   ScanHistory<double>, ScanHistory<std::string>,
+                                   ScanHistory<Swapped<int32_t>>, ScanHistory<Swapped<int64_t>>,
+                                   ScanHistory<Swapped<float>>, ScanHistory<Swapped<double>>>;
+
+template<typename H>
+struct HistoryTraits;
+
+template<typename T>
+struct HistoryTraits<ScanHistory<T>> {
+    using Value = T;
+};
+
+template<typename H>
+using HistoryValue = typename HistoryTraits<std::remove_cvref_t<H>>::Value;
+
+// Protocol type names
+bool parseTypeName(const std::string& name, ScanValueType& type) {
+    if (name == "int32") type = ScanValueType::INT32;
+    else if (name == "int64") type = ScanValueType::INT64;
+    else if (name == "float") type = ScanValueType::FLOAT;
+    else if (name == "double") type = ScanValueType::DOUBLE;
+    else if (name == "int32be") type = ScanValueType::INT32_BE;
+    else if (name == "int64be") type = ScanValueType::INT64_BE;
+    else if (name == "floatbe") type = ScanValueType::FLOAT_BE;
+    else if (name == "doublebe") type = ScanValueType::DOUBLE_BE;
+    else if (name == "ascii" || name == "string") type = ScanValueType::STRING_ASCII;
+    else return false;
+    return true;
+}
+
+// Value type of a request: "type" if given (type is left as it is otherwise), turned into
+// its big-endian or host-order variant by "endian":"big"|"little"
+bool parseRequestType(const JsonRequest& request, ScanValueType& type) {
+    if (request.has("type") && !parseTypeName(request.getString("type"), type)) return false;
+    if (!request.has("endian")) return true;
+    std::string endian = request.getString("endian");
+    if (endian == "big") type = bigEndianScanValueType(type);
+    else if (endian == "little") type = nativeScanValueType(type);
+    else return false;
+    return true;
+}
+
+const char* typeName(ScanValueType type) {
+    switch (type) {
+        case ScanValueType::INT32: return "int32";
+        case ScanValueType::INT64: return "int64";
+        case ScanValueType::FLOAT: return "float";
+        case ScanValueType::DOUBLE: return "double";
+        case ScanValueType::STRING_ASCII: return "ascii";
+        case ScanValueType::STRING_UNICODE: return "unicode";
+        case ScanValueType::INT32_BE: return "int32be";
+        case ScanValueType::INT64_BE: return "int64be";
+        case ScanValueType::FLOAT_BE: return "floatbe";
+        case ScanValueType::DOUBLE_BE: return "doublebe";
+    }
+    return "int32";
+}
+
+// Calls f(T{}) with the C++ type of a numeric scan type
+template<typename F>
+bool withNumericType(ScanValueType type, F&& f) {
+    switch (type) {
+        case ScanValueType::INT32: f(int32_t{}); return true;
+        case ScanValueType::INT64: f(int64_t{}); return true;
+        case ScanValueType::FLOAT: f(float{}); return true;
+        case ScanValueType::DOUBLE: f(double{}); return true;
+        case ScanValueType::INT32_BE: f(Swapped<int32_t>{}); return true;
+        case ScanValueType::INT64_BE: f(Swapped<int64_t>{}); return true;
+        case ScanValueType::FLOAT_BE: f(Swapped<float>{}); return true;
+        case ScanValueType::DOUBLE_BE: f(Swapped<double>{}); return true;
+        default: return false;
+    }
+}
+
+// Comma separated members of a value-set scan ("values"), false if one does not parse
+template<typename T>
+bool parseValueSet(ScanValueType type, const std::string& text, ValueSet<T>& set) {
+    std::vector<T> values;
+    for (size_t start = 0; start <= text.size();) {
+        size_t end = std::min(text.find(',', start), text.size());
+        std::vector<uint8_t> bytes;
+        if (!parseScanValue(type, text.substr(start, end - start), bytes) || bytes.size() != sizeof(T)) return false;
+        T value;
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        values.push_back(value);
+        start = end + 1;
+    }
+    set = ValueSet<T>(values);
+    return !set.empty();
+}
+
+// Checked before a session is touched, so a bad list leaves it as it was
+bool validValueSet(ScanValueType type, const std::string& text) {
+    bool parsed = false;
+    withNumericType(type, [&](auto zero) {
+        ValueSet<decltype(zero)> set;
+        parsed = parseValueSet(type, text, set);
+    });
+    return parsed;
+}
+
+// Comma separated unsigned numbers (decimal or 0x...), false if one does not parse
+bool parseNumberList(const std::string& text, std::vector<uint64_t>& numbers) {
+    for (size_t start = 0; start < text.size();) {
+        size_t end = std::min(text.find(',', start), text.size());
+        std::string item = text.substr(start, end - start);
+        char* parsed;
+        uint64_t number = std::strtoull(item.c_str(), &parsed, 0);
+        if (item.empty() || *parsed != '\0') return false;
+        numbers.push_back(number);
+        start = end + 1;
+    }
+    return !numbers.empty();
+}
+
+// Staleness a cached read accepts ("max_age_ms")
+std::chrono::milliseconds maxAge(const JsonRequest& request) {
+    return std::chrono::milliseconds(std::clamp<int64_t>(request.getInt("max_age_ms", 0), 0, kMaxCachedReadAgeMs));
+}
+
+std::string errorResponse(const JsonRequest& request, const std::string& message) {
+    return JsonLine(request.id()).flag("ok", false).text("error", message).finish();
+}
+
+std::string formatValue(ScanValueType type, const void* bytes, size_t size) {
+    char text[512];
+    size_t length = formatScanValue(type, static_cast<const uint8_t*>(bytes), size, text, sizeof(text));
+    return std::string(text, length);
+}
+
+std::string hexBytes(const uint8_t* bytes, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(size * 2);
+    for (size_t i = 0; i < size; i++) {
+        out.push_back(digits[bytes[i] >> 4]);
+        out.push_back(digits[bytes[i] & 0xF]);
+    }
+    return out;
+}
+
+template<typename T>
+const void* valueBytes(const T& value) {
+    if constexpr (std::is_same_v<T, std::string>) return value.data();
+    else return &value;
+}
+
+template<typename T>
+size_t valueSize(const T& value) {
+    if constexpr (std::is_same_v<T, std::string>) return value.size();
+    else return sizeof(T);
+}
+
+// Sample every match of the current generation and keep those that changed minRate..maxRate
+// times per second, with their last sampled value. False with error set if the set is too
+// big to sample or cannot be read back.
+template<typename T>
+bool filterByRate(MemoryScanner& scanner, ScanHistory<T>& history, ScanValueType type, std::chrono::milliseconds duration,
+                  std::chrono::microseconds interval, double minRate, double maxRate, const std::atomic<bool>& cancel,
+                  const std::string& label, SampleRunStats& run, std::string& error) {
+    const auto& current = history.current();
+    ChangeSampler sampler(scanner, type, sizeof(T));
+    for (size_t i = 0; i < current.count(); i++) {
+        const auto* match = current.at(i);
+        if (!match) {
+            error = kUnreadableSpillError;
+            return false;
+        }
+        if (!sampler.addAddress(match->address)) {
+            error = "too many results to sample";
+            return false;
+        }
+    }
+    run = sampler.sample(duration, interval, &cancel);
+
+    std::vector<MemoryMatch<T>> kept;
+    for (size_t slot : sampler.rankByRate(minRate, maxRate)) {
+        T value;
+        std::memcpy(&value, sampler.lastValue(slot), sizeof(T));
+        kept.push_back({ sampler.address(slot), value });
+    }
+    std::ranges::sort(kept, {}, &MemoryMatch<T>::address);
+
+    return history.applyFilter([&](const auto& shard) {
+        std::vector<MemoryMatch<T>> result;
+        for (const auto& match : shard) {
+            auto it = std::ranges::lower_bound(kept, match.address, {}, &MemoryMatch<T>::address);
+            if (it != kept.end() && it->address == match.address) result.push_back(*it);
+        }
+        return result;
+    }, label, error);
+}
+
+} // namespace
+
+// One named session on an attached process: scanner, scan history and watch list, shared
+// by all clients that attached to the pid under this name. Every access holds mutex.
+struct ScanServer::Session {
+    Session(pid_t pid, std::string name, std::shared_ptr<ProcessCache> cache)
+        : pid(pid), name(std::move(name)), scanner(pid, std::move(cache)), watchScanner(pid, scanner.cache()),
+          watchList(watchScanner), recordScanner(pid, scanner.cache()), recorder(recordScanner) {}
+
+    pid_t pid;
+    std::string name;
+    std::mutex mutex;
+    MemoryScanner scanner;
+    MemoryScanner watchScanner; // the watch list thread never shares a scanner with scans
+    WatchList watchList;        // its thread starts with the first watch or freeze
+    MemoryScanner recordScanner; // same for the recording thread
+    TimeSeriesRecorder recorder;
+    ScanValueType type = ScanValueType::INT32;
+    ServerHistory history;
+    // Baseline of an unknown-value scan taken as a snapshot; the history stays empty until
+    // the first filter compares against it
+    std::unique_ptr<MemorySnapshot> snapshot;
+    bool hasScan = false;
+    uint64_t revision = 0; // bumped by every scan, filter, undo and redo
+    // Guarded by the server's m_sessionsMutex, not by mutex
+    size_t clients = 0;
+    std::chrono::steady_clock::time_point released = std::chrono::steady_clock::now(); // when the last client let go
+};
+
+struct ScanServer::Client {
+    int fd;
+    std::shared_ptr<Session> session;
+
+    bool send(const std::string& line) const {
+        size_t sent = 0;
+        while (sent < line.size()) {
+            ssize_t n = ::send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+ScanServer::ScanServer(std::string socketPath) : m_socketPath(std::move(socketPath)) {}
+
+ScanServer::~ScanServer() {
+    requestStop();
+    reapClients(true);
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        unlink(m_socketPath.c_str());
+    }
+}
+
+bool ScanServer::start(std::string& error) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.empty() || m_socketPath.size() >= sizeof(address.sun_path)) {
+        error = "socket path is empty or too long";
+        return false;
+    }
+    std::memcpy(address.sun_path, m_socketPath.c_str(), m_socketPath.size() + 1);
+
+    // A socket file left behind by a crashed server is replaced, a live server is not
+    struct stat info;
+    if (lstat(m_socketPath.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            error = m_socketPath + " exists and is not a socket";
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool running = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (running) {
+            error = "another server is listening on " + m_socketPath;
+            return false;
+        }
+        unlink(m_socketPath.c_str());
+    }
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    // The server can write into other processes, only the owner may connect
+    mode_t oldMask = umask(0177);
+    int bound = bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    umask(oldMask);
+    if (bound != 0 || listen(m_listenFd, 16) != 0) {
+        error = std::string("bind/listen: ") + std::strerror(errno);
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void ScanServer::run() {
+    auto pruned = std::chrono::steady_clock::now();
+    while (!m_stopping) {
+        pollfd listener{ m_listenFd, POLLIN, 0 };
+        int ready = poll(&listener, 1, kPollIntervalMs);
+        reapClients(false);
+        if (std::chrono::steady_clock::now() - pruned >= kSessionPruneInterval) {
+            pruneSessions();
+            pruned = std::chrono::steady_clock::now();
+        }
+        if (ready <= 0) continue;
+
+        int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        m_clients.push_back({ std::thread([this, fd, done] {
+            serveClient(fd);
+            *done = true;
+        }), done });
+    }
+    reapClients(true);
+}
+
+void ScanServer::reapClients(bool all) {
+    for (auto it = m_clients.begin(); it != m_clients.end();) {
+        if (all || *it->done) {
+            it->thread.join();
+            it = m_clients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ScanServer::serveClient(int fd) {
+    Client client{ fd, nullptr };
+    std::string buffer;
+    char chunk[64 * 1024];
+    bool open = true;
+
+    auto process = [&](std::string_view line) {
+        if (line.find_first_not_of(" \t\r") == std::string_view::npos) return;
+        JsonRequest request;
+        std::string error;
+        std::string response = request.parse(line, error) ? handle(client, request) : errorResponse(request, error);
+        if (!response.empty() && !client.send(response)) open = false;
+    };
+
+    while (open && !m_stopping) {
+        pollfd connection{ fd, POLLIN, 0 };
+        int ready = poll(&connection, 1, kPollIntervalMs);
+        if (ready < 0 && errno != EINTR) break;
+        if (ready <= 0) continue;
+
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) {
+            // The client closed its side, an unterminated last request is still answered
+            process(buffer);
+            break;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+
+        // Requests are handled in order, one response (or page stream) after the other
+        size_t lineStart = 0;
+        size_t newline;
+        while (open && (newline = buffer.find('\n', lineStart)) != std::string::npos) {
+            process(std::string_view(buffer).substr(lineStart, newline - lineStart));
+            lineStart = newline + 1;
+        }
+        buffer.erase(0, lineStart);
+
+        if (buffer.size() > kMaxRequestLine) {
+            client.send(errorResponse(JsonRequest(), "request line too long"));
+            break;
+        }
+    }
+
+    if (client.session) releaseSession(*client.session);
+    close(fd);
+}
+
+std::shared_ptr<ScanServer::Session> ScanServer::attachSession(pid_t pid, const std::string& name, std::string& error) {
+    if (pid <= 0 || (kill(pid, 0) != 0 && errno == ESRCH)) {
+        error = "no process with pid " + std::to_string(pid);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    auto& session = m_sessions[{ pid, name }];
+    // A cached session whose process is gone belongs to an earlier process with this pid
+    if (!session || (session->clients == 0 && access(("/proc/" + std::to_string(pid)).c_str(), F_OK) != 0)) {
+        // Sessions on the same process share its cache
+        std::shared_ptr<ProcessCache> cache;
+        for (auto it = m_sessions.lower_bound({ pid, std::string() }); it != m_sessions.end() && it->first.first == pid; ++it) {
+            if (it->second && it->second != session) {
+                cache = it->second->scanner.cache();
+                break;
+            }
+        }
+        session = std::make_shared<Session>(pid, name, std::move(cache));
+    }
+    session->clients++;
+    return session;
+}
+
+void ScanServer::releaseSession(Session& session) {
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    if (--session.clients == 0) session.released = std::chrono::steady_clock::now();
+}
+
+void ScanServer::pruneSessions() {
+    // Dropped sessions are destroyed outside the lock, stopping their threads takes a moment
+    std::vector<std::shared_ptr<Session>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = m_sessions.begin(); it != m_sessions.end();) {
+            Session& session = *it->second;
+            bool exited = access(("/proc/" + std::to_string(session.pid)).c_str(), F_OK) != 0;
+            // Watches, freezes and recordings keep working for clients that come back later
+            bool idle = now - session.released >= kSessionIdleTimeout && session.watchList.size() == 0 &&
+                        !session.recorder.isRunning();
+            if (session.clients == 0 && (exited || idle)) {
+                dropped.push_back(std::move(it->second));
+                it = m_sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+std::string ScanServer::handle(Client& client, const JsonRequest& request) {
+    std::string command = request.getString("cmd");
+
+    if (command == "ping") return JsonLine(request.id()).flag("ok", true).finish();
+    if (command == "processes") return cmdProcesses(request);
+    if (command == "memory") return cmdMemory(request);
+    if (command == "attach") return cmdAttach(client, request);
+    if (command == "fleet") return cmdFleet(request);
+    if (command == "recording") return cmdRecording(request);
+    if (command == "shutdown") {
+        requestStop();
+        return JsonLine(request.id()).flag("ok", true).finish();
+    }
+
+    if (!client.session) return errorResponse(request, "not attached");
+
+    if (command == "detach") {
+        releaseSession(*client.session);
+        client.session.reset();
+        return JsonLine(request.id()).flag("ok", true).finish();
+    }
+    if (command == "status") return cmdStatus(client, request);
+    if (command == "scan") return cmdScan(client, request);
+    if (command == "filter") return cmdFilter(client, request);
+    if (command == "undo") return cmdStep(client, request, false);
+    if (command == "redo") return cmdStep(client, request, true);
+    if (command == "results") return cmdResults(client, request);
+    if (command == "read") return cmdRead(client, request);
+    if (command == "write") return cmdWrite(client, request);
+    if (command == "watch") return cmdWatch(client, request);
+    if (command == "unwatch") return cmdUnwatch(client, request);
+    if (command == "watches") return cmdWatches(client, request);
+    if (command == "stats") return cmdStats(client, request);
+    if (command == "record") return cmdRecord(client, request);
+    if (command == "heap") return cmdHeap(client, request);
+
+    return errorResponse(request, "unknown command \"" + command + "\"");
+}
+
+bool ScanServer::selectProcesses(const JsonRequest& request, std::vector<ProcessInfo>& processes, std::string& error) {
+    std::unique_lock<std::mutex> lock(m_processesMutex);
+    m_processes.refresh();
+
+    // Exact pid, pid list, regex or substring (name and command line), all processes without a filter
+    if (request.has("pid")) {
+        if (const ProcessInfo* info = m_processes.findByPid(static_cast<pid_t>(request.getInt("pid", -1)))) {
+            processes.push_back(*info);
+        }
+    } else if (request.has("pids")) {
+        // Comma separated, requests are flat; pids that are gone stay in the list and fail later
+        std::string list = request.getString("pids");
+        for (size_t start = 0; start < list.size();) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) end = list.size();
+            char* parsed;
+            std::string item = list.substr(start, end - start);
+            long pid = std::strtol(item.c_str(), &parsed, 10);
+            if (parsed == item.c_str() || *parsed != '\0' || pid <= 0 || pid > std::numeric_limits<pid_t>::max()) {
+                error = "invalid pid \"" + item + "\"";
+                return false;
+            }
+            const ProcessInfo* info = m_processes.findByPid(static_cast<pid_t>(pid));
+            if (info) {
+                processes.push_back(*info);
+            } else {
+                ProcessInfo unknown;
+                unknown.pid = static_cast<pid_t>(pid);
+                processes.push_back(unknown);
+            }
+            start = end + 1;
+        }
+    } else if (request.has("regex")) {
+        // Matched on a copy, a slow pattern must not hold up other clients' process lookups
+        std::vector<ProcessInfo> candidates = m_processes.processes();
+        lock.unlock();
+        if (!matchProcessesByRegex(request.getString("regex"), candidates, processes, error)) return false;
+    } else {
+        processes = m_processes.findBySubstring(request.getString("filter"));
+    }
+    return true;
+}
+
+std::string ScanServer::cmdProcesses(const JsonRequest& request) {
+    std::vector<ProcessInfo> processes;
+    std::string error;
+    if (!selectProcesses(request, processes, error)) return errorResponse(request, error);
+
+    std::string entries = "[";
+    for (const auto& process : processes) {
+        if (entries.size() > 1) entries += ",";
+        entries += "{\"pid\":" + std::to_string(process.pid) + ",\"name\":";
+        appendJsonString(entries, process.exeName);
+        entries += ",\"cmdline\":";
+        appendJsonString(entries, process.commandLine);
+        entries += ",\"uid\":" + std::to_string(process.uid) + ",\"rss_kb\":" + std::to_string(process.rssKb)
+            + ",\"mappings\":" + std::to_string(process.mappingCount) + "}";
+    }
+    entries += "]";
+    return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(processes.size()))
+        .raw("processes", entries).finish();
+}
+
+std::string ScanServer::cmdFleet(const JsonRequest& request) {
+    std::string op = request.getString("op");
+    if (op != "scan" && op != "filter") return errorResponse(request, "fleet op must be scan or filter");
+    if (!request.has("pid") && !request.has("pids") && !request.has("regex") && request.getString("filter").empty()) {
+        return errorResponse(request, "fleet needs pid, pids, regex or filter");
+    }
+
+    std::vector<ProcessInfo> processes;
+    std::string error;
+    if (!selectProcesses(request, processes, error)) return errorResponse(request, error);
+    // Never scan the server itself, a broad filter would otherwise include it
+    std::erase_if(processes, [](const ProcessInfo& process) { return process.pid == getpid(); });
+    if (processes.size() > kMaxFleetSize) return errorResponse(request, "too many processes");
+
+    std::string name = request.getString("session", "fleet");
+    size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    if (request.has("threads")) threads = static_cast<size_t>(std::clamp<int64_t>(request.getInt("threads"), 1, kMaxFleetThreads));
+    threads = std::min(threads, processes.size());
+
+    // One job per process on a shared pool. A process never gets a second worker, workers
+    // take the waiting processes in the order they were selected, so one large target only
+    // ties up its own worker while the others move through the rest of the fleet.
+    struct FleetJob {
+        std::string response; // the scan or filter response of the process's session
+        double ms = 0;
+    };
+    std::vector<FleetJob> jobs(processes.size());
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < processes.size() && !m_stopping;) {
+            auto started = std::chrono::steady_clock::now();
+            std::string attachError;
+            Client client{ -1, attachSession(processes[i].pid, name, attachError) };
+            if (!client.session) {
+                jobs[i].response = errorResponse(request, attachError);
+                continue;
+            }
+            jobs[i].response = op == "scan" ? cmdScan(client, request) : cmdFilter(client, request);
+            releaseSession(*client.session);
+            jobs[i].ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        }
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(work);
+    work();
+    for (auto& thread : pool) thread.join();
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    if (m_stopping) return errorResponse(request, "server is shutting down");
+
+    // Per-process outcome plus the fleet summary; the matches stay in each process's session
+    int64_t total = 0;
+    int64_t failed = 0;
+    int64_t matched = 0;
+    std::string entries = "[";
+    for (size_t i = 0; i < processes.size(); i++) {
+        JsonRequest response;
+        std::string parseError;
+        response.parse(jobs[i].response, parseError);
+        bool ok = response.getBool("ok");
+        if (entries.size() > 1) entries += ",";
+        entries += "{\"pid\":" + std::to_string(processes[i].pid) + ",\"name\":";
+        appendJsonString(entries, processes[i].exeName);
+        if (ok) {
+            int64_t count = response.getInt("count");
+            total += count;
+            if (count != 0) matched++;
+            entries += ",\"ok\":true,\"count\":" + std::to_string(count) + ",\"ms\":" + response.getString("ms", "0");
+        } else {
+            failed++;
+            entries += ",\"ok\":false,\"error\":";
+            appendJsonString(entries, response.getString("error"));
+        }
+        entries += "}";
+    }
+    entries += "]";
+    return JsonLine(request.id()).flag("ok", true).text("session", name)
+        .number("processes", static_cast<int64_t>(processes.size())).number("matched", matched)
+        .number("failed", failed).number("count", total).number("threads", static_cast<int64_t>(threads))
+        .real("ms", wallMs).raw("results", entries).finish();
+}
+
+std::string ScanServer::cmdAttach(Client& client, const JsonRequest& request) {
+    pid_t pid = static_cast<pid_t>(request.getInt("pid", -1));
+    std::string name = request.getString("session");
+    std::string error;
+    auto session = attachSession(pid, name, error);
+    if (!session) return errorResponse(request, error);
+
+    if (client.session) releaseSession(*client.session);
+    client.session = session;
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    size_t clients;
+    size_t sessions = 0;
+    {
+        std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
+        clients = session->clients;
+        for (auto it = m_sessions.lower_bound({ pid, std::string() }); it != m_sessions.end() && it->first.first == pid; ++it) {
+            sessions++;
+        }
+    }
+    return JsonLine(request.id()).flag("ok", true).number("pid", pid).text("session", name)
+        .flag("cached", session->hasScan).number("clients", static_cast<int64_t>(clients))
+        .number("sessions", static_cast<int64_t>(sessions)).finish();
+}
+
+std::string ScanServer::cmdStatus(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+
+    JsonLine line(request.id());
+    line.flag("ok", true).number("pid", session.pid).text("session", session.name).text("type", typeName(session.type));
+    if (session.hasScan) {
+        std::visit([&](const auto& history) {
+            line.number("count", static_cast<int64_t>(history.current().count()))
+                .text("label", history.current().label)
+                .number("generation", static_cast<int64_t>(history.currentIndex()))
+                .number("generations", static_cast<int64_t>(history.generationCount()))
+                .number("memory_bytes", static_cast<int64_t>(history.memoryUsage()))
+                .number("spilled_bytes", static_cast<int64_t>(history.spilledBytes()))
+                .flag("damaged", history.current().damaged());
+        }, session.history);
+    } else {
+        line.number("count", 0);
+    }
+    if (session.snapshot) line.number("snapshot_bytes", static_cast<int64_t>(session.snapshot->memoryUsage()));
+    const PageCacheStats& pages = session.scanner.pageCacheStats();
+    line.number("page_cache_hits", static_cast<int64_t>(pages.hits)).number("page_cache_misses", static_cast<int64_t>(pages.misses))
+        .flag("heap_filter", session.scanner.heapFilter());
+    return line.number("watches", static_cast<int64_t>(session.watchList.size())).finish();
+}
+
+std::string ScanServer::cmdScan(Client& client, const JsonRequest& request) {
+    ScanValueType type = ScanValueType::INT32;
+    if (!parseRequestType(request, type)) return errorResponse(request, "unknown type");
+
+    // "values" scans for any member of a comma separated set in one pass
+    bool valueSet = request.has("values");
+    if (valueSet && isStringScanValueType(type)) return errorResponse(request, "value sets need a numeric type");
+    bool unknownValue = !request.has("value") && !valueSet;
+    std::string text = valueSet ? "{" + request.getString("values") + "}" : request.getString("value");
+    std::vector<uint8_t> needle;
+    if (unknownValue && isStringScanValueType(type)) return errorResponse(request, "string scans need a value");
+    if (!unknownValue && !valueSet && !parseScanValue(type, text, needle)) return errorResponse(request, "invalid value");
+    if (valueSet && !validValueSet(type, request.getString("values"))) return errorResponse(request, "invalid values");
+
+    bool snapshot = unknownValue && request.getBool("snapshot");
+
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+    std::string label = unknownValue ? std::string("first scan (unknown value)")
+                                     : (valueSet ? "first scan in " : "first scan = ") + text;
+    session.snapshot.reset();
+
+    if (type == ScanValueType::STRING_ASCII) {
+        auto& history = session.history.emplace<ScanHistory<std::string>>();
+        history.reset(session.scanner.scanForString(std::string(needle.begin(), needle.end())), label);
+    } else {
+        withNumericType(type, [&](auto zero) {
+            using T = decltype(zero);
+            T value{};
+            if (!unknownValue && !valueSet) std::memcpy(&value, needle.data(), sizeof(T));
+            ValueSet<T> set;
+            if (valueSet) parseValueSet(type, request.getString("values"), set);
+            auto& history = session.history.emplace<ScanHistory<T>>();
+            if (snapshot) {
+                session.snapshot = std::make_unique<MemorySnapshot>();
+                if (!session.scanner.captureSnapshot(*session.snapshot)) session.snapshot.reset();
+                history.reset({}, "snapshot (unknown value)");
+                return;
+            }
+            history.collect([&](auto&& sink) {
+                if (unknownValue) session.scanner.template scanAllValues<T>(sink);
+                else if (valueSet) session.scanner.scanForValueSet(set, sink);
+                else session.scanner.scanForValue(value, sink);
+            }, label);
+        });
+    }
+    session.type = type;
+    session.hasScan = !snapshot || session.snapshot != nullptr;
+    session.revision++;
+    if (!session.hasScan) return errorResponse(request, "snapshot exceeds the memory budget");
+
+    const ScanStats& stats = session.scanner.lastScanStats();
+    size_t count = std::visit([](const auto& history) { return history.current().count(); }, session.history);
+    JsonLine line(request.id());
+    line.flag("ok", true).number("count", static_cast<int64_t>(count))
+        .text("type", typeName(type)).real("ms", stats.totalMicros / 1000.0)
+        .number("syscalls", static_cast<int64_t>(stats.syscalls));
+    if (session.snapshot) {
+        const SnapshotStats& captured = session.snapshot->stats();
+        line.number("snapshot_bytes", static_cast<int64_t>(session.snapshot->memoryUsage()))
+            .number("raw_bytes", static_cast<int64_t>(captured.rawBytes))
+            .number("zero_pages", static_cast<int64_t>(captured.zeroPages));
+    }
+    return line.finish();
+}
+
+std::string ScanServer::cmdFilter(Client& client, const JsonRequest& request) {
+    std::string mode = request.getString("mode", "exact");
+    if (mode != "exact" && mode != "changed" && mode != "unchanged" && mode != "rate" && mode != "expr") {
+        return errorResponse(request, "unknown filter mode");
+    }
+
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (!session.hasScan) return errorResponse(request, "no scan yet");
+    if (session.snapshot) {
+        if (mode == "rate" || mode == "expr") return errorResponse(request, "filter the snapshot with exact, changed or unchanged first");
+        return filterSnapshot(session, request, mode);
+    }
+    if (mode == "rate") return filterRate(session, request);
+    if (mode == "expr") return filterExpression(session, request);
+
+    std::vector<uint8_t> needle;
+    std::string text = request.getString("value");
+    bool valueSet = mode == "exact" && request.has("values");
+    if (valueSet) {
+        if (!validValueSet(session.type, request.getString("values"))) return errorResponse(request, "invalid values");
+        text = "{" + request.getString("values") + "}";
+    } else if (mode == "exact" && (!request.has("value") || !parseScanValue(session.type, text, needle))) {
+        return errorResponse(request, "invalid value");
+    }
+    std::string label = mode == "exact" ? (valueSet ? "exact in " : "exact = ") + text : mode;
+
+    std::string error;
+    bool filtered = std::visit([&](auto& history) {
+        using T = HistoryValue<decltype(history)>;
+        // One recorded operation over all history shards
+        auto operation = session.scanner.scanOperation("filter");
+
+        if constexpr (std::is_same_v<T, std::string>) {
+            // Strings are re-read with the length they were found with
+            std::string needleText(needle.begin(), needle.end());
+            return history.applyFilter([&](const auto& shard) {
+                std::vector<MemoryMatch<std::string>> kept;
+                std::string current;
+                for (const auto& match : shard) {
+                    current.resize(match.value.size());
+                    if (!session.scanner.readMemory(match.address, current.data(), current.size())) continue;
+                    bool keep = mode == "exact" ? current == needleText : (current != match.value) == (mode == "changed");
+                    if (keep) kept.push_back({ match.address, current });
+                }
+                return kept;
+            }, label, error);
+        } else {
+            T value{};
+            ValueSet<T> set;
+            if (valueSet) parseValueSet(session.type, request.getString("values"), set);
+            else if (mode == "exact") std::memcpy(&value, needle.data(), sizeof(T));
+            return history.applyFilter([&](const auto& shard) {
+                if (valueSet) return session.scanner.filterByValueSet(shard, set);
+                if (mode == "exact") return session.scanner.filterByValue(shard, value);
+                if (mode == "changed") return session.scanner.filterByChanged(shard);
+                return session.scanner.filterByUnchanged(shard);
+            }, label, error);
+        }
+    }, session.history);
+    if (!filtered) return errorResponse(request, error);
+    session.revision++;
+
+    const ScanStats& stats = session.scanner.lastScanStats();
+    size_t count = std::visit([](const auto& history) { return history.current().count(); }, session.history);
+    return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(count))
+        .real("ms", stats.totalMicros / 1000.0).number("syscalls", static_cast<int64_t>(stats.syscalls)).finish();
+}
+
+std::string ScanServer::filterSnapshot(Session& session, const JsonRequest& request, const std::string& mode) {
+    std::vector<uint8_t> needle;
+    std::string text = request.getString("value");
+    bool valueSet = mode == "exact" && request.has("values");
+    if (valueSet) {
+        if (!validValueSet(session.type, request.getString("values"))) return errorResponse(request, "invalid values");
+        text = "{" + request.getString("values") + "}";
+    } else if (mode == "exact" && (!request.has("value") || !parseScanValue(session.type, text, needle))) {
+        return errorResponse(request, "invalid value");
+    }
+
+    // The values that pass become the first generation, the snapshot is done with then
+    std::visit([&](auto& history) {
+        using T = HistoryValue<decltype(history)>;
+        if constexpr (!std::is_same_v<T, std::string>) {
+            T value{};
+            ValueSet<T> set;
+            if (valueSet) parseValueSet(session.type, request.getString("values"), set);
+            else if (mode == "exact") std::memcpy(&value, needle.data(), sizeof(T));
+            SnapshotCompare compare = mode == "changed" ? SnapshotCompare::CHANGED : SnapshotCompare::UNCHANGED;
+            history.collect([&](auto&& sink) {
+                if (valueSet) session.scanner.scanForValueSet(set, sink);
+                else if (mode == "exact") session.scanner.scanForValue(value, sink);
+                else session.scanner.template scanSnapshot<T>(*session.snapshot, compare, sink);
+            }, mode == "exact" ? (valueSet ? "exact in " : "exact = ") + text : mode + " since snapshot");
+        }
+    }, session.history);
+    session.snapshot.reset();
+    session.revision++;
+
+    const ScanStats& stats = session.scanner.lastScanStats();
+    size_t count = std::visit([](const auto& history) { return history.current().count(); }, session.history);
+    return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(count))
+        .real("ms", stats.totalMicros / 1000.0).number("syscalls", static_cast<int64_t>(stats.syscalls)).finish();
+}
+
+std::string ScanServer::filterExpression(Session& session, const JsonRequest& request) {
+    FilterExpression expression;
+    std::string error;
+    if (!expression.compile(request.getString("expr"), session.type, error)) return errorResponse(request, error);
+
+    bool filtered = std::visit([&](auto& history) {
+        using T = HistoryValue<decltype(history)>;
+        if constexpr (!std::is_same_v<T, std::string>) {
+            FirstValueIndex first;
+            if (expression.usesFirst() && !firstValuesOf(history, first, error)) return false;
+            auto operation = session.scanner.scanOperation("filterByExpression");
+            return history.applyFilter([&](const auto& shard) {
+                return filterByExpression(session.scanner, shard, expression, &first);
+            }, "expr " + expression.text(), error);
+        }
+        return true;
+    }, session.history);
+    if (!filtered) return errorResponse(request, error);
+    session.revision++;
+
+    const ScanStats& stats = session.scanner.lastScanStats();
+    size_t count = std::visit([](const auto& history) { return history.current().count(); }, session.history);
+    return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(count))
+        .real("ms", stats.totalMicros / 1000.0).number("syscalls", static_cast<int64_t>(stats.syscalls)).finish();
+}
+
+std::string ScanServer::filterRate(Session& session, const JsonRequest& request) {
+    if (isStringScanValueType(session.type)) return errorResponse(request, "rate filter needs a numeric scan");
+
+    auto duration = std::chrono::seconds(std::clamp<int64_t>(request.getInt("seconds", 5), 1, kMaxSampleSeconds));
+    auto interval = std::chrono::milliseconds(std::clamp<int64_t>(request.getInt("interval_ms", 1), 0, 1000));
+    double minRate = static_cast<double>(request.getInt("min_rate", 0));
+    double maxRate = request.has("max_rate") ? static_cast<double>(request.getInt("max_rate"))
+                                             : std::numeric_limits<double>::infinity();
+    std::string label = "rate " + std::to_string(static_cast<int64_t>(minRate)) + ".." +
+                        (request.has("max_rate") ? request.getString("max_rate") : std::string("max")) + "/s";
+
+    SampleRunStats run;
+    std::string error;
+    bool sampled = std::visit([&](auto& history) {
+        using T = HistoryValue<decltype(history)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            return false;
+        } else {
+            return filterByRate(session.scanner, history, session.type, duration, interval, minRate, maxRate,
+                                m_stopping, label, run, error);
+        }
+    }, session.history);
+    if (!sampled) return errorResponse(request, error);
+    session.revision++;
+
+    size_t count = std::visit([](const auto& history) { return history.current().count(); }, session.history);
+    return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(count))
+        .number("samples", run.samples).real("seconds", run.seconds).finish();
+}
+
+std::string ScanServer::cmdStep(Client& client, const JsonRequest& request, bool redo) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (!session.hasScan) return errorResponse(request, "no scan yet");
+
+    bool moved = std::visit([&](auto& history) { return redo ? history.redo() : history.undo(); }, session.history);
+    if (!moved) return errorResponse(request, redo ? "nothing to redo" : "nothing to undo");
+    session.revision++;
+
+    // A generation that already lost a spilled shard says so, its results are incomplete
+    return std::visit([&](const auto& history) {
+        JsonLine line(request.id());
+        line.flag("ok", true).number("count", static_cast<int64_t>(history.current().count()))
+            .text("label", history.current().label);
+        if (history.current().damaged()) line.text("error", kUnreadableSpillError);
+        return line.finish();
+    }, session.history);
+}
+
+std::string ScanServer::cmdResults(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    size_t offset = static_cast<size_t>(std::max<int64_t>(request.getInt("offset", 0), 0));
+    int64_t limit = request.getInt("limit", -1);
+    size_t pageSize = static_cast<size_t>(std::clamp<int64_t>(request.getInt("page_size", kServerPageSize), 1, kMaxPageSize));
+    bool live = request.getBool("live");
+
+    uint64_t revision;
+    size_t total;
+    {
+        std::lock_guard<std::mutex> lock(session.mutex);
+        if (!session.hasScan) return errorResponse(request, "no scan yet");
+        revision = session.revision;
+        total = std::visit([](const auto& history) { return history.current().count(); }, session.history);
+    }
+    size_t end = limit < 0 ? total : std::min(total, offset + static_cast<size_t>(limit));
+
+    // The session is only locked while a page is built, other clients can work in between.
+    // If the result set changes meanwhile the stream ends with an error.
+    size_t pages = 0;
+    for (size_t pageStart = offset; pageStart < end; pageStart += pageSize) {
+        size_t pageEnd = std::min(end, pageStart + pageSize);
+        std::string entries = "[";
+        {
+            std::lock_guard<std::mutex> lock(session.mutex);
+            if (session.revision != revision) return errorResponse(request, "results changed while streaming");
+
+            // Rows of a shard that could not be read back are not sent as results
+            bool readable = std::visit([&](const auto& history) {
+                const auto& generation = history.current();
+                ScanValueType type = session.type;
+
+                std::vector<decltype(generation.at(0))> page;
+                page.reserve(pageEnd - pageStart);
+                for (size_t i = pageStart; i < pageEnd; i++) {
+                    page.push_back(generation.at(i));
+                    if (!page.back()) return false;
+                }
+
+                // Current values of the whole page with one batched read
+                std::vector<uint8_t> liveBytes;
+                std::vector<MemoryIoRequest> reads;
+                if (live) {
+                    size_t bytes = 0;
+                    for (const auto* match : page) bytes += valueSize(match->value);
+                    liveBytes.resize(bytes);
+                    size_t position = 0;
+                    for (const auto* match : page) {
+                        size_t size = valueSize(match->value);
+                        reads.push_back({ match->address, liveBytes.data() + position, size, false });
+                        position += size;
+                    }
+                    if (request.has("max_age_ms")) session.scanner.readCachedBatch(reads, maxAge(request));
+                    else session.scanner.readMemoryBatch(reads);
+                }
+
+                // With the heap filter every result is tagged with the allocation holding it
+                bool heapTags = session.scanner.heapFilter();
+                if (heapTags) session.scanner.refreshHeapMap();
+
+                char address[20];
+                for (size_t i = pageStart; i < pageEnd; i++) {
+                    const auto& match = *page[i - pageStart];
+                    if (i != pageStart) entries += ",";
+                    entries += "{\"address\":\"";
+                    entries.append(address, formatHexAddress(match.address, address));
+                    entries += "\",\"value\":";
+                    appendJsonString(entries, formatValue(type, valueBytes(match.value), valueSize(match.value)));
+                    if (live) {
+                        const auto& read = reads[i - pageStart];
+                        entries += ",\"live\":";
+                        if (read.success) appendJsonString(entries, formatValue(type, read.buffer, read.size));
+                        else entries += "null";
+                    }
+                    HeapChunk chunk;
+                    if (heapTags && session.scanner.heapChunkOf(match.address, valueSize(match.value), chunk)) {
+                        entries += ",\"chunk\":\"";
+                        entries.append(address, formatHexAddress(chunk.address, address));
+                        entries += "\",\"chunk_size\":" + std::to_string(chunk.size) +
+                                   ",\"chunk_offset\":" + std::to_string(match.address - chunk.address);
+                    }
+                    entries += "}";
+                }
+                return true;
+            }, session.history);
+            if (!readable) return errorResponse(request, kUnreadableSpillError);
+        }
+        entries += "]";
+
+        std::string page = JsonLine(request.id()).number("offset", static_cast<int64_t>(pageStart))
+            .raw("results", entries).finish();
+        if (!client.send(page)) return {};
+        pages++;
+    }
+
+    return JsonLine(request.id()).flag("ok", true).number("total", static_cast<int64_t>(total))
+        .number("offset", static_cast<int64_t>(offset)).number("count", static_cast<int64_t>(end > offset ? end - offset : 0))
+        .number("pages", static_cast<int64_t>(pages)).finish();
+}
+
+std::string ScanServer::cmdRead(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    uintptr_t address;
+    if (!request.getAddress("address", address)) return errorResponse(request, "invalid address");
+
+    std::lock_guard<std::mutex> lock(session.mutex);
+    ScanValueType type = session.type;
+    if (!parseRequestType(request, type)) return errorResponse(request, "unknown type");
+
+    size_t size = scanValueTypeSize(type);
+    if (size == 0) size = static_cast<size_t>(std::clamp<int64_t>(request.getInt("size", 64), 1, kMaxReadSize));
+
+    // "max_age_ms" lets polling clients share cached pages instead of reading every time
+    std::vector<uint8_t> bytes(size);
+    bool read = request.has("max_age_ms")
+        ? session.scanner.readCached(address, bytes.data(), bytes.size(), maxAge(request))
+        : session.scanner.readMemory(address, bytes.data(), bytes.size());
+    if (!read) return errorResponse(request, "read failed");
+
+    return JsonLine(request.id()).flag("ok", true).address("address", address).text("type", typeName(type))
+        .text("value", formatValue(type, bytes.data(), bytes.size())).text("bytes", hexBytes(bytes.data(), bytes.size())).finish();
+}
+
+std::string ScanServer::cmdWrite(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+
+    ScanValueType type = session.type;
+    if (!parseRequestType(request, type)) return errorResponse(request, "unknown type");
+    std::vector<uint8_t> bytes;
+    if (!request.has("value") || !parseScanValue(type, request.getString("value"), bytes)) return errorResponse(request, "invalid value");
+
+    if (!request.getBool("all")) {
+        uintptr_t address;
+        if (!request.getAddress("address", address)) return errorResponse(request, "invalid address");
+        if (!session.scanner.writeMemory(address, bytes.data(), bytes.size())) return errorResponse(request, "write failed");
+        return JsonLine(request.id()).flag("ok", true).address("address", address).finish();
+    }
+
+    // Every address of the current result set in one verified batch
+    if (!session.hasScan) return errorResponse(request, "no scan yet");
+    WriteBatch batch;
+    bool complete = std::visit([&](const auto& history) {
+        const auto& generation = history.current();
+        batch.reserve(generation.count(), generation.count() * bytes.size());
+        for (size_t i = 0; i < generation.count(); i++) {
+            const auto* match = generation.at(i);
+            if (!match) return false;
+            batch.add(match->address, bytes.data(), bytes.size());
+        }
+        return true;
+    }, session.history);
+    if (!complete) return errorResponse(request, kUnreadableSpillError);
+    WriteBatchResult result = batch.submit(session.scanner, request.getBool("verify", true));
+
+    return JsonLine(request.id()).flag("ok", result.ok()).number("written", static_cast<int64_t>(result.written))
+        .number("failed", static_cast<int64_t>(result.failed)).number("mismatched", static_cast<int64_t>(result.mismatched))
+        .number("syscalls", static_cast<int64_t>(result.syscalls)).finish();
+}
+
+std::string ScanServer::cmdWatch(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    uintptr_t address;
+    if (!request.getAddress("address", address)) return errorResponse(request, "invalid address");
+
+    std::lock_guard<std::mutex> lock(session.mutex);
+    ScanValueType type = session.type;
+    if (!parseRequestType(request, type)) return errorResponse(request, "unknown type");
+
+    bool freeze = request.getBool("freeze");
+    uint32_t interval = static_cast<uint32_t>(std::max<int64_t>(
+        request.getInt("interval_ms", freeze ? kFreezeIntervalMs : kWatchIntervalMs), 1));
+
+    // Sessions that never watch anything (most fleet targets) never start the thread
+    session.watchList.start();
+    uint32_t id;
+    if (freeze) {
+        std::vector<uint8_t> bytes;
+        if (!request.has("value") || !parseScanValue(type, request.getString("value"), bytes)) return errorResponse(request, "invalid value");
+        id = session.watchList.addFreeze(address, type, std::move(bytes), interval);
+    } else {
+        size_t size = scanValueTypeSize(type);
+        if (size == 0) size = static_cast<size_t>(std::clamp<int64_t>(request.getInt("size", 16), 1, kMaxReadSize));
+        id = session.watchList.addWatch(address, type, size, interval);
+    }
+    return JsonLine(request.id()).flag("ok", true).number("watch_id", id).finish();
+}
+
+std::string ScanServer::cmdUnwatch(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (!session.watchList.remove(static_cast<uint32_t>(request.getInt("watch_id", 0)))) {
+        return errorResponse(request, "unknown watch_id");
+    }
+    return JsonLine(request.id()).flag("ok", true).finish();
+}
+
+std::string ScanServer::cmdWatches(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+
+    // The session lock makes the clients take turns as the snapshot's single consumer
+    const WatchSnapshot& snapshot = session.watchList.acquireSnapshot();
+    std::string entries = "[";
+    for (const auto& value : snapshot.values) {
+        if (entries.size() > 1) entries += ",";
+        JsonLine entry(std::to_string(value.id));
+        entry.address("address", value.address).text("type", typeName(value.type))
+            .text("mode", value.mode == WatchMode::FREEZE ? "freeze" : "watch").flag("valid", value.valid);
+        if (value.valid) entry.text("value", formatValue(value.type, snapshot.bytes.data() + value.offset, value.size));
+        std::string json = entry.finish();
+        json.pop_back(); // newline
+        entries += json;
+    }
+    entries += "]";
+    return JsonLine(request.id()).flag("ok", true).number("tick", static_cast<int64_t>(snapshot.tick))
+        .raw("watches", entries).finish();
+}
+
+std::string ScanServer::cmdMemory(const JsonRequest& request) {
+    MemoryGovernor& governor = memoryGovernor();
+    if (request.has("budget_mb")) {
+        int64_t megabytes = request.getInt("budget_mb");
+        if (megabytes <= 0) return errorResponse(request, "invalid budget_mb");
+        governor.setBudget(static_cast<size_t>(megabytes) * 1024 * 1024);
+    }
+
+    // Usage of every component summed over all sessions
+    std::string components = "{";
+    for (size_t i = 0; i < static_cast<size_t>(MemoryComponent::COUNT); i++) {
+        auto component = static_cast<MemoryComponent>(i);
+        if (i != 0) components += ",";
+        appendJsonString(components, memoryComponentName(component));
+        components += ":{\"used\":" + std::to_string(governor.used(component)) +
+                      ",\"peak\":" + std::to_string(governor.peak(component)) + "}";
+    }
+    components += "}";
+    return JsonLine(request.id()).flag("ok", true).number("budget", static_cast<int64_t>(governor.budget()))
+        .number("used", static_cast<int64_t>(governor.used()))
+        .number("available", static_cast<int64_t>(governor.available())).raw("components", components).finish();
+}
+
+std::string ScanServer::cmdStats(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+    const ScanStats& stats = session.scanner.lastScanStats();
+
+    return JsonLine(request.id()).flag("ok", true).text("operation", stats.operation)
+        .real("total_ms", stats.totalMicros / 1000.0).real("read_ms", stats.readMicros / 1000.0)
+        .real("compare_ms", stats.compareMicros / 1000.0)
+        .number("regions_visited", static_cast<int64_t>(stats.regionsVisited))
+        .number("regions_skipped", static_cast<int64_t>(stats.regionsSkipped))
+        .number("bytes_read", static_cast<int64_t>(stats.bytesRead))
+        .number("syscalls", static_cast<int64_t>(stats.syscalls))
+        .number("failed_reads", static_cast<int64_t>(stats.failedReads()))
+        .number("holes", static_cast<int64_t>(stats.holes))
+        .number("hole_bytes", static_cast<int64_t>(stats.holeBytes))
+        .number("bytes_recovered", static_cast<int64_t>(stats.bytesRecovered))
+        .number("matches", static_cast<int64_t>(stats.matches)).finish();
+}
+
+std::string ScanServer::cmdRecord(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+    TimeSeriesRecorder& recorder = session.recorder;
+    std::string op = request.getString("op", "status");
+
+    if (op == "start") {
+        if (recorder.isRunning()) return errorResponse(request, "already recording");
+        if (!request.has("path")) return errorResponse(request, "missing path");
+        recorder.clear();
+
+        // "ranges" as "address:size,...", the current result set otherwise
+        if (request.has("ranges")) {
+            std::string list = request.getString("ranges");
+            for (size_t start = 0; start < list.size();) {
+                size_t end = std::min(list.find(',', start), list.size());
+                std::string item = list.substr(start, end - start);
+                char* parsed;
+                uint64_t address = std::strtoull(item.c_str(), &parsed, 0);
+                uint64_t size = *parsed == ':' ? std::strtoull(parsed + 1, &parsed, 0) : 0;
+                if (*parsed != '\0' || size == 0) return errorResponse(request, "invalid range \"" + item + "\"");
+                if (!recorder.addRange(static_cast<uintptr_t>(address), static_cast<size_t>(size))) {
+                    return errorResponse(request, "too many bytes to record");
+                }
+                start = end + 1;
+            }
+        } else {
+            if (!session.hasScan) return errorResponse(request, "no scan yet");
+            size_t size = scanValueTypeSize(session.type);
+            if (size == 0) return errorResponse(request, "recording a result set needs a numeric scan");
+            std::string addError = std::visit([&](const auto& history) -> std::string {
+                const auto& generation = history.current();
+                for (size_t i = 0; i < generation.count(); i++) {
+                    const auto* match = generation.at(i);
+                    if (!match) return kUnreadableSpillError;
+                    if (!recorder.addRange(match->address, size)) return "too many bytes to record";
+                }
+                return {};
+            }, session.history);
+            if (!addError.empty()) {
+                recorder.clear();
+                return errorResponse(request, addError);
+            }
+        }
+
+        auto interval = std::chrono::microseconds(
+            std::clamp<int64_t>(request.getInt("interval_us", kRecordIntervalUs), 1, kMaxRecordIntervalUs));
+        std::string error;
+        if (!recorder.start(request.getString("path"), interval, session.type, error)) return errorResponse(request, error);
+        return JsonLine(request.id()).flag("ok", true).number("ranges", static_cast<int64_t>(recorder.rangeCount()))
+            .number("interval_us", interval.count()).finish();
+    }
+    if (op == "stop") {
+        if (!recorder.isRunning()) return errorResponse(request, "not recording");
+        recorder.stop();
+    } else if (op != "status") {
+        return errorResponse(request, "unknown op \"" + op + "\"");
+    }
+
+    RecordingStats stats = recorder.stats();
+    return JsonLine(request.id()).flag("ok", !stats.failed).flag("recording", recorder.isRunning())
+        .number("samples", static_cast<int64_t>(stats.samples)).number("late", static_cast<int64_t>(stats.lateSamples))
+        .number("failed_reads", static_cast<int64_t>(stats.failedReads)).number("chunks", stats.chunks)
+        .number("bytes", static_cast<int64_t>(stats.bytesWritten)).finish();
+}
+
+std::string ScanServer::cmdHeap(Client& client, const JsonRequest& request) {
+    Session& session = *client.session;
+    std::lock_guard<std::mutex> lock(session.mutex);
+
+    // "enabled" switches the filter, without it the current map is reported
+    if (request.has("enabled")) {
+        std::string error;
+        if (!session.scanner.setHeapFilter(request.getBool("enabled"), error)) return errorResponse(request, error);
+    }
+    session.scanner.refreshHeapMap();
+    HeapMapStats stats = session.scanner.heapMapStats();
+    return JsonLine(request.id()).flag("ok", true).flag("enabled", session.scanner.heapFilter())
+        .number("arenas", stats.arenas).number("heaps", stats.heaps).number("failed_heaps", stats.failedHeaps)
+        .number("live_chunks", static_cast<int64_t>(stats.liveChunks))
+        .number("free_chunks", static_cast<int64_t>(stats.freeChunks))
+        .number("live_bytes", static_cast<int64_t>(stats.liveBytes))
+        .number("free_bytes", static_cast<int64_t>(stats.freeBytes))
+        .number("skipped_bytes", static_cast<int64_t>(stats.skippedBytes))
+        .real("walk_ms", stats.buildMicros / 1000.0).finish();
+}
+
+std::string ScanServer::cmdRecording(const JsonRequest& request) {
+    // Needs no session, a recording is read without its target
+    TimeSeriesReader reader;
+    std::string error;
+    if (!reader.open(request.getString("path"), error)) return errorResponse(request, error);
+    ScanValueType type = reader.type();
+    if (!parseRequestType(request, type)) return errorResponse(request, "unknown type");
+    std::string op = request.getString("op", "info");
+
+    if (op == "info") {
+        uint64_t bytes = 0;
+        for (const auto& range : reader.ranges()) bytes += range.size;
+        return JsonLine(request.id()).flag("ok", true).text("type", typeName(reader.type()))
+            .number("ranges", static_cast<int64_t>(reader.ranges().size())).number("bytes", static_cast<int64_t>(bytes))
+            .number("interval_us", reader.interval().count()).number("samples", static_cast<int64_t>(reader.samples()))
+            .number("duration_us", static_cast<int64_t>(reader.durationUs()))
+            .number("chunks", static_cast<int64_t>(reader.chunks())).finish();
+    }
+
+    size_t size = scanValueTypeSize(type);
+    if (size == 0) size = static_cast<size_t>(std::clamp<int64_t>(request.getInt("size", 16), 1, kMaxReadSize));
+    std::vector<uint8_t> bytes(size);
+
+    if (op == "value") {
+        uintptr_t address;
+        if (!request.getAddress("address", address)) return errorResponse(request, "invalid address");
+        uint64_t time = static_cast<uint64_t>(std::max<int64_t>(request.getInt("time_us", 0), 0));
+        if (!reader.valueAt(address, bytes.data(), size, time)) return errorResponse(request, "no recorded value at that time");
+        return JsonLine(request.id()).flag("ok", true).address("address", address).text("type", typeName(type))
+            .text("value", formatValue(type, bytes.data(), size)).text("bytes", hexBytes(bytes.data(), size)).finish();
+    }
+    if (op == "changes") {
+        uintptr_t address;
+        if (!request.getAddress("address", address)) return errorResponse(request, "invalid address");
+        uint64_t from = static_cast<uint64_t>(std::max<int64_t>(request.getInt("from_us", 0), 0));
+        uint64_t to = request.has("to_us") ? static_cast<uint64_t>(std::max<int64_t>(request.getInt("to_us"), 0)) : UINT64_MAX;
+        size_t limit = static_cast<size_t>(std::clamp<int64_t>(request.getInt("limit", kServerPageSize), 1, kMaxPageSize));
+
+        std::string entries = "[";
+        size_t count = 0;
+        bool recorded = reader.changes(address, size, from, to, [&](uint64_t time, const uint8_t* value) {
+            if (count++ != 0) entries += ",";
+            entries += "{\"time_us\":" + std::to_string(time) + ",\"value\":";
+            appendJsonString(entries, formatValue(type, value, size));
+            entries += "}";
+            return count < limit;
+        });
+        if (!recorded) return errorResponse(request, "address not recorded");
+        entries += "]";
+        return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(count))
+            .raw("changes", entries).finish();
+    }
+    if (op == "filter") {
+        if (isStringScanValueType(type)) return errorResponse(request, "replay needs a numeric type");
+        FilterExpression expression;
+        if (!expression.compile(request.getString("expr"), type, error)) return errorResponse(request, error);
+        std::vector<uint64_t> times;
+        if (!parseNumberList(request.getString("times"), times) || !std::ranges::is_sorted(times)) {
+            return errorResponse(request, "times must be an ascending list");
+        }
+
+        // "addresses" as a list, every value slot of the recorded ranges otherwise
+        std::vector<uint64_t> listed;
+        std::vector<uintptr_t> addresses;
+        if (request.has("addresses")) {
+            if (!parseNumberList(request.getString("addresses"), listed)) return errorResponse(request, "invalid addresses");
+            addresses.assign(listed.begin(), listed.end());
+        } else {
+            for (const auto& range : reader.ranges()) {
+                for (size_t offset = 0; offset + size <= range.size; offset += size) addresses.push_back(range.address + offset);
+            }
+        }
+
+        std::vector<uintptr_t> survivors = reader.replayFilter(addresses, expression, times);
+        size_t limit = static_cast<size_t>(std::clamp<int64_t>(request.getInt("limit", kServerPageSize), 1, kMaxPageSize));
+        std::string entries = "[";
+        for (size_t i = 0; i < survivors.size() && i < limit; i++) {
+            if (i != 0) entries += ",";
+            char text[20];
+            entries += "\"";
+            entries.append(text, formatHexAddress(survivors[i], text));
+            entries += "\"";
+        }
+        entries += "]";
+        return JsonLine(request.id()).flag("ok", true).number("count", static_cast<int64_t>(survivors.size()))
+            .raw("addresses", entries).finish();
+    }
+    return errorResponse(request, "unknown op \"" + op + "\"");
+}
+#endif
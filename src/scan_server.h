@@ -0,0 +1,117 @@
+#pragma once
+#ifdef __linux__
+#include "process_utils.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+class JsonRequest;
+
+// Results per page line when streaming a result set
+constexpr size_t kServerPageSize = 1000;
+// A session nobody is attached to is dropped after this long without use
+constexpr std::chrono::minutes kSessionIdleTimeout{ 10 };
+
+// Headless scanner engine behind a Unix domain socket.
+// Clients send one JSON request per line (see server_protocol.h) and get one response
+// line per request; result sets are streamed as several page lines. Every client runs
+// on its own thread, clients attached to the same pid and session name share one cached
+// session (scan history, watch list), which stays cached after they disconnect. Sessions
+// with different names on one pid are independent and run in parallel; they share the
+// process's ProcessCache (regions, modules, bad ranges, chunk buffers). A session without
+// clients is dropped once its process is gone, or once it has been idle for
+// kSessionIdleTimeout without watches or a recording to keep it alive.
+//
+// "fleet" runs one scan or filter on a whole set of processes (pid list, regex or name
+// filter) on a shared worker pool. Every process keeps its matches in its own session of
+// the given name, so attaching to one of them continues from the fleet's result set.
+//
+// "record" samples ranges (or the current result set) into a time-series file on a thread
+// of the session; "recording" answers value, change and filter-replay queries from such a
+// file and needs no attached process.
+//
+// "heap" switches a session to heap-aware scanning (glibc targets): its scans and filters
+// skip free malloc chunks, and results carry the chunk they lie in and their offset in it.
+//
+// Commands: ping, processes, fleet, memory, recording, attach, detach, status, scan,
+// filter, undo, redo, results, read, write, watch, unwatch, watches, stats, record, heap,
+// shutdown.
+class ScanServer {
+public:
+    explicit ScanServer(std::string socketPath);
+    ~ScanServer();
+
+    ScanServer(const ScanServer&) = delete;
+    ScanServer& operator=(const ScanServer&) = delete;
+
+    // Create the socket (only accessible by the current user). Returns false with error set.
+    bool start(std::string& error);
+
+    // Accept and serve clients until requestStop() or a shutdown command
+    void run();
+
+    // Safe to call from a signal handler
+    void requestStop() { m_stopping = true; }
+
+private:
+    struct Session;
+    struct Client;
+
+    struct ClientThread {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    std::string m_socketPath;
+    int m_listenFd = -1;
+    std::atomic<bool> m_stopping{false};
+
+    std::mutex m_sessionsMutex;
+    std::map<std::pair<pid_t, std::string>, std::shared_ptr<Session>> m_sessions;
+
+    std::vector<ClientThread> m_clients;
+
+    std::mutex m_processesMutex;
+    ProcessDirectory m_processes;
+
+    void serveClient(int fd);
+    std::string handle(Client& client, const JsonRequest& request);
+    std::shared_ptr<Session> attachSession(pid_t pid, const std::string& name, std::string& error);
+    // A client lets go of its session
+    void releaseSession(Session& session);
+    // Drop unattached sessions of exited processes and idle ones
+    void pruneSessions();
+    void reapClients(bool all);
+    bool selectProcesses(const JsonRequest& request, std::vector<ProcessInfo>& processes, std::string& error);
+
+    // Command handlers, each returns the final response line
+    std::string cmdProcesses(const JsonRequest& request);
+    std::string cmdFleet(const JsonRequest& request);
+    std::string cmdMemory(const JsonRequest& request);
+    std::string cmdAttach(Client& client, const JsonRequest& request);
+    std::string cmdStatus(Client& client, const JsonRequest& request);
+    std::string cmdScan(Client& client, const JsonRequest& request);
+    std::string cmdFilter(Client& client, const JsonRequest& request);
+    std::string filterSnapshot(Session& session, const JsonRequest& request, const std::string& mode);
+    std::string filterRate(Session& session, const JsonRequest& request);
+    std::string filterExpression(Session& session, const JsonRequest& request);
+    std::string cmdStep(Client& client, const JsonRequest& request, bool redo);
+    std::string cmdResults(Client& client, const JsonRequest& request);
+    std::string cmdRead(Client& client, const JsonRequest& request);
+    std::string cmdWrite(Client& client, const JsonRequest& request);
+    std::string cmdWatch(Client& client, const JsonRequest& request);
+    std::string cmdUnwatch(Client& client, const JsonRequest& request);
+    std::string cmdWatches(Client& client, const JsonRequest& request);
+    std::string cmdStats(Client& client, const JsonRequest& request);
+    std::string cmdRecord(Client& client, const JsonRequest& request);
+    std::string cmdHeap(Client& client, const JsonRequest& request);
+    std::string cmdRecording(const JsonRequest& request);
+};
+#endif
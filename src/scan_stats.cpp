@@ -0,0 +1,253 @@
+#include "scan_stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Common time base, so spans of consecutive operations line up in the trace
+ScanRecorder::Clock::time_point traceEpoch() {
+    static const auto epoch = ScanRecorder::Clock::now();
+    return epoch;
+}
+
+double toMilliseconds(uint64_t micros) {
+    return static_cast<double>(micros) / 1000.0;
+}
+
+} // namespace
+
+const char* readFailureName(ReadFailure reason) {
+    switch (reason) {
+        case ReadFailure::PARTIAL: return "partial";
+        case ReadFailure::UNMAPPED: return "unmapped";
+        case ReadFailure::PERMISSION: return "permission";
+        case ReadFailure::OTHER: return "other";
+    }
+    return "other";
+}
+
+uint64_t ScanStats::failedReads() const {
+    uint64_t total = 0;
+    for (uint64_t count : readFailures) total += count;
+    return total;
+}
+
+void ScanRecorder::beginOperation(const char* name) {
+    if (m_depth++ > 0) return;
+
+    m_stats = ScanStats();
+    m_stats.operation = name;
+    m_region = nullptr;
+    m_operationStart = Clock::now();
+    m_stats.startMicros = micros(m_operationStart);
+}
+
+void ScanRecorder::endOperation() {
+    if (m_depth == 0 || --m_depth > 0) return;
+
+    if (m_region) endRegion();
+    m_stats.totalMicros = micros(Clock::now()) - m_stats.startMicros;
+
+    if (m_traceEnabled) {
+        if (m_log.size() >= kMaxTracedOperations) m_log.erase(m_log.begin());
+        m_log.push_back(m_stats);
+    }
+}
+
+void ScanRecorder::recordEnumeration(Clock::time_point start, size_t regionsFound) {
+    if (!active()) return;
+    auto end = Clock::now();
+    m_stats.enumerateMicros += micros(end) - micros(start);
+    m_stats.regions.reserve(m_stats.regions.size() + regionsFound);
+    addSpan("enumerate", start, end, 0, regionsFound);
+}
+
+void ScanRecorder::beginRegion(uintptr_t baseAddress, size_t size) {
+    if (!active()) return;
+    if (m_region) endRegion();
+
+    m_stats.regionsVisited++;
+    RegionStats region;
+    region.baseAddress = baseAddress;
+    region.size = size;
+    m_stats.regions.push_back(region);
+    m_region = &m_stats.regions.back();
+    m_regionStart = Clock::now();
+}
+
+void ScanRecorder::skipRegion() {
+    if (active()) m_stats.regionsSkipped++;
+}
+
+void ScanRecorder::endRegion() {
+    if (!active() || !m_region) return;
+    addSpan("region", m_regionStart, Clock::now(), m_region->baseAddress, m_region->size);
+    m_region = nullptr;
+}
+
+void ScanRecorder::recordRead(uintptr_t address, size_t requested, size_t read, ReadFailure reason, Clock::time_point start) {
+    if (active()) recordRead(address, requested, read, reason, start, Clock::now());
+}
+
+void ScanRecorder::recordRead(uintptr_t address, size_t requested, size_t read, ReadFailure reason,
+                              Clock::time_point start, Clock::time_point end) {
+    if (!active()) return;
+    uint64_t duration = micros(end) - micros(start);
+
+    m_stats.reads++;
+    m_stats.bytesRequested += requested;
+    m_stats.bytesRead += read;
+    m_stats.readMicros += duration;
+    if (read != requested) {
+        m_stats.readFailures[static_cast<size_t>(reason)]++;
+    }
+
+    if (m_region) {
+        m_region->reads++;
+        m_region->bytesRequested += requested;
+        m_region->bytesRead += read;
+        m_region->readMicros += duration;
+        if (read != requested) m_region->failedReads++;
+    }
+
+    // Filters issue one tiny read per candidate, only reads inside a region become spans
+    if (m_region) addSpan("read", start, end, address, requested);
+}
+
+void ScanRecorder::recordCompare(uintptr_t address, size_t size, Clock::time_point start, uint64_t matches) {
+    if (!active()) return;
+    auto end = Clock::now();
+    uint64_t duration = micros(end) - micros(start);
+
+    m_stats.compareMicros += duration;
+    m_stats.matches += matches;
+    if (m_region) {
+        m_region->compareMicros += duration;
+        m_region->matches += matches;
+    }
+    addSpan("compare", start, end, address, size);
+}
+
+void ScanRecorder::recordMatches(uint64_t matches) {
+    if (!active()) return;
+    m_stats.matches += matches;
+    if (m_region) m_region->matches += matches;
+}
+
+void ScanRecorder::recordRecovered(size_t bytes) {
+    if (active()) m_stats.bytesRecovered += bytes;
+}
+
+void ScanRecorder::recordHole(uintptr_t address, size_t size, bool known) {
+    if (!active()) return;
+    m_stats.holes++;
+    m_stats.holeBytes += size;
+    if (known) m_stats.knownHoleBytes += size;
+    if (m_region) m_region->holeBytes += size;
+    auto now = Clock::now();
+    addSpan("hole", now, now, address, size);
+}
+
+void ScanRecorder::recordBuffer(size_t bytes) {
+    if (active()) m_stats.peakBufferBytes = std::max(m_stats.peakBufferBytes, bytes);
+}
+
+uint64_t ScanRecorder::micros(Clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - traceEpoch()).count();
+}
+
+void ScanRecorder::addSpan(const char* name, Clock::time_point start, Clock::time_point end, uintptr_t address, size_t size) {
+    if (!m_traceEnabled) return;
+    uint64_t startMicros = micros(start);
+    m_stats.spans.push_back({ name, startMicros, micros(end) - startMicros, address, size });
+}
+
+std::string formatScanStats(const ScanStats& stats, size_t topRegions) {
+    std::ostringstream out;
+    char line[256];
+
+    std::snprintf(line, sizeof(line), "%s: %.2f ms (Regionen %.2f ms, Lesen %.2f ms, Vergleich %.2f ms)\n",
+                  stats.operation.c_str(), toMilliseconds(stats.totalMicros), toMilliseconds(stats.enumerateMicros),
+                  toMilliseconds(stats.readMicros), toMilliseconds(stats.compareMicros));
+    out << line;
+
+    std::snprintf(line, sizeof(line), "  Regionen: %llu besucht, %llu übersprungen | Treffer: %llu | Syscalls: %llu\n",
+                  static_cast<unsigned long long>(stats.regionsVisited), static_cast<unsigned long long>(stats.regionsSkipped),
+                  static_cast<unsigned long long>(stats.matches), static_cast<unsigned long long>(stats.syscalls));
+    out << line;
+
+    std::snprintf(line, sizeof(line), "  Gelesen: %.1f / %.1f MB in %llu Lesezugriffen | Puffer max. %.1f MB\n",
+                  stats.bytesRead / 1048576.0, stats.bytesRequested / 1048576.0,
+                  static_cast<unsigned long long>(stats.reads), stats.peakBufferBytes / 1048576.0);
+    out << line;
+
+    if (stats.failedReads() > 0) {
+        out << "  Fehlgeschlagene Lesezugriffe:";
+        for (size_t i = 0; i < kReadFailureKinds; i++) {
+            if (stats.readFailures[i] == 0) continue;
+            out << " " << readFailureName(static_cast<ReadFailure>(i)) << "=" << stats.readFailures[i];
+        }
+        out << "\n";
+    }
+
+    if (stats.holes > 0) {
+        std::snprintf(line, sizeof(line), "  Lücken: %llu (%.1f KB, davon %.1f KB bekannt) | seitenweise gerettet: %.1f KB\n",
+                      static_cast<unsigned long long>(stats.holes), stats.holeBytes / 1024.0,
+                      stats.knownHoleBytes / 1024.0, stats.bytesRecovered / 1024.0);
+        out << line;
+    }
+
+    // The few regions that dominate the scan time
+    std::vector<const RegionStats*> slowest;
+    for (const auto& region : stats.regions) slowest.push_back(&region);
+    size_t shown = std::min(topRegions, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + shown, slowest.end(), [](const RegionStats* a, const RegionStats* b) {
+        return a->readMicros + a->compareMicros > b->readMicros + b->compareMicros;
+    });
+    for (size_t i = 0; i < shown; i++) {
+        const RegionStats& region = *slowest[i];
+        std::snprintf(line, sizeof(line), "  0x%016llX %8.1f KB  %7.2f ms lesen %7.2f ms vergleichen  %llu Treffer%s\n",
+                      static_cast<unsigned long long>(region.baseAddress), region.size / 1024.0,
+                      toMilliseconds(region.readMicros), toMilliseconds(region.compareMicros),
+                      static_cast<unsigned long long>(region.matches), region.holeBytes ? "  (Lücken)" : region.failedReads ? "  (Lesefehler)" : "");
+        out << line;
+    }
+
+    return out.str();
+}
+
+bool writeChromeTrace(const std::vector<ScanStats>& operations, const std::string& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    // Complete events ("ph":"X") on one thread nest by time, which gives operation > region > read/compare
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    char event[512];
+    for (const auto& operation : operations) {
+        std::snprintf(event, sizeof(event),
+                      "%s\n{\"name\":\"%s\",\"cat\":\"scan\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%llu,"
+                      "\"args\":{\"matches\":%llu,\"bytes_read\":%llu,\"syscalls\":%llu,\"failed_reads\":%llu,\"hole_bytes\":%llu}}",
+                      first ? "" : ",", operation.operation.c_str(),
+                      static_cast<unsigned long long>(operation.startMicros), static_cast<unsigned long long>(operation.totalMicros),
+                      static_cast<unsigned long long>(operation.matches), static_cast<unsigned long long>(operation.bytesRead),
+                      static_cast<unsigned long long>(operation.syscalls), static_cast<unsigned long long>(operation.failedReads()),
+                      static_cast<unsigned long long>(operation.holeBytes));
+        file << event;
+        first = false;
+
+        for (const auto& span : operation.spans) {
+            std::snprintf(event, sizeof(event),
+                          ",\n{\"name\":\"%s\",\"cat\":\"scan\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%llu,"
+                          "\"args\":{\"address\":\"0x%llX\",\"size\":%llu}}",
+                          span.name, static_cast<unsigned long long>(span.startMicros),
+                          static_cast<unsigned long long>(span.durationMicros),
+                          static_cast<unsigned long long>(span.address), static_cast<unsigned long long>(span.size));
+            file << event;
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Completed operations kept for the trace export while tracing is enabled
+constexpr size_t kMaxTracedOperations = 64;
+
+// Why a remote read did not return all requested bytes
+enum class ReadFailure {
+    PARTIAL,    // some bytes were copied, then the range ran into an unreadable page
+    UNMAPPED,   // the address is not mapped (anymore)
+    PERMISSION, // access to the process or page was denied
+    OTHER
+};
+constexpr size_t kReadFailureKinds = 4;
+
+const char* readFailureName(ReadFailure reason);
+
+// Per-region counters of one operation
+struct RegionStats {
+    uintptr_t baseAddress = 0;
+    size_t size = 0;
+    uint64_t bytesRequested = 0;
+    uint64_t bytesRead = 0;
+    uint32_t reads = 0;
+    uint32_t failedReads = 0;
+    uint64_t holeBytes = 0;
+    uint64_t matches = 0;
+    uint64_t readMicros = 0;
+    uint64_t compareMicros = 0;
+};
+
+// One timed span for the trace export
+struct TraceSpan {
+    const char* name;   // "read", "compare", "hole", "region" or the operation name
+    uint64_t startMicros;
+    uint64_t durationMicros;
+    uintptr_t address;
+    size_t size;
+};
+
+// Everything recorded for one scanner operation (first scan, filter, group scan, ...)
+struct ScanStats {
+    std::string operation;
+    uint64_t startMicros = 0;
+    uint64_t totalMicros = 0;
+    uint64_t enumerateMicros = 0;
+    uint64_t readMicros = 0;
+    uint64_t compareMicros = 0;
+
+    uint64_t regionsVisited = 0;
+    uint64_t regionsSkipped = 0;
+    uint64_t bytesRequested = 0;
+    uint64_t bytesRead = 0;
+    uint64_t syscalls = 0;
+    uint64_t reads = 0;
+    std::array<uint64_t, kReadFailureKinds> readFailures{};
+    uint64_t bytesRecovered = 0; // read page by page from chunks whose full read failed
+    uint64_t holes = 0;          // unreadable page ranges inside readable regions
+    uint64_t holeBytes = 0;
+    uint64_t knownHoleBytes = 0; // part of holeBytes skipped through the bad-range cache
+    uint64_t matches = 0;
+    size_t peakBufferBytes = 0; // largest working buffer the scanner held at once
+
+    std::vector<RegionStats> regions;
+    std::vector<TraceSpan> spans; // only filled while tracing is enabled
+
+    uint64_t failedReads() const;
+};
+
+// Collects ScanStats while an operation runs. Nested operations (a scan calling another
+// scan) are folded into the outermost one; reads outside any operation are not recorded.
+class ScanRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void setTraceEnabled(bool enabled) { m_traceEnabled = enabled; }
+    bool traceEnabled() const { return m_traceEnabled; }
+
+    void beginOperation(const char* name);
+    void endOperation();
+    bool active() const { return m_depth > 0; }
+
+    void recordEnumeration(Clock::time_point start, size_t regionsFound);
+    void beginRegion(uintptr_t baseAddress, size_t size);
+    void skipRegion();
+    void endRegion();
+
+    void recordSyscall(uint64_t count = 1) { if (active()) m_stats.syscalls += count; }
+    // One remote read, read == requested means success (reason is ignored then)
+    void recordRead(uintptr_t address, size_t requested, size_t read, ReadFailure reason, Clock::time_point start);
+    // A read that ran asynchronously between start and end
+    void recordRead(uintptr_t address, size_t requested, size_t read, ReadFailure reason,
+                    Clock::time_point start, Clock::time_point end);
+    void recordCompare(uintptr_t address, size_t size, Clock::time_point start, uint64_t matches);
+    void recordMatches(uint64_t matches);
+    // Pages of a partly unreadable chunk: read after all, or left out (known: skipped
+    // without a read because an earlier scan found them unreadable)
+    void recordRecovered(size_t bytes);
+    void recordHole(uintptr_t address, size_t size, bool known);
+    void recordBuffer(size_t bytes);
+
+    const ScanStats& stats() const { return m_stats; }
+    const std::vector<ScanStats>& traceLog() const { return m_log; }
+    void clearTraceLog() { m_log.clear(); }
+
+private:
+    ScanStats m_stats;
+    std::vector<ScanStats> m_log;
+    RegionStats* m_region = nullptr;
+    Clock::time_point m_regionStart;
+    Clock::time_point m_operationStart;
+    int m_depth = 0;
+    bool m_traceEnabled = false;
+
+    uint64_t micros(Clock::time_point time) const;
+    void addSpan(const char* name, Clock::time_point start, Clock::time_point end, uintptr_t address, size_t size);
+};
+
+// Marks one scanner operation for the lifetime of the scope
+class ScanOperationScope {
+public:
+    ScanOperationScope(ScanRecorder& recorder, const char* name) : m_recorder(recorder) { m_recorder.beginOperation(name); }
+    ~ScanOperationScope() { m_recorder.endOperation(); }
+
+    ScanOperationScope(const ScanOperationScope&) = delete;
+    ScanOperationScope& operator=(const ScanOperationScope&) = delete;
+
+private:
+    ScanRecorder& m_recorder;
+};
+
+// Human readable summary for the console, including the slowest regions
+std::string formatScanStats(const ScanStats& stats, size_t topRegions = 5);
+
+// Write operations as Chrome trace-event JSON (chrome://tracing, Perfetto).
+// Every operation becomes one span, its regions, reads and compares nested spans.
+bool writeChromeTrace(const std::vector<ScanStats>& operations, const std::string& path);
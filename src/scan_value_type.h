@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+
+// Scan value types shared by the scanner frontends
+enum class ScanValueType {
+    INT32,
+    INT64,
+    FLOAT,
+    DOUBLE,
+    STRING_ASCII,
+    STRING_UNICODE,
+    // The numeric types stored big-endian (emulated consoles, network buffers)
+    INT32_BE,
+    INT64_BE,
+    FLOAT_BE,
+    DOUBLE_BE
+};
+
+// Short display name of a scan value type ("INT32", "ASCII", ...)
+inline const char* scanValueTypeName(ScanValueType type) {
+    switch (type) {
+        case ScanValueType::INT32: return "INT32";
+        case ScanValueType::INT64: return "INT64";
+        case ScanValueType::FLOAT: return "FLOAT";
+        case ScanValueType::DOUBLE: return "DOUBLE";
+        case ScanValueType::STRING_ASCII: return "ASCII";
+        case ScanValueType::STRING_UNICODE: return "UNICODE";
+        case ScanValueType::INT32_BE: return "INT32 BE";
+        case ScanValueType::INT64_BE: return "INT64 BE";
+        case ScanValueType::FLOAT_BE: return "FLOAT BE";
+        case ScanValueType::DOUBLE_BE: return "DOUBLE BE";
+    }
+    return "NUMERIC";
+}
+
+// Byte width of a numeric scan value type (0 for strings, their width depends on the needle)
+inline size_t scanValueTypeSize(ScanValueType type) {
+    switch (type) {
+        case ScanValueType::INT32: case ScanValueType::INT32_BE: return 4;
+        case ScanValueType::INT64: case ScanValueType::INT64_BE: return 8;
+        case ScanValueType::FLOAT: case ScanValueType::FLOAT_BE: return 4;
+        case ScanValueType::DOUBLE: case ScanValueType::DOUBLE_BE: return 8;
+        default: return 0;
+    }
+}
+
+inline bool isStringScanValueType(ScanValueType type) {
+    return type == ScanValueType::STRING_ASCII || type == ScanValueType::STRING_UNICODE;
+}
+
+// Big-endian types hold their values byte-swapped relative to the host (always
+// little-endian where the scanner runs)
+inline bool isBigEndianScanValueType(ScanValueType type) {
+    return type == ScanValueType::INT32_BE || type == ScanValueType::INT64_BE ||
+           type == ScanValueType::FLOAT_BE || type == ScanValueType::DOUBLE_BE;
+}
+
+// The host-order type with the same width and meaning (the type itself if it is not big-endian)
+inline ScanValueType nativeScanValueType(ScanValueType type) {
+    switch (type) {
+        case ScanValueType::INT32_BE: return ScanValueType::INT32;
+        case ScanValueType::INT64_BE: return ScanValueType::INT64;
+        case ScanValueType::FLOAT_BE: return ScanValueType::FLOAT;
+        case ScanValueType::DOUBLE_BE: return ScanValueType::DOUBLE;
+        default: return type;
+    }
+}
+
+// The big-endian variant of a numeric type, strings stay as they are
+inline ScanValueType bigEndianScanValueType(ScanValueType type) {
+    switch (type) {
+        case ScanValueType::INT32: return ScanValueType::INT32_BE;
+        case ScanValueType::INT64: return ScanValueType::INT64_BE;
+        case ScanValueType::FLOAT: return ScanValueType::FLOAT_BE;
+        case ScanValueType::DOUBLE: return ScanValueType::DOUBLE_BE;
+        default: return type;
+    }
+}
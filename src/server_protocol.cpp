@@ -0,0 +1,256 @@
+#include "server_protocol.h"
+#include "value_format.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+void skipSpace(std::string_view text, size_t& pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) pos++;
+}
+
+void appendUtf8(std::string& out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+// Unquoted values may only be numbers or literals, ids are echoed back verbatim
+bool isScalarToken(const std::string& token) {
+    if (token == "true" || token == "false" || token == "null") return true;
+    if (token.empty()) return false;
+    for (char c : token) {
+        if (!(c >= '0' && c <= '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') return false;
+    }
+    return true;
+}
+
+// Quoted string starting at text[pos] == '"'
+bool parseString(std::string_view text, size_t& pos, std::string& out) {
+    pos++;
+    while (pos < text.size()) {
+        char c = text[pos++];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out.push_back(c);
+            continue;
+        }
+        if (pos >= text.size()) return false;
+        char escape = text[pos++];
+        switch (escape) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                if (pos + 4 > text.size()) return false;
+                char hex[5] = { text[pos], text[pos + 1], text[pos + 2], text[pos + 3], 0 };
+                char* end = nullptr;
+                uint32_t codepoint = static_cast<uint32_t>(std::strtoul(hex, &end, 16));
+                if (end != hex + 4) return false;
+                appendUtf8(out, codepoint);
+                pos += 4;
+                break;
+            }
+            default: return false;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool JsonRequest::parse(std::string_view line, std::string& error) {
+    m_values.clear();
+    m_id = "null";
+
+    size_t pos = 0;
+    skipSpace(line, pos);
+    if (pos >= line.size() || line[pos] != '{') {
+        error = "expected a JSON object";
+        return false;
+    }
+    pos++;
+    skipSpace(line, pos);
+    if (pos < line.size() && line[pos] == '}') return true;
+
+    while (pos < line.size()) {
+        std::string key;
+        skipSpace(line, pos);
+        if (pos >= line.size() || line[pos] != '"' || !parseString(line, pos, key)) {
+            error = "expected a quoted key";
+            return false;
+        }
+        skipSpace(line, pos);
+        if (pos >= line.size() || line[pos] != ':') {
+            error = "expected ':' after \"" + key + "\"";
+            return false;
+        }
+        pos++;
+        skipSpace(line, pos);
+
+        std::string value;
+        std::string rawToken;
+        if (pos < line.size() && line[pos] == '"') {
+            size_t start = pos;
+            if (!parseString(line, pos, value)) {
+                error = "unterminated string for \"" + key + "\"";
+                return false;
+            }
+            rawToken = std::string(line.substr(start, pos - start));
+        } else {
+            // Numbers, true, false, null
+            size_t start = pos;
+            while (pos < line.size() && line[pos] != ',' && line[pos] != '}' && line[pos] != ' ' && line[pos] != '\t') pos++;
+            value = std::string(line.substr(start, pos - start));
+            if (!isScalarToken(value)) {
+                error = "unsupported value for \"" + key + "\" (only flat objects)";
+                return false;
+            }
+            rawToken = value;
+        }
+        if (key == "id") m_id = rawToken;
+        m_values[key] = std::move(value);
+
+        skipSpace(line, pos);
+        if (pos < line.size() && line[pos] == ',') {
+            pos++;
+            continue;
+        }
+        if (pos < line.size() && line[pos] == '}') return true;
+        error = "expected ',' or '}'";
+        return false;
+    }
+
+    error = "unterminated object";
+    return false;
+}
+
+std::string JsonRequest::getString(const std::string& key, const std::string& fallback) const {
+    auto it = m_values.find(key);
+    return it == m_values.end() ? fallback : it->second;
+}
+
+int64_t JsonRequest::getInt(const std::string& key, int64_t fallback) const {
+    auto it = m_values.find(key);
+    if (it == m_values.end()) return fallback;
+    char* end = nullptr;
+    long long value = std::strtoll(it->second.c_str(), &end, 0);
+    return end == it->second.c_str() ? fallback : value;
+}
+
+bool JsonRequest::getBool(const std::string& key, bool fallback) const {
+    auto it = m_values.find(key);
+    if (it == m_values.end()) return fallback;
+    if (it->second == "true" || it->second == "1") return true;
+    if (it->second == "false" || it->second == "0") return false;
+    return fallback;
+}
+
+bool JsonRequest::getAddress(const std::string& key, uintptr_t& out) const {
+    auto it = m_values.find(key);
+    if (it == m_values.end() || it->second.empty()) return false;
+    char* end = nullptr;
+    // Base 0: "0x..." is hex, plain digits decimal
+    unsigned long long value = std::strtoull(it->second.c_str(), &end, 0);
+    if (*end != '\0') return false;
+    out = static_cast<uintptr_t>(value);
+    return true;
+}
+
+void appendJsonString(std::string& out, std::string_view text) {
+    out.push_back('"');
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    out += escaped;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+JsonLine::JsonLine(const std::string& id) {
+    m_out = "{\"id\":" + id;
+}
+
+void JsonLine::key(std::string_view name) {
+    m_out.push_back(',');
+    appendJsonString(m_out, name);
+    m_out.push_back(':');
+}
+
+JsonLine& JsonLine::text(std::string_view key, std::string_view value) {
+    this->key(key);
+    appendJsonString(m_out, value);
+    return *this;
+}
+
+JsonLine& JsonLine::number(std::string_view key, int64_t value) {
+    this->key(key);
+    m_out += std::to_string(value);
+    return *this;
+}
+
+JsonLine& JsonLine::real(std::string_view key, double value) {
+    this->key(key);
+    // JSON has no nan or inf. Huge magnitudes switch to exponent notation, in fixed
+    // notation they would be cut off by the buffer.
+    if (!std::isfinite(value)) {
+        m_out += "null";
+        return *this;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), std::fabs(value) < 1e15 ? "%.3f" : "%.17g", value);
+    m_out += buffer;
+    return *this;
+}
+
+JsonLine& JsonLine::flag(std::string_view key, bool value) {
+    this->key(key);
+    m_out += value ? "true" : "false";
+    return *this;
+}
+
+JsonLine& JsonLine::address(std::string_view key, uintptr_t value) {
+    this->key(key);
+    char buffer[20];
+    size_t length = formatHexAddress(value, buffer);
+    m_out.push_back('"');
+    m_out.append(buffer, length);
+    m_out.push_back('"');
+    return *this;
+}
+
+JsonLine& JsonLine::raw(std::string_view key, std::string_view json) {
+    this->key(key);
+    m_out += json;
+    return *this;
+}
+
+std::string JsonLine::finish() {
+    m_out += "}\n";
+    return std::move(m_out);
+}
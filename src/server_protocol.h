@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+// JSON-lines protocol of the scan server: every request and every response is one
+// JSON object on one line. Requests are flat, their values are strings, numbers,
+// booleans or null. Addresses travel as "0x..." strings (JSON numbers lose precision
+// above 2^53).
+
+// One parsed request line
+class JsonRequest {
+public:
+    // Parse one line. Returns false and sets error if it is not a flat JSON object.
+    bool parse(std::string_view line, std::string& error);
+
+    bool has(const std::string& key) const { return m_values.count(key) != 0; }
+    std::string getString(const std::string& key, const std::string& fallback = {}) const;
+    int64_t getInt(const std::string& key, int64_t fallback = 0) const;
+    bool getBool(const std::string& key, bool fallback = false) const;
+
+    // Accepts "0x..." strings and plain numbers
+    bool getAddress(const std::string& key, uintptr_t& out) const;
+
+    // Echoed in every response, so clients can pipeline requests
+    const std::string& id() const { return m_id; }
+
+private:
+    std::map<std::string, std::string> m_values; // strings unescaped, other values as their raw token
+    std::string m_id = "null";                   // raw JSON token of "id"
+};
+
+// Append text as a quoted JSON string
+void appendJsonString(std::string& out, std::string_view text);
+
+// Builds one response line
+class JsonLine {
+public:
+    explicit JsonLine(const std::string& id);
+
+    JsonLine& text(std::string_view key, std::string_view value);
+    JsonLine& number(std::string_view key, int64_t value);
+    // Three decimals, null for nan and infinities
+    JsonLine& real(std::string_view key, double value);
+    JsonLine& flag(std::string_view key, bool value);
+    JsonLine& address(std::string_view key, uintptr_t value);
+    // Already encoded JSON (arrays, nested objects)
+    JsonLine& raw(std::string_view key, std::string_view json);
+
+    // The finished object including the trailing newline
+    std::string finish();
+
+private:
+    std::string m_out;
+
+    void key(std::string_view name);
+};
@@ -0,0 +1,574 @@
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "time_series.h"
+#include "result_spill.h"
+#include "scan_kernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char kFileMagic[4] = { 'M', 'S', 'T', 'S' };
+constexpr char kChunkMagic[4] = { 'T', 'S', 'C', 'K' };
+constexpr char kIndexMagic[4] = { 'T', 'S', 'I', 'X' };
+constexpr uint32_t kFormatVersion = 1;
+// Changes are tracked in units of this many bytes
+constexpr size_t kUnit = 4;
+// magic, payload size, samples, first and last time
+constexpr size_t kChunkHeaderSize = 4 + 4 + 4 + 8 + 8;
+// offset, first and last time, samples
+constexpr size_t kIndexEntrySize = 8 + 8 + 8 + 4;
+// index offset, chunk count, magic
+constexpr size_t kTrailerSize = 8 + 4 + 4;
+
+template<typename T>
+void appendField(std::vector<uint8_t>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(&out[at], &value, sizeof(T));
+}
+
+void appendMagic(std::vector<uint8_t>& out, const char (&magic)[4]) {
+    size_t at = out.size();
+    out.resize(at + 4);
+    std::memcpy(&out[at], magic, 4);
+}
+
+template<typename T>
+T loadField(const uint8_t*& pos) {
+    T value;
+    std::memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+bool readExact(std::ifstream& file, uint64_t offset, size_t size, std::vector<uint8_t>& out) {
+    out.resize(size);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(size));
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+TimeSeriesRecorder::TimeSeriesRecorder(MemoryScanner& scanner) : m_scanner(scanner) {}
+
+TimeSeriesRecorder::~TimeSeriesRecorder() {
+    stop();
+}
+
+bool TimeSeriesRecorder::addRange(uintptr_t address, size_t size) {
+    if (m_running || size == 0) return false;
+    size_t total = 0;
+    for (const auto& range : m_ranges) total += range.size;
+    if (size > kMaxRecordedBytes - total) return false;
+    m_ranges.push_back({ address, size, 0 });
+    return true;
+}
+
+void TimeSeriesRecorder::clear() {
+    if (!m_running) m_ranges.clear();
+}
+
+bool TimeSeriesRecorder::start(const std::filesystem::path& path, std::chrono::microseconds interval, ScanValueType type,
+                               std::string& error) {
+    if (m_running) {
+        error = "already recording";
+        return false;
+    }
+    if (m_ranges.empty()) {
+        error = "nothing to record";
+        return false;
+    }
+
+    // Overlapping and adjacent ranges become one, every sample is read with one batch
+    std::ranges::sort(m_ranges, {}, &RecordedRange::address);
+    std::vector<RecordedRange> merged;
+    for (const auto& range : m_ranges) {
+        if (!merged.empty() && range.address <= merged.back().address + merged.back().size) {
+            auto& last = merged.back();
+            last.size = std::max(last.size, static_cast<size_t>(range.address + range.size - last.address));
+        } else {
+            merged.push_back(range);
+        }
+    }
+    m_ranges = std::move(merged);
+    m_bytes = 0;
+    for (auto& range : m_ranges) {
+        range.offset = m_bytes;
+        m_bytes += range.size;
+    }
+    m_bytes = (m_bytes + kUnit - 1) / kUnit * kUnit;
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) {
+        error = "cannot create " + path.string();
+        return false;
+    }
+
+    std::vector<uint8_t> header;
+    appendMagic(header, kFileMagic);
+    appendField<uint32_t>(header, kFormatVersion);
+    appendField<uint32_t>(header, static_cast<uint32_t>(type));
+    appendField<uint32_t>(header, static_cast<uint32_t>(m_ranges.size()));
+    appendField<uint64_t>(header, static_cast<uint64_t>(interval.count()));
+    appendField<uint64_t>(header, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+    for (const auto& range : m_ranges) {
+        appendField<uint64_t>(header, range.address);
+        appendField<uint32_t>(header, static_cast<uint32_t>(range.size));
+    }
+    m_file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    if (!m_file) {
+        error = "cannot write " + path.string();
+        m_file.close();
+        return false;
+    }
+
+    m_previous.assign(m_bytes, 0);
+    m_current.assign(m_bytes, 0);
+    m_chunk.clear();
+    m_index.clear();
+    m_chunkSamples = 0;
+    m_interval = std::max(interval, std::chrono::microseconds(1));
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats = RecordingStats();
+        m_stats.bytesWritten = header.size();
+    }
+
+    m_stopRequested = false;
+    m_running = true;
+    m_thread = std::thread(&TimeSeriesRecorder::run, this);
+    return true;
+}
+
+void TimeSeriesRecorder::stop() {
+    if (!m_running) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+    m_running = false;
+}
+
+RecordingStats TimeSeriesRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void TimeSeriesRecorder::run() {
+    // Every range reads straight into its part of the sample buffer
+    std::vector<MemoryIoRequest> requests(m_ranges.size());
+    for (size_t i = 0; i < m_ranges.size(); i++) {
+        requests[i] = { m_ranges[i].address, &m_current[m_ranges[i].offset], m_ranges[i].size, false };
+    }
+
+    const auto start = Clock::now();
+    auto due = start;
+    bool ok = true;
+    while (ok) {
+        // A sample is stamped with the time its read started
+        auto taken = Clock::now();
+        for (auto& request : requests) request.success = false;
+        m_scanner.readMemoryBatch(requests);
+        encodeSample(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(taken - start).count()),
+                     requests);
+        if (m_chunkSamples >= kTimeSeriesChunkSamples || m_chunk.size() >= kTimeSeriesChunkBytes) ok = flushChunk();
+
+        // Fixed rate: a late sample does not shift the ones after it
+        due += m_interval;
+        auto now = Clock::now();
+        if (due <= now) {
+            due = now;
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.lateSamples++;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_wakeup.wait_until(lock, due, [this] { return m_stopRequested; })) break;
+    }
+
+    ok = ok && flushChunk() && writeIndex();
+    m_file.close();
+    if (!ok) {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.failed = true;
+    }
+}
+
+void TimeSeriesRecorder::encodeSample(uint64_t timeUs, const std::vector<MemoryIoRequest>& requests) {
+    // The first sample of a chunk is encoded against zeros
+    if (m_chunkSamples == 0) {
+        std::fill(m_previous.begin(), m_previous.end(), uint8_t{0});
+        m_chunkFirstUs = timeUs;
+        m_lastUs = timeUs;
+    }
+
+    // A failed range keeps its previous bytes and is listed as failed
+    m_failed.clear();
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].success) continue;
+        const RecordedRange& range = m_ranges[i];
+        std::memcpy(&m_current[range.offset], &m_previous[range.offset], range.size);
+        m_failed.push_back(static_cast<uint32_t>(i));
+    }
+
+    appendVarint(m_chunk, timeUs - m_lastUs);
+    appendVarint(m_chunk, m_failed.size());
+    uint32_t previousFailed = 0;
+    for (uint32_t index : m_failed) {
+        appendVarint(m_chunk, index - previousFailed);
+        previousFailed = index;
+    }
+
+    // Runs of changed units, found 16 bytes at a time
+    std::vector<std::pair<size_t, size_t>> runs;
+    forEachChangedSlot(m_previous.data(), m_current.data(), m_bytes / kUnit, kUnit, [&](size_t unit) {
+        if (!runs.empty() && runs.back().first + runs.back().second == unit) runs.back().second++;
+        else runs.push_back({ unit, 1 });
+    });
+    appendVarint(m_chunk, runs.size());
+    size_t end = 0;
+    for (const auto& [first, units] : runs) {
+        appendVarint(m_chunk, first - end);
+        appendVarint(m_chunk, units);
+        const uint8_t* bytes = &m_current[first * kUnit];
+        m_chunk.insert(m_chunk.end(), bytes, bytes + units * kUnit);
+        std::memcpy(&m_previous[first * kUnit], bytes, units * kUnit);
+        end = first + units;
+    }
+
+    m_chunkSamples++;
+    m_lastUs = timeUs;
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.samples++;
+    m_stats.failedReads += m_failed.size();
+}
+
+bool TimeSeriesRecorder::flushChunk() {
+    if (m_chunkSamples == 0) return true;
+
+    uint64_t offset;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        offset = m_stats.bytesWritten;
+    }
+    std::vector<uint8_t> header;
+    appendMagic(header, kChunkMagic);
+    appendField<uint32_t>(header, static_cast<uint32_t>(m_chunk.size()));
+    appendField<uint32_t>(header, m_chunkSamples);
+    appendField<uint64_t>(header, m_chunkFirstUs);
+    appendField<uint64_t>(header, m_lastUs);
+    m_file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    m_file.write(reinterpret_cast<const char*>(m_chunk.data()), static_cast<std::streamsize>(m_chunk.size()));
+
+    appendField<uint64_t>(m_index, offset);
+    appendField<uint64_t>(m_index, m_chunkFirstUs);
+    appendField<uint64_t>(m_index, m_lastUs);
+    appendField<uint32_t>(m_index, m_chunkSamples);
+
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.bytesWritten += header.size() + m_chunk.size();
+        m_stats.chunks++;
+    }
+    m_chunk.clear();
+    m_chunkSamples = 0;
+    // Readers of a recording in progress see every finished chunk
+    m_file.flush();
+    return static_cast<bool>(m_file);
+}
+
+bool TimeSeriesRecorder::writeIndex() {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    appendField<uint64_t>(m_index, m_stats.bytesWritten);
+    appendField<uint32_t>(m_index, m_stats.chunks);
+    appendMagic(m_index, kIndexMagic);
+    m_file.write(reinterpret_cast<const char*>(m_index.data()), static_cast<std::streamsize>(m_index.size()));
+    m_stats.bytesWritten += m_index.size();
+    return static_cast<bool>(m_file);
+}
+
+bool TimeSeriesReader::open(const std::filesystem::path& path, std::string& error) {
+    m_file.close();
+    m_ranges.clear();
+    m_chunks.clear();
+    m_chunk = SIZE_MAX;
+
+    std::error_code sizeError;
+    uint64_t fileSize = std::filesystem::file_size(path, sizeError);
+    m_file.open(path, std::ios::binary);
+    if (sizeError || !m_file.is_open()) {
+        error = "cannot open " + path.string();
+        return false;
+    }
+    m_fileSize = fileSize;
+    if (!readHeader(error)) return false;
+    if (!readIndex(fileSize)) scanChunks(fileSize);
+    return true;
+}
+
+bool TimeSeriesReader::readHeader(std::string& error) {
+    std::vector<uint8_t> bytes;
+    if (!readExact(m_file, 0, 4 + 4 + 4 + 4 + 8 + 8, bytes) || std::memcmp(bytes.data(), kFileMagic, 4) != 0) {
+        error = "not a recording";
+        return false;
+    }
+    const uint8_t* pos = bytes.data() + 4;
+    uint32_t version = loadField<uint32_t>(pos);
+    uint32_t type = loadField<uint32_t>(pos);
+    uint32_t rangeCount = loadField<uint32_t>(pos);
+    m_interval = std::chrono::microseconds(loadField<uint64_t>(pos));
+    if (version != kFormatVersion || type > static_cast<uint32_t>(ScanValueType::DOUBLE_BE)) {
+        error = "unsupported recording version";
+        return false;
+    }
+    m_type = static_cast<ScanValueType>(type);
+
+    // The range count comes from the file: it must fit the file before anything is allocated
+    const uint64_t rangesOffset = bytes.size();
+    if (uint64_t(rangeCount) * 12 > m_fileSize - std::min(m_fileSize, rangesOffset) ||
+        !readExact(m_file, rangesOffset, size_t(rangeCount) * 12, bytes)) {
+        error = "truncated recording header";
+        return false;
+    }
+    pos = bytes.data();
+    m_bytes = 0;
+    for (uint32_t i = 0; i < rangeCount; i++) {
+        uintptr_t address = static_cast<uintptr_t>(loadField<uint64_t>(pos));
+        size_t size = loadField<uint32_t>(pos);
+        // The recorder never writes more, and each sample allocates this much state
+        if (size > kMaxRecordedBytes - m_bytes) {
+            m_ranges.clear();
+            error = "recorded ranges too large";
+            return false;
+        }
+        m_ranges.push_back({ address, size, m_bytes });
+        m_bytes += size;
+    }
+    m_bytes = (m_bytes + kUnit - 1) / kUnit * kUnit;
+    m_headerSize = rangesOffset + bytes.size();
+    return true;
+}
+
+bool TimeSeriesReader::readIndex(uint64_t fileSize) {
+    std::vector<uint8_t> bytes;
+    if (fileSize < m_headerSize + kTrailerSize || !readExact(m_file, fileSize - kTrailerSize, kTrailerSize, bytes)) return false;
+    const uint8_t* pos = bytes.data();
+    uint64_t indexOffset = loadField<uint64_t>(pos);
+    uint32_t count = loadField<uint32_t>(pos);
+    if (std::memcmp(pos, kIndexMagic, 4) != 0 || indexOffset < m_headerSize ||
+        indexOffset + uint64_t(count) * kIndexEntrySize != fileSize - kTrailerSize) {
+        return false;
+    }
+
+    if (!readExact(m_file, indexOffset, size_t(count) * kIndexEntrySize, bytes)) return false;
+    pos = bytes.data();
+    for (uint32_t i = 0; i < count; i++) {
+        Chunk chunk;
+        chunk.offset = loadField<uint64_t>(pos);
+        chunk.firstUs = loadField<uint64_t>(pos);
+        chunk.lastUs = loadField<uint64_t>(pos);
+        chunk.samples = loadField<uint32_t>(pos);
+        m_chunks.push_back(chunk);
+    }
+    return true;
+}
+
+void TimeSeriesReader::scanChunks(uint64_t fileSize) {
+    // No index (recording still running or interrupted): walk the chunk headers, a chunk
+    // cut off at the end of the file is left out
+    std::vector<uint8_t> bytes;
+    uint64_t offset = m_headerSize;
+    while (offset + kChunkHeaderSize <= fileSize && readExact(m_file, offset, kChunkHeaderSize, bytes) &&
+           std::memcmp(bytes.data(), kChunkMagic, 4) == 0) {
+        const uint8_t* pos = bytes.data() + 4;
+        uint32_t payload = loadField<uint32_t>(pos);
+        Chunk chunk;
+        chunk.offset = offset;
+        chunk.samples = loadField<uint32_t>(pos);
+        chunk.firstUs = loadField<uint64_t>(pos);
+        chunk.lastUs = loadField<uint64_t>(pos);
+        if (offset + kChunkHeaderSize + payload > fileSize) break;
+        m_chunks.push_back(chunk);
+        offset += kChunkHeaderSize + payload;
+    }
+}
+
+uint64_t TimeSeriesReader::samples() const {
+    uint64_t total = 0;
+    for (const auto& chunk : m_chunks) total += chunk.samples;
+    return total;
+}
+
+bool TimeSeriesReader::loadChunk(size_t chunk) {
+    m_chunk = SIZE_MAX;
+    std::vector<uint8_t> header;
+    if (!readExact(m_file, m_chunks[chunk].offset, kChunkHeaderSize, header) ||
+        std::memcmp(header.data(), kChunkMagic, 4) != 0) {
+        return false;
+    }
+    const uint8_t* pos = header.data() + 4;
+    uint32_t payload = loadField<uint32_t>(pos);
+    if (m_chunks[chunk].offset + kChunkHeaderSize + payload > m_fileSize ||
+        !readExact(m_file, m_chunks[chunk].offset + kChunkHeaderSize, payload, m_payload)) {
+        return false;
+    }
+
+    m_chunk = chunk;
+    m_sample = 0;
+    m_position = 0;
+    m_timeUs = m_chunks[chunk].firstUs;
+    m_state.assign(m_bytes, 0);
+    m_failed.assign(m_ranges.size(), 0);
+    return true;
+}
+
+bool TimeSeriesReader::decodeSample() {
+    const uint8_t* pos = m_payload.data() + m_position;
+    const uint8_t* end = m_payload.data() + m_payload.size();
+    uint64_t delta, failed, runs;
+    if (!readVarint(pos, end, delta) || !readVarint(pos, end, failed) || failed > m_ranges.size()) return false;
+
+    std::fill(m_failed.begin(), m_failed.end(), uint8_t{0});
+    uint64_t index = 0;
+    for (uint64_t i = 0; i < failed; i++) {
+        uint64_t step;
+        if (!readVarint(pos, end, step) || (index += step) >= m_ranges.size()) return false;
+        m_failed[index] = 1;
+    }
+
+    if (!readVarint(pos, end, runs)) return false;
+    uint64_t unit = 0;
+    for (uint64_t i = 0; i < runs; i++) {
+        uint64_t gap, units;
+        if (!readVarint(pos, end, gap) || !readVarint(pos, end, units)) return false;
+        unit += gap;
+        if (unit + units > m_bytes / kUnit || units * kUnit > static_cast<uint64_t>(end - pos)) return false;
+        std::memcpy(&m_state[unit * kUnit], pos, units * kUnit);
+        pos += units * kUnit;
+        unit += units;
+    }
+
+    m_position = pos - m_payload.data();
+    m_timeUs += delta;
+    m_sample++;
+    return true;
+}
+
+bool TimeSeriesReader::next() {
+    if (m_chunk != SIZE_MAX && m_sample < m_chunks[m_chunk].samples) return decodeSample();
+    size_t chunk = m_chunk == SIZE_MAX ? 0 : m_chunk + 1;
+    return chunk < m_chunks.size() && loadChunk(chunk) && decodeSample();
+}
+
+bool TimeSeriesReader::seek(uint64_t timeUs) {
+    auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), timeUs, [](uint64_t value, const Chunk& chunk) {
+        return value < chunk.firstUs;
+    });
+    if (it == m_chunks.begin()) return false;
+    size_t chunk = static_cast<size_t>(it - m_chunks.begin()) - 1;
+
+    // Keep decoding forward from the cursor when it is in the same chunk and not past timeUs
+    if (chunk != m_chunk || m_sample == 0 || m_timeUs > timeUs) {
+        if (!loadChunk(chunk) || !decodeSample()) return false;
+    }
+    while (m_sample < m_chunks[chunk].samples) {
+        const uint8_t* pos = m_payload.data() + m_position;
+        uint64_t delta;
+        if (!readVarint(pos, m_payload.data() + m_payload.size(), delta) || m_timeUs + delta > timeUs) break;
+        if (!decodeSample()) return false;
+    }
+    return true;
+}
+
+const RecordedRange* TimeSeriesReader::rangeOf(uintptr_t address, size_t size) const {
+    auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), address, [](uintptr_t value, const RecordedRange& range) {
+        return value < range.address;
+    });
+    if (it == m_ranges.begin()) return nullptr;
+    --it;
+    return address - it->address <= it->size && size <= it->size - (address - it->address) ? &*it : nullptr;
+}
+
+bool TimeSeriesReader::current(uintptr_t address, void* out, size_t size) const {
+    const RecordedRange* range = rangeOf(address, size);
+    if (!range || m_failed[range - m_ranges.data()]) return false;
+    std::memcpy(out, &m_state[range->offset + (address - range->address)], size);
+    return true;
+}
+
+bool TimeSeriesReader::valueAt(uintptr_t address, void* out, size_t size, uint64_t timeUs) {
+    return rangeOf(address, size) && seek(timeUs) && current(address, out, size);
+}
+
+bool TimeSeriesReader::changes(uintptr_t address, size_t size, uint64_t fromUs, uint64_t toUs,
+                               const std::function<bool(uint64_t timeUs, const uint8_t* bytes)>& onChange) {
+    if (!rangeOf(address, size)) return false;
+
+    // Start at the sample in effect at fromUs, or at the first one if fromUs is before it
+    bool positioned = seek(fromUs);
+    if (!positioned) {
+        m_chunk = SIZE_MAX;
+        positioned = next();
+    }
+
+    std::vector<uint8_t> last(size), now(size);
+    bool seen = false;
+    while (positioned && m_timeUs <= toUs) {
+        if (current(address, now.data(), size) && (!seen || now != last)) {
+            if (!onChange(std::max(m_timeUs, fromUs), now.data())) break;
+            last.swap(now);
+            seen = true;
+        }
+        positioned = next();
+    }
+    return true;
+}
+
+std::vector<uintptr_t> TimeSeriesReader::replayFilter(const std::vector<uintptr_t>& addresses, const FilterExpression& expression,
+                                                      const std::vector<uint64_t>& times) {
+    const size_t width = scanValueTypeSize(expression.type());
+    std::vector<uintptr_t> survivors;
+    if (width == 0 || times.empty() || !seek(times[0])) return survivors;
+
+    // First scan: every address readable at times[0]
+    std::vector<uint8_t> first, old;
+    first.resize(addresses.size() * width);
+    for (uintptr_t address : addresses) {
+        if (current(address, &first[survivors.size() * width], width)) survivors.push_back(address);
+    }
+    first.resize(survivors.size() * width);
+    old = first;
+
+    std::vector<uint8_t> values, keep;
+    for (size_t step = 1; step < times.size() && !survivors.empty(); step++) {
+        if (!seek(times[step])) break;
+        const size_t count = survivors.size();
+        values.resize(count * width);
+        keep.resize(count);
+        for (size_t i = 0; i < count; i++) keep[i] = current(survivors[i], &values[i * width], width);
+        std::vector<uint8_t> readable = keep;
+        expression.evaluate(values.data(), old.data(), first.data(), count, keep.data());
+
+        // Compact like a live filter: survivors keep their first value, their old value
+        // becomes the one just read
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!keep[i] || !readable[i]) continue;
+            survivors[kept] = survivors[i];
+            std::memmove(&first[kept * width], &first[i * width], width);
+            std::memcpy(&old[kept * width], &values[i * width], width);
+            kept++;
+        }
+        survivors.resize(kept);
+        first.resize(kept * width);
+        old.resize(kept * width);
+    }
+    return survivors;
+}
+#endif
@@ -0,0 +1,186 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "filter_expression.h"
+#include "memory_scanner.h"
+#include "scan_value_type.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Samples per chunk; every chunk starts from scratch, so a lookup decodes at most this many
+constexpr uint32_t kTimeSeriesChunkSamples = 1024;
+// A chunk is also closed once its encoded samples reach this size
+constexpr size_t kTimeSeriesChunkBytes = 1024 * 1024;
+// Bytes one recording may sample per round
+constexpr size_t kMaxRecordedBytes = 64 * 1024 * 1024;
+
+// One recorded memory range
+struct RecordedRange {
+    uintptr_t address;
+    size_t size;
+    size_t offset; // of its bytes in a decoded sample
+};
+
+// Counters of a running or finished recording
+struct RecordingStats {
+    uint64_t samples = 0;
+    uint64_t lateSamples = 0;  // started after the next one was already due
+    uint64_t failedReads = 0;  // range reads that failed in some sample
+    uint64_t bytesWritten = 0; // file size so far
+    uint32_t chunks = 0;
+    bool failed = false;       // the file could not be written, recording stopped
+};
+
+// Records how a set of memory ranges evolves: every interval all ranges are read with one
+// batched read, the sample is delta encoded against the previous one and appended to a file.
+//
+// File layout (host byte order):
+//   header   "MSTS", version, value type, range count, interval (us), start (us since epoch),
+//            then address and size of every range
+//   chunks   "TSCK", payload size, samples, first and last time (us since start), payload
+//   index    offset, first and last time and samples of every chunk, then the index offset,
+//            the chunk count and "TSIX" (written by stop(); a reader of a file without one
+//            walks the chunk headers instead)
+//
+// A sample is the time since the previous sample, the ranges that failed to read and the
+// runs of 4-byte units that changed, each as gap, length and the new bytes (varints). The
+// first sample of a chunk is encoded against zeros, so every chunk decodes on its own.
+class TimeSeriesRecorder {
+public:
+    explicit TimeSeriesRecorder(MemoryScanner& scanner);
+    ~TimeSeriesRecorder();
+
+    TimeSeriesRecorder(const TimeSeriesRecorder&) = delete;
+    TimeSeriesRecorder& operator=(const TimeSeriesRecorder&) = delete;
+
+    // Record size bytes at address. Ranges may come in any order, overlapping and adjacent
+    // ones are merged. False while recording or beyond kMaxRecordedBytes.
+    bool addRange(uintptr_t address, size_t size);
+    void clear();
+    size_t rangeCount() const { return m_ranges.size(); }
+
+    // Create path and sample every interval on a thread of its own until stop(). type only
+    // tells readers how to show values. A sample that is late does not shift the later ones.
+    bool start(const std::filesystem::path& path, std::chrono::microseconds interval, ScanValueType type, std::string& error);
+    // Finish the last chunk and write the index
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    RecordingStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    MemoryScanner& m_scanner;
+    std::vector<RecordedRange> m_ranges;
+    size_t m_bytes = 0; // sample size, a multiple of 4
+
+    std::ofstream m_file;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    bool m_stopRequested = false;
+    std::chrono::microseconds m_interval{1000};
+
+    // Owned by the recording thread while it runs
+    std::vector<uint8_t> m_previous;
+    std::vector<uint8_t> m_current;
+    std::vector<uint8_t> m_chunk;     // encoded samples of the open chunk
+    std::vector<uint8_t> m_index;     // index entries of the written chunks
+    std::vector<uint32_t> m_failed;   // ranges that failed in this sample
+    uint32_t m_chunkSamples = 0;
+    uint64_t m_chunkFirstUs = 0;
+    uint64_t m_lastUs = 0;
+
+    mutable std::mutex m_statsMutex;
+    RecordingStats m_stats;
+
+    void run();
+    void encodeSample(uint64_t timeUs, const std::vector<MemoryIoRequest>& requests);
+    bool flushChunk();
+    bool writeIndex();
+};
+
+// Read-only access to a recording, usable without the target. Lookups move a decode cursor
+// through the file: queries in ascending time only decode the samples in between, a query
+// before the cursor restarts at the chunk containing it.
+class TimeSeriesReader {
+public:
+    // Open a recording, false with error set if it is not one
+    bool open(const std::filesystem::path& path, std::string& error);
+
+    const std::vector<RecordedRange>& ranges() const { return m_ranges; }
+    ScanValueType type() const { return m_type; }
+    std::chrono::microseconds interval() const { return m_interval; }
+    uint64_t samples() const;
+    uint64_t durationUs() const { return m_chunks.empty() ? 0 : m_chunks.back().lastUs; }
+    size_t chunks() const { return m_chunks.size(); }
+
+    // size bytes at address as of the last sample at or before timeUs. False if timeUs is
+    // before the first sample, the bytes were not recorded or their range failed to read.
+    bool valueAt(uintptr_t address, void* out, size_t size, uint64_t timeUs);
+
+    // Calls onChange(timeUs, bytes) with the size bytes at address as of the last sample at
+    // or before fromUs and then for every later sample up to toUs in which they differ.
+    // Stops early when onChange returns false. False if the bytes were not recorded.
+    bool changes(uintptr_t address, size_t size, uint64_t fromUs, uint64_t toUs,
+                 const std::function<bool(uint64_t timeUs, const uint8_t* bytes)>& onChange);
+
+    // Replay the recording through a filter the way a session applies it live: the first
+    // scan keeps every address readable at times[0], every later time keeps the survivors
+    // for which expression holds (v = value then, old = value at the time before, first =
+    // value at times[0]). Exact, changed and unchanged filters are "v == x", "v != old" and
+    // "v == old". Values have the width of the expression's type. Times must ascend.
+    std::vector<uintptr_t> replayFilter(const std::vector<uintptr_t>& addresses, const FilterExpression& expression,
+                                        const std::vector<uint64_t>& times);
+
+private:
+    struct Chunk {
+        uint64_t offset;  // of the chunk header
+        uint64_t firstUs;
+        uint64_t lastUs;
+        uint32_t samples;
+    };
+
+    std::ifstream m_file;
+    std::vector<RecordedRange> m_ranges;
+    std::vector<Chunk> m_chunks;
+    ScanValueType m_type = ScanValueType::INT32;
+    std::chrono::microseconds m_interval{0};
+    size_t m_bytes = 0;
+    uint64_t m_headerSize = 0;
+    uint64_t m_fileSize = 0;
+
+    // Decode cursor: the state after sample m_sample of chunk m_chunk
+    size_t m_chunk = SIZE_MAX;
+    uint32_t m_sample = 0;
+    uint64_t m_timeUs = 0;
+    std::vector<uint8_t> m_payload;
+    size_t m_position = 0;
+    std::vector<uint8_t> m_state;
+    std::vector<uint8_t> m_failed; // per range, failed in the current sample
+
+    bool readHeader(std::string& error);
+    bool readIndex(uint64_t fileSize);
+    void scanChunks(uint64_t fileSize);
+    // Move the cursor to the last sample at or before timeUs, false if there is none
+    bool seek(uint64_t timeUs);
+    bool loadChunk(size_t chunk);
+    bool decodeSample();
+    // Advance the cursor one sample, into the next chunk if needed
+    bool next();
+    // Range holding [address, address + size), nullptr if none does
+    const RecordedRange* rangeOf(uintptr_t address, size_t size) const;
+    bool current(uintptr_t address, void* out, size_t size) const;
+};
+#endif
@@ -0,0 +1,181 @@
+#include "value_format.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+size_t appendUtf8(uint32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+template<typename T>
+T loadValue(const uint8_t* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+template<typename T>
+bool parseNumber(std::string_view text, std::vector<uint8_t>& out) {
+    // Tolerate surrounding whitespace and a leading '+' from user input
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r' || text.back() == '\n')) text.remove_suffix(1);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    if (text.empty()) return false;
+
+    T value{};
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) return false;
+
+    out.resize(sizeof(T));
+    std::memcpy(out.data(), &value, sizeof(T));
+    return true;
+}
+
+} // namespace
+
+size_t formatHexAddress(uintptr_t address, char* out) {
+    static const char digits[] = "0123456789ABCDEF";
+    out[0] = '0';
+    out[1] = 'x';
+    for (int i = 0; i < 16; i++) {
+        out[2 + i] = digits[(static_cast<uint64_t>(address) >> ((15 - i) * 4)) & 0xF];
+    }
+    return 18;
+}
+
+size_t formatScanValue(ScanValueType type, const uint8_t* bytes, size_t size, char* out, size_t outSize) {
+    char* end = out + outSize;
+    switch (type) {
+        case ScanValueType::INT32:
+            return std::to_chars(out, end, loadValue<int32_t>(bytes)).ptr - out;
+        case ScanValueType::INT64:
+            return std::to_chars(out, end, loadValue<int64_t>(bytes)).ptr - out;
+        case ScanValueType::FLOAT:
+            return std::to_chars(out, end, loadValue<float>(bytes)).ptr - out;
+        case ScanValueType::DOUBLE:
+            return std::to_chars(out, end, loadValue<double>(bytes)).ptr - out;
+
+        case ScanValueType::INT32_BE: case ScanValueType::INT64_BE:
+        case ScanValueType::FLOAT_BE: case ScanValueType::DOUBLE_BE: {
+            // Reverse into host order and format like the native type
+            uint8_t swapped[8];
+            const size_t width = scanValueTypeSize(type);
+            std::reverse_copy(bytes, bytes + width, swapped);
+            return formatScanValue(nativeScanValueType(type), swapped, width, out, outSize);
+        }
+
+        case ScanValueType::STRING_ASCII: {
+            size_t chars = std::min(size, kMaxDisplayChars);
+            size_t length = 0;
+            for (size_t i = 0; i < chars; i++) {
+                char c = static_cast<char>(bytes[i]);
+                out[length++] = (c >= 0x20 && c < 0x7F) ? c : '.';
+            }
+            if (size > kMaxDisplayChars) {
+                std::memcpy(out + length - 3, "...", 3);
+            }
+            return length;
+        }
+
+        case ScanValueType::STRING_UNICODE: {
+            size_t totalChars = size / sizeof(wchar_t);
+            size_t chars = std::min(totalChars, kMaxDisplayChars);
+            size_t length = 0;
+            for (size_t i = 0; i < chars; i++) {
+                uint32_t cp = static_cast<uint32_t>(loadValue<wchar_t>(bytes + i * sizeof(wchar_t)));
+                if constexpr (sizeof(wchar_t) == 2) {
+                    // Combine UTF-16 surrogate pairs
+                    if (cp >= 0xD800 && cp < 0xDC00 && i + 1 < chars) {
+                        uint32_t low = static_cast<uint32_t>(loadValue<wchar_t>(bytes + (i + 1) * sizeof(wchar_t)));
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            i++;
+                        }
+                    }
+                }
+                if (cp < 0x20 || (cp >= 0xD800 && cp < 0xE000) || cp > 0x10FFFF) cp = '.';
+                length += appendUtf8(cp, out + length);
+            }
+            if (totalChars > kMaxDisplayChars) {
+                std::memcpy(out + length, "...", 3);
+                length += 3;
+            }
+            return length;
+        }
+    }
+    return 0;
+}
+
+bool parseScanValue(ScanValueType type, std::string_view text, std::vector<uint8_t>& out) {
+    switch (type) {
+        case ScanValueType::INT32: return parseNumber<int32_t>(text, out);
+        case ScanValueType::INT64: return parseNumber<int64_t>(text, out);
+        case ScanValueType::FLOAT: return parseNumber<float>(text, out);
+        case ScanValueType::DOUBLE: return parseNumber<double>(text, out);
+
+        case ScanValueType::INT32_BE: case ScanValueType::INT64_BE:
+        case ScanValueType::FLOAT_BE: case ScanValueType::DOUBLE_BE:
+            // Written and compared as the target stores them
+            if (!parseScanValue(nativeScanValueType(type), text, out)) return false;
+            std::reverse(out.begin(), out.end());
+            return true;
+
+        case ScanValueType::STRING_ASCII:
+            if (text.empty()) return false;
+            out.assign(text.begin(), text.end());
+            return true;
+
+        case ScanValueType::STRING_UNICODE: {
+            if (text.empty()) return false;
+            // Decode UTF-8 into the native wchar_t encoding
+            std::vector<wchar_t> wide;
+            for (size_t i = 0; i < text.size();) {
+                uint8_t c = static_cast<uint8_t>(text[i]);
+                uint32_t cp;
+                size_t length;
+                if (c < 0x80) { cp = c; length = 1; }
+                else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; length = 2; }
+                else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; length = 3; }
+                else { cp = c & 0x07; length = 4; }
+                if (i + length > text.size()) return false;
+                for (size_t k = 1; k < length; k++) {
+                    cp = (cp << 6) | (static_cast<uint8_t>(text[i + k]) & 0x3F);
+                }
+                i += length;
+
+                if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+                    cp -= 0x10000;
+                    wide.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+                    wide.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+                } else {
+                    wide.push_back(static_cast<wchar_t>(cp));
+                }
+            }
+            out.resize(wide.size() * sizeof(wchar_t));
+            std::memcpy(out.data(), wide.data(), out.size());
+            return true;
+        }
+    }
+    return false;
+}
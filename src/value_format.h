@@ -0,0 +1,19 @@
+#pragma once
+#include "scan_value_type.h"
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Longest string value shown by the frontends (in characters)
+constexpr size_t kMaxDisplayChars = 100;
+
+// Format an address as "0x" followed by 16 upper-case hex digits. out needs room for 18 chars.
+size_t formatHexAddress(uintptr_t address, char* out);
+
+// Format raw value bytes of the given type as UTF-8 text, returns the number of chars written.
+// size is the value width in bytes (needle length for strings). out needs at least 512 chars.
+size_t formatScanValue(ScanValueType type, const uint8_t* bytes, size_t size, char* out, size_t outSize);
+
+// Parse user input into the raw bytes of the given type. Returns false if the text is not a valid value.
+bool parseScanValue(ScanValueType type, std::string_view text, std::vector<uint8_t>& out);
@@ -0,0 +1,187 @@
+#pragma once
+#include "byte_order.h"
+#include "scan_kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Largest set whose members are compared with one broadcast each, bigger sets are probed
+// through a bitset of value hashes
+constexpr size_t kValueSetBroadcastMax = 16;
+
+// Numeric values searched for together, e.g. the few values a setting can take or a list
+// of item ids. Members are compared bitwise like MemoryScanner::scanForValue: 0.0 also
+// matches -0.0, NaN is never a member.
+//
+// find() checks every byte offset of a buffer in one pass. Small sets compare the first and
+// last byte of 16 offsets against every member at once (SSE2), larger sets test a 64 Kbit
+// bitset of value hashes and only look up the offsets whose bit is set.
+template<typename T>
+class ValueSet {
+    static_assert(std::is_arithmetic_v<typename NativeValue<T>::Type> && (sizeof(T) == 4 || sizeof(T) == 8),
+                  "value sets hold 4 or 8 byte numbers");
+    using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+
+public:
+    ValueSet() = default;
+    explicit ValueSet(const std::vector<T>& values);
+
+    // Members in the order they were given, without duplicates and NaN
+    const std::vector<T>& values() const { return m_values; }
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+    // Position of value in values(), -1 if it is not a member
+    ptrdiff_t indexOf(T value) const {
+        Bits bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        return indexOfBits(bits);
+    }
+    bool contains(T value) const { return indexOf(value) >= 0; }
+
+    // Calls onMatch(offset, index) for every byte offset of data at which a member starts,
+    // in ascending order; index is the member's position in values()
+    template<typename F>
+    void find(const uint8_t* data, size_t size, F&& onMatch) const;
+
+private:
+    static constexpr unsigned kHashBits = 16;
+
+    std::vector<T> m_values;
+    std::vector<Bits> m_keys;       // bit patterns of the members, sorted (0.0 adds -0.0)
+    std::vector<uint32_t> m_index;  // position in m_values of every key
+    std::vector<uint64_t> m_hashes; // bitset of key hashes, only for large sets
+    uint64_t m_firstBytes[4] = {};  // the keys' first bytes, checked before a small set lookup
+
+    static size_t hash(Bits bits) {
+        return static_cast<size_t>((static_cast<uint64_t>(bits) * 0x9E3779B97F4A7C15ull) >> (64 - kHashBits));
+    }
+    bool large() const { return m_keys.size() > kValueSetBroadcastMax; }
+
+    ptrdiff_t indexOfBits(Bits bits) const {
+        if (!large()) {
+            for (size_t k = 0; k < m_keys.size(); k++) {
+                if (m_keys[k] == bits) return m_index[k];
+            }
+            return -1;
+        }
+        size_t h = hash(bits);
+        if (!((m_hashes[h / 64] >> (h % 64)) & 1)) return -1;
+        auto it = std::lower_bound(m_keys.begin(), m_keys.end(), bits);
+        if (it == m_keys.end() || *it != bits) return -1;
+        return m_index[it - m_keys.begin()];
+    }
+};
+
+template<typename T>
+ValueSet<T>::ValueSet(const std::vector<T>& values) {
+    // Keys with the position of the value they came from. Sorted, equal bit patterns are
+    // neighbours and the first given value of each comes first, so duplicates drop out
+    // without comparing every value against every other.
+    std::vector<std::pair<Bits, uint32_t>> keys;
+    keys.reserve(values.size());
+    auto addKey = [&](T value, uint32_t position) {
+        Bits bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        keys.push_back({ bits, position });
+    };
+    for (size_t position = 0; position < values.size(); position++) {
+        T value = values[position];
+        if constexpr (isFloatingScanValue<T>) {
+            if (std::isnan(nativeValue(value))) continue;
+        }
+        addKey(value, static_cast<uint32_t>(position));
+        if constexpr (isFloatingScanValue<T>) {
+            // Both encodings of zero compare equal
+            if (nativeValue(value) == 0) addKey(NativeValue<T>::make(-nativeValue(value)), static_cast<uint32_t>(position));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end(), [](const auto& a, const auto& b) { return a.first == b.first; }),
+               keys.end());
+
+    // A value is a member if one of its keys is left, members keep the order they were given in
+    constexpr uint32_t kDropped = UINT32_MAX;
+    std::vector<uint32_t> memberIndex(values.size(), kDropped);
+    for (const auto& key : keys) memberIndex[key.second] = 0;
+    for (size_t position = 0; position < values.size(); position++) {
+        if (memberIndex[position] == kDropped) continue;
+        memberIndex[position] = static_cast<uint32_t>(m_values.size());
+        m_values.push_back(values[position]);
+    }
+
+    m_keys.reserve(keys.size());
+    m_index.reserve(keys.size());
+    for (const auto& [bits, position] : keys) {
+        m_keys.push_back(bits);
+        m_index.push_back(memberIndex[position]);
+        uint8_t first = static_cast<uint8_t>(bits);
+        m_firstBytes[first / 64] |= uint64_t(1) << (first % 64);
+    }
+    if (large()) {
+        m_hashes.assign((size_t(1) << kHashBits) / 64, 0);
+        for (Bits bits : m_keys) m_hashes[hash(bits) / 64] |= uint64_t(1) << (hash(bits) % 64);
+    }
+}
+
+template<typename T>
+template<typename F>
+void ValueSet<T>::find(const uint8_t* data, size_t size, F&& onMatch) const {
+    if (m_keys.empty() || size < sizeof(T)) return;
+    const size_t lastStart = size - sizeof(T);
+    size_t i = 0;
+
+    auto check = [&](size_t offset) {
+        Bits bits;
+        std::memcpy(&bits, data + offset, sizeof(T));
+        ptrdiff_t index = indexOfBits(bits);
+        if (index >= 0) onMatch(offset, static_cast<size_t>(index));
+    };
+
+    if (large()) {
+        // The bitset rejects almost every offset without touching the sorted keys
+        for (; i <= lastStart; i++) {
+            Bits bits;
+            std::memcpy(&bits, data + i, sizeof(T));
+            size_t h = hash(bits);
+            if ((m_hashes[h / 64] >> (h % 64)) & 1) check(i);
+        }
+        return;
+    }
+
+#ifdef SCAN_KERNELS_SSE2
+    __m128i firstBytes[kValueSetBroadcastMax];
+    __m128i lastBytes[kValueSetBroadcastMax];
+    for (size_t k = 0; k < m_keys.size(); k++) {
+        firstBytes[k] = _mm_set1_epi8(static_cast<char>(m_keys[k]));
+        lastBytes[k] = _mm_set1_epi8(static_cast<char>(m_keys[k] >> (8 * (sizeof(T) - 1))));
+    }
+
+    // Same window as findPattern: both loads stay inside data while all 16 starts are valid
+    for (; i + 15 <= lastStart; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + sizeof(T) - 1));
+        __m128i candidates = _mm_setzero_si128();
+        for (size_t k = 0; k < m_keys.size(); k++) {
+            candidates = _mm_or_si128(candidates, _mm_and_si128(_mm_cmpeq_epi8(firstBytes[k], blockFirst),
+                                                                _mm_cmpeq_epi8(lastBytes[k], blockLast)));
+        }
+
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(candidates));
+        while (mask != 0) {
+            check(i + static_cast<size_t>(std::countr_zero(mask)));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i <= lastStart; i++) {
+        if ((m_firstBytes[data[i] / 64] >> (data[i] % 64)) & 1) check(i);
+    }
+}
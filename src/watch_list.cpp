@@ -0,0 +1,250 @@
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "watch_list.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Entries due within this window are handled in the same tick
+constexpr auto kTickSlack = std::chrono::milliseconds(1);
+// Scheduler wakeup when nothing is due
+constexpr auto kIdleWakeup = std::chrono::milliseconds(500);
+
+uint64_t toMilliseconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+// Next multiple of the interval on the steady clock, so entries with equal
+// intervals share their ticks no matter when they were added
+std::chrono::steady_clock::time_point alignedDue(std::chrono::steady_clock::time_point now, uint32_t intervalMs) {
+    auto interval = std::chrono::milliseconds(std::max<uint32_t>(intervalMs, 1));
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
+    return std::chrono::steady_clock::time_point((sinceEpoch / interval + 1) * interval);
+}
+
+} // namespace
+
+WatchList::WatchList(MemoryScanner& scanner) : m_scanner(scanner) {}
+
+WatchList::~WatchList() {
+    stop();
+}
+
+uint32_t WatchList::addEntry(uintptr_t address, ScanValueType type, WatchMode mode, std::vector<uint8_t> value, uint32_t intervalMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Entry entry;
+    entry.id = m_nextId++;
+    entry.address = address;
+    entry.type = type;
+    entry.mode = mode;
+    entry.intervalMs = std::max<uint32_t>(intervalMs, 1);
+    entry.nextDue = Clock::now();
+    entry.value = std::move(value);
+    entry.valid = false;
+    entry.timestampMs = 0;
+    m_entries.push_back(std::move(entry));
+
+    m_entriesChanged = true;
+    m_wakeup.notify_one();
+    return m_entries.back().id;
+}
+
+uint32_t WatchList::addWatch(uintptr_t address, ScanValueType type, size_t size, uint32_t intervalMs) {
+    return addEntry(address, type, WatchMode::WATCH, std::vector<uint8_t>(size, 0), intervalMs);
+}
+
+uint32_t WatchList::addFreeze(uintptr_t address, ScanValueType type, std::vector<uint8_t> value, uint32_t intervalMs) {
+    return addEntry(address, type, WatchMode::FREEZE, std::move(value), intervalMs);
+}
+
+bool WatchList::setFrozen(uint32_t id, bool frozen, const std::vector<uint8_t>& value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::ranges::find_if(m_entries, [id](const Entry& e) { return e.id == id; });
+    if (it == m_entries.end()) return false;
+
+    it->mode = frozen ? WatchMode::FREEZE : WatchMode::WATCH;
+    // Freezing without a value keeps the last value that was read
+    if (frozen && !value.empty()) {
+        it->value = value;
+    }
+    it->nextDue = Clock::now();
+
+    m_entriesChanged = true;
+    m_wakeup.notify_one();
+    return true;
+}
+
+bool WatchList::remove(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::ranges::find_if(m_entries, [id](const Entry& e) { return e.id == id; });
+    if (it == m_entries.end()) return false;
+    m_entries.erase(it);
+
+    m_entriesChanged = true;
+    m_wakeup.notify_one();
+    return true;
+}
+
+void WatchList::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_entriesChanged = true;
+    m_wakeup.notify_one();
+}
+
+size_t WatchList::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void WatchList::start() {
+    if (m_running) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = false;
+    }
+    m_running = true;
+    m_thread = std::thread(&WatchList::run, this);
+}
+
+void WatchList::stop() {
+    if (!m_running) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+    m_running = false;
+}
+
+const WatchSnapshot& WatchList::acquireSnapshot() {
+    if (m_middle.load(std::memory_order_acquire) & kSnapshotFresh) {
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & 3;
+    }
+    return m_snapshots[m_front];
+}
+
+void WatchList::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopRequested) {
+        auto now = Clock::now();
+        runTick(now, lock);
+
+        auto next = now + kIdleWakeup;
+        for (const auto& entry : m_entries) {
+            next = std::min(next, entry.nextDue);
+        }
+
+        m_entriesChanged = false;
+        m_wakeup.wait_until(lock, next, [this] { return m_stopRequested || m_entriesChanged; });
+    }
+}
+
+void WatchList::runTick(Clock::time_point now, std::unique_lock<std::mutex>& lock) {
+    m_reads.clear();
+    m_writes.clear();
+    m_readEntries.clear();
+    m_writeEntries.clear();
+
+    // Collect everything that is due, buffers are laid out before any pointer is taken.
+    // Values to freeze are copied, the entries may change while the lock is released.
+    size_t readBytes = 0;
+    size_t writeBytes = 0;
+    for (const Entry& entry : m_entries) {
+        if (entry.nextDue > now + kTickSlack || entry.value.empty()) continue;
+
+        if (entry.mode == WatchMode::FREEZE) {
+            m_writeEntries.push_back({ entry.id, entry.nextDue });
+            writeBytes += entry.value.size();
+        } else {
+            m_readEntries.push_back({ entry.id, entry.nextDue });
+            readBytes += entry.value.size();
+        }
+    }
+
+    if (m_readEntries.empty() && m_writeEntries.empty()) {
+        if (m_entriesChanged) publish();
+        return;
+    }
+
+    m_readBuffer.resize(readBytes);
+    m_writeBuffer.resize(writeBytes);
+    size_t readOffset = 0;
+    size_t writeOffset = 0;
+    size_t nextRead = 0;
+    size_t nextWrite = 0;
+    for (const Entry& entry : m_entries) {
+        if (nextRead < m_readEntries.size() && m_readEntries[nextRead].id == entry.id) {
+            m_reads.push_back({ entry.address, &m_readBuffer[readOffset], entry.value.size(), false });
+            readOffset += entry.value.size();
+            nextRead++;
+        } else if (nextWrite < m_writeEntries.size() && m_writeEntries[nextWrite].id == entry.id) {
+            std::memcpy(&m_writeBuffer[writeOffset], entry.value.data(), entry.value.size());
+            m_writes.push_back({ entry.address, &m_writeBuffer[writeOffset], entry.value.size(), false });
+            writeOffset += entry.value.size();
+            nextWrite++;
+        }
+    }
+
+    // One batched read and one batched write per tick, without blocking the UI's edits
+    lock.unlock();
+    if (!m_reads.empty()) m_scanner.readMemoryBatch(m_reads);
+    if (!m_writes.empty()) m_scanner.writeMemoryBatch(m_writes);
+    lock.lock();
+
+    storeResults(m_readEntries, m_reads, true, now);
+    storeResults(m_writeEntries, m_writes, false, now);
+    publish();
+}
+
+void WatchList::storeResults(const std::vector<DueEntry>& due, const std::vector<MemoryIoRequest>& io, bool read,
+                             Clock::time_point now) {
+    // Entries keep their order and ids only grow, so due and m_entries are walked together.
+    // An entry removed, refrozen or unfrozen during the I/O keeps its new state.
+    uint64_t nowMs = toMilliseconds(now);
+    size_t next = 0;
+    for (Entry& entry : m_entries) {
+        while (next < due.size() && due[next].id < entry.id) next++;
+        if (next == due.size()) break;
+        if (due[next].id != entry.id || due[next].nextDue != entry.nextDue) continue;
+
+        entry.valid = io[next].success;
+        if (read && entry.valid) {
+            std::memcpy(entry.value.data(), io[next].buffer, entry.value.size());
+        }
+        entry.timestampMs = nowMs;
+        entry.nextDue = alignedDue(now, entry.intervalMs);
+    }
+}
+
+void WatchList::publish() {
+    WatchSnapshot& snapshot = m_snapshots[m_back];
+    snapshot.tick = ++m_tick;
+    snapshot.values.clear();
+    snapshot.bytes.clear();
+
+    for (const auto& entry : m_entries) {
+        WatchValue value;
+        value.id = entry.id;
+        value.address = entry.address;
+        value.type = entry.type;
+        value.mode = entry.mode;
+        value.valid = entry.valid;
+        value.timestampMs = entry.timestampMs;
+        value.offset = static_cast<uint32_t>(snapshot.bytes.size());
+        value.size = static_cast<uint32_t>(entry.value.size());
+        snapshot.values.push_back(value);
+        snapshot.bytes.insert(snapshot.bytes.end(), entry.value.begin(), entry.value.end());
+    }
+
+    m_back = m_middle.exchange(m_back | kSnapshotFresh, std::memory_order_acq_rel) & 3;
+}
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "memory_scanner.h"
+#include "scan_value_type.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watched entries are read periodically, frozen entries are rewritten periodically
+enum class WatchMode {
+    WATCH,
+    FREEZE
+};
+
+// Latest known value of one watch list entry
+struct WatchValue {
+    uint32_t id;
+    uintptr_t address;
+    ScanValueType type;
+    WatchMode mode;
+    bool valid;          // last read/write succeeded
+    uint64_t timestampMs; // steady clock time of the last update
+    uint32_t offset;     // value bytes in WatchSnapshot::bytes
+    uint32_t size;
+};
+
+// Consistent view of all watch list values, published once per scheduler tick
+struct WatchSnapshot {
+    uint64_t tick = 0;
+    std::vector<WatchValue> values;
+    std::vector<uint8_t> bytes;
+};
+
+// Watch list with a single scheduler thread.
+// All entries that are due in a tick are read with one batched read and
+// rewritten with one batched write, the values are handed to the UI through
+// a lock-free triple buffer.
+class WatchList {
+public:
+    explicit WatchList(MemoryScanner& scanner);
+    ~WatchList();
+
+    WatchList(const WatchList&) = delete;
+    WatchList& operator=(const WatchList&) = delete;
+
+    // Watch size bytes at address, re-read every intervalMs. Returns the entry id.
+    uint32_t addWatch(uintptr_t address, ScanValueType type, size_t size, uint32_t intervalMs);
+
+    // Keep address at value, rewritten every intervalMs. Returns the entry id.
+    uint32_t addFreeze(uintptr_t address, ScanValueType type, std::vector<uint8_t> value, uint32_t intervalMs);
+
+    // Switch an existing entry between watching and freezing (freezes the given value)
+    bool setFrozen(uint32_t id, bool frozen, const std::vector<uint8_t>& value = {});
+
+    bool remove(uint32_t id);
+    void clear();
+    size_t size() const;
+
+    // Start/stop the scheduler thread
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // Latest published values. Only one consumer thread may call this, the returned
+    // snapshot stays valid until its next call.
+    const WatchSnapshot& acquireSnapshot();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        uint32_t id;
+        uintptr_t address;
+        ScanValueType type;
+        WatchMode mode;
+        uint32_t intervalMs;
+        Clock::time_point nextDue;
+        std::vector<uint8_t> value; // last read value, or the value to freeze
+        bool valid;
+        uint64_t timestampMs;
+    };
+
+    MemoryScanner& m_scanner;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::vector<Entry> m_entries;
+    uint32_t m_nextId = 1;
+    bool m_entriesChanged = false;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    bool m_stopRequested = false;
+
+    // Triple buffer: the scheduler fills m_snapshots[m_back], the UI reads m_snapshots[m_front].
+    // m_middle holds the index of the spare buffer plus kSnapshotFresh once it was republished.
+    static constexpr uint32_t kSnapshotFresh = 4;
+    WatchSnapshot m_snapshots[3];
+    uint32_t m_back = 0;
+    std::atomic<uint32_t> m_middle{1};
+    uint32_t m_front = 2;
+    uint64_t m_tick = 0;
+
+    // An entry taken into a tick: results only go back to it if it is unchanged since
+    struct DueEntry {
+        uint32_t id;
+        Clock::time_point nextDue;
+    };
+
+    // Reused I/O lists of the scheduler thread
+    std::vector<MemoryIoRequest> m_reads;
+    std::vector<MemoryIoRequest> m_writes;
+    std::vector<DueEntry> m_readEntries;
+    std::vector<DueEntry> m_writeEntries;
+    std::vector<uint8_t> m_readBuffer;
+    std::vector<uint8_t> m_writeBuffer;
+
+    uint32_t addEntry(uintptr_t address, ScanValueType type, WatchMode mode, std::vector<uint8_t> value, uint32_t intervalMs);
+    void run();
+    // Copies the due entries under lock, does the I/O with lock released, then stores the results
+    void runTick(Clock::time_point now, std::unique_lock<std::mutex>& lock);
+    void storeResults(const std::vector<DueEntry>& due, const std::vector<MemoryIoRequest>& io, bool read, Clock::time_point now);
+    void publish();
+};
+#endif
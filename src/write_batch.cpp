@@ -0,0 +1,93 @@
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "write_batch.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+void WriteBatch::add(uintptr_t address, const void* bytes, size_t size) {
+    m_entries.push_back({ address, m_data.size(), size, WriteStatus::PENDING });
+    const auto* begin = static_cast<const uint8_t*>(bytes);
+    m_data.insert(m_data.end(), begin, begin + size);
+}
+
+void WriteBatch::reserve(size_t entries, size_t bytes) {
+    m_entries.reserve(entries);
+    m_data.reserve(bytes);
+}
+
+void WriteBatch::clear() {
+    m_entries.clear();
+    m_data.clear();
+}
+
+WriteBatchResult WriteBatch::submit(MemoryScanner& scanner, bool verify) {
+    WriteBatchResult result;
+    uint64_t syscallsBefore = scanner.syscallCount();
+
+    // Of several entries for the same address only the one added last is written
+    std::vector<size_t> order(m_entries.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::ranges::stable_sort(order, [&](size_t a, size_t b) {
+        return m_entries[a].address < m_entries[b].address;
+    });
+    std::vector<size_t> winner(m_entries.size());
+    std::vector<size_t> unique;
+    unique.reserve(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i + 1 < order.size() && m_entries[order[i + 1]].address == m_entries[order[i]].address) continue;
+        unique.push_back(order[i]);
+    }
+    for (size_t i = 0, u = 0; i < order.size(); i++) {
+        if (m_entries[order[i]].address != m_entries[unique[u]].address) u++;
+        winner[order[i]] = unique[u];
+    }
+
+    std::vector<MemoryIoRequest> requests;
+    requests.reserve(unique.size());
+    for (size_t index : unique) {
+        const auto& entry = m_entries[index];
+        requests.push_back({ entry.address, m_data.data() + entry.offset, entry.size, false });
+    }
+    scanner.writeMemoryBatch(requests);
+
+    for (size_t i = 0; i < unique.size(); i++) {
+        m_entries[unique[i]].status = requests[i].success ? WriteStatus::WRITTEN : WriteStatus::FAILED;
+    }
+
+    if (verify) {
+        // Read back into a scratch copy of the buffer, the same layout as m_data
+        std::vector<uint8_t> readBack(m_data.size());
+        std::vector<MemoryIoRequest> reads;
+        std::vector<size_t> readEntries;
+        for (size_t index : unique) {
+            const auto& entry = m_entries[index];
+            if (entry.status != WriteStatus::WRITTEN) continue;
+            reads.push_back({ entry.address, readBack.data() + entry.offset, entry.size, false });
+            readEntries.push_back(index);
+        }
+        scanner.readMemoryBatch(reads);
+
+        for (size_t i = 0; i < reads.size(); i++) {
+            auto& entry = m_entries[readEntries[i]];
+            bool same = reads[i].success && std::memcmp(readBack.data() + entry.offset, bytes(entry), entry.size) == 0;
+            entry.status = same ? WriteStatus::VERIFIED : WriteStatus::MISMATCH;
+        }
+    }
+
+    // Superseded entries share the fate of the entry that replaced them
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        m_entries[i].status = m_entries[winner[i]].status;
+        switch (m_entries[i].status) {
+            case WriteStatus::WRITTEN:
+            case WriteStatus::VERIFIED: result.written++; break;
+            case WriteStatus::FAILED: result.failed++; break;
+            case WriteStatus::MISMATCH: result.mismatched++; break;
+            case WriteStatus::PENDING: break;
+        }
+    }
+
+    result.syscalls = scanner.syscallCount() - syscallsBefore;
+    return result;
+}
+#endif
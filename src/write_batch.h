@@ -0,0 +1,68 @@
+#pragma once
+#include "platform.h"
+#ifdef MEMORY_SCANNER_SUPPORTED
+#include "memory_scanner.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// State of one entry after WriteBatch::submit
+enum class WriteStatus {
+    PENDING,    // not submitted yet
+    WRITTEN,    // written, not read back
+    VERIFIED,   // written and read back with the expected bytes
+    FAILED,     // the target refused the write
+    MISMATCH    // written, but the read-back differs or failed
+};
+
+struct WriteBatchEntry {
+    uintptr_t address;
+    size_t offset; // value bytes in the batch buffer
+    size_t size;
+    WriteStatus status;
+};
+
+// Outcome of one submit
+struct WriteBatchResult {
+    size_t written = 0;    // WRITTEN or VERIFIED
+    size_t failed = 0;
+    size_t mismatched = 0;
+    uint64_t syscalls = 0; // OS calls for the writes and the read-back
+
+    bool ok() const { return failed == 0 && mismatched == 0; }
+};
+
+// Collects (address, bytes) pairs and writes them together: entries are sorted by
+// address, adjacent ones are coalesced and everything is submitted through
+// MemoryScanner::writeMemoryBatch, so the target sees far fewer (on Linux usually one)
+// writes than with writeValue per address.
+// An address added twice keeps the bytes added last; partially overlapping entries
+// are written in address order.
+class WriteBatch {
+public:
+    void add(uintptr_t address, const void* bytes, size_t size);
+
+    template<typename T>
+    void addValue(uintptr_t address, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "addValue needs a plain value type");
+        add(address, &value, sizeof(T));
+    }
+
+    void reserve(size_t entries, size_t bytes);
+    void clear();
+
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    const std::vector<WriteBatchEntry>& entries() const { return m_entries; }
+    const uint8_t* bytes(const WriteBatchEntry& entry) const { return m_data.data() + entry.offset; }
+
+    // Write all entries. With verify, every written entry is read back (batched as well)
+    // and compared. Entry states are updated, the batch can be submitted again.
+    WriteBatchResult submit(MemoryScanner& scanner, bool verify = false);
+
+private:
+    std::vector<WriteBatchEntry> m_entries;
+    std::vector<uint8_t> m_data;
+};
+#endif
@@ -0,0 +1,133 @@
+// Unit tests of FilterExpression: parsing, precedence, register allocation and its limits.
+#include "filter_expression.h"
+#include "test_check.h"
+#include <string>
+
+namespace {
+
+// Compile text for INT32 and evaluate it for one row
+bool keepsInt(const std::string& text, int32_t v, int32_t old = 0, int32_t first = 0) {
+    FilterExpression expression;
+    std::string error;
+    if (!expression.compile(text, ScanValueType::INT32, error)) {
+        std::fprintf(stderr, "compile \"%s\": %s\n", text.c_str(), error.c_str());
+        testFailures()++;
+        return false;
+    }
+    uint8_t keep = 2;
+    expression.evaluate(reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&old),
+                        reinterpret_cast<const uint8_t*>(&first), 1, &keep);
+    return keep == 1;
+}
+
+bool keepsDouble(const std::string& text, double v) {
+    FilterExpression expression;
+    std::string error;
+    if (!expression.compile(text, ScanValueType::DOUBLE, error)) {
+        testFailures()++;
+        return false;
+    }
+    uint8_t keep = 2;
+    expression.evaluate(reinterpret_cast<const uint8_t*>(&v), nullptr, nullptr, 1, &keep);
+    return keep == 1;
+}
+
+// Error message of compiling text for type, empty if it compiles
+std::string compileError(const std::string& text, ScanValueType type = ScanValueType::INT32) {
+    FilterExpression expression;
+    std::string error;
+    return expression.compile(text, type, error) ? std::string() : error;
+}
+
+void testPrecedence() {
+    CHECK(keepsInt("v == 1 + 2 * 3", 7));
+    CHECK(!keepsInt("v == 1 + 2 * 3", 9));
+    CHECK(keepsInt("v == 10 - 4 - 3", 3));       // left-associative
+    CHECK(keepsInt("v == 20 / 2 % 3", 1));
+    CHECK(keepsInt("v > 1 == 1", 2));            // relations bind tighter than equality
+    CHECK(keepsInt("v == 0 || v == 1 && v == 2", 0)); // && binds tighter than ||
+    CHECK(!keepsInt("(v == 0 || v == 1) && v == 2", 0));
+    CHECK(keepsInt("v <= 5 && v >= 5 && v != 4", 5));
+}
+
+void testParentheses() {
+    CHECK(keepsInt("v == (1 + 2) * 3", 9));
+    CHECK(keepsInt("((((v)))) == 4", 4));
+    CHECK(keepsInt("abs(v - old) == 3", 5, 8));
+    CHECK(keepsInt("v - old == first", 7, 4, 3));
+    CHECK(compileError("(v == 1").find("missing ')'") != std::string::npos);
+    CHECK(compileError("abs v").find("missing '('") != std::string::npos);
+    CHECK(compileError("v == 1)").find("unexpected ')'") != std::string::npos);
+}
+
+void testUnary() {
+    CHECK(keepsInt("-v == 3", -3));
+    CHECK(keepsInt("--v == 3", 3));
+    CHECK(keepsInt("-2 * 3 == v", -6));
+    CHECK(keepsInt("!(v == 1)", 2));
+    CHECK(keepsInt("!!v", 5));
+    CHECK(!keepsInt("!v", 5));
+    CHECK(keepsInt("v - -1 == 3", 2));
+    CHECK(keepsDouble("-v > 1.5", -2.0));
+}
+
+void testIntegerSemantics() {
+    CHECK(keepsInt("v / 0 == 0", 5));
+    CHECK(keepsInt("v % 0 == 0", 5));
+    CHECK(keepsInt("v == 0x10", 16));
+    CHECK(keepsDouble("v / 2 == 1.25", 2.5));
+}
+
+void testErrors() {
+    // Wrong constant for the scan type, unknown names, non-numeric scans
+    CHECK(compileError("v == 1.5").find("integer constant expected") != std::string::npos);
+    CHECK(compileError("v == 1.5", ScanValueType::FLOAT).empty());
+    CHECK(compileError("w > 1").find("unknown name 'w'") != std::string::npos);
+    CHECK(compileError("v > 1x").find("invalid constant") != std::string::npos);
+    CHECK(compileError("v == 99999999999999999999").find("out of range") != std::string::npos);
+    CHECK(compileError("v > 1", ScanValueType::STRING_ASCII) == "expressions filter numeric values only");
+    CHECK(compileError("v >").find("unexpected end") != std::string::npos);
+    CHECK(compileError("").find("unexpected end") != std::string::npos);
+}
+
+void testRegisters() {
+    // A flat chain reuses two registers however long it is
+    std::string chain = "v";
+    for (int i = 0; i < 1000; i++) chain += " + v";
+    CHECK(keepsInt(chain + " == 1001", 1));
+
+    // Right-nested operands take a register per level
+    std::string nested = "v";
+    for (int i = 0; i < 20; i++) nested = "1 + (" + nested + ")";
+    CHECK(keepsInt(nested + " == 20", 0));
+    nested = "v";
+    for (size_t i = 0; i < kMaxExpressionRegisters; i++) nested = "1 + (" + nested + ")";
+    CHECK(compileError(nested).find("expression nested too deep at") != std::string::npos);
+}
+
+void testDepthLimit() {
+    auto wrapped = [](size_t depth) { return std::string(depth, '(') + "v" + std::string(depth, ')') + " == 1"; };
+    CHECK(compileError(wrapped(kMaxExpressionDepth)).empty());
+    CHECK(compileError(wrapped(kMaxExpressionDepth + 1)).find("expression nested too deeply") != std::string::npos);
+
+    // Deep enough to overflow the stack without the limit
+    CHECK(compileError(std::string(1 << 20, '(')).find("expression nested too deeply") != std::string::npos);
+    CHECK(compileError(std::string(1 << 20, '-') + "v").find("expression nested too deeply") != std::string::npos);
+    CHECK(compileError(std::string(1 << 20, '!') + "v").find("expression nested too deeply") != std::string::npos);
+    std::string abs;
+    for (int i = 0; i < 100000; i++) abs += "abs(";
+    CHECK(compileError(abs).find("expression nested too deeply") != std::string::npos);
+}
+
+} // namespace
+
+int main() {
+    testPrecedence();
+    testParentheses();
+    testUnary();
+    testIntegerSemantics();
+    testErrors();
+    testRegisters();
+    testDepthLimit();
+    return TEST_RESULT();
+}
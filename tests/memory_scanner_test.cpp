@@ -0,0 +1,85 @@
+// Unit tests of the partitioned filters, run against this test's own memory.
+#include "memory_scanner.h"
+#include "test_check.h"
+#include <atomic>
+
+#ifdef __linux__
+#include <unistd.h>
+
+namespace {
+
+void testRunParallel() {
+    std::vector<std::atomic<int>> runs(100);
+    runParallel(runs.size(), [&](size_t i) { runs[i]++; });
+    bool once = true;
+    for (const auto& count : runs) once = once && count == 1;
+    CHECK(once);
+
+    // Callers on several threads share the pool, each still gets all of its tasks run
+    std::vector<std::atomic<int>> shared(8 * 50);
+    std::vector<std::thread> callers;
+    for (size_t c = 0; c < 8; c++) {
+        callers.emplace_back([&, c] { runParallel(50, [&](size_t i) { shared[c * 50 + i]++; }); });
+    }
+    for (auto& caller : callers) caller.join();
+    once = true;
+    for (const auto& count : shared) once = once && count == 1;
+    CHECK(once);
+
+    size_t called = 0;
+    runParallel(0, [&](size_t) { called++; });
+    runParallel(1, [&](size_t) { called++; });
+    CHECK(called == 1);
+}
+
+void testFilters() {
+    // Enough candidates to be split into partitions where there are cores for it
+    std::vector<int32_t> memory(4 * kFilterParallelThreshold + 123);
+    for (size_t i = 0; i < memory.size(); i++) memory[i] = static_cast<int32_t>(i % 7);
+    std::vector<MemoryMatch<int32_t>> candidates;
+    for (const auto& value : memory) candidates.push_back({ reinterpret_cast<uintptr_t>(&value), value });
+    for (size_t i = 0; i < memory.size(); i += 5) memory[i] = 100;
+
+    MemoryScanner scanner(getpid());
+    auto changed = scanner.filterByChanged(candidates);
+    size_t expected = 0;
+    bool ordered = true;
+    for (size_t i = 0; i < memory.size(); i += 5) {
+        if (candidates[i].value == 100) continue;
+        ordered = ordered && expected < changed.size() && changed[expected].address == candidates[i].address &&
+                  changed[expected].value == 100;
+        expected++;
+    }
+    CHECK(changed.size() == expected);
+    CHECK(ordered);
+    CHECK(candidates[0].value == 0); // the source is left as it was
+
+    auto threes = scanner.filterByValue(candidates, int32_t(3));
+    size_t unchangedThrees = 0;
+    for (size_t i = 0; i < memory.size(); i++) unchangedThrees += memory[i] == 3;
+    CHECK(threes.size() == unchangedThrees);
+
+    // Compacting in place keeps the same survivors in the same order
+    auto compacted = candidates;
+    CHECK(scanner.compactByChanged(compacted) == changed.size());
+    bool same = compacted.size() == changed.size();
+    for (size_t i = 0; same && i < compacted.size(); i++) {
+        same = compacted[i].address == changed[i].address && compacted[i].value == changed[i].value;
+    }
+    CHECK(same);
+
+    std::vector<MemoryMatch<int32_t>> none;
+    CHECK(scanner.filterByUnchanged(none).empty());
+    CHECK(scanner.compactByUnchanged(none) == 0);
+}
+
+} // namespace
+#endif
+
+int main() {
+#ifdef __linux__
+    testRunParallel();
+    testFilters();
+#endif
+    return TEST_RESULT();
+}
@@ -0,0 +1,75 @@
+// Unit tests of the process regex filter with hostile patterns and command lines.
+#include "process_utils.h"
+#include "test_check.h"
+#include <thread>
+
+#ifdef __linux__
+namespace {
+
+ProcessInfo process(pid_t pid, const std::string& name, const std::string& commandLine) {
+    ProcessInfo info;
+    info.pid = pid;
+    info.exeName = name;
+    info.commandLine = commandLine;
+    return info;
+}
+
+std::vector<pid_t> matching(const std::string& pattern, const std::vector<ProcessInfo>& candidates,
+                            std::string* errorOut = nullptr) {
+    std::vector<ProcessInfo> out;
+    std::string error;
+    std::vector<pid_t> pids;
+    if (!matchProcessesByRegex(pattern, candidates, out, error)) {
+        if (errorOut) *errorOut = error;
+        pids.push_back(-1);
+        return pids;
+    }
+    for (const auto& info : out) pids.push_back(info.pid);
+    return pids;
+}
+
+void testMatching() {
+    std::vector<ProcessInfo> candidates = {
+        process(10, "bash", "/bin/bash --login"),
+        process(20, "java", "/usr/bin/java -Xmx4g -jar Server.jar"),
+        process(30, "game.exe", "wine C:\\Game\\game.exe -windowed"),
+    };
+    CHECK((matching("^java$", candidates) == std::vector<pid_t>{ 20 }));
+    CHECK((matching("server\\.JAR", candidates) == std::vector<pid_t>{ 20 })); // case-insensitive
+    CHECK((matching("bash|game", candidates) == std::vector<pid_t>{ 10, 30 }));
+    CHECK(matching("nothing", candidates).empty());
+
+    std::string error;
+    CHECK((matching("(unclosed", candidates, &error) == std::vector<pid_t>{ -1 }));
+    CHECK(error == "invalid regex");
+    CHECK((matching(std::string(kMaxProcessRegexLength + 1, 'a'), candidates, &error) == std::vector<pid_t>{ -1 }));
+    CHECK(error.find("longer than") != std::string::npos);
+}
+
+void testLongCommandLines() {
+    // A pattern that recurses per character against a command line far beyond what the
+    // stack holds: only the first kProcessRegexCommandLineLimit bytes are searched
+    std::string arguments;
+    while (arguments.size() < 200000) arguments += "ab";
+    std::vector<ProcessInfo> candidates = {
+        process(1, "java", "/usr/bin/java -jar " + arguments + " c"),
+        process(2, "java", "/usr/bin/java -jar " + arguments.substr(0, 1000) + "c"),
+    };
+
+    std::vector<pid_t> found;
+    std::thread worker([&] { found = matching("(a|b)*c", candidates); });
+    worker.join();
+    CHECK((found == std::vector<pid_t>{ 2 }));
+    CHECK((matching("^java$", candidates) == std::vector<pid_t>{ 1, 2 }));
+}
+
+} // namespace
+#endif
+
+int main() {
+#ifdef __linux__
+    testMatching();
+    testLongCommandLines();
+#endif
+    return TEST_RESULT();
+}
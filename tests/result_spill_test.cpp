@@ -0,0 +1,145 @@
+// Unit tests of the spill encoding: varints, zigzag integers, runs, and the segment file.
+#include "result_spill.h"
+#include "memory_scanner.h"
+#include "test_check.h"
+#include <limits>
+#include <string>
+
+namespace {
+
+template<typename T>
+bool roundTrips(const T& value, size_t expectedBytes = 0) {
+    std::vector<uint8_t> bytes;
+    encodeSpillValue(bytes, value);
+    if (expectedBytes && bytes.size() != expectedBytes) return false;
+    const uint8_t* pos = bytes.data();
+    T decoded{};
+    return decodeSpillValue(pos, bytes.data() + bytes.size(), decoded) &&
+           pos == bytes.data() + bytes.size() && decoded == value;
+}
+
+void testVarint() {
+    const uint64_t values[] = { 0, 1, 127, 128, 16383, 16384, (1ull << 35) - 1,
+                                std::numeric_limits<uint64_t>::max() };
+    const size_t widths[] = { 1, 1, 1, 2, 2, 3, 5, 10 };
+    for (size_t i = 0; i < std::size(values); i++) {
+        std::vector<uint8_t> bytes;
+        appendVarint(bytes, values[i]);
+        CHECK(bytes.size() == widths[i]);
+        const uint8_t* pos = bytes.data();
+        uint64_t decoded = 0;
+        CHECK(readVarint(pos, bytes.data() + bytes.size(), decoded) && decoded == values[i]);
+        CHECK(pos == bytes.data() + bytes.size());
+
+        // Every truncation is rejected instead of read past the end
+        for (size_t cut = 0; cut < bytes.size(); cut++) {
+            pos = bytes.data();
+            CHECK(!readVarint(pos, bytes.data() + cut, decoded));
+        }
+    }
+
+    // More than ten continuation bytes do not fit 64 bits
+    std::vector<uint8_t> overlong(11, 0x80);
+    overlong.push_back(0);
+    const uint8_t* pos = overlong.data();
+    uint64_t decoded;
+    CHECK(!readVarint(pos, overlong.data() + overlong.size(), decoded));
+}
+
+void testZigzag() {
+    // Small magnitudes of either sign take one byte
+    CHECK(roundTrips<int32_t>(0, 1));
+    CHECK(roundTrips<int32_t>(-1, 1));
+    CHECK(roundTrips<int32_t>(63, 1));
+    CHECK(roundTrips<int32_t>(-64, 1));
+    CHECK(roundTrips<int32_t>(64, 2));
+    CHECK(roundTrips<int8_t>(std::numeric_limits<int8_t>::min()));
+    CHECK(roundTrips<int8_t>(std::numeric_limits<int8_t>::max()));
+    CHECK(roundTrips<int16_t>(std::numeric_limits<int16_t>::min()));
+    CHECK(roundTrips<int32_t>(std::numeric_limits<int32_t>::min()));
+    CHECK(roundTrips<int32_t>(std::numeric_limits<int32_t>::max()));
+    CHECK(roundTrips<int64_t>(std::numeric_limits<int64_t>::min()));
+    CHECK(roundTrips<int64_t>(std::numeric_limits<int64_t>::max()));
+    CHECK(roundTrips<uint64_t>(std::numeric_limits<uint64_t>::max(), 10));
+    CHECK(roundTrips<uint8_t>(255, 2));
+
+    // Floating point values and strings are stored as they are
+    CHECK(roundTrips<float>(-0.5f, sizeof(float)));
+    CHECK(roundTrips<double>(std::numeric_limits<double>::max(), sizeof(double)));
+    CHECK(roundTrips<std::string>("", 1));
+    CHECK(roundTrips<std::string>("health", 7));
+    CHECK(roundTrips<std::wstring>(L"Leben", 1 + 5 * sizeof(wchar_t)));
+
+    // A string length beyond the buffer is rejected
+    std::vector<uint8_t> bytes;
+    encodeSpillValue(bytes, std::string("abc"));
+    bytes.pop_back();
+    const uint8_t* pos = bytes.data();
+    std::string decoded;
+    CHECK(!decodeSpillValue(pos, bytes.data() + bytes.size(), decoded));
+}
+
+template<typename T>
+void checkRun(const std::vector<MemoryMatch<T>>& run) {
+    std::vector<uint8_t> bytes = encodeSpillRun(run);
+    std::vector<MemoryMatch<T>> decoded;
+    CHECK(decodeSpillRun(bytes, run.size(), decoded));
+    CHECK(decoded.size() == run.size());
+    for (size_t i = 0; i < run.size() && i < decoded.size(); i++) {
+        CHECK(decoded[i].address == run[i].address && decoded[i].value == run[i].value);
+    }
+
+    // A short buffer, a wrong count or trailing bytes fail the whole run
+    if (!bytes.empty()) {
+        std::vector<uint8_t> truncated(bytes.begin(), bytes.end() - 1);
+        CHECK(!decodeSpillRun(truncated, run.size(), decoded));
+        CHECK(!decodeSpillRun(bytes, run.size() + 1, decoded));
+        if (run.size() > 1) CHECK(!decodeSpillRun(bytes, run.size() - 1, decoded));
+    }
+}
+
+void testRuns() {
+    checkRun<int32_t>({});
+    checkRun<int32_t>({ { 0x1000, 5 }, { 0x1004, -5 }, { 0x1008, std::numeric_limits<int32_t>::min() },
+                        { 0x7ffff0000000, std::numeric_limits<int32_t>::max() } });
+    checkRun<uint64_t>({ { 8, 0 }, { 16, std::numeric_limits<uint64_t>::max() },
+                         { std::numeric_limits<uintptr_t>::max(), 1 } });
+    checkRun<float>({ { 0x20, 1.5f }, { 0x24, -0.0f }, { 0x10000, 3.0e38f } });
+    checkRun<std::string>({ { 0x400, "abc" }, { 0x500, "" }, { 0x501, std::string(300, 'x') } });
+
+    // Dense runs cost about one byte of address per match
+    std::vector<MemoryMatch<int32_t>> dense;
+    for (int32_t i = 0; i < 1000; i++) dense.push_back({ 0x10000 + uintptr_t(i) * 4, i % 50 });
+    checkRun(dense);
+    CHECK(encodeSpillRun(dense).size() < dense.size() * 3);
+}
+
+void testSegment() {
+    std::error_code error;
+    auto segment = SpillSegment::create(std::filesystem::temp_directory_path(error));
+    CHECK(segment != nullptr);
+    if (!segment) return;
+
+    std::vector<uint8_t> first(1000, 0xab), second = { 1, 2, 3 };
+    uint64_t firstOffset = 0, secondOffset = 0;
+    CHECK(segment->append(first, firstOffset) && segment->append(second, secondOffset));
+    CHECK(firstOffset == 0 && secondOffset == first.size());
+    CHECK(segment->size() == first.size() + second.size());
+
+    std::vector<uint8_t> read;
+    CHECK(segment->read(secondOffset, second.size(), read) && read == second);
+    CHECK(segment->read(firstOffset, first.size(), read) && read == first);
+
+    // Reads past the end fail instead of returning a short buffer
+    CHECK(!segment->read(secondOffset, second.size() + 1, read));
+}
+
+} // namespace
+
+int main() {
+    testVarint();
+    testZigzag();
+    testRuns();
+    testSegment();
+    return TEST_RESULT();
+}
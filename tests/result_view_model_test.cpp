@@ -0,0 +1,79 @@
+// Unit tests of ResultViewModel with rows whose shard could not be read back.
+#include "result_view_model.h"
+#include "test_check.h"
+#include <cstring>
+#include <optional>
+#include <string>
+
+namespace {
+
+struct Row {
+    uintptr_t address;
+    int32_t value;
+    bool readable;
+};
+
+void setRows(ResultViewModel& view, const std::vector<Row>& rows) {
+    view.setSource(rows.size(), ScanValueType::INT32, sizeof(int32_t),
+        [&rows](size_t i) -> std::optional<uintptr_t> {
+            if (!rows[i].readable) return std::nullopt;
+            return rows[i].address;
+        },
+        [&rows](size_t i, void* out, size_t outSize) -> size_t {
+            if (!rows[i].readable || outSize < sizeof(int32_t)) return 0;
+            std::memcpy(out, &rows[i].value, sizeof(int32_t));
+            return sizeof(int32_t);
+        });
+}
+
+std::string cell(ResultViewModel& view, size_t row, ResultColumn column) {
+    return std::string(view.formatCell(row, column));
+}
+
+void testUnreadableRows() {
+    std::vector<Row> rows = {
+        { 0x3000, 30, true },
+        { 0, 0, false },
+        { 0x1000, 10, true },
+        { 0, 0, false },
+        { 0x2000, 20, true },
+    };
+    ResultViewModel view;
+    setRows(view, rows);
+
+    // No address or value is made up for rows that were lost
+    CHECK(!view.addressAt(1).has_value());
+    CHECK(cell(view, 1, ResultColumn::ADDRESS) == "??");
+    CHECK(cell(view, 1, ResultColumn::VALUE) == "??");
+    CHECK(cell(view, 2, ResultColumn::VALUE) == "10");
+    CHECK(view.addressAt(2) == std::optional<uintptr_t>(0x1000));
+
+    // Sorting keeps unreadable rows last in both directions
+    CHECK(view.sortBy(ResultSortKey::ADDRESS, true));
+    CHECK(view.addressAt(0) == std::optional<uintptr_t>(0x1000) && view.addressAt(2) == std::optional<uintptr_t>(0x3000));
+    CHECK(!view.addressAt(3) && !view.addressAt(4));
+    CHECK(view.sortBy(ResultSortKey::VALUE, false));
+    CHECK(cell(view, 0, ResultColumn::VALUE) == "30" && cell(view, 2, ResultColumn::VALUE) == "10");
+    CHECK(!view.addressAt(3) && !view.addressAt(4));
+
+    // Live refresh only reads the readable rows
+    size_t reads = 0;
+    bool zeroRead = false;
+    view.setReader([&](uintptr_t address, void* buffer, size_t size) {
+        reads++;
+        zeroRead = zeroRead || address == 0;
+        std::memset(buffer, 0, size);
+        return true;
+    }, 0);
+    view.setVisibleRange(0, 4);
+    view.refreshVisible(1);
+    CHECK(reads > 0 && !zeroRead);
+    CHECK(cell(view, 4, ResultColumn::VALUE) == "??");
+}
+
+} // namespace
+
+int main() {
+    testUnreadableRows();
+    return TEST_RESULT();
+}
@@ -0,0 +1,19 @@
+#pragma once
+// Minimal checks for the unit tests: a failed CHECK prints its location and the test
+// continues, TEST_RESULT() is the exit code of main (1 if any check failed)
+#include <cstdio>
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures()++;                                                         \
+        }                                                                             \
+    } while (0)
+
+#define TEST_RESULT() (testFailures() == 0 ? 0 : 1)
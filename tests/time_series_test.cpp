@@ -0,0 +1,69 @@
+// Unit tests of TimeSeriesReader against hand-made recordings with hostile headers.
+#include "time_series.h"
+#include "test_check.h"
+#include <string>
+
+#ifdef MEMORY_SCANNER_SUPPORTED
+namespace {
+
+template<typename T>
+void append(std::vector<uint8_t>& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// File header as the recorder writes it, followed by the given ranges
+std::vector<uint8_t> header(uint32_t rangeCount, const std::vector<uint32_t>& rangeSizes) {
+    std::vector<uint8_t> out = { 'M', 'S', 'T', 'S' };
+    append<uint32_t>(out, 1);
+    append<uint32_t>(out, static_cast<uint32_t>(ScanValueType::INT32));
+    append<uint32_t>(out, rangeCount);
+    append<uint64_t>(out, 1000);
+    append<uint64_t>(out, 0);
+    uint64_t address = 0x10000;
+    for (uint32_t size : rangeSizes) {
+        append<uint64_t>(out, address);
+        append<uint32_t>(out, size);
+        address += size;
+    }
+    return out;
+}
+
+std::string openError(const std::vector<uint8_t>& bytes) {
+    std::error_code ignored;
+    std::filesystem::path path = std::filesystem::temp_directory_path(ignored) / "time_series_test.msts";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+    TimeSeriesReader reader;
+    std::string error;
+    bool opened = reader.open(path, error);
+    std::filesystem::remove(path, ignored);
+    return opened ? std::string() : error;
+}
+
+void testHeader() {
+    CHECK(openError(header(2, { 16, 8 })).empty());
+    CHECK(openError(header(0, {})).empty());
+    CHECK(openError({ 'M', 'S', 'T' }) == "not a recording");
+
+    // A range count beyond the file is rejected before anything is allocated for it
+    CHECK(openError(header(3, { 16, 8 })) == "truncated recording header");
+    CHECK(openError(header(0xffffffffu, { 16 })) == "truncated recording header");
+
+    // Ranges that fit the file but add up to more state than the recorder ever writes
+    CHECK(openError(header(1, { 0xffffffffu })) == "recorded ranges too large");
+    CHECK(openError(header(2, { static_cast<uint32_t>(kMaxRecordedBytes), 4 })) == "recorded ranges too large");
+    CHECK(openError(header(1, { static_cast<uint32_t>(kMaxRecordedBytes) })).empty());
+}
+
+} // namespace
+#endif
+
+int main() {
+#ifdef MEMORY_SCANNER_SUPPORTED
+    testHeader();
+#endif
+    return TEST_RESULT();
+}
@@ -0,0 +1,135 @@
+// Unit tests of ValueSet: membership, deduplication and find() on the small (SSE2) and the
+// large (hash bitset) path.
+#include "value_set.h"
+#include "test_check.h"
+#include <limits>
+#include <random>
+
+namespace {
+
+// Offsets at which find() reports a member, checked against a plain comparison at every offset
+template<typename T>
+bool findMatchesBruteForce(const ValueSet<T>& set, const std::vector<uint8_t>& data) {
+    std::vector<std::pair<size_t, size_t>> found;
+    set.find(data.data(), data.size(), [&](size_t offset, size_t index) { found.push_back({ offset, index }); });
+
+    std::vector<std::pair<size_t, size_t>> expected;
+    for (size_t offset = 0; offset + sizeof(T) <= data.size(); offset++) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        if constexpr (isFloatingScanValue<T>) {
+            if (std::isnan(nativeValue(value))) continue;
+        }
+        for (size_t m = 0; m < set.values().size(); m++) {
+            if (nativeValue(set.values()[m]) == nativeValue(value)) {
+                expected.push_back({ offset, m });
+                break;
+            }
+        }
+    }
+    return found == expected;
+}
+
+// Buffer of random bytes with the given values planted at unaligned offsets
+template<typename T>
+std::vector<uint8_t> plant(const std::vector<T>& values, size_t size, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) byte = static_cast<uint8_t>(random());
+    for (size_t i = 0; i < values.size() * 4; i++) {
+        size_t offset = random() % (size - sizeof(T));
+        std::memcpy(&data[offset], &values[i % values.size()], sizeof(T));
+    }
+    return data;
+}
+
+void testDeduplication() {
+    ValueSet<int32_t> set(std::vector<int32_t>{ 5, 3, 5, 9, 3, 3, 1 });
+    CHECK((set.values() == std::vector<int32_t>{ 5, 3, 9, 1 }));
+    CHECK(set.indexOf(5) == 0 && set.indexOf(3) == 1 && set.indexOf(9) == 2 && set.indexOf(1) == 3);
+    CHECK(set.indexOf(4) == -1);
+    CHECK(ValueSet<int32_t>(std::vector<int32_t>{}).empty());
+
+    // Many duplicates: every value once, in the order first given
+    std::vector<int64_t> repeated;
+    for (int round = 0; round < 50; round++) {
+        for (int64_t v = 0; v < 2000; v++) repeated.push_back(v * 1000003 % 2000);
+    }
+    ValueSet<int64_t> large(repeated);
+    CHECK(large.size() == 2000);
+    bool ordered = true;
+    for (size_t i = 0; i < large.size(); i++) ordered = ordered && large.values()[i] == repeated[i];
+    CHECK(ordered);
+}
+
+void testFloatingPoint() {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    // NaN is never a member, 0.0 and -0.0 are one member matched by both encodings
+    ValueSet<double> set(std::vector<double>{ nan, 1.5, -0.0, 0.0, nan, 2.5 });
+    CHECK(set.size() == 3);
+    CHECK(set.values()[0] == 1.5 && std::signbit(set.values()[1]) && set.values()[2] == 2.5);
+    CHECK(set.indexOf(0.0) == 1 && set.indexOf(-0.0) == 1);
+    CHECK(!set.contains(nan));
+    CHECK(ValueSet<float>(std::vector<float>{ std::numeric_limits<float>::quiet_NaN() }).empty());
+
+    std::vector<uint8_t> zeros(64, 0);
+    double negative = -0.0;
+    std::memcpy(&zeros[20], &negative, sizeof(double));
+    CHECK(findMatchesBruteForce(set, zeros));
+
+    // The same on the large path
+    std::vector<float> many{ std::numeric_limits<float>::quiet_NaN(), 0.0f };
+    for (int i = 1; i <= 40; i++) many.push_back(static_cast<float>(i) * 0.25f);
+    many.push_back(-0.0f);
+    ValueSet<float> largeSet(many);
+    CHECK(largeSet.size() == 41);
+    CHECK(largeSet.indexOf(-0.0f) == 0 && largeSet.indexOf(0.0f) == 0);
+    CHECK(!largeSet.contains(std::numeric_limits<float>::quiet_NaN()));
+    CHECK(findMatchesBruteForce(largeSet, plant(many, 4096, 7)));
+
+    // Byte-swapped values compare by their converted value as well
+    using BigFloat = Swapped<float>;
+    ValueSet<BigFloat> swapped(std::vector<BigFloat>{ BigFloat::fromValue(0.0f), BigFloat::fromValue(3.0f) });
+    CHECK(swapped.contains(BigFloat::fromValue(-0.0f)) && swapped.contains(BigFloat::fromValue(3.0f)));
+}
+
+void testFind() {
+    // Small sets take the broadcast path, up to kValueSetBroadcastMax keys
+    std::vector<int32_t> small{ 17, -1, 0x01020304, 0x7f000000 };
+    std::vector<int32_t> atLimit;
+    for (size_t i = 0; i < kValueSetBroadcastMax; i++) atLimit.push_back(static_cast<int32_t>(i * 7919 + 11));
+    std::vector<int64_t> small64{ 1, -1, std::numeric_limits<int64_t>::min() };
+    CHECK(findMatchesBruteForce(ValueSet<int32_t>(small), plant(small, 5000, 1)));
+    CHECK(findMatchesBruteForce(ValueSet<int32_t>(atLimit), plant(atLimit, 5000, 2)));
+    CHECK(findMatchesBruteForce(ValueSet<int64_t>(small64), plant(small64, 5000, 3)));
+
+    // Larger sets take the hash bitset path
+    std::vector<int32_t> large;
+    for (int i = 0; i < 300; i++) large.push_back(i * 65537);
+    std::vector<int64_t> large64;
+    for (int64_t i = 0; i < 100; i++) large64.push_back(i << 40);
+    CHECK(findMatchesBruteForce(ValueSet<int32_t>(large), plant(large, 20000, 4)));
+    CHECK(findMatchesBruteForce(ValueSet<int64_t>(large64), plant(large64, 20000, 5)));
+
+    // Members at the very start and end, buffers shorter than a value or a vector
+    std::vector<uint8_t> edges(37, 0xee);
+    int32_t member = 17;
+    std::memcpy(&edges[0], &member, sizeof(member));
+    std::memcpy(&edges[edges.size() - sizeof(member)], &member, sizeof(member));
+    ValueSet<int32_t> smallSet(small);
+    CHECK(findMatchesBruteForce(smallSet, edges));
+    CHECK(findMatchesBruteForce(ValueSet<int32_t>(large), edges));
+    for (size_t size = 0; size < 20; size++) {
+        CHECK(findMatchesBruteForce(smallSet, std::vector<uint8_t>(edges.begin(), edges.begin() + size)));
+    }
+}
+
+} // namespace
+
+int main() {
+    testDeduplication();
+    testFloatingPoint();
+    testFind();
+    return TEST_RESULT();
+}
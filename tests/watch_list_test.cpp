@@ -0,0 +1,118 @@
+// Unit tests of WatchList against this test's own memory.
+#include "watch_list.h"
+#include "test_check.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <unistd.h>
+
+namespace {
+
+// Wait until the published snapshot satisfies done, false after a second
+template<typename Done>
+bool waitFor(WatchList& list, Done done) {
+    for (int i = 0; i < 200; i++) {
+        if (done(list.acquireSnapshot())) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+const WatchValue* find(const WatchSnapshot& snapshot, uint32_t id) {
+    for (const auto& value : snapshot.values) {
+        if (value.id == id) return &value;
+    }
+    return nullptr;
+}
+
+int32_t valueOf(const WatchSnapshot& snapshot, const WatchValue& value) {
+    int32_t result;
+    std::memcpy(&result, &snapshot.bytes[value.offset], sizeof(result));
+    return result;
+}
+
+void testWatchAndFreeze() {
+    static volatile int32_t watched = 5;
+    static volatile int32_t frozen = 0;
+
+    MemoryScanner scanner(getpid());
+    WatchList list(scanner);
+    list.start();
+    uint32_t watchId = list.addWatch(reinterpret_cast<uintptr_t>(&watched), ScanValueType::INT32, sizeof(int32_t), 1);
+    int32_t target = 42;
+    std::vector<uint8_t> bytes(sizeof(target));
+    std::memcpy(bytes.data(), &target, sizeof(target));
+    uint32_t freezeId = list.addFreeze(reinterpret_cast<uintptr_t>(&frozen), ScanValueType::INT32, bytes, 1);
+
+    CHECK(waitFor(list, [&](const WatchSnapshot& snapshot) {
+        const WatchValue* value = find(snapshot, watchId);
+        return value && value->valid && valueOf(snapshot, *value) == 5;
+    }));
+    watched = 7;
+    CHECK(waitFor(list, [&](const WatchSnapshot& snapshot) {
+        const WatchValue* value = find(snapshot, watchId);
+        return value && valueOf(snapshot, *value) == 7;
+    }));
+
+    // The frozen address is rewritten whatever this thread stores there
+    CHECK(waitFor(list, [&](const WatchSnapshot&) { return frozen == 42; }));
+    frozen = 1;
+    CHECK(waitFor(list, [&](const WatchSnapshot&) { return frozen == 42; }));
+
+    // Unfreezing keeps the entry and reads it from then on
+    CHECK(list.setFrozen(freezeId, false));
+    frozen = 9;
+    CHECK(waitFor(list, [&](const WatchSnapshot& snapshot) {
+        const WatchValue* value = find(snapshot, freezeId);
+        return value && value->mode == WatchMode::WATCH && valueOf(snapshot, *value) == 9;
+    }));
+
+    // Unreadable addresses are reported, removed entries disappear
+    uint32_t badId = list.addWatch(0x10, ScanValueType::INT32, sizeof(int32_t), 1);
+    CHECK(waitFor(list, [&](const WatchSnapshot& snapshot) {
+        const WatchValue* value = find(snapshot, badId);
+        return value && value->timestampMs != 0 && !value->valid;
+    }));
+    CHECK(list.remove(watchId));
+    CHECK(!list.remove(watchId));
+    CHECK(waitFor(list, [&](const WatchSnapshot& snapshot) { return !find(snapshot, watchId); }));
+    CHECK(list.size() == 2);
+    list.stop();
+}
+
+void testEditsWhileRunning() {
+    // Entries added and removed between and during ticks never disturb the others
+    static volatile int32_t values[64];
+    MemoryScanner scanner(getpid());
+    WatchList list(scanner);
+    list.start();
+    std::vector<uint32_t> ids;
+    for (int round = 0; round < 20; round++) {
+        for (size_t i = 0; i < 64; i++) {
+            ids.push_back(list.addWatch(reinterpret_cast<uintptr_t>(&values[i]), ScanValueType::INT32, sizeof(int32_t), 1));
+        }
+        for (size_t i = 0; i < ids.size(); i += 2) list.remove(ids[i]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    size_t remaining = list.size();
+    CHECK(waitFor(list, [&](const WatchSnapshot& snapshot) {
+        if (snapshot.values.size() != remaining) return false;
+        for (const auto& value : snapshot.values) {
+            if (!value.valid) return false;
+        }
+        return true;
+    }));
+    list.clear();
+    list.stop();
+}
+
+} // namespace
+#endif
+
+int main() {
+#ifdef __linux__
+    testWatchAndFreeze();
+    testEditsWhileRunning();
+#endif
+    return TEST_RESULT();
+}